@@ -0,0 +1,152 @@
+/*
+* Read-only memory mapped file
+*
+* Maps a whole file into the address space so it can be read without
+* an intermediate copy, pages are loaded by the OS on first access
+*/
+
+#pragma once
+
+#include <string>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace vkTools
+{
+
+	class MappedFile
+	{
+	private:
+#ifdef _WIN32
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = NULL;
+#else
+		int file = -1;
+#endif
+		const uint8_t *mappedData = nullptr;
+		size_t mappedSize = 0;
+
+	public:
+		MappedFile() {}
+
+		MappedFile(const std::string &filename)
+		{
+			open(filename);
+		}
+
+		~MappedFile()
+		{
+			close();
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Map the whole file, returns false if it doesn't exist or is empty
+		bool open(const std::string &filename)
+		{
+			close();
+#ifdef _WIN32
+			file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart == 0))
+			{
+				close();
+				return false;
+			}
+			mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mapping == NULL)
+			{
+				close();
+				return false;
+			}
+			mappedData = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			mappedSize = (size_t)fileSize.QuadPart;
+#else
+			file = ::open(filename.c_str(), O_RDONLY);
+			if (file < 0)
+			{
+				return false;
+			}
+			struct stat fileStat;
+			if ((fstat(file, &fileStat) != 0) || (fileStat.st_size == 0))
+			{
+				close();
+				return false;
+			}
+			void *data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (data != MAP_FAILED)
+			{
+				mappedData = (const uint8_t*)data;
+				mappedSize = (size_t)fileStat.st_size;
+			}
+#endif
+			if (mappedData == nullptr)
+			{
+				close();
+				return false;
+			}
+			return true;
+		}
+
+		void close()
+		{
+#ifdef _WIN32
+			if (mappedData)
+			{
+				UnmapViewOfFile(mappedData);
+			}
+			if (mapping != NULL)
+			{
+				CloseHandle(mapping);
+				mapping = NULL;
+			}
+			if (file != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(file);
+				file = INVALID_HANDLE_VALUE;
+			}
+#else
+			if (mappedData)
+			{
+				munmap((void*)mappedData, mappedSize);
+			}
+			if (file >= 0)
+			{
+				::close(file);
+				file = -1;
+			}
+#endif
+			mappedData = nullptr;
+			mappedSize = 0;
+		}
+
+		bool isOpen() const
+		{
+			return mappedData != nullptr;
+		}
+
+		const uint8_t *data() const
+		{
+			return mappedData;
+		}
+
+		size_t size() const
+		{
+			return mappedSize;
+		}
+	};
+
+}
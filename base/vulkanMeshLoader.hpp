@@ -7,8 +7,12 @@
 #include <fstream>
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <thread>
+#include <atomic>
 #ifdef _WIN32
 #include <windows.h>
 #include <fcntl.h>
@@ -17,6 +21,13 @@
 #endif
 
 #include "vulkan/vulkan.h"
+#include "vulkanmemory.hpp"
+#include "vulkanupload.hpp"
+#include "vulkanmeshoptimizer.hpp"
+#include "vulkanmeshsimplifier.hpp"
+#include "vulkanmeshlets.hpp"
+#include "vulkanparallel.hpp"
+#include "vulkanbvh.hpp"
 
 #include <assimp/Importer.hpp> 
 #include <assimp/scene.h>     
@@ -25,6 +36,7 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 
 namespace vkMeshLoader 
 {
@@ -34,20 +46,137 @@ namespace vkMeshLoader
 		VERTEX_LAYOUT_COLOR = 0x2,
 		VERTEX_LAYOUT_UV = 0x3,
 		VERTEX_LAYOUT_TANGENT = 0x4,
-		VERTEX_LAYOUT_BITANGENT = 0x5
+		VERTEX_LAYOUT_BITANGENT = 0x5,
+		// Packed variants of the above
+		// Position as unorm16 relative to the bounds of all meshes, w = 1.0 (see MeshBuffer::dequantization)
+		VERTEX_LAYOUT_POSITION_QUANTIZED = 0x6,
+		// Snorm 10:10:10:2, w = 0
+		VERTEX_LAYOUT_NORMAL_PACKED = 0x7,
+		VERTEX_LAYOUT_TANGENT_PACKED = 0x8,
+		// Half float
+		VERTEX_LAYOUT_UV_HALF = 0x9,
+		// Unorm8, alpha = 1.0
+		VERTEX_LAYOUT_COLOR_UNORM8 = 0xA
 	} VertexLayout;
 
+	// Size of a single vertex component in bytes
+	constexpr uint32_t componentSize(VertexLayout component)
+	{
+		return
+			(component == VERTEX_LAYOUT_UV) ? 2 * sizeof(float) :
+			(component == VERTEX_LAYOUT_POSITION_QUANTIZED) ? 4 * sizeof(uint16_t) :
+			((component == VERTEX_LAYOUT_NORMAL_PACKED) || (component == VERTEX_LAYOUT_TANGENT_PACKED) ||
+			 (component == VERTEX_LAYOUT_UV_HALF) || (component == VERTEX_LAYOUT_COLOR_UNORM8)) ? sizeof(uint32_t) :
+			3 * sizeof(float);
+	}
+
+	// Vertex input format of a component
+	constexpr VkFormat componentFormat(VertexLayout component)
+	{
+		return
+			(component == VERTEX_LAYOUT_UV) ? VK_FORMAT_R32G32_SFLOAT :
+			(component == VERTEX_LAYOUT_POSITION_QUANTIZED) ? VK_FORMAT_R16G16B16A16_UNORM :
+			((component == VERTEX_LAYOUT_NORMAL_PACKED) || (component == VERTEX_LAYOUT_TANGENT_PACKED)) ? VK_FORMAT_A2B10G10R10_SNORM_PACK32 :
+			(component == VERTEX_LAYOUT_UV_HALF) ? VK_FORMAT_R16G16_SFLOAT :
+			(component == VERTEX_LAYOUT_COLOR_UNORM8) ? VK_FORMAT_R8G8B8A8_UNORM :
+			VK_FORMAT_R32G32B32_SFLOAT;
+	}
+
+	// Values needed to convert a vertex to the components of a layout
+	struct PackParams
+	{
+		float scale;
+		// Maps the (scaled) position to [0..1] for VERTEX_LAYOUT_POSITION_QUANTIZED
+		glm::vec3 positionMin;
+		glm::vec3 positionRcpExtent;
+	};
+
+	inline void packQuantizedPosition(const glm::vec3 &position, const PackParams &params, void *out)
+	{
+		glm::vec3 normalized = glm::clamp((position * params.scale - params.positionMin) * params.positionRcpExtent, glm::vec3(0.0f), glm::vec3(1.0f));
+		uint64_t packed = glm::packUnorm4x16(glm::vec4(normalized, 1.0f));
+		memcpy(out, &packed, sizeof(packed));
+	}
+
+	inline void packSnorm10(const glm::vec3 &v, void *out)
+	{
+		uint32_t packed = glm::packSnorm3x10_1x2(glm::vec4(v, 0.0f));
+		memcpy(out, &packed, sizeof(packed));
+	}
+
+	inline void packHalf2(const glm::vec2 &v, void *out)
+	{
+		uint32_t packed = glm::packHalf2x16(v);
+		memcpy(out, &packed, sizeof(packed));
+	}
+
+	inline void packUnorm8(const glm::vec3 &v, void *out)
+	{
+		uint32_t packed = glm::packUnorm4x8(glm::vec4(v, 1.0f));
+		memcpy(out, &packed, sizeof(packed));
+	}
+
 	struct MeshBufferInfo 
 	{
 		VkBuffer buf = VK_NULL_HANDLE;
-		VkDeviceMemory mem = VK_NULL_HANDLE;
+		vkTools::Allocation allocation;
+	};
+
+	// Vertex and index range of a single mesh of the loaded scene
+	struct MeshDescriptor
+	{
+		uint32_t vertexBase;
+		uint32_t vertexCount;
+		uint32_t indexBase;
+		uint32_t indexCount;
+		uint32_t materialIndex;
+		// Bounding box of the (scaled) vertex positions
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
+	// Meshes with up to this many vertices use 16 bit indices
+	// 0xFFFF is left out as it's the primitive restart index
+	static const uint32_t maxVertexCount16 = 0xFFFF;
+
+	// Range of the index buffer drawn with a single vkCmdDrawIndexed
+	struct MeshDrawRange
+	{
+		uint32_t indexBase;
+		uint32_t indexCount;
+		// Added to the indices, 16 bit indices are relative to the first vertex of their mesh
+		int32_t vertexOffset;
+	};
+
+	// Index range and draw ranges of one level of detail of all meshes
+	struct MeshLod
+	{
+		uint32_t indexBase;
+		uint32_t indexCount;
+		// Largest distance (in model units) of the simplified surface to the original mesh
+		float error;
+		// Draws of this level in MeshBuffer::drawRanges
+		// A single draw for 32 bit indices, one per mesh for 16 bit indices
+		uint32_t firstDrawRange;
+		uint32_t drawRangeCount;
 	};
 
 	struct MeshBuffer 
 	{
 		MeshBufferInfo vertices;
 		MeshBufferInfo indices;
+		// Number of indices of the full detail meshes (first level of detail)
 		uint32_t indexCount;
+		// Type to bind the index buffer with
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+		std::vector<MeshDescriptor> meshDescriptors;
+		// Levels of detail from full to lowest detail, all share the index buffer
+		// Always contains at least the full detail level
+		std::vector<MeshLod> lods;
+		std::vector<MeshDrawRange> drawRanges;
+		// Transforms quantized positions back to model space
+		// Identity if the layout doesn't use VERTEX_LAYOUT_POSITION_QUANTIZED
+		glm::mat4 dequantization;
 	};
 
 	// Get vertex size from vertex layout
@@ -56,27 +185,113 @@ namespace vkMeshLoader
 		uint32_t vSize = 0;
 		for (auto& layoutDetail : layout)
 		{
-			switch (layoutDetail)
+			vSize += componentSize(layoutDetail);
+		}
+		return vSize;
+	}
+
+	// One attribute per component of the layout at consecutive shader locations starting with firstLocation
+	static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(std::vector<vkMeshLoader::VertexLayout> layout, uint32_t binding, uint32_t firstLocation = 0)
+	{
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+		uint32_t offset = 0;
+		for (auto& layoutDetail : layout)
+		{
+			attributeDescriptions.push_back({ firstLocation++, binding, componentFormat(layoutDetail), offset });
+			offset += componentSize(layoutDetail);
+		}
+		return attributeDescriptions;
+	}
+
+	// Returns true if the device supports all component formats of the layout as vertex input
+	// Support for the packed normal and tangent format isn't required by the spec
+	static bool isLayoutSupported(VkPhysicalDevice physicalDevice, std::vector<vkMeshLoader::VertexLayout> layout)
+	{
+		for (auto& layoutDetail : layout)
+		{
+			VkFormatProperties formatProps;
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, componentFormat(layoutDetail), &formatProps);
+			if (!(formatProps.bufferFeatures & VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static bool hasQuantizedPositions(const std::vector<vkMeshLoader::VertexLayout> &layout)
+	{
+		return std::find(layout.begin(), layout.end(), VERTEX_LAYOUT_POSITION_QUANTIZED) != layout.end();
+	}
+
+	// Bounds of all meshes
+	static void getBounds(const std::vector<MeshDescriptor> &meshDescriptors, glm::vec3 &min, glm::vec3 &max)
+	{
+		min = meshDescriptors.empty() ? glm::vec3(0.0f) : meshDescriptors[0].min;
+		max = meshDescriptors.empty() ? glm::vec3(0.0f) : meshDescriptors[0].max;
+		for (auto& descriptor : meshDescriptors)
+		{
+			min = glm::min(min, descriptor.min);
+			max = glm::max(max, descriptor.max);
+		}
+	}
+
+	// Matrix that maps quantized [0..1] positions back to the bounds of all meshes
+	static glm::mat4 getDequantization(const std::vector<MeshDescriptor> &meshDescriptors)
+	{
+		glm::vec3 min, max;
+		getBounds(meshDescriptors, min, max);
+		return glm::scale(glm::translate(glm::mat4(), min), max - min);
+	}
+
+	// Pixels per model unit at a distance of one for a perspective projection
+	static float getLodProjectionScale(float fovY, float viewportHeight)
+	{
+		return viewportHeight / (2.0f * tanf(glm::radians(fovY) * 0.5f));
+	}
+
+	// Returns the lowest detail level whose error projected at the given distance
+	// stays below pixelThreshold pixels (projectionScale from getLodProjectionScale)
+	static uint32_t selectLod(const MeshBuffer &meshBuffer, float distance, float projectionScale, float pixelThreshold = 1.0f)
+	{
+		uint32_t lod = 0;
+		for (uint32_t i = 1; i < meshBuffer.lods.size(); i++)
+		{
+			if (meshBuffer.lods[i].error * projectionScale > pixelThreshold * distance)
 			{
-			// UV only has two components
-			case VERTEX_LAYOUT_UV: 
-				vSize += 2 * sizeof(float);
 				break;
-			default:
-				vSize += 3 * sizeof(float);
 			}
+			lod = i;
+		}
+		return lod;
+	}
+
+	// Draw a level of detail of the mesh
+	// The index buffer has to be bound with meshBuffer.indexType
+	static void drawMesh(VkCommandBuffer commandBuffer, const MeshBuffer &meshBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0, uint32_t lod = 0)
+	{
+		if (meshBuffer.lods.empty())
+		{
+			// Buffers that haven't been created by the mesh loader
+			vkCmdDrawIndexed(commandBuffer, meshBuffer.indexCount, instanceCount, 0, 0, firstInstance);
+			return;
+		}
+		const MeshLod &meshLod = meshBuffer.lods[lod];
+		for (uint32_t i = 0; i < meshLod.drawRangeCount; i++)
+		{
+			const MeshDrawRange &range = meshBuffer.drawRanges[meshLod.firstDrawRange + i];
+			vkCmdDrawIndexed(commandBuffer, range.indexCount, instanceCount, range.indexBase, range.vertexOffset, firstInstance);
 		}
-		return vSize;
 	}
 
 	static void freeMeshBufferResources(VkDevice device, vkMeshLoader::MeshBuffer *meshBuffer)
 	{
 		vkDestroyBuffer(device, meshBuffer->vertices.buf, nullptr);
-		vkFreeMemory(device, meshBuffer->vertices.mem, nullptr);
+		meshBuffer->vertices.allocation.free();
 		if (meshBuffer->indices.buf != VK_NULL_HANDLE)
 		{
 			vkDestroyBuffer(device, meshBuffer->indices.buf, nullptr);
-			vkFreeMemory(device, meshBuffer->indices.mem, nullptr);
+			meshBuffer->indices.allocation.free();
 		}
 	}
 }
@@ -113,29 +328,16 @@ private:
 		uint32_t vertexBase;
 		std::vector<Vertex> Vertices;
 		std::vector<unsigned int> Indices;
+		// Bounds of the vertex positions (see computeBounds)
+		vkMeshLoader::BoundingBox bounds;
+		vkMeshLoader::BoundingSphere sphere;
 	};
 
 
-	VkBool32 getMemoryType(VkPhysicalDeviceMemoryProperties deviceMemoryProperties, uint32_t typeBits, VkFlags properties, uint32_t * typeIndex)
-	{
-		for (int i = 0; i < 32; i++)
-		{
-			if ((typeBits & 1) == 1)
-			{
-				if ((deviceMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
-				{
-					*typeIndex = i;
-					return true;
-				}
-			}
-			typeBits >>= 1;
-		}
-		return false;
-	}
-
 public:
 	std::vector<MeshEntry> m_Entries;
 
+	// Bounds of all meshes
 	struct Dimension 
 	{
 		glm::vec3 min = glm::vec3(FLT_MAX);
@@ -143,18 +345,21 @@ public:
 		glm::vec3 size;
 	} dim;
 
+	// Optional triangle BVH over all meshes (see buildBvh)
+	vkMeshLoader::Bvh bvh;
+
 	uint32_t numVertices = 0;
 
 	// Optional
 	struct
 	{
 		VkBuffer buf;
-		VkDeviceMemory mem;
+		vkTools::Allocation allocation;
 	} vertexBuffer;
 
 	struct {
 		VkBuffer buf;
-		VkDeviceMemory mem;
+		vkTools::Allocation allocation;
 		uint32_t count;
 	} indexBuffer;
 
@@ -166,6 +371,9 @@ public:
 	Assimp::Importer Importer;
 	const aiScene* pScene;
 
+	// Import flags used by LoadMesh(Filename)
+	static const int defaultFlags = aiProcess_FlipWindingOrder | aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals;
+
 	~VulkanMeshLoader()
 	{
 		m_Entries.clear();
@@ -174,9 +382,7 @@ public:
 	// Loads the mesh with some default flags
 	bool LoadMesh(const std::string& Filename) 
 	{
-		int flags = aiProcess_FlipWindingOrder | aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals;
-
-		return LoadMesh(Filename, flags);
+		return LoadMesh(Filename, defaultFlags);
 	}
 
 	// Load the mesh with custom flags
@@ -213,6 +419,8 @@ public:
 			InitMesh(i, paiMesh, pScene);
 		}
 
+		computeBounds();
+
 		return true;
 	}
 
@@ -247,19 +455,9 @@ public:
 				glm::vec3(pColor.r, pColor.g, pColor.b)
 				);
 
-			dim.max.x = fmax(pPos->x, dim.max.x);
-			dim.max.y = fmax(pPos->y, dim.max.y);
-			dim.max.z = fmax(pPos->z, dim.max.z);
-
-			dim.min.x = fmin(pPos->x, dim.min.x);
-			dim.min.y = fmin(pPos->y, dim.min.y);
-			dim.min.z = fmin(pPos->z, dim.min.z);
-
 			m_Entries[index].Vertices.push_back(v);
 		}
 
-		dim.size = dim.max - dim.min;
-
 		for (unsigned int i = 0; i < paiMesh->mNumFaces; i++) 
 		{
 			const aiFace& Face = paiMesh->mFaces[i];
@@ -274,123 +472,760 @@ public:
 	static void freeVulkanResources(VkDevice device, VulkanMeshLoader *mesh)
 	{
 		vkDestroyBuffer(device, mesh->vertexBuffer.buf, nullptr);
-		vkFreeMemory(device, mesh->vertexBuffer.mem, nullptr);
+		mesh->vertexBuffer.allocation.free();
 		vkDestroyBuffer(device, mesh->indexBuffer.buf, nullptr);
-		vkFreeMemory(device, mesh->indexBuffer.mem, nullptr);
+		mesh->indexBuffer.allocation.free();
+	}
+
+	// Create a buffer and return a pointer that it's data can be written to
+	// If an upload manager is passed, the buffer is device local and the pointer
+	// points into the upload manager's staging buffer (valid until it's next flush)
+	// Otherwise the buffer is host visible and the pointer points to it's memory
+	// Returns nullptr if the data doesn't fit into the staging buffer
+	static void *createBuffer(
+		VkDevice device,
+		vkTools::VulkanMemoryAllocator *allocator,
+		vkTools::VulkanUploadManager *uploader,
+		VkBufferUsageFlags usage,
+		VkDeviceSize size,
+		vkMeshLoader::MeshBufferInfo *bufferInfo)
+	{
+		if (uploader)
+		{
+			usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		}
+		VkBufferCreateInfo bufferCreateInfo = vkTools::initializers::bufferCreateInfo(usage, size);
+		VkResult err = vkCreateBuffer(device, &bufferCreateInfo, nullptr, &bufferInfo->buf);
+		assert(!err);
+		if (uploader)
+		{
+			bufferInfo->allocation = allocator->allocateBuffer(bufferInfo->buf, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			return uploader->reserve(bufferInfo->buf, size);
+		}
+		// Memory is sub-allocated from a persistently mapped host visible block
+		bufferInfo->allocation = allocator->allocateBuffer(bufferInfo->buf, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+		return bufferInfo->allocation.mapped;
+	}
+
+	// Create a buffer and fill it with data
+	// Uses device local memory and a staging upload if an upload manager is passed
+	static void createBuffer(
+		VkDevice device,
+		vkTools::VulkanMemoryAllocator *allocator,
+		vkTools::VulkanUploadManager *uploader,
+		VkBufferUsageFlags usage,
+		void *data,
+		VkDeviceSize size,
+		vkMeshLoader::MeshBufferInfo *bufferInfo)
+	{
+		void *dst = createBuffer(device, allocator, uploader, usage, size, bufferInfo);
+		if (dst)
+		{
+			memcpy(dst, data, size);
+		}
+		else
+		{
+			uploader->upload(bufferInfo->buf, data, size);
+		}
+	}
+
+	// Compute the bounding box and sphere of each mesh and the bounds of all meshes (dim)
+	// from the vertex positions, called after loading and splitting meshes
+	void computeBounds(uint32_t threadCount = 0)
+	{
+		vkMeshLoader::runParallel((uint32_t)m_Entries.size(), threadCount, [&](uint32_t m)
+		{
+			MeshEntry &entry = m_Entries[m];
+			std::vector<glm::vec3> positions(entry.Vertices.size());
+			entry.bounds = vkMeshLoader::BoundingBox();
+			for (size_t v = 0; v < entry.Vertices.size(); v++)
+			{
+				positions[v] = entry.Vertices[v].m_pos;
+				entry.bounds.expand(positions[v]);
+			}
+			entry.sphere = vkMeshLoader::computeBoundingSphere(positions.data(), positions.size(), entry.bounds);
+		});
+
+		vkMeshLoader::BoundingBox bounds;
+		for (auto& entry : m_Entries)
+		{
+			if (entry.bounds.valid())
+			{
+				bounds.expand(entry.bounds);
+			}
+		}
+		dim.min = bounds.min;
+		dim.max = bounds.max;
+		dim.size = bounds.valid() ? (dim.max - dim.min) : glm::vec3(0.0f);
+	}
+
+	// Build a BVH over the full detail triangles of all meshes (bvh)
+	// Triangle indices of ray hits refer to the index list written by packIndices (see getTriangleEntry)
+	void buildBvh(uint32_t threadCount = 0)
+	{
+		std::vector<glm::vec3> positions(numVertices);
+		for (auto& entry : m_Entries)
+		{
+			for (size_t v = 0; v < entry.Vertices.size(); v++)
+			{
+				positions[entry.vertexBase + v] = entry.Vertices[v].m_pos;
+			}
+		}
+		std::vector<uint32_t> indices(getIndexCount());
+		packIndices(indices.data(), threadCount);
+		bvh.build(indices.data(), indices.size(), positions.data(), threadCount);
+	}
+
+	// Index of the mesh a triangle of the packed index list belongs to
+	uint32_t getTriangleEntry(uint32_t triangle)
+	{
+		uint32_t firstTriangle = 0;
+		for (size_t m = 0; m < m_Entries.size(); m++)
+		{
+			firstTriangle += (uint32_t)m_Entries[m].Indices.size() / 3;
+			if (triangle < firstTriangle)
+			{
+				return (uint32_t)m;
+			}
+		}
+		return UINT32_MAX;
+	}
+
+	// Vertex and index ranges and bounds of all meshes
+	std::vector<vkMeshLoader::MeshDescriptor> getMeshDescriptors(float scale)
+	{
+		std::vector<vkMeshLoader::MeshDescriptor> descriptors(m_Entries.size());
+		uint32_t indexBase = 0;
+		for (size_t m = 0; m < m_Entries.size(); m++)
+		{
+			vkMeshLoader::MeshDescriptor &descriptor = descriptors[m];
+			descriptor.vertexBase = m_Entries[m].vertexBase;
+			descriptor.vertexCount = (uint32_t)m_Entries[m].Vertices.size();
+			descriptor.indexBase = indexBase;
+			descriptor.indexCount = (uint32_t)m_Entries[m].Indices.size();
+			descriptor.materialIndex = m_Entries[m].MaterialIndex;
+			descriptor.min = glm::min(m_Entries[m].bounds.min * scale, m_Entries[m].bounds.max * scale);
+			descriptor.max = glm::max(m_Entries[m].bounds.min * scale, m_Entries[m].bounds.max * scale);
+			indexBase += descriptor.indexCount;
+		}
+		return descriptors;
+	}
+
+	// Reorder the triangles of each mesh for vertex cache locality and less overdraw,
+	// then reorder it's vertices by first use (see vulkanmeshoptimizer.hpp)
+	// Call after loading and before creating the buffers
+	// Returns the vertex cache statistics of all meshes before and after optimizing
+	vkMeshLoader::MeshOptimizationStatistics optimize(float overdrawThreshold = 1.05f, uint32_t threadCount = 0)
+	{
+		std::vector<vkMeshLoader::MeshOptimizationStatistics> entryStats(m_Entries.size());
+		vkMeshLoader::runParallel((uint32_t)m_Entries.size(), threadCount, [&](uint32_t m)
+		{
+			MeshEntry &entry = m_Entries[m];
+			const uint32_t vertexCount = (uint32_t)entry.Vertices.size();
+			uint32_t *indices = entry.Indices.data();
+			const size_t indexCount = entry.Indices.size();
+			entryStats[m].before = vkMeshLoader::analyzeVertexCache(indices, indexCount, vertexCount);
+
+			vkMeshLoader::optimizeVertexCache(indices, indexCount, vertexCount);
+
+			std::vector<glm::vec3> positions(vertexCount);
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				positions[v] = entry.Vertices[v].m_pos;
+			}
+			vkMeshLoader::optimizeOverdraw(indices, indexCount, positions.data(), vertexCount, overdrawThreshold);
+
+			std::vector<uint32_t> remap = vkMeshLoader::optimizeVertexFetchRemap(indices, indexCount, vertexCount);
+			std::vector<Vertex> vertices(vertexCount);
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				vertices[remap[v]] = entry.Vertices[v];
+			}
+			entry.Vertices.swap(vertices);
+			for (size_t i = 0; i < indexCount; i++)
+			{
+				indices[i] = remap[indices[i]];
+			}
+
+			entryStats[m].after = vkMeshLoader::analyzeVertexCache(indices, indexCount, vertexCount);
+		});
+
+		// Levels of detail reference the old vertex order
+		lodLevels.clear();
+
+		vkMeshLoader::MeshOptimizationStatistics stats;
+		for (auto& entry : entryStats)
+		{
+			vkMeshLoader::accumulateStatistics(stats.before, entry.before);
+			vkMeshLoader::accumulateStatistics(stats.after, entry.after);
+		}
+		return stats;
+	}
+
+	// Generate up to levelCount levels of detail below the full detail meshes
+	// Each level is simplified from the previous one down to reduction times it's triangles
+	// (see vulkanmeshsimplifier.hpp) and reordered for the vertex cache
+	// maxError limits the simplification error relative to the size of each mesh
+	// Levels are stored after the full detail indices in the index buffer
+	// Call after optimize, returns the number of generated levels
+	uint32_t generateLods(uint32_t levelCount, float reduction = 0.5f, float maxError = 0.1f, uint32_t threadCount = 0)
+	{
+		struct EntryLod
+		{
+			std::vector<uint32_t> indices;
+			float error;
+		};
+		std::vector<std::vector<EntryLod>> entryLods(m_Entries.size());
+		vkMeshLoader::runParallel((uint32_t)m_Entries.size(), threadCount, [&](uint32_t m)
+		{
+			MeshEntry &entry = m_Entries[m];
+			const uint32_t vertexCount = (uint32_t)entry.Vertices.size();
+			std::vector<glm::vec3> positions(vertexCount);
+			glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				positions[v] = entry.Vertices[v].m_pos;
+				min = glm::min(min, positions[v]);
+				max = glm::max(max, positions[v]);
+			}
+			const float errorLimit = (vertexCount > 0) ? maxError * glm::length(max - min) : 0.0f;
+
+			std::vector<uint32_t> indices(entry.Indices.begin(), entry.Indices.end());
+			float error = 0.0f;
+			for (uint32_t level = 0; level < levelCount; level++)
+			{
+				size_t targetIndexCount = (size_t)(indices.size() / 3 * reduction) * 3;
+				float levelError;
+				std::vector<uint32_t> lod = vkMeshLoader::simplifyMesh(indices.data(), indices.size(), positions.data(), vertexCount, targetIndexCount, std::max(errorLimit - error, 0.0f), &levelError);
+				if (lod.empty() || (lod.size() >= indices.size()))
+				{
+					break;
+				}
+				vkMeshLoader::optimizeVertexCache(lod.data(), lod.size(), vertexCount);
+				// Errors of the levels add up as each level is simplified from the previous one
+				error += levelError;
+				entryLods[m].push_back({ lod, error });
+				indices.swap(lod);
+			}
+		});
+
+		// Meshes that can't be simplified any further use their lowest level in the remaining levels
+		uint32_t generatedLevels = 0;
+		for (auto& lods : entryLods)
+		{
+			generatedLevels = std::max(generatedLevels, (uint32_t)lods.size());
+		}
+		lodLevels.clear();
+		lodLevels.resize(generatedLevels);
+		for (uint32_t level = 0; level < generatedLevels; level++)
+		{
+			LodLevel &lodLevel = lodLevels[level];
+			lodLevel.indices.resize(m_Entries.size());
+			lodLevel.error = 0.0f;
+			for (size_t m = 0; m < m_Entries.size(); m++)
+			{
+				if (entryLods[m].empty())
+				{
+					lodLevel.indices[m].assign(m_Entries[m].Indices.begin(), m_Entries[m].Indices.end());
+					continue;
+				}
+				const EntryLod &entryLod = entryLods[m][std::min(level, (uint32_t)entryLods[m].size() - 1)];
+				lodLevel.indices[m] = entryLod.indices;
+				lodLevel.error = std::max(lodLevel.error, entryLod.error);
+			}
+		}
+		return generatedLevels;
+	}
+
+	// Index ranges of all levels of detail, starting with the full detail meshes
+	// Errors are scaled to match the vertex positions
+	// If drawRanges is passed, the draws for an index buffer of the given type are added to it
+	std::vector<vkMeshLoader::MeshLod> getLods(float scale, VkIndexType indexType = VK_INDEX_TYPE_UINT32, std::vector<vkMeshLoader::MeshDrawRange> *drawRanges = nullptr)
+	{
+		std::vector<vkMeshLoader::MeshLod> lods;
+		std::vector<vkMeshLoader::MeshDrawRange> ranges;
+		uint32_t indexBase = 0;
+		for (uint32_t level = 0; level <= lodLevels.size(); level++)
+		{
+			vkMeshLoader::MeshLod lod = { indexBase, 0, (level > 0) ? lodLevels[level - 1].error * scale : 0.0f, (uint32_t)ranges.size(), 0 };
+			for (size_t m = 0; m < m_Entries.size(); m++)
+			{
+				uint32_t indexCount = (level > 0) ? (uint32_t)lodLevels[level - 1].indices[m].size() : (uint32_t)m_Entries[m].Indices.size();
+				if ((indexType == VK_INDEX_TYPE_UINT16) && (indexCount > 0))
+				{
+					ranges.push_back({ indexBase, indexCount, (int32_t)m_Entries[m].vertexBase });
+				}
+				indexBase += indexCount;
+				lod.indexCount += indexCount;
+			}
+			if (indexType == VK_INDEX_TYPE_UINT32)
+			{
+				// 32 bit indices are offset to the meshes' first vertex, so all meshes are drawn at once
+				ranges.push_back({ lod.indexBase, lod.indexCount, 0 });
+			}
+			lod.drawRangeCount = (uint32_t)ranges.size() - lod.firstDrawRange;
+			lods.push_back(lod);
+		}
+		if (drawRanges)
+		{
+			drawRanges->insert(drawRanges->end(), ranges.begin(), ranges.end());
+		}
+		return lods;
+	}
+
+	// Split meshes with more than maxVertexCount vertices into several meshes with the same material
+	// so all meshes can be drawn with 16 bit indices. Vertices used by more than one of the new
+	// meshes are duplicated. Keeps the triangle order, call after optimize and before generateLods
+	void splitMeshes(uint32_t maxVertexCount = vkMeshLoader::maxVertexCount16)
+	{
+		std::vector<MeshEntry> entries;
+		for (auto& entry : m_Entries)
+		{
+			if (entry.Vertices.size() <= maxVertexCount)
+			{
+				entries.push_back(std::move(entry));
+				continue;
+			}
+
+			// Add triangles to the current mesh until it's out of vertices
+			std::vector<uint32_t> remap(entry.Vertices.size(), UINT32_MAX);
+			std::vector<uint32_t> partVertices;
+			MeshEntry part;
+			part.MaterialIndex = entry.MaterialIndex;
+			for (size_t t = 0; t + 2 < entry.Indices.size(); t += 3)
+			{
+				uint32_t newVertices = 0;
+				for (size_t v = 0; v < 3; v++)
+				{
+					newVertices += (remap[entry.Indices[t + v]] == UINT32_MAX) ? 1 : 0;
+				}
+				if (part.Vertices.size() + newVertices > maxVertexCount)
+				{
+					for (auto vertex : partVertices)
+					{
+						remap[vertex] = UINT32_MAX;
+					}
+					partVertices.clear();
+					entries.push_back(std::move(part));
+					part = MeshEntry();
+					part.MaterialIndex = entry.MaterialIndex;
+				}
+				for (size_t v = 0; v < 3; v++)
+				{
+					uint32_t index = entry.Indices[t + v];
+					if (remap[index] == UINT32_MAX)
+					{
+						remap[index] = (uint32_t)part.Vertices.size();
+						part.Vertices.push_back(entry.Vertices[index]);
+						partVertices.push_back(index);
+					}
+					part.Indices.push_back(remap[index]);
+				}
+			}
+			if (!part.Indices.empty())
+			{
+				entries.push_back(std::move(part));
+			}
+		}
+
+		numVertices = 0;
+		for (auto& entry : entries)
+		{
+			entry.vertexBase = numVertices;
+			entry.NumIndices = (uint32_t)entry.Indices.size();
+			numVertices += (uint32_t)entry.Vertices.size();
+		}
+		m_Entries.swap(entries);
+		computeBounds();
+		// Levels of detail reference the old meshes
+		lodLevels.clear();
+	}
+
+	// 16 bit indices if no mesh has more than maxVertexCount16 vertices
+	VkIndexType getIndexType()
+	{
+		for (auto& entry : m_Entries)
+		{
+			if (entry.Vertices.size() > vkMeshLoader::maxVertexCount16)
+			{
+				return VK_INDEX_TYPE_UINT32;
+			}
+		}
+		return VK_INDEX_TYPE_UINT16;
+	}
+
+	// Size of the index data of all levels of detail for the given index type in bytes
+	VkDeviceSize getIndexDataSize(VkIndexType indexType)
+	{
+		return (VkDeviceSize)(getIndexCount() + getLodIndexCount()) * ((indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t));
+	}
+
+	// Write the indices of all levels of detail to dst (getIndexDataSize bytes)
+	// 16 bit indices are relative to their mesh (see getLods for the matching draw ranges)
+	void packIndexData(VkIndexType indexType, void *dst)
+	{
+		if (indexType == VK_INDEX_TYPE_UINT32)
+		{
+			packIndices((uint32_t*)dst);
+			packLodIndices((uint32_t*)dst + getIndexCount());
+			return;
+		}
+		uint16_t *out = (uint16_t*)dst;
+		for (auto& entry : m_Entries)
+		{
+			for (auto index : entry.Indices)
+			{
+				*out++ = (uint16_t)index;
+			}
+		}
+		for (auto& level : lodLevels)
+		{
+			for (auto& indices : level.indices)
+			{
+				for (auto index : indices)
+				{
+					*out++ = (uint16_t)index;
+				}
+			}
+		}
+	}
+
+	// Number of indices of all meshes
+	uint32_t getIndexCount()
+	{
+		uint32_t indexCount = 0;
+		for (auto& entry : m_Entries)
+		{
+			indexCount += (uint32_t)entry.Indices.size();
+		}
+		return indexCount;
+	}
+
+	// Partition the full detail triangles of all meshes into meshlets, meshlets never span meshes
+	// Index ranges refer to the 32 bit index list written by packIndices
+	std::vector<vkMeshLoader::Meshlet> buildMeshlets(uint32_t maxVertices = vkMeshLoader::meshletMaxVertices, uint32_t maxTriangles = vkMeshLoader::meshletMaxTriangles)
+	{
+		std::vector<vkMeshLoader::Meshlet> meshlets;
+		std::vector<glm::vec3> positions;
+		uint32_t indexBase = 0;
+		for (auto& entry : m_Entries)
+		{
+			positions.resize(entry.Vertices.size());
+			for (size_t v = 0; v < entry.Vertices.size(); v++)
+			{
+				positions[v] = entry.Vertices[v].m_pos;
+			}
+			std::vector<vkMeshLoader::Meshlet> entryMeshlets = vkMeshLoader::buildMeshlets(entry.Indices.data(), entry.Indices.size(), positions.data(), (uint32_t)positions.size(), maxVertices, maxTriangles);
+			for (auto& meshlet : entryMeshlets)
+			{
+				meshlet.indexBase += indexBase;
+			}
+			meshlets.insert(meshlets.end(), entryMeshlets.begin(), entryMeshlets.end());
+			indexBase += (uint32_t)entry.Indices.size();
+		}
+		return meshlets;
 	}
 
 	// Create vertex and index buffer with given layout
+	// If an upload manager is passed, the buffers are placed in device local memory
+	// and filled on the upload manager's next flush, otherwise they're host visible
+	// Vertex and index data is written straight into staging or mapped memory
 	void createVulkanBuffers(
 		VkDevice device, 
-		VkPhysicalDeviceMemoryProperties deviceMemoryProperties,
+		vkTools::VulkanMemoryAllocator *allocator,
 		vkMeshLoader::MeshBuffer *meshBuffer, 
 		std::vector<vkMeshLoader::VertexLayout> layout, 
-		float scale)
+		float scale,
+		vkTools::VulkanUploadManager *uploader = nullptr)
+	{
+		createBuffers(device, allocator, meshBuffer, vkMeshLoader::vertexSize(layout), vkMeshLoader::hasQuantizedPositions(layout), scale, uploader, [&](void *dst)
+		{
+			packVertices(layout, scale, dst);
+		});
+	}
+
+	// Create vertex and index buffer with a compile time vertex format (see vulkanvertexformat.hpp)
+	template <typename Format>
+	void createVulkanBuffers(
+		VkDevice device,
+		vkTools::VulkanMemoryAllocator *allocator,
+		vkMeshLoader::MeshBuffer *meshBuffer,
+		float scale,
+		vkTools::VulkanUploadManager *uploader = nullptr)
+	{
+		createBuffers(device, allocator, meshBuffer, Format::stride, vkMeshLoader::hasQuantizedPositions(Format::layout()), scale, uploader, [&](void *dst)
+		{
+			packVertices<Format>(scale, dst);
+		});
+	}
+
+	// Build the interleaved vertex data for the given layout and the index data
+	void getBufferData(
+		std::vector<vkMeshLoader::VertexLayout> layout,
+		float scale,
+		std::vector<float> &vertexBuffer,
+		std::vector<uint32_t> &indexBuffer)
+	{
+		vertexBuffer.resize((size_t)numVertices * vkMeshLoader::vertexSize(layout) / sizeof(float));
+		packVertices(layout, scale, vertexBuffer.data());
+		indexBuffer.resize(getIndexCount() + getLodIndexCount());
+		packIndices(indexBuffer.data());
+		packLodIndices(indexBuffer.data() + getIndexCount());
+	}
+
+	// Write the interleaved vertex data of all meshes for the given layout to dst
+	// dst must have room for numVertices * vertexSize(layout) bytes
+	// Meshes are split into ranges of up to packRangeSize vertices that are packed
+	// on threadCount threads (defaults to the number of hardware threads)
+	void packVertices(const std::vector<vkMeshLoader::VertexLayout> &layout, float scale, void *dst, uint32_t threadCount = 0)
+	{
+		const uint32_t stride = vkMeshLoader::vertexSize(layout) / sizeof(float);
+		const vkMeshLoader::PackParams params = getPackParams(scale, vkMeshLoader::hasQuantizedPositions(layout));
+		std::vector<PackRange> ranges = getPackRanges();
+		vkMeshLoader::runParallel((uint32_t)ranges.size(), threadCount, [&](uint32_t index)
+		{
+			const PackRange &range = ranges[index];
+			float *out = (float*)dst + (size_t)(range.entry->vertexBase + range.first) * stride;
+			packVertexRange(&range.entry->Vertices[range.first], range.count, layout, params, out);
+		});
+	}
+
+	// Same as above for a compile time vertex format
+	// dst must have room for numVertices * Format::stride bytes
+	template <typename Format>
+	void packVertices(float scale, void *dst, uint32_t threadCount = 0)
 	{
+		const vkMeshLoader::PackParams params = getPackParams(scale, vkMeshLoader::hasQuantizedPositions(Format::layout()));
+		std::vector<PackRange> ranges = getPackRanges();
+		vkMeshLoader::runParallel((uint32_t)ranges.size(), threadCount, [&](uint32_t index)
+		{
+			const PackRange &range = ranges[index];
+			float *out = (float*)((uint8_t*)dst + (size_t)(range.entry->vertexBase + range.first) * Format::stride);
+			Format::pack(&range.entry->Vertices[range.first], range.count, params, out);
+		});
+	}
 
-		std::vector<float> vertexBuffer;
-		for (int m = 0; m < m_Entries.size(); m++)
+	// Write the indices of all meshes to dst, offset to the mesh's first vertex
+	// dst must have room for getIndexCount() indices
+	void packIndices(uint32_t *dst, uint32_t threadCount = 0)
+	{
+		std::vector<uint32_t> indexBase(m_Entries.size());
+		uint32_t indexCount = 0;
+		for (size_t m = 0; m < m_Entries.size(); m++)
 		{
-			for (int i = 0; i < m_Entries[m].Vertices.size(); i++)
+			indexBase[m] = indexCount;
+			indexCount += (uint32_t)m_Entries[m].Indices.size();
+		}
+
+		vkMeshLoader::runParallel((uint32_t)m_Entries.size(), threadCount, [&](uint32_t m)
+		{
+			// Indices of each mesh start at zero, offset them to the mesh's first vertex
+			const uint32_t vertexBase = m_Entries[m].vertexBase;
+			const unsigned int *src = m_Entries[m].Indices.data();
+			uint32_t *out = dst + indexBase[m];
+			for (size_t i = 0; i < m_Entries[m].Indices.size(); i++)
 			{
-				// Push vertex data depending on layout
-				for (auto& layoutDetail : layout)
+				out[i] = src[i] + vertexBase;
+			}
+		});
+	}
+
+	// Number of indices of all generated levels of detail
+	uint32_t getLodIndexCount()
+	{
+		uint32_t indexCount = 0;
+		for (auto& level : lodLevels)
+		{
+			for (auto& indices : level.indices)
+			{
+				indexCount += (uint32_t)indices.size();
+			}
+		}
+		return indexCount;
+	}
+
+	// Write the indices of all generated levels of detail to dst, offset to the mesh's first vertex
+	// dst must have room for getLodIndexCount() indices
+	void packLodIndices(uint32_t *dst)
+	{
+		for (auto& level : lodLevels)
+		{
+			for (size_t m = 0; m < level.indices.size(); m++)
+			{
+				const uint32_t vertexBase = m_Entries[m].vertexBase;
+				for (auto index : level.indices[m])
 				{
-					// Position
-					if (layoutDetail == vkMeshLoader::VERTEX_LAYOUT_POSITION)
-					{
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_pos.x * scale);
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_pos.y * scale);
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_pos.z * scale);
-					}
-					// Normal
-					if (layoutDetail == vkMeshLoader::VERTEX_LAYOUT_NORMAL)
-					{
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_normal.x);
-						vertexBuffer.push_back(-m_Entries[m].Vertices[i].m_normal.y);  
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_normal.z);
-					}
-					// Texture coordinates
-					if (layoutDetail == vkMeshLoader::VERTEX_LAYOUT_UV)
-					{
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_tex.s);
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_tex.t);
-					}
-					// Color
-					if (layoutDetail == vkMeshLoader::VERTEX_LAYOUT_COLOR)
-					{
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_color.r);
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_color.g);
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_color.b);
-					}
-					// Tangent
-					if (layoutDetail == vkMeshLoader::VERTEX_LAYOUT_TANGENT)
-					{
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_tangent.x);
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_tangent.y);
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_tangent.z);
-					}
-					// Bitangent
-					if (layoutDetail == vkMeshLoader::VERTEX_LAYOUT_BITANGENT)
-					{
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_binormal.x);
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_binormal.y);
-						vertexBuffer.push_back(m_Entries[m].Vertices[i].m_binormal.z);
-					}
-					// todo : add checks if vertex component exists
+					*dst++ = index + vertexBase;
 				}
 			}
 		}
-		size_t vertexBufferSize = vertexBuffer.size() * sizeof(float);
+	}
+
+private:
+	// Indices of one level of detail for each mesh
+	struct LodLevel
+	{
+		std::vector<std::vector<uint32_t>> indices;
+		float error;
+	};
+	std::vector<LodLevel> lodLevels;
 
-		std::vector<uint32_t> indexBuffer;
-		for (uint32_t m = 0; m < m_Entries.size(); m++)
+	// Vertices of a mesh that are packed together
+	struct PackRange
+	{
+		MeshEntry *entry;
+		uint32_t first;
+		uint32_t count;
+	};
+	static const uint32_t packRangeSize = 16384;
+
+	std::vector<PackRange> getPackRanges()
+	{
+		std::vector<PackRange> ranges;
+		for (auto& entry : m_Entries)
 		{
-			uint32_t indexBase = (uint32_t)indexBuffer.size();
-			for (uint32_t i = 0; i < m_Entries[m].Indices.size(); i++) 
+			for (uint32_t first = 0; first < entry.Vertices.size(); first += packRangeSize)
 			{
-				indexBuffer.push_back(m_Entries[m].Indices[i] + indexBase);
+				ranges.push_back({ &entry, first, std::min((uint32_t)entry.Vertices.size() - first, packRangeSize) });
 			}
 		}
-		size_t indexBufferSize = indexBuffer.size() * sizeof(uint32_t);
+		return ranges;
+	}
 
-		VkMemoryAllocateInfo memAlloc = vkTools::initializers::memoryAllocateInfo();
-		VkMemoryRequirements memReqs;
+	// Create the buffers, packVertexData(dst) writes the vertex data of all meshes to dst
+	template <typename PackFunc>
+	void createBuffers(
+		VkDevice device,
+		vkTools::VulkanMemoryAllocator *allocator,
+		vkMeshLoader::MeshBuffer *meshBuffer,
+		uint32_t vertexStride,
+		bool quantizedPositions,
+		float scale,
+		vkTools::VulkanUploadManager *uploader,
+		PackFunc packVertexData)
+	{
+		VkDeviceSize vertexBufferSize = (VkDeviceSize)numVertices * vertexStride;
+		void *vertexData = createBuffer(device, allocator, uploader, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBufferSize, &meshBuffer->vertices);
+		if (vertexData)
+		{
+			packVertexData(vertexData);
+		}
+		else
+		{
+			// Too large for the staging buffer, pack into host memory first
+			std::vector<uint8_t> data((size_t)vertexBufferSize);
+			packVertexData(data.data());
+			uploader->upload(meshBuffer->vertices.buf, data.data(), vertexBufferSize);
+		}
 
-		VkResult err;
-		void *data;
+		// Levels of detail are stored after the full detail indices
+		meshBuffer->indexCount = getIndexCount();
+		meshBuffer->indexType = getIndexType();
+		VkDeviceSize indexBufferSize = getIndexDataSize(meshBuffer->indexType);
+		void *indexData = createBuffer(device, allocator, uploader, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBufferSize, &meshBuffer->indices);
+		if (indexData)
+		{
+			packIndexData(meshBuffer->indexType, indexData);
+		}
+		else
+		{
+			std::vector<uint8_t> data((size_t)indexBufferSize);
+			packIndexData(meshBuffer->indexType, data.data());
+			uploader->upload(meshBuffer->indices.buf, data.data(), indexBufferSize);
+		}
 
-		// Generate vertex buffer
-		VkBufferCreateInfo vBufferInfo = vkTools::initializers::bufferCreateInfo(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBufferSize);
-		err = vkCreateBuffer(device, &vBufferInfo, nullptr, &meshBuffer->vertices.buf);
-		assert(!err);
-		vkGetBufferMemoryRequirements(device, meshBuffer->vertices.buf, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		getMemoryType(deviceMemoryProperties, memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &memAlloc.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAlloc, nullptr, &meshBuffer->vertices.mem);
-		assert(!err);
-		err = vkMapMemory(device, meshBuffer->vertices.mem, 0, vertexBufferSize, 0, &data);
-		assert(!err);
-		memcpy(data, vertexBuffer.data(), vertexBufferSize);
-		vkUnmapMemory(device, meshBuffer->vertices.mem);
-		err = vkBindBufferMemory(device, meshBuffer->vertices.buf, meshBuffer->vertices.mem, 0);
-		assert(!err);
+		meshBuffer->drawRanges.clear();
+		meshBuffer->lods = getLods(scale, meshBuffer->indexType, &meshBuffer->drawRanges);
+		meshBuffer->meshDescriptors = getMeshDescriptors(scale);
+		meshBuffer->dequantization = quantizedPositions ? vkMeshLoader::getDequantization(meshBuffer->meshDescriptors) : glm::mat4();
+	}
 
-		// Generate index buffer
-		VkBufferCreateInfo iBufferInfo = vkTools::initializers::bufferCreateInfo(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBufferSize);
-		err = vkCreateBuffer(device, &iBufferInfo, nullptr, &meshBuffer->indices.buf);
-		assert(!err);
-		vkGetBufferMemoryRequirements(device, meshBuffer->indices.buf, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		getMemoryType(deviceMemoryProperties, memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &memAlloc.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAlloc, nullptr, &meshBuffer->indices.mem);
-		assert(!err);
-		err = vkMapMemory(device, meshBuffer->indices.mem, 0, indexBufferSize, 0, &data);
-		assert(!err);
-		memcpy(data, indexBuffer.data(), indexBufferSize);
-		vkUnmapMemory(device, meshBuffer->indices.mem);
-		err = vkBindBufferMemory(device, meshBuffer->indices.buf, meshBuffer->indices.mem, 0);
-		assert(!err);
-		meshBuffer->indexCount = (uint32_t)indexBuffer.size();
+	// Bounds for quantized positions are only calculated if the layout uses them
+	vkMeshLoader::PackParams getPackParams(float scale, bool quantizedPositions)
+	{
+		vkMeshLoader::PackParams params = { scale, glm::vec3(0.0f), glm::vec3(1.0f) };
+		if (quantizedPositions)
+		{
+			glm::vec3 max;
+			vkMeshLoader::getBounds(getMeshDescriptors(scale), params.positionMin, max);
+			glm::vec3 extent = max - params.positionMin;
+			for (int i = 0; i < 3; i++)
+			{
+				params.positionRcpExtent[i] = (extent[i] > 0.0f) ? 1.0f / extent[i] : 0.0f;
+			}
+		}
+		return params;
+	}
+
+	// Write vertex components in layout order, no bounds checks or allocations
+	static void packVertexRange(const Vertex *src, uint32_t count, const std::vector<vkMeshLoader::VertexLayout> &layout, const vkMeshLoader::PackParams &params, float *out)
+	{
+		const vkMeshLoader::VertexLayout *components = layout.data();
+		const size_t componentCount = layout.size();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const Vertex &vertex = src[i];
+			for (size_t c = 0; c < componentCount; c++)
+			{
+				switch (components[c])
+				{
+				case vkMeshLoader::VERTEX_LAYOUT_POSITION:
+					out[0] = vertex.m_pos.x * params.scale;
+					out[1] = vertex.m_pos.y * params.scale;
+					out[2] = vertex.m_pos.z * params.scale;
+					out += 3;
+					break;
+				case vkMeshLoader::VERTEX_LAYOUT_NORMAL:
+					out[0] = vertex.m_normal.x;
+					out[1] = -vertex.m_normal.y;
+					out[2] = vertex.m_normal.z;
+					out += 3;
+					break;
+				case vkMeshLoader::VERTEX_LAYOUT_UV:
+					out[0] = vertex.m_tex.s;
+					out[1] = vertex.m_tex.t;
+					out += 2;
+					break;
+				case vkMeshLoader::VERTEX_LAYOUT_COLOR:
+					out[0] = vertex.m_color.r;
+					out[1] = vertex.m_color.g;
+					out[2] = vertex.m_color.b;
+					out += 3;
+					break;
+				case vkMeshLoader::VERTEX_LAYOUT_TANGENT:
+					out[0] = vertex.m_tangent.x;
+					out[1] = vertex.m_tangent.y;
+					out[2] = vertex.m_tangent.z;
+					out += 3;
+					break;
+				case vkMeshLoader::VERTEX_LAYOUT_BITANGENT:
+					out[0] = vertex.m_binormal.x;
+					out[1] = vertex.m_binormal.y;
+					out[2] = vertex.m_binormal.z;
+					out += 3;
+					break;
+				case vkMeshLoader::VERTEX_LAYOUT_POSITION_QUANTIZED:
+					vkMeshLoader::packQuantizedPosition(vertex.m_pos, params, out);
+					out += 2;
+					break;
+				case vkMeshLoader::VERTEX_LAYOUT_NORMAL_PACKED:
+					vkMeshLoader::packSnorm10(glm::vec3(vertex.m_normal.x, -vertex.m_normal.y, vertex.m_normal.z), out);
+					out += 1;
+					break;
+				case vkMeshLoader::VERTEX_LAYOUT_TANGENT_PACKED:
+					vkMeshLoader::packSnorm10(vertex.m_tangent, out);
+					out += 1;
+					break;
+				case vkMeshLoader::VERTEX_LAYOUT_UV_HALF:
+					vkMeshLoader::packHalf2(vertex.m_tex, out);
+					out += 1;
+					break;
+				case vkMeshLoader::VERTEX_LAYOUT_COLOR_UNORM8:
+					vkMeshLoader::packUnorm8(vertex.m_color, out);
+					out += 1;
+					break;
+				}
+			}
+		}
 	}
 };
\ No newline at end of file
@@ -4,9 +4,15 @@
 
 #pragma once
 
+#include <vector>
+#include <algorithm>
+#include <map>
 #include <vulkan/vulkan.h>
 #include <gli/gli.hpp>
 
+#include "vulkanmemory.hpp"
+#include "vulkantexturefile.hpp"
+
 namespace vkTools 
 {
 
@@ -15,12 +21,15 @@ namespace vkTools
 		VkSampler sampler;
 		VkImage image;
 		VkImageLayout imageLayout;
-		VkDeviceMemory deviceMemory;
+		vkTools::Allocation allocation;
 		VkImageView view;
 		uint32_t width, height;
 		uint32_t mipLevels;
 	};
 
+	// Handle of an asynchronous texture upload (see VulkanTextureLoader::loadTextureAsync)
+	typedef uint32_t TextureUploadHandle;
+
 	class VulkanTextureLoader
 	{
 	private:
@@ -29,24 +38,179 @@ namespace vkTools
 		VkQueue queue;
 		VkCommandBuffer cmdBuffer;
 		VkCommandPool cmdPool;
-		VkPhysicalDeviceMemoryProperties deviceMemoryProperties;
-
-		// Try to find appropriate memory type for a memory allocation
-		VkBool32 getMemoryType(uint32_t typeBits, VkFlags properties, uint32_t *typeIndex)
+		// Image memory is sub-allocated from the example's allocator
+		vkTools::VulkanMemoryAllocator *allocator;
+
+		// Queue used for asynchronous uploads
+		// Same as the graphics queue if the device has no separate transfer queue
+		VkQueue transferQueue;
+		uint32_t transferQueueFamilyIndex = 0;
+		uint32_t graphicsQueueFamilyIndex = 0;
+		VkCommandPool transferCmdPool = VK_NULL_HANDLE;
+
+		// Resources of an upload that are released once it has finished
+		struct AsyncUpload
 		{
-			for (int i = 0; i < 32; i++) {
-				if ((typeBits & 1) == 1) {
-					if ((deviceMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
-					{
-						*typeIndex = i;
-						return true;
-					}
-				}
-				typeBits >>= 1;
+			VkBuffer stagingBuffer;
+			vkTools::Allocation stagingMemory;
+			// Copy (and queue ownership release) on the transfer queue
+			VkCommandBuffer transferCmdBuffer;
+			// Queue ownership acquire on the graphics queue
+			VkCommandBuffer acquireCmdBuffer = VK_NULL_HANDLE;
+			VkSemaphore semaphore = VK_NULL_HANDLE;
+			// Signaled by the last submission of the upload
+			VkFence fence;
+		};
+		std::map<TextureUploadHandle, AsyncUpload> uploads;
+		TextureUploadHandle nextUploadHandle = 1;
+
+		void releaseUpload(AsyncUpload &upload)
+		{
+			vkDestroyFence(device, upload.fence, nullptr);
+			if (upload.semaphore != VK_NULL_HANDLE)
+			{
+				vkDestroySemaphore(device, upload.semaphore, nullptr);
+			}
+			vkFreeCommandBuffers(device, transferCmdPool, 1, &upload.transferCmdBuffer);
+			if (upload.acquireCmdBuffer != VK_NULL_HANDLE)
+			{
+				vkFreeCommandBuffers(device, cmdPool, 1, &upload.acquireCmdBuffer);
 			}
-			return false;
+			vkDestroyBuffer(device, upload.stagingBuffer, nullptr);
+			allocator->free(upload.stagingMemory);
 		}
+
+		// Layout transition of the first level of a texture image that may also transfer queue family ownership
+		void imageBarrier(
+			VkCommandBuffer cmdBuffer,
+			VkImage image,
+			VkImageLayout oldLayout,
+			VkImageLayout newLayout,
+			VkAccessFlags srcAccessMask,
+			VkAccessFlags dstAccessMask,
+			VkPipelineStageFlags srcStageMask,
+			VkPipelineStageFlags dstStageMask,
+			uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED)
+		{
+			VkImageSubresourceRange subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			imageBarrier(cmdBuffer, image, subresourceRange, oldLayout, newLayout, srcAccessMask, dstAccessMask, srcStageMask, dstStageMask, srcQueueFamilyIndex, dstQueueFamilyIndex);
+		}
+
+		// Layout transition of a range of mip levels and layers of a texture image
+		void imageBarrier(
+			VkCommandBuffer cmdBuffer,
+			VkImage image,
+			VkImageSubresourceRange subresourceRange,
+			VkImageLayout oldLayout,
+			VkImageLayout newLayout,
+			VkAccessFlags srcAccessMask,
+			VkAccessFlags dstAccessMask,
+			VkPipelineStageFlags srcStageMask,
+			VkPipelineStageFlags dstStageMask,
+			uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED)
+		{
+			VkImageMemoryBarrier imageMemoryBarrier = vkTools::initializers::imageMemoryBarrier();
+			imageMemoryBarrier.oldLayout = oldLayout;
+			imageMemoryBarrier.newLayout = newLayout;
+			imageMemoryBarrier.srcAccessMask = srcAccessMask;
+			imageMemoryBarrier.dstAccessMask = dstAccessMask;
+			imageMemoryBarrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+			imageMemoryBarrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+			imageMemoryBarrier.image = image;
+			imageMemoryBarrier.subresourceRange = subresourceRange;
+			vkCmdPipelineBarrier(
+				cmdBuffer,
+				srcStageMask,
+				dstStageMask,
+				VK_FLAGS_NONE,
+				0, nullptr,
+				0, nullptr,
+				1, &imageMemoryBarrier);
+		}
+
 	public:
+		// Number of levels of a full mip chain down to 1x1
+		static uint32_t getMipLevelCount(uint32_t width, uint32_t height)
+		{
+			uint32_t levels = 1;
+			while ((width | height) >> levels)
+			{
+				levels++;
+			}
+			return levels;
+		}
+
+		// Returns true if mip levels of the format can be generated with linear filtered blits
+		// Not supported for block compressed formats, these need to store their mips in the file
+		bool canGenerateMipmaps(VkFormat format)
+		{
+			VkFormatProperties formatProperties;
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+			VkFormatFeatureFlags features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+			return (formatProperties.optimalTilingFeatures & features) == features;
+		}
+
+		// Fill levels 1 to mipLevels - 1 of a 2D image by downsampling each level into the next one
+		// Level 0 needs to be in transfer destination layout, the image needs transfer source and destination usage
+		// All levels are in shader read layout afterwards
+		void generateMipmaps(VkCommandBuffer cmdBuffer, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels)
+		{
+			VkImageSubresourceRange subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			for (uint32_t level = 1; level < mipLevels; level++)
+			{
+				// Wait for the copy or blit into the source level, then read from it
+				subresourceRange.baseMipLevel = level - 1;
+				imageBarrier(
+					cmdBuffer,
+					image,
+					subresourceRange,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					VK_ACCESS_TRANSFER_WRITE_BIT,
+					VK_ACCESS_TRANSFER_READ_BIT,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+				VkImageBlit blit = {};
+				blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
+				blit.srcOffsets[1] = { (int32_t)std::max(width >> (level - 1), 1u), (int32_t)std::max(height >> (level - 1), 1u), 1 };
+				blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+				blit.dstOffsets[1] = { (int32_t)std::max(width >> level, 1u), (int32_t)std::max(height >> level, 1u), 1 };
+				vkCmdBlitImage(cmdBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+			}
+
+			// All but the last level have been read by a blit
+			if (mipLevels > 1)
+			{
+				subresourceRange.baseMipLevel = 0;
+				subresourceRange.levelCount = mipLevels - 1;
+				imageBarrier(
+					cmdBuffer,
+					image,
+					subresourceRange,
+					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					VK_ACCESS_TRANSFER_READ_BIT,
+					VK_ACCESS_SHADER_READ_BIT,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+			}
+			subresourceRange.baseMipLevel = mipLevels - 1;
+			subresourceRange.levelCount = 1;
+			imageBarrier(
+				cmdBuffer,
+				image,
+				subresourceRange,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_ACCESS_SHADER_READ_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		}
+
 		// Load a 2D texture
 		void loadTexture(const char* filename, VkFormat format, VulkanTexture *texture)
 		{
@@ -56,11 +220,12 @@ namespace vkTools
 		// Load a 2D texture
 		void loadTexture(const char* filename, VkFormat format, VulkanTexture *texture, bool forceLinear)
 		{
-			gli::texture2D tex2D(gli::load(filename));
-			assert(!tex2D.empty());
+			// The file is mapped, level data is copied from it straight into the staging buffer
+			TextureFile file(filename);
+			assert(file.isOpen());
 
-			texture->width = (uint32_t)tex2D[0].dimensions().x;
-			texture->height = (uint32_t)tex2D[0].dimensions().y;
+			texture->width = file.getWidth();
+			texture->height = file.getHeight();
 
 			VkResult err;
 
@@ -81,178 +246,137 @@ namespace vkTools
 				useStaging = formatProperties.linearTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
 			}
 
-			VkImageCreateInfo imageCreateInfo = {};
-			imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-			imageCreateInfo.pNext = NULL;
+			VkImageCreateInfo imageCreateInfo = vkTools::initializers::imageCreateInfo();
 			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
 			imageCreateInfo.format = format;
 			imageCreateInfo.extent = { texture->width, texture->height, 1 };
-			imageCreateInfo.mipLevels = 1;
 			imageCreateInfo.arrayLayers = 1;
 			imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-			imageCreateInfo.tiling = VK_IMAGE_TILING_LINEAR;
-			imageCreateInfo.usage = (useStaging) ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : VK_IMAGE_USAGE_SAMPLED_BIT;
 			imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-			imageCreateInfo.flags = 0;
-
-			VkMemoryAllocateInfo memAllocInfo = {};
-			memAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-			memAllocInfo.pNext = NULL;
-			memAllocInfo.allocationSize = 0;
-			memAllocInfo.memoryTypeIndex = 0;
-
-			VkImage mappableImage;
-			VkDeviceMemory mappableMemory;
-
-			// Create base image, if linear texturing is forced
-			// this can directly be used
-			err = vkCreateImage(device, &imageCreateInfo, nullptr, &mappableImage);
-			assert(!err);
-
-			// Get memory requirements for this image 
-			// like size and alignment
-			VkMemoryRequirements memReqs;
-			vkGetImageMemoryRequirements(device, mappableImage, &memReqs);
-			// Set memory allocation size to required memory size
-			memAllocInfo.allocationSize = memReqs.size;
-
-			// Get memory type that can be mapped to host memory
-			getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &memAllocInfo.memoryTypeIndex);
-
-			// Allocate host memory
-			err = vkAllocateMemory(device, &memAllocInfo, nullptr, &(mappableMemory));
-			assert(!err);
-
-			// Bind allocated image for use
-			err = vkBindImageMemory(device, mappableImage, mappableMemory, 0);
-			assert(!err);
-
-			// Get sub resource layout
-			// Mip map count, array layer, etc.
-			VkImageSubresource subRes = {};
-			subRes.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			subRes.mipLevel = 0;
-			subRes.arrayLayer = 0;
-
-			VkSubresourceLayout subResLayout;
-			void *data;
-
-			// Get sub resources layout 
-			// Includes row pitch, size offsets, etc.
-			vkGetImageSubresourceLayout(device, mappableImage, &subRes, &subResLayout);
-
-			// Map image memory
-			err = vkMapMemory(device, mappableMemory, 0, memReqs.size, 0, &data);
-			assert(!err);
-
-			// Copy image data into memory
-			memcpy(data, tex2D[subRes.mipLevel].data(), tex2D[subRes.mipLevel].size());
-
-			vkUnmapMemory(device, mappableMemory);
 
 			if (useStaging)
 			{
-				VkCommandBufferBeginInfo cmdBufInfo = {};
-				cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-				cmdBufInfo.pNext = NULL;
+				// Use the mip levels stored in the file, if there are none 
+				// generate them on the GPU (if the format can be blitted)
+				bool generateMips = (file.getLevels() == 1) && canGenerateMipmaps(format);
+				texture->mipLevels = generateMips ? getMipLevelCount(texture->width, texture->height) : file.getLevels();
+
+				// Staging buffer with all levels of the file
+				std::vector<VkBufferImageCopy> copyRegions(file.getLevels());
+				VkDeviceSize stagingSize = 0;
+				for (uint32_t level = 0; level < file.getLevels(); level++)
+				{
+					copyRegions[level] = {};
+					copyRegions[level].bufferOffset = stagingSize;
+					copyRegions[level].imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+					copyRegions[level].imageExtent = { file.getWidth(level), file.getHeight(level), 1 };
+					// Keep offsets aligned to the texel block size
+					stagingSize += (file.getSize(level) + 15) & ~(VkDeviceSize)15;
+				}
 
-				err = vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo);
+				VkBuffer stagingBuffer;
+				VkBufferCreateInfo bufferCreateInfo = vkTools::initializers::bufferCreateInfo(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingSize);
+				err = vkCreateBuffer(device, &bufferCreateInfo, nullptr, &stagingBuffer);
 				assert(!err);
+				vkTools::Allocation stagingMemory = allocator->allocateBuffer(stagingBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+				for (uint32_t level = 0; level < file.getLevels(); level++)
+				{
+					memcpy((uint8_t*)stagingMemory.mapped + copyRegions[level].bufferOffset, file.getData(level), file.getSize(level));
+				}
 
-				// Setup texture as blit target with optimal tiling
+				// Setup texture as copy (and blit) target with optimal tiling
+				imageCreateInfo.mipLevels = texture->mipLevels;
 				imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 				imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+				if (generateMips)
+				{
+					// Each level is the blit source for the next one
+					imageCreateInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+				}
 
 				err = vkCreateImage(device, &imageCreateInfo, nullptr, &texture->image);
 				assert(!err);
 
-				vkGetImageMemoryRequirements(device, texture->image, &memReqs);
-
-				memAllocInfo.allocationSize = memReqs.size;
-
-				// Get device only memory type 
-				getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAllocInfo.memoryTypeIndex);
-
-				// Allocate device memory
-				err = vkAllocateMemory(device, &memAllocInfo, nullptr, &texture->deviceMemory);
-				assert(!err);
+				// Allocate device only memory and bind it to the image
+				texture->allocation = allocator->allocateImage(texture->image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-				// Bind allocated image for use
-				err = vkBindImageMemory(device, texture->image, texture->deviceMemory, 0);
+				VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
+				err = vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo);
 				assert(!err);
 
-				// Image barrier for linear image (base)
-				// Linear image will be used as a source for the blit
-				setImageLayout(cmdBuffer, 
-					mappableImage,
-					VK_IMAGE_ASPECT_COLOR_BIT,
-					VK_IMAGE_LAYOUT_UNDEFINED,
-					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-
-				// Image barrier for optimal image (target)
-				// Optimal image will be used as a target for the blit
-				setImageLayout(cmdBuffer,
+				VkImageSubresourceRange subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, texture->mipLevels, 0, 1 };
+				imageBarrier(
+					cmdBuffer,
 					texture->image,
-					VK_IMAGE_ASPECT_COLOR_BIT,
+					subresourceRange,
 					VK_IMAGE_LAYOUT_UNDEFINED,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-				// Copy region for image blit
-				VkImageCopy copyRegion = {};
-
-				copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				copyRegion.srcSubresource.baseArrayLayer = 0;
-				copyRegion.srcSubresource.mipLevel = 0;
-				copyRegion.srcSubresource.layerCount = 1;
-				copyRegion.srcOffset = { 0, 0, 0 };
-
-				copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				copyRegion.dstSubresource.baseArrayLayer = 0;
-				copyRegion.dstSubresource.mipLevel = 0;
-				copyRegion.dstSubresource.layerCount = 1;
-				copyRegion.dstOffset = { 0, 0, 0 };
-
-				copyRegion.extent.width = texture->width;
-				copyRegion.extent.height = texture->height;
-				copyRegion.extent.depth = 1;
-
-				// Put image copy into command buffer
-				vkCmdCopyImage(cmdBuffer,
-					mappableImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-					texture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					1, &copyRegion);
-
-				// Change texture image layout to shader read after the copy
-				texture->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				setImageLayout(cmdBuffer,
-					texture->image,
-					VK_IMAGE_ASPECT_COLOR_BIT,
 					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					texture->imageLayout);
+					0,
+					VK_ACCESS_TRANSFER_WRITE_BIT,
+					VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+					VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+				vkCmdCopyBufferToImage(cmdBuffer, stagingBuffer, texture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)copyRegions.size(), copyRegions.data());
+
+				// Change texture image layout to shader read after the copy (or the last blit)
+				texture->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				if (generateMips)
+				{
+					generateMipmaps(cmdBuffer, texture->image, texture->width, texture->height, texture->mipLevels);
+				}
+				else
+				{
+					imageBarrier(
+						cmdBuffer,
+						texture->image,
+						subresourceRange,
+						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						texture->imageLayout,
+						VK_ACCESS_TRANSFER_WRITE_BIT,
+						VK_ACCESS_SHADER_READ_BIT,
+						VK_PIPELINE_STAGE_TRANSFER_BIT,
+						VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+				}
 
 				err = vkEndCommandBuffer(cmdBuffer);
 				assert(!err);
 
-				VkFence nullFence = { VK_NULL_HANDLE };
-
 				VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-				submitInfo.waitSemaphoreCount = 0;
 				submitInfo.commandBufferCount = 1;
 				submitInfo.pCommandBuffers = &cmdBuffer;
 
-				err = vkQueueSubmit(queue, 1, &submitInfo, nullFence);
+				err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
 				assert(!err);
 
 				err = vkQueueWaitIdle(queue);
 				assert(!err);
+
+				vkDestroyBuffer(device, stagingBuffer, nullptr);
+				allocator->free(stagingMemory);
 			}
 			else
 			{
 				// Linear tiled images don't need to be staged
 				// and can be directly used as textures
+				// Linear tiling usually won't support mip maps, so only the first level is used
+				texture->mipLevels = 1;
+				imageCreateInfo.mipLevels = 1;
+				imageCreateInfo.tiling = VK_IMAGE_TILING_LINEAR;
+				imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+
+				VkImage mappableImage;
+				vkTools::Allocation mappableMemory;
+				err = vkCreateImage(device, &imageCreateInfo, nullptr, &mappableImage);
+				assert(!err);
+
+				// Allocate memory that is mapped to host memory and bind it to the image
+				mappableMemory = allocator->allocateImage(mappableImage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_IMAGE_TILING_LINEAR);
+
+				// Copy image data into the (persistently mapped) image memory
+				memcpy(mappableMemory.mapped, file.getData(0), file.getSize(0));
 
 				texture->image = mappableImage;
-				texture->deviceMemory = mappableMemory;
+				texture->allocation = mappableMemory;
 				texture->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
 				// Setup image memory barrier
@@ -282,7 +406,8 @@ namespace vkTools
 			sampler.maxAnisotropy = 0;
 			sampler.compareOp = VK_COMPARE_OP_NEVER;
 			sampler.minLod = 0.0f;
-			sampler.maxLod = 0.0f;
+			// Max level-of-detail should match mip level count
+			sampler.maxLod = (float)texture->mipLevels;
 			sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
 			err = vkCreateSampler(device, &sampler, nullptr, &texture->sampler);
 			assert(!err);
@@ -298,34 +423,272 @@ namespace vkTools
 			view.viewType = VK_IMAGE_VIEW_TYPE_2D;
 			view.format = format;
 			view.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
+			view.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, texture->mipLevels, 0, 1 };
+			view.image = texture->image;
+			err = vkCreateImageView(device, &view, nullptr, &texture->view);
+			assert(!err);
+		}
+
+		// Load a 2D texture without waiting for the upload to finish
+		// The image is copied from a staging buffer on the transfer queue, and if that
+		// belongs to a different queue family, ownership is handed over to the graphics queue
+		// Image view and sampler are created right away, so descriptors can be written
+		// before the upload has finished. Command buffers that sample the texture can be submitted
+		// at any time, the GPU then waits for the upload (poll with isUploadComplete to avoid that)
+		TextureUploadHandle loadTextureAsync(const char* filename, VkFormat format, VulkanTexture *texture)
+		{
+			assert(transferCmdPool != VK_NULL_HANDLE);
+
+			TextureFile file(filename);
+			assert(file.isOpen());
+
+			texture->width = file.getWidth();
+			texture->height = file.getHeight();
+			texture->mipLevels = 1;
+
+			VkResult err;
+			AsyncUpload upload;
+
+			// Staging buffer with the image data of the first mip level
+			VkDeviceSize dataSize = file.getSize(0);
+			VkBufferCreateInfo bufferCreateInfo = vkTools::initializers::bufferCreateInfo(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, dataSize);
+			err = vkCreateBuffer(device, &bufferCreateInfo, nullptr, &upload.stagingBuffer);
+			assert(!err);
+			upload.stagingMemory = allocator->allocateBuffer(upload.stagingBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			memcpy(upload.stagingMemory.mapped, file.getData(0), (size_t)dataSize);
+
+			VkImageCreateInfo imageCreateInfo = vkTools::initializers::imageCreateInfo();
+			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageCreateInfo.format = format;
+			imageCreateInfo.extent = { texture->width, texture->height, 1 };
+			imageCreateInfo.mipLevels = 1;
+			imageCreateInfo.arrayLayers = 1;
+			imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			err = vkCreateImage(device, &imageCreateInfo, nullptr, &texture->image);
+			assert(!err);
+			texture->allocation = allocator->allocateImage(texture->image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			texture->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			bool ownershipTransfer = (transferQueueFamilyIndex != graphicsQueueFamilyIndex);
+
+			VkCommandBufferAllocateInfo cmdBufAllocateInfo = vkTools::initializers::commandBufferAllocateInfo(transferCmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+			err = vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &upload.transferCmdBuffer);
+			assert(!err);
+
+			VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
+			cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			err = vkBeginCommandBuffer(upload.transferCmdBuffer, &cmdBufInfo);
+			assert(!err);
+
+			imageBarrier(
+				upload.transferCmdBuffer,
+				texture->image,
+				VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				0,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+			VkBufferImageCopy copyRegion = {};
+			copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copyRegion.imageSubresource.mipLevel = 0;
+			copyRegion.imageSubresource.baseArrayLayer = 0;
+			copyRegion.imageSubresource.layerCount = 1;
+			copyRegion.imageExtent = { texture->width, texture->height, 1 };
+			vkCmdCopyBufferToImage(upload.transferCmdBuffer, upload.stagingBuffer, texture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+
+			if (ownershipTransfer)
+			{
+				// Release the image from the transfer queue family
+				// The matching acquire is done on the graphics queue
+				imageBarrier(
+					upload.transferCmdBuffer,
+					texture->image,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					texture->imageLayout,
+					VK_ACCESS_TRANSFER_WRITE_BIT,
+					0,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+					transferQueueFamilyIndex,
+					graphicsQueueFamilyIndex);
+			}
+			else
+			{
+				imageBarrier(
+					upload.transferCmdBuffer,
+					texture->image,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					texture->imageLayout,
+					VK_ACCESS_TRANSFER_WRITE_BIT,
+					VK_ACCESS_SHADER_READ_BIT,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+			}
+
+			err = vkEndCommandBuffer(upload.transferCmdBuffer);
+			assert(!err);
+
+			VkFenceCreateInfo fenceCreateInfo = vkTools::initializers::fenceCreateInfo(VK_FLAGS_NONE);
+			err = vkCreateFence(device, &fenceCreateInfo, nullptr, &upload.fence);
+			assert(!err);
+
+			VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &upload.transferCmdBuffer;
+
+			if (ownershipTransfer)
+			{
+				VkSemaphoreCreateInfo semaphoreCreateInfo = vkTools::initializers::semaphoreCreateInfo(VK_FLAGS_NONE);
+				err = vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &upload.semaphore);
+				assert(!err);
+
+				submitInfo.signalSemaphoreCount = 1;
+				submitInfo.pSignalSemaphores = &upload.semaphore;
+				err = vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE);
+				assert(!err);
+
+				// Acquire the image on the graphics queue once the copy is done
+				cmdBufAllocateInfo.commandPool = cmdPool;
+				err = vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &upload.acquireCmdBuffer);
+				assert(!err);
+				err = vkBeginCommandBuffer(upload.acquireCmdBuffer, &cmdBufInfo);
+				assert(!err);
+				imageBarrier(
+					upload.acquireCmdBuffer,
+					texture->image,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					texture->imageLayout,
+					0,
+					VK_ACCESS_SHADER_READ_BIT,
+					VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+					VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+					transferQueueFamilyIndex,
+					graphicsQueueFamilyIndex);
+				err = vkEndCommandBuffer(upload.acquireCmdBuffer);
+				assert(!err);
+
+				VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+				submitInfo = vkTools::initializers::submitInfo();
+				submitInfo.waitSemaphoreCount = 1;
+				submitInfo.pWaitSemaphores = &upload.semaphore;
+				submitInfo.pWaitDstStageMask = &waitStageMask;
+				submitInfo.commandBufferCount = 1;
+				submitInfo.pCommandBuffers = &upload.acquireCmdBuffer;
+				err = vkQueueSubmit(queue, 1, &submitInfo, upload.fence);
+				assert(!err);
+			}
+			else
+			{
+				err = vkQueueSubmit(transferQueue, 1, &submitInfo, upload.fence);
+				assert(!err);
+			}
+
+			// Sampler and view don't depend on the image contents
+			VkSamplerCreateInfo sampler = vkTools::initializers::samplerCreateInfo();
+			sampler.magFilter = VK_FILTER_LINEAR;
+			sampler.minFilter = VK_FILTER_LINEAR;
+			sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+			sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			sampler.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			sampler.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			sampler.mipLodBias = 0.0f;
+			sampler.maxAnisotropy = 0;
+			sampler.compareOp = VK_COMPARE_OP_NEVER;
+			sampler.minLod = 0.0f;
+			sampler.maxLod = 0.0f;
+			sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+			err = vkCreateSampler(device, &sampler, nullptr, &texture->sampler);
+			assert(!err);
+
+			VkImageViewCreateInfo view = vkTools::initializers::imageViewCreateInfo();
+			view.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			view.format = format;
+			view.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
 			view.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
 			view.image = texture->image;
 			err = vkCreateImageView(device, &view, nullptr, &texture->view);
 			assert(!err);
 
-			if (useStaging)
+			TextureUploadHandle handle = nextUploadHandle++;
+			uploads[handle] = upload;
+			return handle;
+		}
+
+		// Returns true once the upload has finished (doesn't block)
+		// Staging resources of the upload are released on the first call that returns true
+		bool isUploadComplete(TextureUploadHandle handle)
+		{
+			auto upload = uploads.find(handle);
+			if (upload == uploads.end())
+			{
+				return true;
+			}
+			if (vkGetFenceStatus(device, upload->second.fence) != VK_SUCCESS)
+			{
+				return false;
+			}
+			releaseUpload(upload->second);
+			uploads.erase(upload);
+			return true;
+		}
+
+		// Release staging resources of all finished uploads
+		// Called by the example base class once per frame
+		void pollUploads()
+		{
+			for (auto upload = uploads.begin(); upload != uploads.end();)
 			{
-				vkDestroyImage(device, mappableImage, nullptr);
-				vkFreeMemory(device, mappableMemory, nullptr);
+				if (vkGetFenceStatus(device, upload->second.fence) == VK_SUCCESS)
+				{
+					releaseUpload(upload->second);
+					upload = uploads.erase(upload);
+				}
+				else
+				{
+					++upload;
+				}
 			}
 		}
 
+		// Number of uploads that haven't been found finished yet
+		uint32_t pendingUploads()
+		{
+			return (uint32_t)uploads.size();
+		}
+
+		// Block until all uploads have finished
+		void waitForUploads()
+		{
+			for (auto& upload : uploads)
+			{
+				VkResult err = vkWaitForFences(device, 1, &upload.second.fence, VK_TRUE, UINT64_MAX);
+				assert(!err);
+				releaseUpload(upload.second);
+			}
+			uploads.clear();
+		}
+
 		// Clean up vulkan resources used by a texture object
 		void destroyTexture(VulkanTexture texture)
 		{
 			vkDestroyImageView(device, texture.view, nullptr);
 			vkDestroyImage(device, texture.image, nullptr);
 			vkDestroySampler(device, texture.sampler, nullptr);
-			vkFreeMemory(device, texture.deviceMemory, nullptr);
+			texture.allocation.free();
 		}
 
-		VulkanTextureLoader(VkPhysicalDevice physicalDevice, VkDevice device, VkQueue queue, VkCommandPool cmdPool)
+		VulkanTextureLoader(VkPhysicalDevice physicalDevice, VkDevice device, VkQueue queue, VkCommandPool cmdPool, vkTools::VulkanMemoryAllocator *allocator)
 		{
 			this->physicalDevice = physicalDevice;
 			this->device = device;
 			this->queue = queue;
 			this->cmdPool = cmdPool;
-			vkGetPhysicalDeviceMemoryProperties(physicalDevice, &deviceMemoryProperties);
+			this->allocator = allocator;
 
 			// Create command buffer for submitting image barriers
 			// and converting tilings
@@ -341,156 +704,127 @@ namespace vkTools
 
 		~VulkanTextureLoader()
 		{
+			waitForUploads();
+			if (transferCmdPool != VK_NULL_HANDLE)
+			{
+				vkDestroyCommandPool(device, transferCmdPool, nullptr);
+			}
 			vkFreeCommandBuffers(device, cmdPool, 1, &cmdBuffer);
 		}
 
+		// Set the queue used for asynchronous uploads (required before calling loadTextureAsync)
+		// If it belongs to a different family than the graphics queue,
+		// ownership of uploaded images is transferred to the graphics queue family
+		void setTransferQueue(VkQueue transferQueue, uint32_t transferQueueFamilyIndex, uint32_t graphicsQueueFamilyIndex)
+		{
+			waitForUploads();
+			if (transferCmdPool != VK_NULL_HANDLE)
+			{
+				vkDestroyCommandPool(device, transferCmdPool, nullptr);
+			}
+
+			this->transferQueue = transferQueue;
+			this->transferQueueFamilyIndex = transferQueueFamilyIndex;
+			this->graphicsQueueFamilyIndex = graphicsQueueFamilyIndex;
+
+			VkCommandPoolCreateInfo cmdPoolInfo = {};
+			cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			cmdPoolInfo.queueFamilyIndex = transferQueueFamilyIndex;
+			cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			VkResult err = vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &transferCmdPool);
+			assert(!err);
+		}
+
 		// Load a cubemap texture (single file)
 		void loadCubemap(const char* filename, VkFormat format, VulkanTexture *texture)
 		{
-			VkFormatProperties formatProperties;
 			VkResult err;
 
-			gli::textureCube texCube(gli::load(filename));
-			assert(!texCube.empty());
+			TextureFile file(filename);
+			assert(file.isOpen() && (file.getFaces() == 6));
 
-			texture->width = (uint32_t)texCube[0].dimensions().x;
-			texture->height = (uint32_t)texCube[0].dimensions().y;
+			texture->width = file.getWidth();
+			texture->height = file.getHeight();
+			texture->mipLevels = file.getLevels();
 
-			// Get device properites for the requested texture format
-			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+			// Staging buffer with all levels of all faces
+			std::vector<VkBufferImageCopy> copyRegions;
+			VkDeviceSize stagingSize = 0;
+			for (uint32_t face = 0; face < 6; face++)
+			{
+				for (uint32_t level = 0; level < texture->mipLevels; level++)
+				{
+					VkBufferImageCopy copyRegion = {};
+					copyRegion.bufferOffset = stagingSize;
+					copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, face, 1 };
+					copyRegion.imageExtent = { file.getWidth(level), file.getHeight(level), 1 };
+					copyRegions.push_back(copyRegion);
+					// Keep offsets aligned to the texel block size
+					stagingSize += (file.getSize(level) + 15) & ~(VkDeviceSize)15;
+				}
+			}
+
+			VkBuffer stagingBuffer;
+			VkBufferCreateInfo bufferCreateInfo = vkTools::initializers::bufferCreateInfo(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingSize);
+			err = vkCreateBuffer(device, &bufferCreateInfo, nullptr, &stagingBuffer);
+			assert(!err);
+			vkTools::Allocation stagingMemory = allocator->allocateBuffer(stagingBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			for (auto& copyRegion : copyRegions)
+			{
+				const uint32_t face = copyRegion.imageSubresource.baseArrayLayer;
+				const uint32_t level = copyRegion.imageSubresource.mipLevel;
+				memcpy((uint8_t*)stagingMemory.mapped + copyRegion.bufferOffset, file.getData(level, 0, face), file.getSize(level));
+			}
 
+			// Setup texture as copy target with optimal tiling
 			VkImageCreateInfo imageCreateInfo = vkTools::initializers::imageCreateInfo();
 			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
 			imageCreateInfo.format = format;
 			imageCreateInfo.extent = { texture->width, texture->height, 1 };
-			imageCreateInfo.mipLevels = 1;
-			imageCreateInfo.arrayLayers = 1;
+			imageCreateInfo.mipLevels = texture->mipLevels;
 			imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-			imageCreateInfo.tiling = VK_IMAGE_TILING_LINEAR;
-			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-			imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-			imageCreateInfo.flags = 0;
-
-			VkMemoryAllocateInfo memAllocInfo = vkTools::initializers::memoryAllocateInfo();
-			VkMemoryRequirements memReqs;
-
-			struct {
-				VkImage image;
-				VkDeviceMemory memory;
-			} cubeFace[6];
-
-			VkCommandBufferBeginInfo cmdBufInfo = {};
-			cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			cmdBufInfo.pNext = NULL;
-
-			err = vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo);
-			assert(!err);
-
-			// Load separate cube map faces into linear tiled textures
-			for (uint32_t face = 0; face < 6; ++face)
-			{
-				err = vkCreateImage(device, &imageCreateInfo, nullptr, &cubeFace[face].image);
-				assert(!err);
-
-				vkGetImageMemoryRequirements(device, cubeFace[face].image, &memReqs);
-				memAllocInfo.allocationSize = memReqs.size;
-				getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &memAllocInfo.memoryTypeIndex);
-				err = vkAllocateMemory(device, &memAllocInfo, nullptr, &cubeFace[face].memory);
-				assert(!err);
-				err = vkBindImageMemory(device, cubeFace[face].image, cubeFace[face].memory, 0);
-				assert(!err);
-
-				VkImageSubresource subRes = {};
-				subRes.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-
-				VkSubresourceLayout subResLayout;
-				void *data;
-
-				vkGetImageSubresourceLayout(device, cubeFace[face].image, &subRes, &subResLayout);
-				assert(!err);
-				err = vkMapMemory(device, cubeFace[face].memory, 0, memReqs.size, 0, &data);
-				assert(!err);
-				memcpy(data, texCube[face][subRes.mipLevel].data(), texCube[face][subRes.mipLevel].size());
-				vkUnmapMemory(device, cubeFace[face].memory);
-
-				// Image barrier for linear image (base)
-				// Linear image will be used as a source for the copy
-				setImageLayout(
-					cmdBuffer,
-					cubeFace[face].image,
-					VK_IMAGE_ASPECT_COLOR_BIT,
-					VK_IMAGE_LAYOUT_UNDEFINED,
-					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-			}
-
-			// Transfer cube map faces to optimal tiling
-
-			// Setup texture as blit target with optimal tiling
 			imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 			imageCreateInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
 			imageCreateInfo.arrayLayers = 6;
 
 			err = vkCreateImage(device, &imageCreateInfo, nullptr, &texture->image);
 			assert(!err);
 
-			vkGetImageMemoryRequirements(device, texture->image, &memReqs);
+			texture->allocation = allocator->allocateImage(texture->image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-			memAllocInfo.allocationSize = memReqs.size;
-
-			getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAllocInfo.memoryTypeIndex);
-			err = vkAllocateMemory(device, &memAllocInfo, nullptr, &texture->deviceMemory);
-			assert(!err);
-			err = vkBindImageMemory(device, texture->image, texture->deviceMemory, 0);
+			VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
+			err = vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo);
 			assert(!err);
 
-			// Image barrier for optimal image (target)
-			// Optimal image will be used as destination for the copy
-			setImageLayout(
+			// All faces and levels are transitioned at once
+			VkImageSubresourceRange subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, texture->mipLevels, 0, 6 };
+			imageBarrier(
 				cmdBuffer,
 				texture->image,
-				VK_IMAGE_ASPECT_COLOR_BIT,
+				subresourceRange,
 				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				0,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-			// Copy cube map faces one by one
-			for (uint32_t face = 0; face < 6; ++face)
-			{
-				// Copy region for image blit
-				VkImageCopy copyRegion = {};
-
-				copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				copyRegion.srcSubresource.baseArrayLayer = 0;
-				copyRegion.srcSubresource.mipLevel = 0;
-				copyRegion.srcSubresource.layerCount = 1;
-				copyRegion.srcOffset = { 0, 0, 0 };
-
-				copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				copyRegion.dstSubresource.baseArrayLayer = face;
-				copyRegion.dstSubresource.mipLevel = 0;
-				copyRegion.dstSubresource.layerCount = 1;
-				copyRegion.dstOffset = { 0, 0, 0 };
-
-				copyRegion.extent.width = texture->width;
-				copyRegion.extent.height = texture->height;
-				copyRegion.extent.depth = 1;
-
-				// Put image copy into command buffer
-				vkCmdCopyImage(
-					cmdBuffer,
-					cubeFace[face].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-					texture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					1, &copyRegion);
+			vkCmdCopyBufferToImage(cmdBuffer, stagingBuffer, texture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)copyRegions.size(), copyRegions.data());
 
-				// Change texture image layout to shader read after the copy
-				texture->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				setImageLayout(
-					cmdBuffer,
-					texture->image,
-					VK_IMAGE_ASPECT_COLOR_BIT,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					texture->imageLayout);
-			}
+			// Change texture image layout to shader read after the copy
+			texture->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			imageBarrier(
+				cmdBuffer,
+				texture->image,
+				subresourceRange,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				texture->imageLayout,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_ACCESS_SHADER_READ_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 
 			err = vkEndCommandBuffer(cmdBuffer);
 			assert(!err);
@@ -520,7 +854,7 @@ namespace vkTools
 			sampler.maxAnisotropy = 8;
 			sampler.compareOp = VK_COMPARE_OP_NEVER;
 			sampler.minLod = 0.0f;
-			sampler.maxLod = 0.0f;
+			sampler.maxLod = (float)texture->mipLevels;
 			sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
 			err = vkCreateSampler(device, &sampler, nullptr, &texture->sampler);
 			assert(!err);
@@ -532,17 +866,15 @@ namespace vkTools
 			view.format = format;
 			view.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
 			view.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			view.subresourceRange.levelCount = texture->mipLevels;
 			view.subresourceRange.layerCount = 6;
 			view.image = texture->image;
 			err = vkCreateImageView(device, &view, nullptr, &texture->view);
 			assert(!err);
 
 			// Cleanup
-			for (auto& face : cubeFace)
-			{
-				vkDestroyImage(device, face.image, nullptr);
-				vkFreeMemory(device, face.memory, nullptr);
-			}
+			vkDestroyBuffer(device, stagingBuffer, nullptr);
+			allocator->free(stagingMemory);
 		}
 
 
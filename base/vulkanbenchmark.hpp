@@ -0,0 +1,223 @@
+/*
+* Frame time benchmark
+*
+* Collects per-frame timings over a fixed number of frames
+* and writes statistics to a JSON and a CSV file
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <math.h>
+
+namespace vkTools
+{
+
+	class VulkanBenchmark
+	{
+	public:
+		// Timings of a single frame (in milliseconds)
+		struct FrameSample
+		{
+			// CPU time spent in the example's render function
+			double cpuTime = 0.0;
+			// Time spent waiting for a free frame slot and acquiring the swap chain image
+			double acquireTime = 0.0;
+			// Time between the first and the last command executed on the GPU
+			// Negative if not available (e.g. no timestamp support)
+			double gpuTime = -1.0;
+		};
+
+		struct Statistics
+		{
+			double min = 0.0;
+			double avg = 0.0;
+			double p50 = 0.0;
+			double p95 = 0.0;
+			double p99 = 0.0;
+			double max = 0.0;
+		};
+
+		// Set by the "-benchmark" command line argument
+		bool active = false;
+		// Number of frames to measure
+		uint32_t frameCount = 0;
+		// Number of frames rendered (and discarded) before measuring
+		uint32_t warmupCount = 0;
+		// Fixed time step (in seconds) passed to the example instead of the measured frame time
+		// Makes animations (and thus the rendered frames) deterministic
+		float timeStep = 1.0f / 60.0f;
+		// Base file name of the report (without extension)
+		std::string filename;
+		// Time from creating the example to the first frame (in milliseconds)
+		double startupTime = 0.0;
+		// True if the pipeline cache was initialized from a file
+		bool pipelineCacheWarm = false;
+
+		std::vector<FrameSample> samples;
+
+		void setup(uint32_t frameCount, uint32_t warmupCount)
+		{
+			active = true;
+			this->frameCount = frameCount;
+			this->warmupCount = warmupCount;
+			samples.resize(frameCount);
+		}
+
+		// Returns true once all warmup and benchmark frames have been rendered
+		bool finished(uint32_t renderedFrames)
+		{
+			return renderedFrames >= warmupCount + frameCount;
+		}
+
+		// Store CPU timings for the given frame number
+		// Warmup frames are discarded
+		void setCpuTimes(uint32_t frameNumber, double cpuTime, double acquireTime)
+		{
+			FrameSample *sample = getSample(frameNumber);
+			if (sample)
+			{
+				sample->cpuTime = cpuTime;
+				sample->acquireTime = acquireTime;
+			}
+		}
+
+		// GPU timings are only available once the frame has finished
+		// so they are stored separately
+		void setGpuTime(uint32_t frameNumber, double gpuTime)
+		{
+			FrameSample *sample = getSample(frameNumber);
+			if (sample)
+			{
+				sample->gpuTime = gpuTime;
+			}
+		}
+
+		// Calculate min/avg/max and percentiles (nearest rank) for a list of values
+		static Statistics getStatistics(std::vector<double> values)
+		{
+			Statistics stats;
+			if (values.empty())
+			{
+				return stats;
+			}
+			std::sort(values.begin(), values.end());
+			double sum = 0.0;
+			for (auto& value : values)
+			{
+				sum += value;
+			}
+			stats.min = values.front();
+			stats.max = values.back();
+			stats.avg = sum / values.size();
+			stats.p50 = getPercentile(values, 50.0);
+			stats.p95 = getPercentile(values, 95.0);
+			stats.p99 = getPercentile(values, 99.0);
+			return stats;
+		}
+
+		// Write statistics to <filename>.json and per-frame timings to <filename>.csv
+		void saveReport(std::string exampleName, std::string deviceName, uint32_t width, uint32_t height)
+		{
+			std::vector<double> cpuTimes, acquireTimes, gpuTimes;
+			for (auto& sample : samples)
+			{
+				cpuTimes.push_back(sample.cpuTime);
+				acquireTimes.push_back(sample.acquireTime);
+				if (sample.gpuTime >= 0.0)
+				{
+					gpuTimes.push_back(sample.gpuTime);
+				}
+			}
+
+			Statistics cpuStats = getStatistics(cpuTimes);
+			Statistics acquireStats = getStatistics(acquireTimes);
+			Statistics gpuStats = getStatistics(gpuTimes);
+
+			std::ofstream json(filename + ".json");
+			json << std::fixed << std::setprecision(4);
+			json << "{\n";
+			json << "\t\"example\": \"" << exampleName << "\",\n";
+			json << "\t\"device\": \"" << deviceName << "\",\n";
+			json << "\t\"width\": " << width << ",\n";
+			json << "\t\"height\": " << height << ",\n";
+			json << "\t\"frames\": " << frameCount << ",\n";
+			json << "\t\"warmup\": " << warmupCount << ",\n";
+			json << "\t\"timestep\": " << timeStep << ",\n";
+			json << "\t\"startup_ms\": " << startupTime << ",\n";
+			json << "\t\"pipeline_cache\": \"" << (pipelineCacheWarm ? "warm" : "cold") << "\",\n";
+			writeStatistics(json, "cpu_ms", cpuStats, true);
+			writeStatistics(json, "acquire_ms", acquireStats, true);
+			if (!gpuTimes.empty())
+			{
+				writeStatistics(json, "gpu_ms", gpuStats, false);
+			}
+			else
+			{
+				json << "\t\"gpu_ms\": null\n";
+			}
+			json << "}\n";
+			json.close();
+
+			std::ofstream csv(filename + ".csv");
+			csv << std::fixed << std::setprecision(4);
+			csv << "frame,cpu_ms,acquire_ms,gpu_ms\n";
+			for (size_t i = 0; i < samples.size(); i++)
+			{
+				csv << i << "," << samples[i].cpuTime << "," << samples[i].acquireTime << ",";
+				if (samples[i].gpuTime >= 0.0)
+				{
+					csv << samples[i].gpuTime;
+				}
+				csv << "\n";
+			}
+			csv.close();
+
+			std::cout << std::fixed << std::setprecision(3);
+			std::cout << "Benchmark (" << frameCount << " frames) : " << exampleName << " on " << deviceName << "\n";
+			std::cout << "  cpu avg " << cpuStats.avg << " ms, p99 " << cpuStats.p99 << " ms\n";
+			std::cout << "  acquire avg " << acquireStats.avg << " ms, p99 " << acquireStats.p99 << " ms\n";
+			if (!gpuTimes.empty())
+			{
+				std::cout << "  gpu avg " << gpuStats.avg << " ms, p99 " << gpuStats.p99 << " ms\n";
+			}
+			std::cout << "Results written to " << filename << ".json/.csv\n";
+		}
+
+	private:
+		FrameSample *getSample(uint32_t frameNumber)
+		{
+			if ((frameNumber < warmupCount) || (frameNumber >= warmupCount + frameCount))
+			{
+				return nullptr;
+			}
+			return &samples[frameNumber - warmupCount];
+		}
+
+		// Values must be sorted
+		static double getPercentile(const std::vector<double> &values, double percentile)
+		{
+			size_t rank = (size_t)ceil(percentile / 100.0 * values.size());
+			rank = std::max(rank, (size_t)1);
+			return values[std::min(rank, values.size()) - 1];
+		}
+
+		static void writeStatistics(std::ofstream &stream, std::string name, Statistics &stats, bool separator)
+		{
+			stream << "\t\"" << name << "\": { ";
+			stream << "\"min\": " << stats.min << ", ";
+			stream << "\"avg\": " << stats.avg << ", ";
+			stream << "\"p50\": " << stats.p50 << ", ";
+			stream << "\"p95\": " << stats.p95 << ", ";
+			stream << "\"p99\": " << stats.p99 << ", ";
+			stream << "\"max\": " << stats.max << " }";
+			stream << (separator ? ",\n" : "\n");
+		}
+	};
+
+}
@@ -0,0 +1,212 @@
+/*
+* Bounding volumes
+*
+* Axis aligned bounding boxes, bounding spheres, view frusta and rays
+* with the intersection tests used for culling and picking
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+
+#include <glm/glm.hpp>
+
+namespace vkMeshLoader
+{
+
+	struct BoundingBox
+	{
+		glm::vec3 min = glm::vec3(FLT_MAX);
+		glm::vec3 max = glm::vec3(-FLT_MAX);
+
+		BoundingBox() {}
+		BoundingBox(const glm::vec3 &min, const glm::vec3 &max) : min(min), max(max) {}
+
+		void expand(const glm::vec3 &p)
+		{
+			min = glm::min(min, p);
+			max = glm::max(max, p);
+		}
+
+		void expand(const BoundingBox &box)
+		{
+			min = glm::min(min, box.min);
+			max = glm::max(max, box.max);
+		}
+
+		// False for an empty box (nothing added yet)
+		bool valid() const
+		{
+			return (min.x <= max.x) && (min.y <= max.y) && (min.z <= max.z);
+		}
+
+		glm::vec3 center() const
+		{
+			return (min + max) * 0.5f;
+		}
+
+		glm::vec3 size() const
+		{
+			return max - min;
+		}
+
+		float surfaceArea() const
+		{
+			glm::vec3 s = max - min;
+			return 2.0f * (s.x * s.y + s.y * s.z + s.z * s.x);
+		}
+
+		// Bounds of the box transformed by matrix (e.g. into light space for a shadow frustum)
+		BoundingBox transform(const glm::mat4 &matrix) const
+		{
+			// Arvo, "Transforming Axis-Aligned Bounding Boxes"
+			BoundingBox result;
+			result.min = result.max = glm::vec3(matrix[3]);
+			for (int i = 0; i < 3; i++)
+			{
+				glm::vec3 a = glm::vec3(matrix[i]) * min[i];
+				glm::vec3 b = glm::vec3(matrix[i]) * max[i];
+				result.min += glm::min(a, b);
+				result.max += glm::max(a, b);
+			}
+			return result;
+		}
+	};
+
+	struct BoundingSphere
+	{
+		glm::vec3 center = glm::vec3(0.0f);
+		float radius = 0.0f;
+	};
+
+	// Sphere around the center of the bounding box of the points
+	inline BoundingSphere computeBoundingSphere(const glm::vec3 *points, size_t count, const BoundingBox &box)
+	{
+		BoundingSphere sphere;
+		sphere.center = box.center();
+		float radiusSquared = 0.0f;
+		for (size_t i = 0; i < count; i++)
+		{
+			glm::vec3 d = points[i] - sphere.center;
+			radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+		}
+		sphere.radius = sqrtf(radiusSquared);
+		return sphere;
+	}
+
+	// View frustum as six planes (left, right, bottom, top, near, far) pointing inwards
+	struct Frustum
+	{
+		glm::vec4 planes[6];
+
+		Frustum() {}
+
+		// Extract the planes from a (model) view projection matrix
+		// Planes are in the space the matrix transforms from
+		Frustum(const glm::mat4 &matrix)
+		{
+			glm::vec4 row[4];
+			for (int i = 0; i < 4; i++)
+			{
+				row[i] = glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+			}
+			planes[0] = row[3] + row[0];
+			planes[1] = row[3] - row[0];
+			planes[2] = row[3] + row[1];
+			planes[3] = row[3] - row[1];
+			planes[4] = row[3] + row[2];
+			planes[5] = row[3] - row[2];
+			for (auto& plane : planes)
+			{
+				plane /= glm::length(glm::vec3(plane));
+			}
+		}
+
+		bool intersects(const BoundingSphere &sphere) const
+		{
+			for (auto& plane : planes)
+			{
+				if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Conservative, boxes near the frustum's edges may pass
+		bool intersects(const BoundingBox &box) const
+		{
+			for (auto& plane : planes)
+			{
+				// Corner furthest along the plane's normal
+				glm::vec3 p(
+					(plane.x >= 0.0f) ? box.max.x : box.min.x,
+					(plane.y >= 0.0f) ? box.max.y : box.min.y,
+					(plane.z >= 0.0f) ? box.max.z : box.min.z);
+				if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+
+	struct Ray
+	{
+		glm::vec3 origin;
+		glm::vec3 direction;
+		// Component wise 1 / direction
+		glm::vec3 invDirection;
+
+		Ray(const glm::vec3 &origin, const glm::vec3 &direction) : origin(origin), direction(direction)
+		{
+			invDirection = 1.0f / direction;
+		}
+
+		// Slab test, returns the entry distance in tNear if the box is hit closer than tMax
+		bool intersects(const BoundingBox &box, float tMax, float *tNear) const
+		{
+			glm::vec3 t0 = (box.min - origin) * invDirection;
+			glm::vec3 t1 = (box.max - origin) * invDirection;
+			glm::vec3 tMin = glm::min(t0, t1);
+			glm::vec3 tFar = glm::max(t0, t1);
+			float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+			float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+			*tNear = enter;
+			return enter <= exit;
+		}
+
+		// Moller-Trumbore, returns the distance and barycentrics of the hit (both faces are hit)
+		bool intersects(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, float *t, float *u, float *v) const
+		{
+			glm::vec3 e1 = p1 - p0;
+			glm::vec3 e2 = p2 - p0;
+			glm::vec3 p = glm::cross(direction, e2);
+			float det = glm::dot(e1, p);
+			if (fabsf(det) < 1e-12f)
+			{
+				return false;
+			}
+			float invDet = 1.0f / det;
+			glm::vec3 s = origin - p0;
+			*u = glm::dot(s, p) * invDet;
+			if ((*u < 0.0f) || (*u > 1.0f))
+			{
+				return false;
+			}
+			glm::vec3 q = glm::cross(s, e1);
+			*v = glm::dot(direction, q) * invDet;
+			if ((*v < 0.0f) || (*u + *v > 1.0f))
+			{
+				return false;
+			}
+			*t = glm::dot(e2, q) * invDet;
+			return *t >= 0.0f;
+		}
+	};
+
+}
@@ -0,0 +1,351 @@
+/*
+* Bounding volume hierarchy
+*
+* Binary BVH over the triangles of a mesh, built top down with a binned surface area
+* heuristic (SAH). The top of the tree is split on the calling thread, the subtrees
+* below are built in parallel. Used for ray casts (e.g. picking) against the mesh
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+#include "vulkanbounds.hpp"
+#include "vulkanparallel.hpp"
+
+namespace vkMeshLoader
+{
+
+	class Bvh
+	{
+	public:
+		struct Node
+		{
+			BoundingBox bounds;
+			// Inner nodes : index of the left child, the right child follows it
+			// Leaves : first triangle in triangles
+			uint32_t first;
+			// Number of triangles, zero for inner nodes
+			uint32_t count;
+		};
+
+		struct RayHit
+		{
+			float distance = FLT_MAX;
+			// Index of the triangle in the index list the BVH was built from
+			uint32_t triangle = UINT32_MAX;
+			// Barycentrics of the hit point relative to the triangle's second and third vertex
+			float u = 0.0f;
+			float v = 0.0f;
+		};
+
+		// Nodes, the root is the first node
+		std::vector<Node> nodes;
+		// Triangles (indices into the source index list / 3) ordered by leaf
+		std::vector<uint32_t> triangles;
+
+	private:
+		static const uint32_t binCount = 16;
+		static const uint32_t maxLeafSize = 4;
+
+		// Positions of the triangles' vertices, in the order of triangles
+		std::vector<glm::vec3> vertices;
+
+		// Split the triangles of a node with the lowest SAH cost over binned centroids
+		// Returns false if the node should be a leaf, otherwise the triangles are
+		// partitioned and leftCount is the number of triangles of the left child
+		bool split(const Node &node, const std::vector<BoundingBox> &triangleBounds, const std::vector<glm::vec3> &centroids, uint32_t *leftCount)
+		{
+			if (node.count <= maxLeafSize)
+			{
+				return false;
+			}
+
+			BoundingBox centroidBounds;
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+			{
+				centroidBounds.expand(centroids[triangles[i]]);
+			}
+
+			float bestCost = FLT_MAX;
+			int bestAxis = -1;
+			uint32_t bestBin = 0;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+				if (extent <= 0.0f)
+				{
+					continue;
+				}
+				float binScale = binCount / extent;
+
+				BoundingBox binBounds[binCount];
+				uint32_t binTriangles[binCount] = {};
+				for (uint32_t i = node.first; i < node.first + node.count; i++)
+				{
+					uint32_t t = triangles[i];
+					uint32_t bin = std::min((uint32_t)((centroids[t][axis] - centroidBounds.min[axis]) * binScale), binCount - 1);
+					binBounds[bin].expand(triangleBounds[t]);
+					binTriangles[bin]++;
+				}
+
+				// Sweep from the right to get the cost of the right side of each split plane
+				float rightCost[binCount];
+				BoundingBox bounds;
+				uint32_t count = 0;
+				for (uint32_t bin = binCount - 1; bin > 0; bin--)
+				{
+					bounds.expand(binBounds[bin]);
+					count += binTriangles[bin];
+					rightCost[bin] = (count > 0) ? bounds.surfaceArea() * count : 0.0f;
+				}
+				bounds = BoundingBox();
+				count = 0;
+				for (uint32_t bin = 0; bin < binCount - 1; bin++)
+				{
+					bounds.expand(binBounds[bin]);
+					count += binTriangles[bin];
+					float cost = ((count > 0) ? bounds.surfaceArea() * count : 0.0f) + rightCost[bin + 1];
+					if ((count > 0) && (count < node.count) && (cost < bestCost))
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestBin = bin;
+					}
+				}
+			}
+
+			// Splitting has to be cheaper than intersecting all triangles of the node
+			if ((bestAxis < 0) || (bestCost >= node.bounds.surfaceArea() * node.count))
+			{
+				if (node.count <= maxLeafSize * 8)
+				{
+					return false;
+				}
+				// Too many triangles for a leaf (e.g. all centroids at the same spot), split in the middle
+				*leftCount = node.count / 2;
+				return true;
+			}
+
+			float extent = centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis];
+			float binScale = binCount / extent;
+			auto middle = std::partition(triangles.begin() + node.first, triangles.begin() + node.first + node.count, [&](uint32_t t)
+			{
+				return std::min((uint32_t)((centroids[t][bestAxis] - centroidBounds.min[bestAxis]) * binScale), binCount - 1) <= bestBin;
+			});
+			*leftCount = (uint32_t)(middle - (triangles.begin() + node.first));
+			return true;
+		}
+
+		BoundingBox computeBounds(uint32_t first, uint32_t count, const std::vector<BoundingBox> &triangleBounds)
+		{
+			BoundingBox bounds;
+			for (uint32_t i = first; i < first + count; i++)
+			{
+				bounds.expand(triangleBounds[triangles[i]]);
+			}
+			return bounds;
+		}
+
+		// Build the subtree below root (already in subtree) depth first
+		void buildSubtree(std::vector<Node> &subtree, const std::vector<BoundingBox> &triangleBounds, const std::vector<glm::vec3> &centroids)
+		{
+			std::vector<uint32_t> stack(1, 0);
+			while (!stack.empty())
+			{
+				uint32_t index = stack.back();
+				stack.pop_back();
+				uint32_t leftCount;
+				if (!split(subtree[index], triangleBounds, centroids, &leftCount))
+				{
+					continue;
+				}
+				Node node = subtree[index];
+				Node left = { computeBounds(node.first, leftCount, triangleBounds), node.first, leftCount };
+				Node right = { computeBounds(node.first + leftCount, node.count - leftCount, triangleBounds), node.first + leftCount, node.count - leftCount };
+				subtree[index].first = (uint32_t)subtree.size();
+				subtree[index].count = 0;
+				subtree.push_back(left);
+				subtree.push_back(right);
+				stack.push_back(subtree[index].first);
+				stack.push_back(subtree[index].first + 1);
+			}
+		}
+
+	public:
+		// Build the BVH over a triangle list
+		// threadCount = 0 uses all hardware threads
+		void build(const uint32_t *indices, size_t indexCount, const glm::vec3 *positions, uint32_t threadCount = 0)
+		{
+			const uint32_t triangleCount = (uint32_t)(indexCount / 3);
+			nodes.clear();
+			triangles.resize(triangleCount);
+			vertices.clear();
+			if (triangleCount == 0)
+			{
+				return;
+			}
+
+			std::vector<BoundingBox> triangleBounds(triangleCount);
+			std::vector<glm::vec3> centroids(triangleCount);
+			for (uint32_t t = 0; t < triangleCount; t++)
+			{
+				for (uint32_t v = 0; v < 3; v++)
+				{
+					triangleBounds[t].expand(positions[indices[t * 3 + v]]);
+				}
+				centroids[t] = triangleBounds[t].center();
+				triangles[t] = t;
+			}
+
+			if (threadCount == 0)
+			{
+				threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+			}
+
+			// Split the top levels breadth first until there are enough subtrees for all threads
+			nodes.push_back({ computeBounds(0, triangleCount, triangleBounds), 0, triangleCount });
+			std::vector<uint32_t> pending(1, 0);
+			std::vector<uint32_t> subtreeRoots;
+			const size_t subtreeTarget = (threadCount > 1) ? threadCount * 4 : 1;
+			size_t head = 0;
+			while ((head < pending.size()) && (pending.size() - head + subtreeRoots.size() < subtreeTarget))
+			{
+				uint32_t index = pending[head++];
+				uint32_t leftCount;
+				if (!split(nodes[index], triangleBounds, centroids, &leftCount))
+				{
+					// Leaf
+					continue;
+				}
+				Node node = nodes[index];
+				Node left = { computeBounds(node.first, leftCount, triangleBounds), node.first, leftCount };
+				Node right = { computeBounds(node.first + leftCount, node.count - leftCount, triangleBounds), node.first + leftCount, node.count - leftCount };
+				nodes[index].first = (uint32_t)nodes.size();
+				nodes[index].count = 0;
+				nodes.push_back(left);
+				nodes.push_back(right);
+				pending.push_back(nodes[index].first);
+				pending.push_back(nodes[index].first + 1);
+			}
+			subtreeRoots.insert(subtreeRoots.end(), pending.begin() + head, pending.end());
+
+			// Subtrees own disjoint triangle ranges, so they can be built at the same time
+			std::vector<std::vector<Node>> subtrees(subtreeRoots.size());
+			vkMeshLoader::runParallel((uint32_t)subtreeRoots.size(), threadCount, [&](uint32_t i)
+			{
+				subtrees[i].push_back(nodes[subtreeRoots[i]]);
+				buildSubtree(subtrees[i], triangleBounds, centroids);
+			});
+
+			// Append the subtrees, their roots replace the nodes they were built from
+			for (size_t i = 0; i < subtrees.size(); i++)
+			{
+				const uint32_t offset = (uint32_t)nodes.size() - 1;
+				for (size_t n = 0; n < subtrees[i].size(); n++)
+				{
+					Node node = subtrees[i][n];
+					if (node.count == 0)
+					{
+						node.first += offset;
+					}
+					if (n == 0)
+					{
+						nodes[subtreeRoots[i]] = node;
+					}
+					else
+					{
+						nodes.push_back(node);
+					}
+				}
+			}
+
+			vertices.resize(triangleCount * 3);
+			for (uint32_t i = 0; i < triangleCount; i++)
+			{
+				for (uint32_t v = 0; v < 3; v++)
+				{
+					vertices[i * 3 + v] = positions[indices[triangles[i] * 3 + v]];
+				}
+			}
+		}
+
+		bool empty() const
+		{
+			return nodes.empty();
+		}
+
+		const BoundingBox &getBounds() const
+		{
+			return nodes[0].bounds;
+		}
+
+		// Find the closest triangle hit by a ray closer than maxDistance
+		// Distances are in units of the ray direction's length
+		bool raycast(const Ray &ray, RayHit *hit, float maxDistance = FLT_MAX) const
+		{
+			RayHit closest;
+			closest.distance = maxDistance;
+			float tNear;
+			if (nodes.empty() || !ray.intersects(nodes[0].bounds, closest.distance, &tNear))
+			{
+				return false;
+			}
+
+			std::vector<uint32_t> stack;
+			stack.reserve(64);
+			stack.push_back(0);
+			while (!stack.empty())
+			{
+				const Node &node = nodes[stack.back()];
+				stack.pop_back();
+				if (node.count > 0)
+				{
+					for (uint32_t i = node.first; i < node.first + node.count; i++)
+					{
+						float t, u, v;
+						if (ray.intersects(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2], &t, &u, &v) && (t < closest.distance))
+						{
+							closest.distance = t;
+							closest.triangle = triangles[i];
+							closest.u = u;
+							closest.v = v;
+						}
+					}
+					continue;
+				}
+				// Visit the closer child first
+				float tLeft, tRight;
+				bool hitLeft = ray.intersects(nodes[node.first].bounds, closest.distance, &tLeft);
+				bool hitRight = ray.intersects(nodes[node.first + 1].bounds, closest.distance, &tRight);
+				if (hitLeft && hitRight)
+				{
+					bool leftFirst = tLeft <= tRight;
+					stack.push_back(leftFirst ? node.first + 1 : node.first);
+					stack.push_back(leftFirst ? node.first : node.first + 1);
+				}
+				else if (hitLeft)
+				{
+					stack.push_back(node.first);
+				}
+				else if (hitRight)
+				{
+					stack.push_back(node.first + 1);
+				}
+			}
+
+			if (closest.triangle == UINT32_MAX)
+			{
+				return false;
+			}
+			*hit = closest;
+			return true;
+		}
+	};
+
+}
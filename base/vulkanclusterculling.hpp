@@ -0,0 +1,319 @@
+/*
+* GPU cluster culling
+*
+* Culls the meshlets of a set of meshes in a compute shader against the view frustum
+* and by their normal cones. The triangles of visible meshlets are compacted into an
+* output index buffer and each mesh gets an indexed indirect draw command, so the
+* draws only contain triangles that passed culling
+*/
+
+#pragma once
+
+#include <vector>
+#include <assert.h>
+#include <string.h>
+
+#include <vulkan/vulkan.h>
+#include "vulkantools.h"
+#include "vulkanmemory.hpp"
+#include "vulkanupload.hpp"
+#include "vulkanuniformring.hpp"
+#include "vulkanmeshlets.hpp"
+#include "vulkanbounds.hpp"
+
+#include <glm/glm.hpp>
+
+namespace vkTools
+{
+
+	class VulkanClusterCuller
+	{
+	private:
+		VkDevice device = VK_NULL_HANDLE;
+		VulkanMemoryAllocator *allocator;
+		// The culling parameters are a block of the uniform ring, so updates
+		// don't touch the copy of frames that are still in flight
+		VulkanUniformRing *uniformRing;
+		VkDeviceSize uniformOffset;
+
+		// Meshlet as read by the culling shader (std430)
+		struct Cluster
+		{
+			glm::vec4 sphere;
+			glm::vec4 cone;
+			uint32_t indexBase;
+			uint32_t indexCount;
+			// Draw command the meshlet's triangles are added to
+			uint32_t drawIndex;
+			// CLUSTER_FLAG_*
+			uint32_t flags;
+		};
+		enum { CLUSTER_FLAG_CONE_CULLING = 0x1 };
+
+		struct
+		{
+			glm::vec4 frustumPlanes[6];
+			glm::vec4 cameraPos;
+		} ubo;
+
+		std::vector<Cluster> clusters;
+		std::vector<uint32_t> indices;
+		// Initial draw commands with an index count of zero
+		// The culling shader adds the index counts of the visible meshlets
+		std::vector<VkDrawIndexedIndirectCommand> drawCommands;
+
+		struct Buffer
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			Allocation allocation;
+			VkDescriptorBufferInfo descriptor;
+		};
+		Buffer clusterBuffer;
+		Buffer indexBuffer;
+		Buffer outputIndexBuffer;
+		Buffer drawCommandBuffer;
+
+		VkDescriptorPool descriptorPool;
+		VkDescriptorSetLayout descriptorSetLayout;
+		VkDescriptorSet descriptorSet;
+		VkPipelineLayout pipelineLayout;
+		VkPipeline pipeline;
+
+		// Create a buffer, device local buffers are filled through the upload manager
+		void createBuffer(Buffer &buffer, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkDeviceSize size, const void *data, VulkanUploadManager *uploadManager)
+		{
+			if (data && !(properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+			{
+				usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			}
+			VkBufferCreateInfo bufferInfo = vkTools::initializers::bufferCreateInfo(usage, size);
+			VkResult err = vkCreateBuffer(device, &bufferInfo, nullptr, &buffer.buffer);
+			assert(!err);
+			buffer.allocation = allocator->allocateBuffer(buffer.buffer, properties);
+			if (data)
+			{
+				if (buffer.allocation.mapped)
+				{
+					memcpy(buffer.allocation.mapped, data, (size_t)size);
+				}
+				else
+				{
+					uploadManager->upload(buffer.buffer, data, size);
+				}
+			}
+			buffer.descriptor.buffer = buffer.buffer;
+			buffer.descriptor.offset = 0;
+			buffer.descriptor.range = size;
+		}
+
+		void destroyBuffer(Buffer &buffer)
+		{
+			vkDestroyBuffer(device, buffer.buffer, nullptr);
+			allocator->free(buffer.allocation);
+			buffer.buffer = VK_NULL_HANDLE;
+		}
+
+	public:
+		// Add the meshlets of a mesh, returns the index of the mesh's draw command
+		// indices are the mesh's (32 bit) indices that the meshlets refer to, vertexOffset
+		// is added to them when drawing (e.g. the mesh's offset in a geometry pool)
+		// Disable cone culling for meshes that aren't drawn with back face culling
+		uint32_t addMesh(const uint32_t *meshIndices, size_t indexCount, const std::vector<vkMeshLoader::Meshlet> &meshlets, int32_t vertexOffset = 0, bool coneCulling = true)
+		{
+			assert(device == VK_NULL_HANDLE);
+			uint32_t drawIndex = (uint32_t)drawCommands.size();
+			uint32_t indexBase = (uint32_t)indices.size();
+			indices.insert(indices.end(), meshIndices, meshIndices + indexCount);
+			for (auto& meshlet : meshlets)
+			{
+				assert(meshlet.indexBase + meshlet.indexCount <= indexCount);
+				Cluster cluster = { meshlet.sphere, meshlet.cone, indexBase + meshlet.indexBase, meshlet.indexCount, drawIndex, coneCulling ? (uint32_t)CLUSTER_FLAG_CONE_CULLING : 0u };
+				clusters.push_back(cluster);
+			}
+			// Visible triangles are written to the mesh's part of the output index buffer
+			VkDrawIndexedIndirectCommand drawCommand = { 0, 1, indexBase, vertexOffset, 0 };
+			drawCommands.push_back(drawCommand);
+			return drawIndex;
+		}
+
+		// Create the buffers and the compute pipeline, call after adding all meshes
+		// shaderStage is the culling compute shader (see data/shaders/vulkanscene/clustercull.comp)
+		void prepare(VkDevice device, VulkanMemoryAllocator *allocator, VulkanUploadManager *uploadManager, VulkanUniformRing *uniformRing, VkPipelineShaderStageCreateInfo shaderStage, VkPipelineCache pipelineCache)
+		{
+			assert(!clusters.empty());
+			// One work group per cluster
+			assert(clusters.size() <= 65535);
+			// Draw commands are reset with vkCmdUpdateBuffer
+			assert(drawCommands.size() * sizeof(VkDrawIndexedIndirectCommand) <= 65536);
+
+			this->device = device;
+			this->allocator = allocator;
+			this->uniformRing = uniformRing;
+
+			uniformOffset = uniformRing->allocate(sizeof(ubo));
+			uniformRing->update(uniformOffset, &ubo, sizeof(ubo));
+			createBuffer(clusterBuffer, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, clusters.size() * sizeof(Cluster), clusters.data(), uploadManager);
+			createBuffer(indexBuffer, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indices.size() * sizeof(uint32_t), indices.data(), uploadManager);
+			createBuffer(outputIndexBuffer, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indices.size() * sizeof(uint32_t), nullptr, uploadManager);
+			createBuffer(drawCommandBuffer, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, drawCommands.size() * sizeof(VkDrawIndexedIndirectCommand), drawCommands.data(), uploadManager);
+
+			std::vector<VkDescriptorPoolSize> poolSizes =
+			{
+				vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1),
+				vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4)
+			};
+			VkDescriptorPoolCreateInfo descriptorPoolInfo = vkTools::initializers::descriptorPoolCreateInfo((uint32_t)poolSizes.size(), poolSizes.data(), 1);
+			VkResult err = vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &descriptorPool);
+			assert(!err);
+
+			std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings =
+			{
+				// Binding 0 : Frustum planes and camera position
+				vkTools::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_COMPUTE_BIT, 0),
+				// Binding 1 : Clusters
+				vkTools::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1),
+				// Binding 2 : Source indices
+				vkTools::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 2),
+				// Binding 3 : Compacted indices of the visible clusters
+				vkTools::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 3),
+				// Binding 4 : Indirect draw commands
+				vkTools::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 4)
+			};
+			VkDescriptorSetLayoutCreateInfo descriptorLayout = vkTools::initializers::descriptorSetLayoutCreateInfo(setLayoutBindings.data(), (uint32_t)setLayoutBindings.size());
+			err = vkCreateDescriptorSetLayout(device, &descriptorLayout, nullptr, &descriptorSetLayout);
+			assert(!err);
+
+			VkPipelineLayoutCreateInfo pipelineLayoutInfo = vkTools::initializers::pipelineLayoutCreateInfo(&descriptorSetLayout, 1);
+			err = vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+			assert(!err);
+
+			VkDescriptorSetAllocateInfo allocInfo = vkTools::initializers::descriptorSetAllocateInfo(descriptorPool, &descriptorSetLayout, 1);
+			err = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet);
+			assert(!err);
+
+			VkDescriptorBufferInfo uniformDescriptor = uniformRing->getDescriptor(uniformOffset, sizeof(ubo));
+			std::vector<VkWriteDescriptorSet> writeDescriptorSets =
+			{
+				vkTools::initializers::writeDescriptorSet(descriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0, &uniformDescriptor),
+				vkTools::initializers::writeDescriptorSet(descriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &clusterBuffer.descriptor),
+				vkTools::initializers::writeDescriptorSet(descriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2, &indexBuffer.descriptor),
+				vkTools::initializers::writeDescriptorSet(descriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3, &outputIndexBuffer.descriptor),
+				vkTools::initializers::writeDescriptorSet(descriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4, &drawCommandBuffer.descriptor)
+			};
+			vkUpdateDescriptorSets(device, (uint32_t)writeDescriptorSets.size(), writeDescriptorSets.data(), 0, nullptr);
+
+			VkComputePipelineCreateInfo pipelineInfo = vkTools::initializers::computePipelineCreateInfo(pipelineLayout, 0);
+			pipelineInfo.stage = shaderStage;
+			err = vkCreateComputePipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+			assert(!err);
+		}
+
+		void destroy()
+		{
+			if (device == VK_NULL_HANDLE)
+			{
+				return;
+			}
+			vkDestroyPipeline(device, pipeline, nullptr);
+			vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+			vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+			vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+			destroyBuffer(clusterBuffer);
+			destroyBuffer(indexBuffer);
+			destroyBuffer(outputIndexBuffer);
+			destroyBuffer(drawCommandBuffer);
+			device = VK_NULL_HANDLE;
+		}
+
+		// Update the culling parameters
+		// modelViewProjection and cameraPos need to be in the space of the meshlets (i.e. model space)
+		void update(const glm::mat4 &modelViewProjection, const glm::vec3 &cameraPos)
+		{
+			vkMeshLoader::Frustum frustum(modelViewProjection);
+			for (int i = 0; i < 6; i++)
+			{
+				ubo.frustumPlanes[i] = frustum.planes[i];
+			}
+			ubo.cameraPos = glm::vec4(cameraPos, 1.0f);
+			// Before prepare the parameters are only stored, prepare writes them to the ring
+			if (device != VK_NULL_HANDLE)
+			{
+				uniformRing->update(uniformOffset, &ubo, sizeof(ubo));
+			}
+		}
+
+		// Record the culling pass, must be recorded outside of a render pass
+		// and before the draws that use the results
+		// dynamicOffset selects the uniform ring region of the command buffer (see VulkanUniformRing::getDynamicOffset)
+		void cull(VkCommandBuffer cmdBuffer, uint32_t dynamicOffset)
+		{
+			// Previous draws have to finish reading the output before it's overwritten
+			VkMemoryBarrier memoryBarrier = vkTools::initializers::memoryBarrier();
+			memoryBarrier.srcAccessMask = 0;
+			memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			vkCmdPipelineBarrier(
+				cmdBuffer,
+				VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_FLAGS_NONE,
+				1, &memoryBarrier,
+				0, nullptr,
+				0, nullptr);
+
+			// Reset the index counts of the draw commands
+			vkCmdUpdateBuffer(cmdBuffer, drawCommandBuffer.buffer, 0, drawCommands.size() * sizeof(VkDrawIndexedIndirectCommand), (const uint32_t*)drawCommands.data());
+
+			memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			vkCmdPipelineBarrier(
+				cmdBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_FLAGS_NONE,
+				1, &memoryBarrier,
+				0, nullptr,
+				0, nullptr);
+
+			vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+			vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 1, &dynamicOffset);
+			vkCmdDispatch(cmdBuffer, (uint32_t)clusters.size(), 1, 1);
+
+			// Make the draw commands and compacted indices visible to the draws
+			memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			memoryBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+			vkCmdPipelineBarrier(
+				cmdBuffer,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+				VK_FLAGS_NONE,
+				1, &memoryBarrier,
+				0, nullptr,
+				0, nullptr);
+		}
+
+		// Bind the compacted index buffer for draw, once for all culled meshes
+		void bindIndexBuffer(VkCommandBuffer cmdBuffer)
+		{
+			vkCmdBindIndexBuffer(cmdBuffer, outputIndexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+		}
+
+		// Draw the visible triangles of a mesh added with addMesh
+		// The compacted index buffer (see bindIndexBuffer), the mesh's vertex buffer and pipeline need to be bound
+		void draw(VkCommandBuffer cmdBuffer, uint32_t drawIndex)
+		{
+			assert(drawIndex < drawCommands.size());
+			vkCmdDrawIndexedIndirect(cmdBuffer, drawCommandBuffer.buffer, drawIndex * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+		}
+
+		uint32_t getClusterCount()
+		{
+			return (uint32_t)clusters.size();
+		}
+
+		uint32_t getTriangleCount()
+		{
+			return (uint32_t)indices.size() / 3;
+		}
+	};
+
+}
@@ -1,6 +1,8 @@
 
 #include "vulkanexamplebase.h"
 
+std::vector<const char*> VulkanExampleBase::args;
+
 VkResult VulkanExampleBase::createInstance(bool enableValidation)
 {
 	this->enableValidation = enableValidation;
@@ -13,14 +15,24 @@ VkResult VulkanExampleBase::createInstance(bool enableValidation)
 	// todo : Use VK_API_VERSION 
 	appInfo.apiVersion = VK_MAKE_VERSION(1, 0, 2);
 
-	std::vector<const char*> enabledExtensions = { VK_KHR_SURFACE_EXTENSION_NAME };
+	std::vector<const char*> enabledExtensions;
 
+	// No surface extensions required in headless mode
+	if (!headless)
+	{
+		enabledExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
 #ifdef _WIN32
-	enabledExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+		enabledExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
 #else
-	// todo : linux/android
-	enabledExtensions.push_back(VK_KHR_XCB_SURFACE_EXTENSION_NAME);
+		// todo : linux/android
+		enabledExtensions.push_back(VK_KHR_XCB_SURFACE_EXTENSION_NAME);
 #endif
+	}
+
+	if (enableValidation)
+	{
+		enabledExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
+	}
 
 	// todo : check if all extensions are present
 
@@ -30,10 +42,6 @@ VkResult VulkanExampleBase::createInstance(bool enableValidation)
 	instanceCreateInfo.pApplicationInfo = &appInfo;
 	if (enabledExtensions.size() > 0)
 	{
-		if (enableValidation)
-		{
-			enabledExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
-		}
 		instanceCreateInfo.enabledExtensionCount = (uint32_t)enabledExtensions.size();
 		instanceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
 	}
@@ -45,15 +53,21 @@ VkResult VulkanExampleBase::createInstance(bool enableValidation)
 	return vkCreateInstance(&instanceCreateInfo, nullptr, &instance);
 }
 
-VkResult VulkanExampleBase::createDevice(VkDeviceQueueCreateInfo requestedQueues, bool enableValidation)
+VkResult VulkanExampleBase::createDevice(std::vector<VkDeviceQueueCreateInfo> requestedQueues, bool enableValidation)
 {
-	std::vector<const char*> enabledExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+	std::vector<const char*> enabledExtensions;
+
+	// The swap chain extension depends on the surface extension, which is not enabled in headless mode
+	if (!headless)
+	{
+		enabledExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	}
 
 	VkDeviceCreateInfo deviceCreateInfo = {};
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	deviceCreateInfo.pNext = NULL;
-	deviceCreateInfo.queueCreateInfoCount = 1;
-	deviceCreateInfo.pQueueCreateInfos = &requestedQueues;
+	deviceCreateInfo.queueCreateInfoCount = (uint32_t)requestedQueues.size();
+	deviceCreateInfo.pQueueCreateInfos = requestedQueues.data();
 	deviceCreateInfo.pEnabledFeatures = NULL;
 
 	if (enabledExtensions.size() > 0)
@@ -101,19 +115,11 @@ void VulkanExampleBase::createCommandBuffers()
 
 	VkResult vkRes = vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, drawCmdBuffers.data());
 	assert(!vkRes);
-
-	// Create one command buffer for submitting the
-	// post present image memory barrier
-	cmdBufAllocateInfo.commandBufferCount = 1;
-
-	vkRes = vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &postPresentCmdBuffer);
-	assert(!vkRes);
 }
 
 void VulkanExampleBase::destroyCommandBuffers()
 {
 	vkFreeCommandBuffers(device, cmdPool, (uint32_t)drawCmdBuffers.size(), drawCmdBuffers.data());
-	vkFreeCommandBuffers(device, cmdPool, 1, &postPresentCmdBuffer);
 }
 
 void VulkanExampleBase::createSetupCommandBuffer()
@@ -168,11 +174,300 @@ void VulkanExampleBase::flushSetupCommandBuffer()
 	setupCmdBuffer = VK_NULL_HANDLE; // todo : check if still necessary
 }
 
+void VulkanExampleBase::createFrameResources()
+{
+	VkResult err;
+
+	frames.resize(framesInFlight);
+
+	// Two command buffers per frame slot (start and end of frame queries)
+	std::vector<VkCommandBuffer> cmdBuffers(framesInFlight * 2);
+	VkCommandBufferAllocateInfo cmdBufAllocateInfo =
+		vkTools::initializers::commandBufferAllocateInfo(
+			cmdPool,
+			VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+			framesInFlight * 2);
+	err = vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, cmdBuffers.data());
+	assert(!err);
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo = vkTools::initializers::semaphoreCreateInfo(0);
+	// Create fences in signaled state so the first wait on each frame slot returns immediately
+	VkFenceCreateInfo fenceCreateInfo = vkTools::initializers::fenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
+
+	for (uint32_t i = 0; i < framesInFlight; i++)
+	{
+		err = vkCreateFence(device, &fenceCreateInfo, nullptr, &frames[i].fence);
+		assert(!err);
+		err = vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &frames[i].presentComplete);
+		assert(!err);
+		err = vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &frames[i].renderComplete);
+		assert(!err);
+		frames[i].cmdBuffer = cmdBuffers[i * 2];
+		frames[i].timestampCmdBuffer = cmdBuffers[i * 2 + 1];
+		frames[i].timestampsPending = false;
+	}
+
+	imageFences.assign(swapChain.imageCount, VK_NULL_HANDLE);
+	currentFrame = 0;
+
+	// GPU frame times are only measured in benchmark mode and
+	// if the graphics queue supports timestamps
+	if (benchmark.active)
+	{
+		uint32_t queueCount;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueCount, NULL);
+		std::vector<VkQueueFamilyProperties> queueProps(queueCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueCount, queueProps.data());
+
+		if (queueProps[swapChain.queueNodeIndex].timestampValidBits > 0)
+		{
+			VkQueryPoolCreateInfo queryPoolInfo = {};
+			queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			queryPoolInfo.queryCount = framesInFlight * 2;
+			err = vkCreateQueryPool(device, &queryPoolInfo, nullptr, &timestampQueryPool);
+			assert(!err);
+		}
+		else
+		{
+			std::cout << "Timestamps not supported by the graphics queue, GPU times will not be measured\n";
+		}
+	}
+
+	if (profiler.enabled)
+	{
+		profiler.prepare(physicalDevice, device, cmdPool, swapChain.queueNodeIndex, framesInFlight);
+	}
+}
+
+void VulkanExampleBase::destroyFrameResources()
+{
+	for (auto& frame : frames)
+	{
+		vkDestroyFence(device, frame.fence, nullptr);
+		vkDestroySemaphore(device, frame.presentComplete, nullptr);
+		vkDestroySemaphore(device, frame.renderComplete, nullptr);
+		vkFreeCommandBuffers(device, cmdPool, 1, &frame.cmdBuffer);
+		vkFreeCommandBuffers(device, cmdPool, 1, &frame.timestampCmdBuffer);
+	}
+	frames.clear();
+	imageFences.clear();
+	if (timestampQueryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(device, timestampQueryPool, nullptr);
+		timestampQueryPool = VK_NULL_HANDLE;
+	}
+	if (profiler.enabled)
+	{
+		profiler.destroy();
+	}
+}
+
+void VulkanExampleBase::beginFrame()
+{
+	VkResult err;
+	FrameResources &frame = frames[currentFrame];
+
+	// Make sure buffers created since the last frame have their data
+	uploadManager.flush();
+	// Release staging resources of finished texture uploads
+	if (textureLoader)
+	{
+		textureLoader->pollUploads();
+	}
+
+	auto tStart = std::chrono::high_resolution_clock::now();
+
+	// Wait until the GPU is done with the last submission that used this frame slot
+	// This is the only point where the CPU blocks, and only if it's 
+	// more than framesInFlight frames ahead of the GPU
+	err = vkWaitForFences(device, 1, &frame.fence, VK_TRUE, UINT64_MAX);
+	assert(!err);
+
+	// Get next image in the swap chain (back/front buffer)
+	err = swapChain.acquireNextImage(frame.presentComplete, &currentBuffer);
+	assert(!err);
+
+	// The draw command buffer of the acquired image may still be pending
+	// if the image was last rendered to by a different frame slot
+	if ((imageFences[currentBuffer] != VK_NULL_HANDLE) && (imageFences[currentBuffer] != frame.fence))
+	{
+		err = vkWaitForFences(device, 1, &imageFences[currentBuffer], VK_TRUE, UINT64_MAX);
+		assert(!err);
+	}
+	imageFences[currentBuffer] = frame.fence;
+
+	// The image's previous submission has finished, so uniform updates
+	// can go straight into it's region of the uniform ring
+	uniformRing.begin(currentBuffer);
+
+	auto tEnd = std::chrono::high_resolution_clock::now();
+	acquireTime = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+
+	// Upload the next mip levels of streamed textures, before the frame's submission
+	textureStreamer.update();
+
+	// The last submission of this slot has finished, so its timestamps are available
+	if (frame.timestampsPending)
+	{
+		readFrameTimestamps(frame);
+	}
+	frame.frameNumber = frameCounter;
+
+	err = vkResetFences(device, 1, &frame.fence);
+	assert(!err);
+
+	// No layout transition is required for the acquired image, the render pass
+	// takes care of this (see setupRenderPass)
+	// The frame's command buffer is only required for timestamp queries
+	if (!frameCmdBufferRequired())
+	{
+		return;
+	}
+
+	VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
+	err = vkBeginCommandBuffer(frame.cmdBuffer, &cmdBufInfo);
+	assert(!err);
+
+	if (timestampQueryPool != VK_NULL_HANDLE)
+	{
+		vkCmdResetQueryPool(frame.cmdBuffer, timestampQueryPool, currentFrame * 2, 2);
+		vkCmdWriteTimestamp(frame.cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool, currentFrame * 2);
+	}
+
+	// Collects the profiler results of this slot's last submission and resets it's queries
+	profiler.beginFrame(currentFrame, frame.cmdBuffer);
+
+	err = vkEndCommandBuffer(frame.cmdBuffer);
+	assert(!err);
+}
+
+bool VulkanExampleBase::frameCmdBufferRequired()
+{
+	return (timestampQueryPool != VK_NULL_HANDLE) || profiler.enabled;
+}
+
+void VulkanExampleBase::submitFrame()
+{
+	submitFrame({ drawCmdBuffers[currentBuffer] });
+}
+
+void VulkanExampleBase::submitFrame(std::vector<VkCommandBuffer> commandBuffers)
+{
+	VkResult err;
+	FrameResources &frame = frames[currentFrame];
+
+	// Frame command buffer (query resets and start of frame timestamp) goes first
+	if (frameCmdBufferRequired())
+	{
+		commandBuffers.insert(commandBuffers.begin(), frame.cmdBuffer);
+	}
+
+	// End of frame timestamp goes last
+	if (timestampQueryPool != VK_NULL_HANDLE)
+	{
+		VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
+		err = vkBeginCommandBuffer(frame.timestampCmdBuffer, &cmdBufInfo);
+		assert(!err);
+		vkCmdWriteTimestamp(frame.timestampCmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, currentFrame * 2 + 1);
+		err = vkEndCommandBuffer(frame.timestampCmdBuffer);
+		assert(!err);
+		commandBuffers.push_back(frame.timestampCmdBuffer);
+		frame.timestampsPending = true;
+	}
+
+	// Updates from here on may not touch the region this frame reads from
+	uniformRing.end();
+
+	// Only color attachment output needs to wait for the presentation engine
+	// to release the image, earlier stages (and offscreen passes) may start right away
+	VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+	VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
+	submitInfo.commandBufferCount = (uint32_t)commandBuffers.size();
+	submitInfo.pCommandBuffers = commandBuffers.data();
+	// There is no presentation engine to synchronize with in headless mode
+	if (!headless)
+	{
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &frame.presentComplete;
+		submitInfo.pWaitDstStageMask = &waitStageMask;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &frame.renderComplete;
+	}
+
+	// The fence is signaled once this frame's commands have finished
+	err = vkQueueSubmit(queue, 1, &submitInfo, frame.fence);
+	assert(!err);
+
+	err = swapChain.queuePresent(queue, currentBuffer, frame.renderComplete);
+	assert(!err);
+
+	if (headless && dumpFrames)
+	{
+		char filename[64];
+		snprintf(filename, sizeof(filename), "_%05u.ppm", frameCounter);
+		saveFrame(currentBuffer, name + filename);
+	}
+
+	frameCounter++;
+	currentFrame = (currentFrame + 1) % framesInFlight;
+}
+
+void VulkanExampleBase::readFrameTimestamps(FrameResources &frame)
+{
+	uint32_t slot = (uint32_t)(&frame - frames.data());
+	uint64_t timestamps[2];
+	VkResult err = vkGetQueryPoolResults(
+		device, 
+		timestampQueryPool, 
+		slot * 2, 
+		2, 
+		sizeof(timestamps), 
+		timestamps, 
+		sizeof(uint64_t), 
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+	assert(!err);
+	frame.timestampsPending = false;
+
+	// Timestamp period is in nanoseconds per tick
+	double gpuTime = (double)(timestamps[1] - timestamps[0]) * deviceProperties.limits.timestampPeriod / 1000000.0;
+	benchmark.setGpuTime(frame.frameNumber, gpuTime);
+}
+
+bool VulkanExampleBase::benchmarkFrame(double cpuTime)
+{
+	if (!benchmark.active)
+	{
+		return false;
+	}
+	benchmark.setCpuTimes(frameCounter - 1, cpuTime, acquireTime);
+	return benchmark.finished(frameCounter);
+}
+
 void VulkanExampleBase::createPipelineCache()
 {
+	// Initialize the cache with the data saved by the last run (if it's compatible)
+	std::vector<char> cacheData;
+	if (!clearPipelineCache)
+	{
+		std::string fileName = vkTools::VulkanPipelineCacheFile::getFileName(name, deviceProperties);
+		pipelineCacheWarm = vkTools::VulkanPipelineCacheFile::load(fileName, deviceProperties, cacheData);
+	}
+
 	VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
 	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipelineCacheCreateInfo.initialDataSize = cacheData.size();
+	pipelineCacheCreateInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
 	VkResult err = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+	if ((err != VK_SUCCESS) && pipelineCacheWarm)
+	{
+		// Data was rejected by the driver, start with an empty cache
+		pipelineCacheWarm = false;
+		pipelineCacheCreateInfo.initialDataSize = 0;
+		pipelineCacheCreateInfo.pInitialData = nullptr;
+		err = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+	}
 	assert(!err);
 }
 
@@ -187,6 +482,7 @@ void VulkanExampleBase::prepare()
 	createSetupCommandBuffer();
 	setupSwapChain();
 	createCommandBuffers();
+	createFrameResources();
 	setupDepthStencil();
 	setupRenderPass();
 	createPipelineCache();
@@ -194,8 +490,13 @@ void VulkanExampleBase::prepare()
 	flushSetupCommandBuffer();
 	// Recreate setup command buffer for derived class
 	createSetupCommandBuffer();
+	uploadManager.prepare(device, &memoryAllocator, queue, cmdPool);
+	uniformRing.prepare(physicalDevice, device, &memoryAllocator, swapChain.imageCount);
 	// Create a simple texture loader class 
-	textureLoader = new vkTools::VulkanTextureLoader(physicalDevice, device, queue, cmdPool);
+	textureLoader = new vkTools::VulkanTextureLoader(physicalDevice, device, queue, cmdPool, &memoryAllocator);
+	textureLoader->setTransferQueue(transferQueue, transferQueueFamilyIndex, graphicsQueueFamilyIndex);
+	textureCache.prepare(device, textureLoader);
+	textureStreamer.prepare(device, &memoryAllocator, queue, cmdPool, framesInFlight, streamingBudget);
 }
 
 VkPipelineShaderStageCreateInfo VulkanExampleBase::loadShader(const char * fileName, VkShaderStageFlagBits stage)
@@ -227,35 +528,52 @@ VkBool32 VulkanExampleBase::createBuffer(
 	VkDeviceSize size, 
 	void * data, 
 	VkBuffer *buffer, 
-	VkDeviceMemory *memory)
+	vkTools::Allocation *allocation)
 {
-	VkMemoryRequirements memReqs;
-	VkMemoryAllocateInfo memAlloc = vkTools::initializers::memoryAllocateInfo();
+	// Static geometry goes to device local memory
+	VkMemoryPropertyFlags memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	if ((data != nullptr) && (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)))
+	{
+		memoryPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	}
+	return createBuffer(usage, memoryPropertyFlags, size, data, buffer, allocation);
+}
+
+VkBool32 VulkanExampleBase::createBuffer(
+	VkBufferUsageFlags usage,
+	VkMemoryPropertyFlags memoryPropertyFlags,
+	VkDeviceSize size,
+	void * data,
+	VkBuffer *buffer,
+	vkTools::Allocation *allocation)
+{
+	bool staged = !(memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+	if (staged)
+	{
+		usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	}
 	VkBufferCreateInfo bufferCreateInfo = vkTools::initializers::bufferCreateInfo(usage, size);
 
 	VkResult err = vkCreateBuffer(device, &bufferCreateInfo, nullptr, buffer);
 	assert(!err);
-	vkGetBufferMemoryRequirements(device, *buffer, &memReqs);
-	memAlloc.allocationSize = memReqs.size;
-	getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &memAlloc.memoryTypeIndex);
-	err = vkAllocateMemory(device, &memAlloc, nullptr, memory);
-	assert(!err);
+	*allocation = memoryAllocator.allocateBuffer(*buffer, memoryPropertyFlags);
 	if (data != nullptr)
 	{
-		void *mapped;
-		err = vkMapMemory(device, *memory, 0, size, 0, &mapped);
-		assert(!err);
-		memcpy(mapped, data, size);
-		vkUnmapMemory(device, *memory);
+		if (staged)
+		{
+			uploadManager.upload(*buffer, data, size);
+		}
+		else
+		{
+			memcpy(allocation->mapped, data, size);
+		}
 	}
-	err = vkBindBufferMemory(device, *buffer, *memory, 0);
-	assert(!err);
 	return true;
 }
 
-VkBool32 VulkanExampleBase::createBuffer(VkBufferUsageFlags usage, VkDeviceSize size, void * data, VkBuffer * buffer, VkDeviceMemory * memory, VkDescriptorBufferInfo * descriptor)
+VkBool32 VulkanExampleBase::createBuffer(VkBufferUsageFlags usage, VkDeviceSize size, void * data, VkBuffer * buffer, vkTools::Allocation * allocation, VkDescriptorBufferInfo * descriptor)
 {
-	VkBool32 res = createBuffer(usage, size, data, buffer, memory);
+	VkBool32 res = createBuffer(usage, size, data, buffer, allocation);
 	if (res)
 	{
 		descriptor->offset = 0;
@@ -269,126 +587,383 @@ VkBool32 VulkanExampleBase::createBuffer(VkBufferUsageFlags usage, VkDeviceSize
 	}
 }
 
+VulkanMeshLoader *VulkanExampleBase::importMesh(const char *filename, uint32_t lodCount)
+{
+	VulkanMeshLoader *mesh = new VulkanMeshLoader();
+	mesh->LoadMesh(filename);
+	assert(mesh->m_Entries.size() > 0);
+
+	if (optimizeMeshes)
+	{
+		vkMeshLoader::MeshOptimizationStatistics stats = mesh->optimize();
+		std::cout << "Optimized " << filename << std::fixed << std::setprecision(3)
+			<< " : ACMR " << stats.before.acmr << " -> " << stats.after.acmr
+			<< ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr << "\n";
+	}
+
+	// Meshes with more vertices than 16 bit indices can address are split up
+	mesh->splitMeshes();
+
+	if (lodCount > 0)
+	{
+		mesh->generateLods(lodCount);
+		std::cout << "Levels of detail for " << filename << " : ";
+		for (auto& lod : mesh->getLods(1.0f))
+		{
+			std::cout << lod.indexCount / 3 << " ";
+		}
+		std::cout << "triangles\n";
+	}
+
+	return mesh;
+}
+
 void VulkanExampleBase::loadMesh(
 	const char * filename, 
 	vkMeshLoader::MeshBuffer * meshBuffer, 
 	std::vector<vkMeshLoader::VertexLayout> vertexLayout, 
-	float scale)
+	float scale,
+	uint32_t lodCount)
 {
-	VulkanMeshLoader *mesh = new VulkanMeshLoader();
-	mesh->LoadMesh(filename);
-	assert(mesh->m_Entries.size() > 0);
+	// Skip ASSIMP if there is an up to date binary cache
+	if (useMeshCache && vkMeshLoader::MeshCache::load(filename, vertexLayout, scale, VulkanMeshLoader::defaultFlags, device, &memoryAllocator, &uploadManager, meshBuffer, optimizeMeshes, lodCount))
+	{
+		return;
+	}
+
+	VulkanMeshLoader *mesh = importMesh(filename, lodCount);
 
 	mesh->createVulkanBuffers(
 		device,
-		deviceMemoryProperties,
+		&memoryAllocator,
 		meshBuffer,
 		vertexLayout,
-		scale);
+		scale,
+		&uploadManager);
+
+	if (useMeshCache)
+	{
+		vkMeshLoader::MeshCache::save(filename, vertexLayout, scale, VulkanMeshLoader::defaultFlags, mesh, optimizeMeshes, lodCount);
+	}
 
 	delete(mesh);
 }
 
 void VulkanExampleBase::renderLoop()
 {
-#ifdef _WIN32
-	MSG msg;
-	while (TRUE)
+	// Everything up to here (instance, device, assets and pipelines) counts as startup
+	startupTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startupBegin).count();
+	std::cout << "Startup time : " << std::fixed << std::setprecision(1) << startupTime << " ms ("
+		<< (pipelineCacheWarm ? "warm" : "cold") << " pipeline cache)\n";
+	const vkTools::VulkanTextureCache::Statistics &textureStats = textureCache.getStatistics();
+	if (textureStats.requestCount > 0)
 	{
-		auto tStart = std::chrono::high_resolution_clock::now();
-		PeekMessage(&msg, NULL, 0, 0, PM_REMOVE);
-		if (msg.message == WM_QUIT)
+		std::cout << "Texture cache : " << textureStats.textureCount << " textures for " << textureStats.requestCount << " requests, "
+			<< textureStats.savedBytes / 1024 << " KB saved by sharing\n";
+	}
+	benchmark.startupTime = startupTime;
+	benchmark.pipelineCacheWarm = pipelineCacheWarm;
+
+	if (benchmark.active)
+	{
+		if (benchmark.filename.empty())
 		{
-			break;
+			benchmark.filename = name + "_benchmark";
 		}
-		else
+		// Animations advance with a fixed time step
+		frameTimer = benchmark.timeStep;
+	}
+
+	if (headless)
+	{
+		// Render a fixed number of frames without any window system interaction
+		// In benchmark mode the frame count is set by the benchmark instead
+		for (uint32_t i = 0; benchmark.active || (i < headlessFrameCount); i++)
 		{
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
+			auto tStart = std::chrono::high_resolution_clock::now();
+			render();
+			auto tEnd = std::chrono::high_resolution_clock::now();
+			auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+			if (benchmarkFrame(tDiff))
+			{
+				break;
+			}
+			if (!benchmark.active)
+			{
+				frameTimer = (float)tDiff / 1000.0f;
+			}
+			if (!paused)
+			{
+				timer += timerSpeed * frameTimer;
+				if (timer > 1.0)
+				{
+					timer -= 1.0f;
+				}
+			}
 		}
-		render();
-		auto tEnd = std::chrono::high_resolution_clock::now();
-		auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
-		frameTimer = (float)tDiff / 1000.0f;
-		// Convert to clamped timer value
-		if (!paused)
+	}
+	else
+	{
+#ifdef _WIN32
+		MSG msg;
+		while (TRUE)
 		{
-			timer += timerSpeed * frameTimer;
-			if (timer > 1.0)
+			auto tStart = std::chrono::high_resolution_clock::now();
+			PeekMessage(&msg, NULL, 0, 0, PM_REMOVE);
+			if (msg.message == WM_QUIT)
+			{
+				break;
+			}
+			else
 			{
-				timer -= 1.0f;
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
+			}
+			render();
+			auto tEnd = std::chrono::high_resolution_clock::now();
+			auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+			if (benchmarkFrame(tDiff))
+			{
+				break;
+			}
+			if (!benchmark.active)
+			{
+				frameTimer = (float)tDiff / 1000.0f;
+			}
+			// Convert to clamped timer value
+			if (!paused)
+			{
+				timer += timerSpeed * frameTimer;
+				if (timer > 1.0)
+				{
+					timer -= 1.0f;
+				}
 			}
 		}
-	}
 #else
-	xcb_flush(connection);
-	while (!quit)
-	{
-		auto tStart = std::chrono::high_resolution_clock::now();
-		xcb_generic_event_t *event;
-		event = xcb_poll_for_event(connection);
-		if (event) 
+		xcb_flush(connection);
+		while (!quit)
 		{
-			handleEvent(event);
-			free(event);
+			auto tStart = std::chrono::high_resolution_clock::now();
+			xcb_generic_event_t *event;
+			event = xcb_poll_for_event(connection);
+			if (event) 
+			{
+				handleEvent(event);
+				free(event);
+			}
+			render();
+			auto tEnd = std::chrono::high_resolution_clock::now();
+			auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+			if (benchmarkFrame(tDiff))
+			{
+				quit = true;
+			}
+			if (!benchmark.active)
+			{
+				frameTimer = tDiff / 1000.0f;
+			}
 		}
-		render();
-		auto tEnd = std::chrono::high_resolution_clock::now();
-		auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
-		frameTimer = tDiff / 1000.0f;
-}
 #endif
+	}
+	// Frames may still be in flight, make sure the GPU is done
+	// before the derived class starts destroying resources
+	vkDeviceWaitIdle(device);
+
+	if (benchmark.active)
+	{
+		// Collect GPU times of the last frames in flight
+		for (auto& frame : frames)
+		{
+			if (frame.timestampsPending)
+			{
+				readFrameTimestamps(frame);
+			}
+		}
+		benchmark.saveReport(name, deviceProperties.deviceName, width, height);
+	}
+
+	if (profiler.enabled)
+	{
+		profiler.collectAllResults();
+		profiler.print();
+		memoryAllocator.printStatistics();
+	}
 }
 
-// todo : comment
-void VulkanExampleBase::submitPostPresentBarrier(VkImage image)
+void VulkanExampleBase::saveFrame(uint32_t imageIndex, std::string filename)
 {
-	VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
+	VkResult err;
+	VkImage image = swapChain.buffers[imageIndex].image;
+	VkDeviceSize size = width * height * 4;
 
-	VkResult vkRes = vkBeginCommandBuffer(postPresentCmdBuffer, &cmdBufInfo);
-	assert(!vkRes);
+	// Host visible buffer the image is copied into
+	VkBuffer buffer;
+	vkTools::Allocation allocation;
+	createBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT, size, nullptr, &buffer, &allocation);
 
-	VkImageMemoryBarrier postPresentBarrier = vkTools::postPresentBarrier(image);
+	VkCommandBuffer copyCmd;
+	VkCommandBufferAllocateInfo cmdBufAllocateInfo =
+		vkTools::initializers::commandBufferAllocateInfo(
+			cmdPool,
+			VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+			1);
+	err = vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &copyCmd);
+	assert(!err);
 
+	VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
+	err = vkBeginCommandBuffer(copyCmd, &cmdBufInfo);
+	assert(!err);
+
+	// The render pass leaves the headless images in transfer source layout
+	// Make sure rendering has finished before copying
+	VkImageMemoryBarrier imageMemoryBarrier = vkTools::initializers::imageMemoryBarrier();
+	imageMemoryBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageMemoryBarrier.image = image;
+	imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
 	vkCmdPipelineBarrier(
-		postPresentCmdBuffer,
+		copyCmd,
 		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-		0,
-		0, NULL, // No memory barriers,
-		0, NULL, // No buffer barriers,
-		1, &postPresentBarrier);
-
-	vkRes = vkEndCommandBuffer(postPresentCmdBuffer);
-	assert(!vkRes);
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_FLAGS_NONE,
+		0, nullptr,
+		0, nullptr,
+		1, &imageMemoryBarrier);
+
+	VkBufferImageCopy copyRegion = {};
+	copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	copyRegion.imageSubresource.layerCount = 1;
+	copyRegion.imageExtent = { width, height, 1 };
+	vkCmdCopyImageToBuffer(copyCmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &copyRegion);
+
+	err = vkEndCommandBuffer(copyCmd);
+	assert(!err);
 
-	VkSubmitInfo submitInfo = {};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &postPresentCmdBuffer;
+	submitInfo.pCommandBuffers = &copyCmd;
 
-	vkRes = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-	assert(!vkRes);
+	err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+	assert(!err);
 
-	vkRes = vkQueueWaitIdle(queue);
-	assert(!vkRes);
+	err = vkQueueWaitIdle(queue);
+	assert(!err);
+
+	uint8_t *data = (uint8_t*)allocation.mapped;
+
+	// Buffer memory may not be host coherent
+	// The whole block is invalidated as the buffer's offset may not be
+	// a multiple of nonCoherentAtomSize
+	VkMappedMemoryRange mappedRange = {};
+	mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	mappedRange.memory = allocation.memory;
+	mappedRange.size = VK_WHOLE_SIZE;
+	vkInvalidateMappedMemoryRanges(device, 1, &mappedRange);
+
+	// PPM stores RGB, swizzle if the color format is BGR
+	bool swizzle = (colorformat == VK_FORMAT_B8G8R8A8_UNORM) || (colorformat == VK_FORMAT_B8G8R8A8_SRGB);
+
+	std::ofstream file(filename, std::ios::out | std::ios::binary);
+	file << "P6\n" << width << "\n" << height << "\n" << 255 << "\n";
+	for (uint32_t i = 0; i < width * height; i++)
+	{
+		uint8_t *pixel = data + i * 4;
+		if (swizzle)
+		{
+			file.put(pixel[2]);
+			file.put(pixel[1]);
+			file.put(pixel[0]);
+		}
+		else
+		{
+			file.write((char*)pixel, 3);
+		}
+	}
+	file.close();
+
+	vkFreeCommandBuffers(device, cmdPool, 1, &copyCmd);
+	vkDestroyBuffer(device, buffer, nullptr);
+	memoryAllocator.free(allocation);
 }
 
 VulkanExampleBase::VulkanExampleBase(bool enableValidation)
 {
-	// Check for validation command line flag
+	startupBegin = std::chrono::high_resolution_clock::now();
+
+	uint32_t benchmarkFrameCount = 0;
+	uint32_t benchmarkWarmupCount = 0;
+
+	// Check for command line flags
 #ifdef _WIN32
-	for (int32_t i = 0; i < __argc; i++)
+	if (args.empty())
 	{
-		if (__argv[i] == std::string("-validation"))
+		for (int32_t i = 0; i < __argc; i++)
 		{
-			enableValidation = true;
+			args.push_back(__argv[i]);
 		}
 	}
 #endif
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		if (args[i] == std::string("-validation"))
+		{
+			enableValidation = true;
+		}
+		if (args[i] == std::string("-headless"))
+		{
+			headless = true;
+		}
+		if ((args[i] == std::string("-frames")) && (i + 1 < args.size()))
+		{
+			headlessFrameCount = (uint32_t)atoi(args[i + 1]);
+		}
+		if (args[i] == std::string("-dumpframes"))
+		{
+			dumpFrames = true;
+		}
+		if ((args[i] == std::string("-benchmark")) && (i + 1 < args.size()))
+		{
+			benchmarkFrameCount = (uint32_t)atoi(args[i + 1]);
+		}
+		if (args[i] == std::string("-profile"))
+		{
+			profiler.enabled = true;
+		}
+		if (args[i] == std::string("-nomeshcache"))
+		{
+			useMeshCache = false;
+		}
+		if (args[i] == std::string("-optimizemeshes"))
+		{
+			optimizeMeshes = true;
+		}
+		if (args[i] == std::string("-clearpipelinecache"))
+		{
+			clearPipelineCache = true;
+		}
+		if ((args[i] == std::string("-warmup")) && (i + 1 < args.size()))
+		{
+			benchmarkWarmupCount = (uint32_t)atoi(args[i + 1]);
+		}
+		if ((args[i] == std::string("-streambudget")) && (i + 1 < args.size()))
+		{
+			streamingBudget = (uint32_t)atoi(args[i + 1]) * 1024;
+		}
+	}
+	if (benchmarkFrameCount > 0)
+	{
+		benchmark.setup(benchmarkFrameCount, benchmarkWarmupCount);
+	}
+	swapChain.headless = headless;
 
 #ifndef _WIN32
-	initxcbConnection();
+	if (!headless)
+	{
+		initxcbConnection();
+	}
 #endif
 	initVulkan(enableValidation);
 	// Enable console if validation is active
@@ -412,6 +987,7 @@ VulkanExampleBase::~VulkanExampleBase()
 
 	}
 	destroyCommandBuffers();
+	destroyFrameResources();
 	vkDestroyRenderPass(device, renderPass, nullptr);
 	for (uint32_t i = 0; i < frameBuffers.size(); i++)
 	{
@@ -424,17 +1000,26 @@ VulkanExampleBase::~VulkanExampleBase()
 	}
 	vkDestroyImageView(device, depthStencil.view, nullptr);
 	vkDestroyImage(device, depthStencil.image, nullptr);
-	vkFreeMemory(device, depthStencil.mem, nullptr);
+	memoryAllocator.free(depthStencil.allocation);
 
+	// Save the pipeline cache (now also containing this run's pipelines) for the next start
+	vkTools::VulkanPipelineCacheFile::save(vkTools::VulkanPipelineCacheFile::getFileName(name, deviceProperties), deviceProperties, device, pipelineCache);
 	vkDestroyPipelineCache(device, pipelineCache, nullptr);
 
+	textureCache.destroy();
 	if (textureLoader)
 	{
 		delete textureLoader;
 	}
+	textureStreamer.destroy();
+
+	uploadManager.destroy();
+	uniformRing.destroy();
 
 	vkDestroyCommandPool(device, cmdPool, nullptr);
 
+	memoryAllocator.destroy();
+
 	vkDestroyDevice(device, nullptr); 
 
 	if (enableValidation)
@@ -445,8 +1030,11 @@ VulkanExampleBase::~VulkanExampleBase()
 	vkDestroyInstance(instance, nullptr);
 
 #ifndef _WIN32
-	xcb_destroy_window(connection, window);
-	xcb_disconnect(connection);
+	if (!headless)
+	{
+		xcb_destroy_window(connection, window);
+		xcb_disconnect(connection);
+	}
 #endif 
 }
 
@@ -481,6 +1069,9 @@ void VulkanExampleBase::initVulkan(bool enableValidation)
 	// and want to use another one
 	physicalDevice = physicalDevices[0];
 
+	// Store properties (including limits) of the physical device
+	vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
 	// Find a queue that supports graphics operations
 	uint32_t graphicsQueueIndex = 0;
 	uint32_t queueCount;
@@ -497,29 +1088,66 @@ void VulkanExampleBase::initVulkan(bool enableValidation)
 			break;
 	}
 	assert(graphicsQueueIndex < queueCount);
+	graphicsQueueFamilyIndex = graphicsQueueIndex;
+
+	// Look for a queue family that only supports transfers (usually backed by a DMA engine)
+	// Falls back to a transfer capable family without graphics support
+	transferQueueFamilyIndex = UINT32_MAX;
+	for (uint32_t i = 0; i < queueCount; i++)
+	{
+		VkQueueFlags flags = queueProps[i].queueFlags;
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+		{
+			if ((transferQueueFamilyIndex == UINT32_MAX) || !(flags & VK_QUEUE_COMPUTE_BIT))
+			{
+				transferQueueFamilyIndex = i;
+			}
+		}
+	}
 
 	// Vulkan device
 	std::array<float, 1> queuePriorities = { 0.0f };
+	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 	VkDeviceQueueCreateInfo queueCreateInfo = {};
 	queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 	queueCreateInfo.queueFamilyIndex = graphicsQueueIndex;
 	queueCreateInfo.queueCount = 1;
 	queueCreateInfo.pQueuePriorities = queuePriorities.data();
+	queueCreateInfos.push_back(queueCreateInfo);
+
+	if (transferQueueFamilyIndex != UINT32_MAX)
+	{
+		queueCreateInfo.queueFamilyIndex = transferQueueFamilyIndex;
+		queueCreateInfos.push_back(queueCreateInfo);
+	}
 
-	err = createDevice(queueCreateInfo, enableValidation);
+	err = createDevice(queueCreateInfos, enableValidation);
 	assert(!err);
 
 	// Gather physical device memory properties
 	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &deviceMemoryProperties);
 
+	memoryAllocator.prepare(physicalDevice, device);
+
 	// Get the graphics queue
 	vkGetDeviceQueue(device, graphicsQueueIndex, 0, &queue);
 
+	// Get the transfer queue
+	if (transferQueueFamilyIndex != UINT32_MAX)
+	{
+		vkGetDeviceQueue(device, transferQueueFamilyIndex, 0, &transferQueue);
+	}
+	else
+	{
+		transferQueue = queue;
+		transferQueueFamilyIndex = graphicsQueueIndex;
+	}
+
 	// Find a suitable depth format
 	VkBool32 validDepthFormat = vkTools::getSupportedDepthFormat(physicalDevice, &depthFormat);
 	assert(validDepthFormat);
 
-	swapChain.connect(instance, physicalDevice, device);
+	swapChain.connect(instance, physicalDevice, device, &memoryAllocator);
 }
 
 #ifdef _WIN32 
@@ -540,6 +1168,12 @@ HWND VulkanExampleBase::setupWindow(HINSTANCE hinstance, WNDPROC wndproc)
 {
 	this->windowInstance = hinstance;
 
+	if (headless)
+	{
+		window = NULL;
+		return window;
+	}
+
 	bool fullscreen = false;
 
 	// Check command line arguments
@@ -720,6 +1354,12 @@ void VulkanExampleBase::handleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPAR
 // TODO : Not finished...
 xcb_window_t VulkanExampleBase::setupWindow()
 {
+	if (headless)
+	{
+		window = 0;
+		return window;
+	}
+
 	uint32_t value_mask, value_list[32];
 
 	window = xcb_generate_id(connection);
@@ -892,12 +1532,6 @@ void VulkanExampleBase::setupDepthStencil()
 	image.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 	image.flags = 0;
 
-	VkMemoryAllocateInfo mem_alloc = {};
-	mem_alloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	mem_alloc.pNext = NULL;
-	mem_alloc.allocationSize = 0;
-	mem_alloc.memoryTypeIndex = 0;
-
 	VkImageViewCreateInfo depthStencilView = {};
 	depthStencilView.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	depthStencilView.pNext = NULL;
@@ -911,19 +1545,12 @@ void VulkanExampleBase::setupDepthStencil()
 	depthStencilView.subresourceRange.baseArrayLayer = 0;
 	depthStencilView.subresourceRange.layerCount = 1;
 
-	VkMemoryRequirements memReqs;
 	VkResult err;
 
 	err = vkCreateImage(device, &image, nullptr, &depthStencil.image);
 	assert(!err);
-	vkGetImageMemoryRequirements(device, depthStencil.image, &memReqs);
-	mem_alloc.allocationSize = memReqs.size;
-	getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mem_alloc.memoryTypeIndex);
-	err = vkAllocateMemory(device, &mem_alloc, nullptr, &depthStencil.mem);
-	assert(!err);
+	depthStencil.allocation = memoryAllocator.allocateImage(depthStencil.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-	err = vkBindImageMemory(device, depthStencil.image, depthStencil.mem, 0);
-	assert(!err);
 	vkTools::setImageLayout(setupCmdBuffer, depthStencil.image, VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
 
 	depthStencilView.image = depthStencil.image;
@@ -958,7 +1585,7 @@ void VulkanExampleBase::setupFrameBuffer()
 	}
 }
 
-void VulkanExampleBase::setupRenderPass()
+VkRenderPass VulkanExampleBase::createRenderPass(VkImageLayout colorFinalLayout)
 {
 	VkAttachmentDescription attachments[2];
 	attachments[0].format = colorformat;
@@ -967,8 +1594,10 @@ void VulkanExampleBase::setupRenderPass()
 	attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 	attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-	attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	// The color attachment is cleared, so it's previous contents (and layout) can be discarded
+	attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[0].finalLayout = colorFinalLayout;
+	attachments[0].flags = 0;
 
 	attachments[1].format = depthFormat;
 	attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
@@ -978,6 +1607,7 @@ void VulkanExampleBase::setupRenderPass()
 	attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	attachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 	attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	attachments[1].flags = 0;
 
 	VkAttachmentReference colorReference = {};
 	colorReference.attachment = 0;
@@ -999,6 +1629,33 @@ void VulkanExampleBase::setupRenderPass()
 	subpass.preserveAttachmentCount = 0;
 	subpass.pPreserveAttachments = NULL;
 
+	// Subpass dependencies for the layout transitions done by the render pass
+	std::array<VkSubpassDependency, 2> dependencies;
+
+	// Start of the render pass
+	// The transition from the initial layout must wait until the presentation engine
+	// has released the image (the acquire semaphore is waited on at color attachment output)
+	// Also makes sure that depth writes of the previous frame have finished as
+	// the depth buffer is shared by all frames in flight
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dependencyFlags = 0;
+
+	// End of the render pass
+	// Color writes must be finished before the transition to the final layout
+	// (e.g. present or the layout expected by an offscreen example)
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+	dependencies[1].dependencyFlags = 0;
+
 	VkRenderPassCreateInfo renderPassInfo = {};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	renderPassInfo.pNext = NULL;
@@ -1006,17 +1663,32 @@ void VulkanExampleBase::setupRenderPass()
 	renderPassInfo.pAttachments = attachments;
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 0;
-	renderPassInfo.pDependencies = NULL;
+	renderPassInfo.dependencyCount = (uint32_t)dependencies.size();
+	renderPassInfo.pDependencies = dependencies.data();
 
-	VkResult err;
-
-	err = vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass);
+	VkRenderPass pass;
+	VkResult err = vkCreateRenderPass(device, &renderPassInfo, nullptr, &pass);
 	assert(!err);
+
+	return pass;
+}
+
+void VulkanExampleBase::setupRenderPass()
+{
+	// The color attachment is transitioned to present layout at the end of the render pass
+	// This replaces separate pre and post present image barriers
+	// Headless mode : The present layout requires the swap chain extension, the offscreen
+	// images are left in transfer source layout instead (e.g. for saving them to disk)
+	renderPass = createRenderPass(headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 }
 
 void VulkanExampleBase::initSwapchain()
 {
+	if (headless)
+	{
+		swapChain.initHeadless(colorformat);
+		return;
+	}
 #ifdef _WIN32
 	swapChain.initSurface(windowInstance, window);
 #else
@@ -1026,7 +1698,7 @@ void VulkanExampleBase::initSwapchain()
 
 void VulkanExampleBase::setupSwapChain()
 {
-	swapChain.create(setupCmdBuffer, &width, &height);
+	swapChain.create(&width, &height);
 }
 
 
@@ -27,7 +27,16 @@
 
 #include "vulkanswapchain.hpp"
 #include "vulkanTextureLoader.hpp"
+#include "vulkantexturestreamer.hpp"
+#include "vulkantexturecache.hpp"
 #include "vulkanMeshLoader.hpp"
+#include "vulkanvertexformat.hpp"
+#include "vulkanmeshcache.hpp"
+#include "vulkanbenchmark.hpp"
+#include "vulkanprofiler.hpp"
+#include "vulkanupload.hpp"
+#include "vulkanuniformring.hpp"
+#include "vulkanpipelinecache.hpp"
 
 #define deg_to_rad(deg) deg * float(M_PI / 180)
 
@@ -39,7 +48,7 @@ private:
 	// Create application wide Vulkan instance
 	VkResult createInstance(bool enableValidation);
 	// Create logical Vulkan device based on physical device
-	VkResult createDevice(VkDeviceQueueCreateInfo requestedQueues, bool enableValidation);
+	VkResult createDevice(std::vector<VkDeviceQueueCreateInfo> requestedQueues, bool enableValidation);
 protected:
 	// Last frame time, measured using a high performance timer (if available)
 	float frameTimer = 1.0f;
@@ -47,12 +56,28 @@ protected:
 	VkInstance instance;
 	// Physical device (GPU) that Vulkan will ise
 	VkPhysicalDevice physicalDevice;
+	// Stores physical device properties (e.g. limits, device name)
+	VkPhysicalDeviceProperties deviceProperties;
 	// Stores all available memory (type) properties for the physical device
 	VkPhysicalDeviceMemoryProperties deviceMemoryProperties;
+	// Sub-allocates device memory for buffers and images from larger blocks
+	vkTools::VulkanMemoryAllocator memoryAllocator;
+	// Uploads static buffer data to device local memory via a staging buffer
+	// Pending uploads are flushed at the start of the next frame
+	vkTools::VulkanUploadManager uploadManager;
+	// Persistently mapped uniform buffer with one region per swap chain image
+	// Bind allocations as dynamic uniform buffers with uniformRing.getDynamicOffset(i)
+	// for draw command buffer i, updates during a frame go straight into the acquired image's region
+	vkTools::VulkanUniformRing uniformRing;
 	// Logical device, application's view of the physical device (GPU)
 	VkDevice device;
 	// Handle to the device graphics queue that command buffers are submitted to
 	VkQueue queue;
+	uint32_t graphicsQueueFamilyIndex;
+	// Queue used for asynchronous texture uploads
+	// Dedicated transfer queue if the device has one, the graphics queue otherwise
+	VkQueue transferQueue;
+	uint32_t transferQueueFamilyIndex;
 	// Color buffer format
 	VkFormat colorformat = VK_FORMAT_B8G8R8A8_UNORM;
 	// Depth buffer format
@@ -62,10 +87,40 @@ protected:
 	VkCommandPool cmdPool;
 	// Command buffer used for setup
 	VkCommandBuffer setupCmdBuffer = VK_NULL_HANDLE;
-	// Command buffer for submitting a post present barrier
-	VkCommandBuffer postPresentCmdBuffer = VK_NULL_HANDLE;
 	// Command buffers used for rendering
 	std::vector<VkCommandBuffer> drawCmdBuffers;
+	// Synchronization primitives and command buffer for
+	// one frame that may be in flight on the GPU
+	struct FrameResources
+	{
+		// Signaled once the GPU has finished the frame's submission
+		VkFence fence;
+		// Signaled once the acquired swap chain image is ready
+		VkSemaphore presentComplete;
+		// Signaled once rendering is done, waited on by present
+		VkSemaphore renderComplete;
+		// Per-frame command buffer for query resets and start of frame timestamps
+		// Re-recorded every time the frame slot is used
+		VkCommandBuffer cmdBuffer;
+		// Writes the end of frame timestamp (benchmark mode only)
+		VkCommandBuffer timestampCmdBuffer;
+		// Number of the frame last submitted with this slot
+		uint32_t frameNumber;
+		// True if timestamps have been written for frameNumber
+		bool timestampsPending = false;
+	};
+	// Ring of frame resources (see framesInFlight)
+	std::vector<FrameResources> frames;
+	// Index of the frame slot currently being recorded
+	uint32_t currentFrame = 0;
+	// Fence of the frame that last rendered to each swap chain image
+	// Used to make sure that an image's draw command buffer is no longer
+	// pending before it's submitted again
+	std::vector<VkFence> imageFences;
+	// Query pool with a begin and end timestamp for each frame slot (benchmark mode only)
+	VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+	// Time spent in beginFrame for the last frame (in ms)
+	double acquireTime = 0.0;
 	// Global render pass for frame buffer writes
 	VkRenderPass renderPass;
 	// List of available frame buffers (same as number of swap chain images)
@@ -82,11 +137,54 @@ protected:
 	VulkanSwapChain swapChain;
 	// Simple texture loader
 	vkTools::VulkanTextureLoader *textureLoader = nullptr;
+	// Loads textures through the texture loader only once and shares them between users
+	vkTools::VulkanTextureCache textureCache;
+	// Streams the mip levels of textures in over several frames, smallest levels first
+	// Uploads at most streamingBudget bytes per frame ("-streambudget <kb>")
+	vkTools::VulkanTextureStreamer textureStreamer;
+	uint32_t streamingBudget = 1024 * 1024;
 public: 
 	bool prepared = false;
+	// Command line arguments
+	// Need to be set in main before the example is created (Windows uses __argv)
+	static std::vector<const char*> args;
+	// Headless mode, renders to offscreen images instead of a window 
+	// Enabled with the "-headless" command line argument
+	bool headless = false;
+	// Number of frames to render in headless mode ("-frames <n>")
+	uint32_t headlessFrameCount = 100;
+	// Save each rendered frame to a PPM file in headless mode ("-dumpframes")
+	bool dumpFrames = false;
+	// Number of frames submitted so far
+	uint32_t frameCounter = 0;
+	// Benchmark mode ("-benchmark <frames> [-warmup <frames>]")
+	// Renders a fixed number of frames with a fixed time step and 
+	// saves frame time statistics to <name>_benchmark.json/.csv
+	vkTools::VulkanBenchmark benchmark;
+	// GPU timestamp profiler for named scopes ("-profile")
+	// Results are printed once the render loop has finished
+	vkTools::VulkanProfiler profiler;
+	// Pipeline cache contents are loaded from and saved to <name>_pipelinecache_<vendor>_<device>.bin
+	// Start with an empty cache with "-clearpipelinecache" (e.g. to measure a cold start)
+	bool clearPipelineCache = false;
+	// Meshes loaded with loadMesh are cached in a binary file next to the source asset
+	// Disable with "-nomeshcache" (always imports via ASSIMP and doesn't write the cache)
+	bool useMeshCache = true;
+	// Optimize meshes loaded with loadMesh for vertex cache, overdraw and vertex fetch ("-optimizemeshes")
+	// The ACMR and ATVR before and after are printed for each mesh
+	bool optimizeMeshes = false;
+	// True if pipeline cache data from a previous run was loaded
+	bool pipelineCacheWarm = false;
+	// Time from creating the example to the start of the render loop (in milliseconds)
+	double startupTime = 0.0;
+	std::chrono::high_resolution_clock::time_point startupBegin;
 	uint32_t width = 1280;
 	uint32_t height = 720;
 
+	// Max. number of frames the CPU may record and submit ahead of the GPU
+	// Change in the derived class constructor (before prepare is called)
+	uint32_t framesInFlight = 2;
+
 	VkClearColorValue defaultClearColor = { { 0.025f, 0.025f, 0.025f, 1.0f } };
 
 	float zoom = 0;
@@ -113,7 +211,7 @@ public:
 	struct 
 	{
 		VkImage image;
-		VkDeviceMemory mem;
+		vkTools::Allocation allocation;
 		VkImageView view;
 	} depthStencil;
 
@@ -165,7 +263,11 @@ public:
 	void setupDepthStencil();
 	// Create framebuffers for all requested swap chain images
 	void setupFrameBuffer();
+	// Create a render pass with a color (colorformat) and depth attachment
+	// The color attachment is cleared and transitioned to the given layout at the end of the pass
+	VkRenderPass createRenderPass(VkImageLayout colorFinalLayout);
 	// Setup a default render pass
+	// Transitions the swap chain images to present layout
 	void setupRenderPass();
 
 	// Connect and prepare the swap chain
@@ -185,6 +287,21 @@ public:
 	// Finalize setup command bufferm submit it to the queue and remove it
 	void flushSetupCommandBuffer();
 
+	// Create fences, semaphores and command buffers for all frames in flight
+	void createFrameResources();
+	// Destroy all per-frame resources
+	void destroyFrameResources();
+	// Wait until the current frame slot is free and acquire the next swap chain image
+	// Sets currentBuffer to the index of the acquired image
+	void beginFrame();
+	// Submit the current image's draw command buffer and present it
+	void submitFrame();
+	// Submit the given command buffers (in order) for the current frame and present
+	// The submission waits for the acquired image and signals the frame's fence
+	void submitFrame(std::vector<VkCommandBuffer> commandBuffers);
+	// Returns true if the frame command buffer needs to be recorded and submitted
+	bool frameCmdBufferRequired();
+
 	// Create a cache pool for rendering pipelines
 	void createPipelineCache();
 
@@ -199,33 +316,87 @@ public:
 
 	// Create a buffer, fill it with data and bind buffer memory
 	// Can be used for e.g. vertex or index buffer based on mesh data
+	// Vertex and index buffers are placed in device local memory and filled
+	// through the upload manager, all other buffers are host visible and their 
+	// data can be accessed through allocation->mapped
+	VkBool32 createBuffer(
+		VkBufferUsageFlags usage,
+		VkDeviceSize size,
+		void *data,
+		VkBuffer *buffer,
+		vkTools::Allocation *allocation);
+	// Overload with explicit memory placement
+	// Use VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT for vertex buffers that are updated by the host
 	VkBool32 createBuffer(
 		VkBufferUsageFlags usage,
+		VkMemoryPropertyFlags memoryPropertyFlags,
 		VkDeviceSize size,
 		void *data,
 		VkBuffer *buffer,
-		VkDeviceMemory *memory);
+		vkTools::Allocation *allocation);
 	// Overload that assigns buffer info to descriptor
 	VkBool32 createBuffer(
 		VkBufferUsageFlags usage,
 		VkDeviceSize size,
 		void *data,
 		VkBuffer *buffer,
-		VkDeviceMemory *memory,
+		vkTools::Allocation *allocation,
 		VkDescriptorBufferInfo *descriptor);
 
+	// Load a mesh via ASSIMP, optimize it if enabled, split it up for 16 bit indices
+	// and generate lodCount levels of detail
+	VulkanMeshLoader *importMesh(const char *filename, uint32_t lodCount = 0);
+
 	// Load a mesh (using ASSIMP) and create vulkan vertex and index buffers with given vertex layout
+	// Up to lodCount levels of detail are generated and stored in meshBuffer->lods
 	void loadMesh(
 		const char *filename,
 		vkMeshLoader::MeshBuffer *meshBuffer,
 		std::vector<vkMeshLoader::VertexLayout> vertexLayout,
-		float scale);
+		float scale,
+		uint32_t lodCount = 0);
+
+	// Load a mesh with a compile time vertex format (see vulkanvertexformat.hpp)
+	template <typename Format>
+	void loadMesh(
+		const char *filename,
+		vkMeshLoader::MeshBuffer *meshBuffer,
+		float scale,
+		uint32_t lodCount = 0)
+	{
+		if (useMeshCache && vkMeshLoader::MeshCache::load(filename, Format::layout(), scale, VulkanMeshLoader::defaultFlags, device, &memoryAllocator, &uploadManager, meshBuffer, optimizeMeshes, lodCount))
+		{
+			return;
+		}
+
+		VulkanMeshLoader *mesh = importMesh(filename, lodCount);
+
+		mesh->createVulkanBuffers<Format>(
+			device,
+			&memoryAllocator,
+			meshBuffer,
+			scale,
+			&uploadManager);
+
+		if (useMeshCache)
+		{
+			vkMeshLoader::MeshCache::save(filename, Format::layout(), scale, VulkanMeshLoader::defaultFlags, mesh, optimizeMeshes, lodCount);
+		}
+
+		delete(mesh);
+	}
 
 	// Start the main render loop
 	void renderLoop();
 
-	// Submit a post present image barrier to the queue
-	// Transforms image layout back to color attachment layout
-	void submitPostPresentBarrier(VkImage image);
+	// Read back the GPU timestamps of a frame slot and pass them to the benchmark
+	void readFrameTimestamps(FrameResources &frame);
+	// Store timings of the last rendered frame
+	// Returns true once all benchmark frames have been rendered
+	bool benchmarkFrame(double cpuTime);
+
+	// Copy a headless swap chain image to host memory and save it as a binary PPM file
+	// The image is expected to be in transfer source layout (after the render pass has ended)
+	void saveFrame(uint32_t imageIndex, std::string filename);
 };
 
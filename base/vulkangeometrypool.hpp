@@ -0,0 +1,277 @@
+/*
+* Geometry pool
+*
+* Sub-allocates the vertices and indices of many meshes from one large vertex
+* and one large index buffer. Meshes are referenced by their vertex offset and index
+* range, so all meshes of a scene are drawn with a single vertex and index buffer binding
+* Freed ranges are merged and reused by later allocations
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+#include <vulkan/vulkan.h>
+#include "vulkantools.h"
+#include "vulkanmemory.hpp"
+#include "vulkanupload.hpp"
+
+namespace vkTools
+{
+
+	// Vertices and indices of a mesh in a geometry pool
+	// Indices are relative to the mesh's first vertex, draw with vertexOffset
+	struct GeometryRange
+	{
+		int32_t vertexOffset = 0;
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+		uint32_t vertexCount = 0;
+
+		bool valid() const
+		{
+			return vertexCount > 0;
+		}
+	};
+
+	// First fit allocator for ranges of elements, adjacent free ranges are merged
+	class RangeAllocator
+	{
+	private:
+		struct Range
+		{
+			uint32_t offset;
+			uint32_t size;
+		};
+		// Free ranges sorted by offset
+		std::vector<Range> freeRanges;
+		uint32_t capacity = 0;
+		uint32_t used = 0;
+
+	public:
+		void reset(uint32_t capacity)
+		{
+			this->capacity = capacity;
+			used = 0;
+			freeRanges.clear();
+			if (capacity > 0)
+			{
+				freeRanges.push_back({ 0, capacity });
+			}
+		}
+
+		// Returns false if there is no free range of at least size elements
+		bool allocate(uint32_t size, uint32_t *offset)
+		{
+			for (size_t i = 0; i < freeRanges.size(); i++)
+			{
+				Range &range = freeRanges[i];
+				if (range.size < size)
+				{
+					continue;
+				}
+				*offset = range.offset;
+				range.offset += size;
+				range.size -= size;
+				if (range.size == 0)
+				{
+					freeRanges.erase(freeRanges.begin() + i);
+				}
+				used += size;
+				return true;
+			}
+			return false;
+		}
+
+		void free(uint32_t offset, uint32_t size)
+		{
+			auto next = std::upper_bound(freeRanges.begin(), freeRanges.end(), offset, [](uint32_t offset, const Range &range) { return offset < range.offset; });
+			assert((next == freeRanges.end()) || (offset + size <= next->offset));
+			assert((next == freeRanges.begin()) || ((next - 1)->offset + (next - 1)->size <= offset));
+			used -= size;
+			// Merge with the free neighbours
+			if ((next != freeRanges.begin()) && ((next - 1)->offset + (next - 1)->size == offset))
+			{
+				auto prev = next - 1;
+				prev->size += size;
+				if ((next != freeRanges.end()) && (prev->offset + prev->size == next->offset))
+				{
+					prev->size += next->size;
+					freeRanges.erase(next);
+				}
+				return;
+			}
+			if ((next != freeRanges.end()) && (offset + size == next->offset))
+			{
+				next->offset = offset;
+				next->size += size;
+				return;
+			}
+			freeRanges.insert(next, { offset, size });
+		}
+
+		uint32_t getCapacity()
+		{
+			return capacity;
+		}
+
+		uint32_t getUsed()
+		{
+			return used;
+		}
+
+		// Size of the largest free range
+		uint32_t getLargestFree()
+		{
+			uint32_t largest = 0;
+			for (auto& range : freeRanges)
+			{
+				largest = std::max(largest, range.size);
+			}
+			return largest;
+		}
+	};
+
+	class VulkanGeometryPool
+	{
+	private:
+		VkDevice device = VK_NULL_HANDLE;
+		VulkanMemoryAllocator *allocator;
+		VulkanUploadManager *uploadManager;
+		uint32_t vertexStride = 0;
+
+		VkBuffer vertexBuffer = VK_NULL_HANDLE;
+		Allocation vertexMemory;
+		VkBuffer indexBuffer = VK_NULL_HANDLE;
+		Allocation indexMemory;
+
+		RangeAllocator vertexRanges;
+		RangeAllocator indexRanges;
+
+		void createBuffer(VkBufferUsageFlags usage, VkDeviceSize size, VkBuffer *buffer, Allocation *memory)
+		{
+			VkBufferCreateInfo bufferInfo = vkTools::initializers::bufferCreateInfo(usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, size);
+			VkResult err = vkCreateBuffer(device, &bufferInfo, nullptr, buffer);
+			assert(!err);
+			*memory = allocator->allocateBuffer(*buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+
+	public:
+		// Create the (device local) pool buffers with room for vertexCapacity vertices
+		// of vertexStride bytes and indexCapacity 32 bit indices
+		void prepare(VkDevice device, VulkanMemoryAllocator *allocator, VulkanUploadManager *uploadManager, uint32_t vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity)
+		{
+			assert((vertexStride > 0) && (vertexCapacity > 0) && (indexCapacity > 0));
+			this->device = device;
+			this->allocator = allocator;
+			this->uploadManager = uploadManager;
+			this->vertexStride = vertexStride;
+
+			createBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, (VkDeviceSize)vertexCapacity * vertexStride, &vertexBuffer, &vertexMemory);
+			createBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, (VkDeviceSize)indexCapacity * sizeof(uint32_t), &indexBuffer, &indexMemory);
+			vertexRanges.reset(vertexCapacity);
+			indexRanges.reset(indexCapacity);
+		}
+
+		void destroy()
+		{
+			if (device == VK_NULL_HANDLE)
+			{
+				return;
+			}
+			vkDestroyBuffer(device, vertexBuffer, nullptr);
+			allocator->free(vertexMemory);
+			vkDestroyBuffer(device, indexBuffer, nullptr);
+			allocator->free(indexMemory);
+			device = VK_NULL_HANDLE;
+		}
+
+		// Allocate ranges for a mesh and upload it's data (on the upload manager's next flush)
+		// indices are relative to the mesh's first vertex
+		// Returns an invalid range if the pool doesn't have enough free space
+		GeometryRange allocate(const void *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount)
+		{
+			assert(device != VK_NULL_HANDLE);
+			GeometryRange range;
+			uint32_t vertexOffset, firstIndex;
+			if ((vertexCount == 0) || !vertexRanges.allocate(vertexCount, &vertexOffset))
+			{
+				return range;
+			}
+			if ((indexCount > 0) && !indexRanges.allocate(indexCount, &firstIndex))
+			{
+				vertexRanges.free(vertexOffset, vertexCount);
+				return range;
+			}
+			range.vertexOffset = (int32_t)vertexOffset;
+			range.vertexCount = vertexCount;
+			range.firstIndex = (indexCount > 0) ? firstIndex : 0;
+			range.indexCount = indexCount;
+
+			uploadManager->upload(vertexBuffer, vertices, (VkDeviceSize)vertexCount * vertexStride, (VkDeviceSize)vertexOffset * vertexStride);
+			if (indexCount > 0)
+			{
+				uploadManager->upload(indexBuffer, indices, (VkDeviceSize)indexCount * sizeof(uint32_t), (VkDeviceSize)firstIndex * sizeof(uint32_t));
+			}
+			return range;
+		}
+
+		// Return a mesh's ranges to the pool
+		// The mesh must no longer be used by any pending command buffers
+		void free(GeometryRange &range)
+		{
+			if (!range.valid())
+			{
+				return;
+			}
+			vertexRanges.free((uint32_t)range.vertexOffset, range.vertexCount);
+			if (range.indexCount > 0)
+			{
+				indexRanges.free(range.firstIndex, range.indexCount);
+			}
+			range = GeometryRange();
+		}
+
+		// Bind the pool's vertex and index buffer, once for all meshes of the pool
+		void bind(VkCommandBuffer cmdBuffer, uint32_t binding)
+		{
+			VkDeviceSize offsets[1] = { 0 };
+			vkCmdBindVertexBuffers(cmdBuffer, binding, 1, &vertexBuffer, offsets);
+			vkCmdBindIndexBuffer(cmdBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		}
+
+		void draw(VkCommandBuffer cmdBuffer, const GeometryRange &range, uint32_t instanceCount = 1, uint32_t firstInstance = 0)
+		{
+			vkCmdDrawIndexed(cmdBuffer, range.indexCount, instanceCount, range.firstIndex, range.vertexOffset, firstInstance);
+		}
+
+		VkBuffer getVertexBuffer()
+		{
+			return vertexBuffer;
+		}
+
+		VkBuffer getIndexBuffer()
+		{
+			return indexBuffer;
+		}
+
+		uint32_t getVertexStride()
+		{
+			return vertexStride;
+		}
+
+		RangeAllocator &getVertexRanges()
+		{
+			return vertexRanges;
+		}
+
+		RangeAllocator &getIndexRanges()
+		{
+			return indexRanges;
+		}
+	};
+
+}
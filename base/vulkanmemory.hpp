@@ -0,0 +1,433 @@
+/*
+* Device memory sub-allocator
+*
+* Resources are placed into large memory blocks (one list of blocks per memory type)
+* instead of doing a separate vkAllocateMemory for each buffer and image
+* Large images get a dedicated allocation
+* Host visible blocks are persistently mapped
+*/
+
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <assert.h>
+
+#include <vulkan/vulkan.h>
+
+namespace vkTools
+{
+
+	class VulkanMemoryAllocator;
+
+	// Type of resource bound to a memory range
+	// Linear (buffers, linear tiled images) and optimal (optimal tiled images) resources
+	// that share a page of bufferImageGranularity bytes may alias, so they are kept apart
+	enum AllocationType
+	{
+		ALLOCATION_TYPE_FREE = 0,
+		ALLOCATION_TYPE_LINEAR = 1,
+		ALLOCATION_TYPE_OPTIMAL = 2
+	};
+
+	// Memory range returned by the allocator
+	struct Allocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		uint32_t memoryTypeIndex = 0;
+		// Host pointer to the start of the range (host visible memory only)
+		void *mapped = nullptr;
+		// True if the range has it's own device memory allocation
+		bool dedicated = false;
+		// Allocator the range belongs to, nullptr if not allocated
+		VulkanMemoryAllocator *allocator = nullptr;
+
+		// Return the range to it's allocator
+		inline void free();
+	};
+
+	class VulkanMemoryAllocator
+	{
+	public:
+		struct Statistics
+		{
+			// Number of vkAllocateMemory calls currently alive
+			uint32_t deviceMemoryCount = 0;
+			uint32_t blockCount = 0;
+			uint32_t dedicatedCount = 0;
+			// Number of live sub-allocations (without dedicated allocations)
+			uint32_t allocationCount = 0;
+			VkDeviceSize blockBytes = 0;
+			VkDeviceSize dedicatedBytes = 0;
+			// Bytes used by sub-allocations inside of blocks (including alignment padding)
+			VkDeviceSize usedBytes = 0;
+		};
+
+	private:
+		VkDevice device = VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		VkDeviceSize bufferImageGranularity = 1;
+		uint32_t maxAllocationCount = 0;
+		VkDeviceSize preferredBlockSize = 0;
+
+		struct Range
+		{
+			VkDeviceSize offset;
+			VkDeviceSize size;
+			AllocationType type;
+		};
+
+		struct MemoryBlock
+		{
+			VkDeviceMemory memory;
+			VkDeviceSize size;
+			VkDeviceSize used = 0;
+			void *mapped = nullptr;
+			// Sorted list of used and free ranges covering the whole block
+			// Adjacent free ranges are always merged
+			std::vector<Range> ranges;
+		};
+
+		// Blocks for each memory type
+		std::vector<MemoryBlock*> blocks[VK_MAX_MEMORY_TYPES];
+
+		Statistics stats;
+		std::mutex mutex;
+
+		static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		// Returns true if both addresses are on the same bufferImageGranularity page
+		bool onSamePage(VkDeviceSize a, VkDeviceSize b)
+		{
+			return (a / bufferImageGranularity) == (b / bufferImageGranularity);
+		}
+
+		static bool typesConflict(AllocationType a, AllocationType b)
+		{
+			return (a != ALLOCATION_TYPE_FREE) && (b != ALLOCATION_TYPE_FREE) && (a != b);
+		}
+
+		VkDeviceSize getBlockSize(uint32_t memoryTypeIndex)
+		{
+			// Use smaller blocks for small heaps
+			VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+			return std::min(preferredBlockSize, heapSize / 8);
+		}
+
+		VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void **mapped)
+		{
+			if ((maxAllocationCount > 0) && (stats.deviceMemoryCount >= maxAllocationCount))
+			{
+				std::cout << "Device memory allocation count exceeds maxMemoryAllocationCount (" << maxAllocationCount << ")\n";
+			}
+
+			VkMemoryAllocateInfo memAlloc = {};
+			memAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			memAlloc.allocationSize = size;
+			memAlloc.memoryTypeIndex = memoryTypeIndex;
+			VkDeviceMemory memory;
+			VkResult err = vkAllocateMemory(device, &memAlloc, nullptr, &memory);
+			assert(!err);
+
+			*mapped = nullptr;
+			if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+			{
+				err = vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped);
+				assert(!err);
+			}
+			stats.deviceMemoryCount++;
+			return memory;
+		}
+
+		void freeDeviceMemory(VkDeviceMemory memory)
+		{
+			// Memory is implicitly unmapped when freed
+			vkFreeMemory(device, memory, nullptr);
+			stats.deviceMemoryCount--;
+		}
+
+		// Try to place a range inside of a block (first fit)
+		bool allocateFromBlock(MemoryBlock *block, VkDeviceSize size, VkDeviceSize alignment, AllocationType type, VkDeviceSize *offset)
+		{
+			if (block->size - block->used < size)
+			{
+				return false;
+			}
+			for (size_t i = 0; i < block->ranges.size(); i++)
+			{
+				Range &range = block->ranges[i];
+				if ((range.type != ALLOCATION_TYPE_FREE) || (range.size < size))
+				{
+					continue;
+				}
+
+				VkDeviceSize start = alignUp(range.offset, alignment);
+				// Move to the next page if the previous resource is of a different type
+				if ((i > 0) && typesConflict(block->ranges[i - 1].type, type))
+				{
+					Range &prev = block->ranges[i - 1];
+					if (onSamePage(prev.offset + prev.size - 1, start))
+					{
+						start = alignUp(start, bufferImageGranularity);
+					}
+				}
+				VkDeviceSize end = start + size;
+				if (end > range.offset + range.size)
+				{
+					continue;
+				}
+				// Can't share the last page with the next resource either
+				if ((i + 1 < block->ranges.size()) && typesConflict(block->ranges[i + 1].type, type))
+				{
+					if (onSamePage(end - 1, block->ranges[i + 1].offset))
+					{
+						continue;
+					}
+				}
+
+				// Split the free range into [padding][allocation][remainder]
+				Range padding = { range.offset, start - range.offset, ALLOCATION_TYPE_FREE };
+				Range remainder = { end, range.offset + range.size - end, ALLOCATION_TYPE_FREE };
+				range.offset = start;
+				range.size = size;
+				range.type = type;
+				if (remainder.size > 0)
+				{
+					block->ranges.insert(block->ranges.begin() + i + 1, remainder);
+				}
+				if (padding.size > 0)
+				{
+					block->ranges.insert(block->ranges.begin() + i, padding);
+				}
+
+				block->used += size;
+				*offset = start;
+				return true;
+			}
+			return false;
+		}
+
+		void freeFromBlock(MemoryBlock *block, VkDeviceSize offset)
+		{
+			for (size_t i = 0; i < block->ranges.size(); i++)
+			{
+				if ((block->ranges[i].offset != offset) || (block->ranges[i].type == ALLOCATION_TYPE_FREE))
+				{
+					continue;
+				}
+				block->ranges[i].type = ALLOCATION_TYPE_FREE;
+				block->used -= block->ranges[i].size;
+				stats.usedBytes -= block->ranges[i].size;
+				// Merge with free neighbours
+				if ((i + 1 < block->ranges.size()) && (block->ranges[i + 1].type == ALLOCATION_TYPE_FREE))
+				{
+					block->ranges[i].size += block->ranges[i + 1].size;
+					block->ranges.erase(block->ranges.begin() + i + 1);
+				}
+				if ((i > 0) && (block->ranges[i - 1].type == ALLOCATION_TYPE_FREE))
+				{
+					block->ranges[i - 1].size += block->ranges[i].size;
+					block->ranges.erase(block->ranges.begin() + i);
+				}
+				return;
+			}
+			assert(false && "Range not found in memory block");
+		}
+
+	public:
+		// Images with at least this size get a dedicated allocation
+		VkDeviceSize dedicatedImageSize = 0;
+
+		// Read device limits and memory properties
+		// Block size is reduced for heaps smaller than 8 blocks
+		void prepare(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize blockSize = 64 * 1024 * 1024)
+		{
+			this->device = device;
+			preferredBlockSize = blockSize;
+			dedicatedImageSize = blockSize / 4;
+
+			vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+			VkPhysicalDeviceProperties deviceProperties;
+			vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+			bufferImageGranularity = std::max(deviceProperties.limits.bufferImageGranularity, (VkDeviceSize)1);
+			maxAllocationCount = deviceProperties.limits.maxMemoryAllocationCount;
+		}
+
+		// Free all memory blocks
+		// All resources must have been destroyed before
+		void destroy()
+		{
+			for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
+			{
+				for (auto& block : blocks[i])
+				{
+					freeDeviceMemory(block->memory);
+					delete block;
+				}
+				blocks[i].clear();
+			}
+			if ((stats.allocationCount > 0) || (stats.dedicatedCount > 0))
+			{
+				std::cout << "Memory allocator destroyed with " << stats.allocationCount << " allocations and " << stats.dedicatedCount << " dedicated allocations still alive\n";
+			}
+		}
+
+		// Get the index of the first memory type that supports the requested properties
+		bool getMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties, uint32_t *typeIndex)
+		{
+			for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+			{
+				if ((typeBits & (1 << i)) && ((memoryProperties.memoryTypes[i].propertyFlags & properties) == properties))
+				{
+					*typeIndex = i;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Allocate a memory range matching the given requirements
+		Allocation allocate(VkMemoryRequirements memReqs, VkMemoryPropertyFlags properties, AllocationType type, bool dedicated = false)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			Allocation allocation;
+			bool found = getMemoryType(memReqs.memoryTypeBits, properties, &allocation.memoryTypeIndex);
+			assert(found);
+			allocation.size = memReqs.size;
+			allocation.allocator = this;
+
+			VkDeviceSize blockSize = getBlockSize(allocation.memoryTypeIndex);
+			if (dedicated || (memReqs.size > blockSize / 2))
+			{
+				allocation.memory = allocateDeviceMemory(memReqs.size, allocation.memoryTypeIndex, &allocation.mapped);
+				allocation.dedicated = true;
+				stats.dedicatedCount++;
+				stats.dedicatedBytes += memReqs.size;
+				return allocation;
+			}
+
+			VkDeviceSize alignment = std::max(memReqs.alignment, (VkDeviceSize)1);
+			std::vector<MemoryBlock*> &typeBlocks = blocks[allocation.memoryTypeIndex];
+			for (auto& block : typeBlocks)
+			{
+				if (allocateFromBlock(block, memReqs.size, alignment, type, &allocation.offset))
+				{
+					allocation.memory = block->memory;
+					allocation.mapped = block->mapped ? (uint8_t*)block->mapped + allocation.offset : nullptr;
+					stats.allocationCount++;
+					stats.usedBytes += memReqs.size;
+					return allocation;
+				}
+			}
+
+			// No space left in existing blocks
+			MemoryBlock *block = new MemoryBlock();
+			block->size = blockSize;
+			block->memory = allocateDeviceMemory(blockSize, allocation.memoryTypeIndex, &block->mapped);
+			block->ranges.push_back({ 0, blockSize, ALLOCATION_TYPE_FREE });
+			typeBlocks.push_back(block);
+			stats.blockCount++;
+			stats.blockBytes += blockSize;
+
+			found = allocateFromBlock(block, memReqs.size, alignment, type, &allocation.offset);
+			assert(found);
+			allocation.memory = block->memory;
+			allocation.mapped = block->mapped ? (uint8_t*)block->mapped + allocation.offset : nullptr;
+			stats.allocationCount++;
+			stats.usedBytes += memReqs.size;
+			return allocation;
+		}
+
+		// Allocate memory for a buffer and bind it
+		Allocation allocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties)
+		{
+			VkMemoryRequirements memReqs;
+			vkGetBufferMemoryRequirements(device, buffer, &memReqs);
+			Allocation allocation = allocate(memReqs, properties, ALLOCATION_TYPE_LINEAR);
+			VkResult err = vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+			assert(!err);
+			return allocation;
+		}
+
+		// Allocate memory for an image and bind it
+		// Images larger than dedicatedImageSize get their own allocation
+		Allocation allocateImage(VkImage image, VkMemoryPropertyFlags properties, VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL)
+		{
+			VkMemoryRequirements memReqs;
+			vkGetImageMemoryRequirements(device, image, &memReqs);
+			AllocationType type = (tiling == VK_IMAGE_TILING_LINEAR) ? ALLOCATION_TYPE_LINEAR : ALLOCATION_TYPE_OPTIMAL;
+			Allocation allocation = allocate(memReqs, properties, type, memReqs.size >= dedicatedImageSize);
+			VkResult err = vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+			assert(!err);
+			return allocation;
+		}
+
+		// Return a memory range to the allocator
+		// Empty blocks are kept for later allocations
+		void free(Allocation &allocation)
+		{
+			if (allocation.memory == VK_NULL_HANDLE)
+			{
+				return;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (allocation.dedicated)
+			{
+				freeDeviceMemory(allocation.memory);
+				stats.dedicatedCount--;
+				stats.dedicatedBytes -= allocation.size;
+			}
+			else
+			{
+				for (auto& block : blocks[allocation.memoryTypeIndex])
+				{
+					if (block->memory == allocation.memory)
+					{
+						freeFromBlock(block, allocation.offset);
+						break;
+					}
+				}
+				stats.allocationCount--;
+			}
+			allocation = Allocation();
+		}
+
+		Statistics getStatistics()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return stats;
+		}
+
+		// Print current usage statistics
+		void printStatistics()
+		{
+			Statistics current = getStatistics();
+			const double mb = 1024.0 * 1024.0;
+			std::cout << "Device memory allocator :\n";
+			std::cout << std::fixed << std::setprecision(2);
+			std::cout << "  device memory allocations " << current.deviceMemoryCount << " (limit " << maxAllocationCount << ")\n";
+			std::cout << "  blocks " << current.blockCount << " (" << current.blockBytes / mb << " MB), "
+				<< current.allocationCount << " allocations using " << current.usedBytes / mb << " MB\n";
+			std::cout << "  dedicated " << current.dedicatedCount << " (" << current.dedicatedBytes / mb << " MB)\n";
+		}
+	};
+
+	void Allocation::free()
+	{
+		if (allocator)
+		{
+			allocator->free(*this);
+		}
+	}
+
+}
@@ -0,0 +1,242 @@
+/*
+* Binary mesh cache
+*
+* Stores the final vertex and index data of a mesh loaded via ASSIMP next to the
+* source asset, so later loads can skip ASSIMP and copy straight from a mapped file
+* One cache file per source file, vertex layout, scale, import flags and level of detail count
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "vulkanMeshLoader.hpp"
+#include "mappedfile.hpp"
+
+namespace vkMeshLoader
+{
+
+	class MeshCache
+	{
+	private:
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			// Source file the cache was created from
+			uint64_t sourceSize;
+			int64_t sourceModified;
+			uint64_t sourceHash;
+			// Hash of layout, scale, import flags, optimization and level of detail count
+			uint64_t key;
+			uint32_t vertexStride;
+			uint32_t vertexCount;
+			// Indices of all levels of detail
+			uint32_t indexCount;
+			uint32_t indexType;
+			uint32_t meshCount;
+			uint32_t lodCount;
+			uint32_t drawRangeCount;
+			uint32_t padding;
+			// Offsets of the vertex and index data from the start of the file
+			// Mesh descriptors directly follow the header, followed by the levels of detail and draw ranges
+			uint64_t vertexDataOffset;
+			uint64_t indexDataOffset;
+		};
+
+		static const uint32_t fileMagic = 0x434d4b56; // "VKMC"
+		// Increase whenever the file layout or the data generated by VulkanMeshLoader changes
+		static const uint32_t fileVersion = 3;
+
+		// 64 bit FNV-1a
+		static uint64_t hash(const void *data, size_t size, uint64_t hash = 14695981039346656037ULL)
+		{
+			const uint8_t *bytes = (const uint8_t*)data;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash = (hash ^ bytes[i]) * 1099511628211ULL;
+			}
+			return hash;
+		}
+
+		static uint64_t getKey(const std::vector<VertexLayout> &layout, float scale, int flags, bool optimized, uint32_t lodCount)
+		{
+			uint64_t key = hash(layout.data(), layout.size() * sizeof(VertexLayout));
+			key = hash(&scale, sizeof(scale), key);
+			key = hash(&flags, sizeof(flags), key);
+			// Keeps the keys of unoptimized caches written before this was added
+			key = optimized ? hash("optimized", 9, key) : key;
+			return (lodCount > 0) ? hash(&lodCount, sizeof(lodCount), key) : key;
+		}
+
+		static size_t getTableSize(uint32_t meshCount, uint32_t lodCount, uint32_t drawRangeCount)
+		{
+			return sizeof(FileHeader) + meshCount * sizeof(MeshDescriptor) + lodCount * sizeof(MeshLod) + drawRangeCount * sizeof(MeshDrawRange);
+		}
+
+		static bool getSourceInfo(const std::string &filename, uint64_t &size, int64_t &modified)
+		{
+			struct stat fileStat;
+			if (stat(filename.c_str(), &fileStat) != 0)
+			{
+				return false;
+			}
+			size = (uint64_t)fileStat.st_size;
+			modified = (int64_t)fileStat.st_mtime;
+			return true;
+		}
+
+		static uint64_t getSourceHash(const std::string &filename)
+		{
+			vkTools::MappedFile source(filename);
+			return source.isOpen() ? hash(source.data(), source.size()) : 0;
+		}
+
+	public:
+		// Returns the name of the cache file, e.g. "./../data/models/cube.obj.0123456789abcdef.meshcache"
+		static std::string getFileName(const std::string &filename, const std::vector<VertexLayout> &layout, float scale, int flags, bool optimized = false, uint32_t lodCount = 0)
+		{
+			std::stringstream cacheName;
+			cacheName << filename << "." << std::hex << std::setfill('0') << std::setw(16) << getKey(layout, scale, flags, optimized, lodCount) << ".meshcache";
+			return cacheName.str();
+		}
+
+		// Create the mesh's vertex and index buffers from the cache
+		// optimized selects the cache of a mesh written after VulkanMeshLoader::optimize,
+		// lodCount the one of a mesh with levels of detail from VulkanMeshLoader::generateLods
+		// Returns false if there is no cache for the source file or it's out of date
+		// The cache is out of date if the source's size or modification time changed,
+		// and the source's contents no longer match the hash stored with the cache
+		static bool load(
+			const std::string &filename,
+			const std::vector<VertexLayout> &layout,
+			float scale,
+			int flags,
+			VkDevice device,
+			vkTools::VulkanMemoryAllocator *allocator,
+			vkTools::VulkanUploadManager *uploader,
+			MeshBuffer *meshBuffer,
+			bool optimized = false,
+			uint32_t lodCount = 0)
+		{
+			vkTools::MappedFile cache(getFileName(filename, layout, scale, flags, optimized, lodCount));
+			if (!cache.isOpen() || (cache.size() < sizeof(FileHeader)))
+			{
+				return false;
+			}
+
+			FileHeader header;
+			memcpy(&header, cache.data(), sizeof(header));
+			if ((header.magic != fileMagic) ||
+				(header.version != fileVersion) ||
+				(header.key != getKey(layout, scale, flags, optimized, lodCount)) ||
+				(header.vertexStride != vertexSize(layout)))
+			{
+				return false;
+			}
+
+			uint64_t vertexDataSize = (uint64_t)header.vertexCount * header.vertexStride;
+			uint64_t indexDataSize = (uint64_t)header.indexCount * ((header.indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t));
+			if ((header.lodCount == 0) ||
+				(getTableSize(header.meshCount, header.lodCount, header.drawRangeCount) > header.vertexDataOffset) ||
+				(header.vertexDataOffset + vertexDataSize > header.indexDataOffset) ||
+				(header.indexDataOffset + indexDataSize > cache.size()))
+			{
+				return false;
+			}
+
+			// Only hash the source if it looks like it has been changed
+			uint64_t sourceSize;
+			int64_t sourceModified;
+			if (getSourceInfo(filename, sourceSize, sourceModified))
+			{
+				if ((sourceSize != header.sourceSize) || (sourceModified != header.sourceModified))
+				{
+					if (getSourceHash(filename) != header.sourceHash)
+					{
+						return false;
+					}
+				}
+			}
+
+			// Data is read directly from the mapped file
+			VulkanMeshLoader::createBuffer(device, allocator, uploader, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, (void*)(cache.data() + header.vertexDataOffset), vertexDataSize, &meshBuffer->vertices);
+			VulkanMeshLoader::createBuffer(device, allocator, uploader, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, (void*)(cache.data() + header.indexDataOffset), indexDataSize, &meshBuffer->indices);
+			meshBuffer->meshDescriptors.resize(header.meshCount);
+			memcpy(meshBuffer->meshDescriptors.data(), cache.data() + sizeof(FileHeader), header.meshCount * sizeof(MeshDescriptor));
+			meshBuffer->lods.resize(header.lodCount);
+			memcpy(meshBuffer->lods.data(), cache.data() + sizeof(FileHeader) + header.meshCount * sizeof(MeshDescriptor), header.lodCount * sizeof(MeshLod));
+			meshBuffer->drawRanges.resize(header.drawRangeCount);
+			memcpy(meshBuffer->drawRanges.data(), cache.data() + getTableSize(header.meshCount, header.lodCount, 0), header.drawRangeCount * sizeof(MeshDrawRange));
+			meshBuffer->indexCount = meshBuffer->lods[0].indexCount;
+			meshBuffer->indexType = (VkIndexType)header.indexType;
+			meshBuffer->dequantization = hasQuantizedPositions(layout) ? getDequantization(meshBuffer->meshDescriptors) : glm::mat4();
+
+			return true;
+		}
+
+		// Write the cache for a mesh that has been loaded from the given file
+		// Returns false if the cache file couldn't be written (e.g. read only asset directory)
+		static bool save(
+			const std::string &filename,
+			const std::vector<VertexLayout> &layout,
+			float scale,
+			int flags,
+			VulkanMeshLoader *mesh,
+			bool optimized = false,
+			uint32_t lodCount = 0)
+		{
+			std::vector<float> vertexData((size_t)mesh->numVertices * vertexSize(layout) / sizeof(float));
+			mesh->packVertices(layout, scale, vertexData.data());
+			const VkIndexType indexType = mesh->getIndexType();
+			std::vector<uint8_t> indexData((size_t)mesh->getIndexDataSize(indexType));
+			mesh->packIndexData(indexType, indexData.data());
+			std::vector<MeshDescriptor> meshDescriptors = mesh->getMeshDescriptors(scale);
+			std::vector<MeshDrawRange> drawRanges;
+			std::vector<MeshLod> lods = mesh->getLods(scale, indexType, &drawRanges);
+
+			FileHeader header = {};
+			header.magic = fileMagic;
+			header.version = fileVersion;
+			if (!getSourceInfo(filename, header.sourceSize, header.sourceModified))
+			{
+				return false;
+			}
+			header.sourceHash = getSourceHash(filename);
+			header.key = getKey(layout, scale, flags, optimized, lodCount);
+			header.vertexStride = vertexSize(layout);
+			header.vertexCount = (uint32_t)(vertexData.size() * sizeof(float) / header.vertexStride);
+			header.indexCount = mesh->getIndexCount() + mesh->getLodIndexCount();
+			header.indexType = (uint32_t)indexType;
+			header.meshCount = (uint32_t)meshDescriptors.size();
+			header.lodCount = (uint32_t)lods.size();
+			header.drawRangeCount = (uint32_t)drawRanges.size();
+			// Keep the data 16 byte aligned inside of the file
+			header.vertexDataOffset = (getTableSize(header.meshCount, header.lodCount, header.drawRangeCount) + 15) & ~15ULL;
+			header.indexDataOffset = (header.vertexDataOffset + vertexData.size() * sizeof(float) + 15) & ~15ULL;
+
+			std::ofstream file(getFileName(filename, layout, scale, flags, optimized, lodCount), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				return false;
+			}
+			const char padding[16] = {};
+			file.write((char*)&header, sizeof(header));
+			file.write((char*)meshDescriptors.data(), meshDescriptors.size() * sizeof(MeshDescriptor));
+			file.write((char*)lods.data(), lods.size() * sizeof(MeshLod));
+			file.write((char*)drawRanges.data(), drawRanges.size() * sizeof(MeshDrawRange));
+			file.write(padding, header.vertexDataOffset - getTableSize(header.meshCount, header.lodCount, header.drawRangeCount));
+			file.write((char*)vertexData.data(), vertexData.size() * sizeof(float));
+			file.write(padding, header.indexDataOffset - (header.vertexDataOffset + vertexData.size() * sizeof(float)));
+			file.write((char*)indexData.data(), indexData.size());
+			return file.good();
+		}
+	};
+
+}
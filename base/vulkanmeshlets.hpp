@@ -0,0 +1,149 @@
+/*
+* Meshlet builder
+*
+* Partitions an indexed triangle list into small clusters (meshlets) with a
+* bounded number of unique vertices and triangles. Each meshlet stores a bounding
+* sphere and a normal cone, so whole clusters can be culled against the view frustum
+* and rejected if all of their triangles face away from the camera
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <glm/glm.hpp>
+
+namespace vkMeshLoader
+{
+
+	// Default limits of a meshlet, these fit the output limits of common mesh shader implementations
+	static const uint32_t meshletMaxVertices = 64;
+	static const uint32_t meshletMaxTriangles = 124;
+
+	// Matches the std430 layout of the cluster culling shader
+	struct Meshlet
+	{
+		// xyz = center, w = radius
+		glm::vec4 sphere;
+		// xyz = average normal, w = sine of the cone's half angle
+		// A value of 1 or more disables backface cone culling for the meshlet
+		glm::vec4 cone;
+		// Range of the meshlet's triangles in the index list
+		uint32_t indexBase;
+		uint32_t indexCount;
+		uint32_t vertexCount;
+		uint32_t padding;
+	};
+
+	// Compute the bounding sphere and normal cone of the triangles in indices
+	inline void computeMeshletBounds(Meshlet &meshlet, const uint32_t *indices, const glm::vec3 *positions)
+	{
+		glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+		for (uint32_t i = 0; i < meshlet.indexCount; i++)
+		{
+			min = glm::min(min, positions[indices[i]]);
+			max = glm::max(max, positions[indices[i]]);
+		}
+		glm::vec3 center = (min + max) * 0.5f;
+		float radius = 0.0f;
+		for (uint32_t i = 0; i < meshlet.indexCount; i++)
+		{
+			radius = std::max(radius, glm::length(positions[indices[i]] - center));
+		}
+		meshlet.sphere = glm::vec4(center, radius);
+
+		// Cone axis is the average of the (unit) triangle normals
+		std::vector<glm::vec3> normals;
+		normals.reserve(meshlet.indexCount / 3);
+		glm::vec3 axis(0.0f);
+		for (uint32_t i = 0; i + 2 < meshlet.indexCount; i += 3)
+		{
+			const glm::vec3 &p0 = positions[indices[i]];
+			glm::vec3 normal = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+			float length = glm::length(normal);
+			if (length > 0.0f)
+			{
+				normals.push_back(normal / length);
+				axis += normals.back();
+			}
+		}
+
+		meshlet.cone = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		float axisLength = glm::length(axis);
+		if (normals.empty() || (axisLength < 1e-6f))
+		{
+			return;
+		}
+		axis /= axisLength;
+		float minDot = 1.0f;
+		for (auto& normal : normals)
+		{
+			minDot = std::min(minDot, glm::dot(normal, axis));
+		}
+		// Normals spread over more than a hemisphere, the cluster always has front faces
+		if (minDot <= 0.0f)
+		{
+			meshlet.cone = glm::vec4(axis, 1.0f);
+			return;
+		}
+		meshlet.cone = glm::vec4(axis, sqrtf(std::max(1.0f - minDot * minDot, 0.0f)));
+	}
+
+	// Split a triangle list into meshlets of at most maxVertices unique vertices and maxTriangles triangles
+	// Triangles are taken in order, so each meshlet is a contiguous range of the index list and the
+	// index list itself is unchanged. Works best with a vertex cache optimized triangle order
+	static std::vector<Meshlet> buildMeshlets(
+		const uint32_t *indices,
+		size_t indexCount,
+		const glm::vec3 *positions,
+		uint32_t vertexCount,
+		uint32_t maxVertices = meshletMaxVertices,
+		uint32_t maxTriangles = meshletMaxTriangles)
+	{
+		assert((maxVertices >= 3) && (maxTriangles >= 1));
+
+		std::vector<Meshlet> meshlets;
+		// Meshlet each vertex was last added to (plus one)
+		std::vector<uint32_t> vertexMeshlet(vertexCount, 0);
+
+		Meshlet meshlet = {};
+		for (size_t t = 0; t + 2 < indexCount; t += 3)
+		{
+			uint32_t newVertices = 0;
+			for (size_t v = 0; v < 3; v++)
+			{
+				newVertices += (vertexMeshlet[indices[t + v]] != meshlets.size() + 1) ? 1 : 0;
+			}
+			// Start a new meshlet if the triangle doesn't fit into the current one
+			if ((meshlet.indexCount > 0) && ((meshlet.vertexCount + newVertices > maxVertices) || (meshlet.indexCount / 3 >= maxTriangles)))
+			{
+				computeMeshletBounds(meshlet, indices + meshlet.indexBase, positions);
+				meshlets.push_back(meshlet);
+				meshlet = {};
+				meshlet.indexBase = (uint32_t)t;
+			}
+			for (size_t v = 0; v < 3; v++)
+			{
+				uint32_t &mark = vertexMeshlet[indices[t + v]];
+				if (mark != meshlets.size() + 1)
+				{
+					mark = (uint32_t)meshlets.size() + 1;
+					meshlet.vertexCount++;
+				}
+			}
+			meshlet.indexCount += 3;
+		}
+		if (meshlet.indexCount > 0)
+		{
+			computeMeshletBounds(meshlet, indices + meshlet.indexBase, positions);
+			meshlets.push_back(meshlet);
+		}
+		return meshlets;
+	}
+
+}
@@ -0,0 +1,494 @@
+/*
+* Mesh optimization
+*
+* Reorders triangle lists for post-transform vertex cache locality (Tom Forsyth,
+* "Linear-Speed Vertex Cache Optimisation"), sorts clusters of triangles to reduce
+* overdraw (Sander et al., "Fast Triangle Reordering for Vertex Locality and
+* Reduced Overdraw") and remaps vertices into the order they are first used in
+* Works on a single list of 32 bit triangle indices into 0 ... vertexCount - 1
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+namespace vkMeshLoader
+{
+
+	struct VertexCacheStatistics
+	{
+		// Average cache miss ratio : transformed vertices per triangle (0.5 ... 3.0, lower is better)
+		float acmr = 0.0f;
+		// Average transform to vertex ratio : transformed vertices per vertex (1.0 is optimal)
+		float atvr = 0.0f;
+		uint32_t transformedVertices = 0;
+		uint32_t triangleCount = 0;
+		uint32_t vertexCount = 0;
+	};
+
+	struct OverdrawStatistics
+	{
+		// Shaded pixels per covered pixel (1.0 is optimal, higher is worse)
+		float overdraw = 0.0f;
+		uint32_t pixelsCovered = 0;
+		uint32_t pixelsShaded = 0;
+	};
+
+	struct MeshOptimizationStatistics
+	{
+		VertexCacheStatistics before;
+		VertexCacheStatistics after;
+	};
+
+	// Add the counts of a mesh to the statistics of multiple meshes
+	inline void accumulateStatistics(VertexCacheStatistics &total, const VertexCacheStatistics &stats)
+	{
+		total.transformedVertices += stats.transformedVertices;
+		total.triangleCount += stats.triangleCount;
+		total.vertexCount += stats.vertexCount;
+		total.acmr = (total.triangleCount > 0) ? (float)total.transformedVertices / total.triangleCount : 0.0f;
+		total.atvr = (total.vertexCount > 0) ? (float)total.transformedVertices / total.vertexCount : 0.0f;
+	}
+
+	// Simulate a FIFO post-transform cache with cacheSize entries
+	static VertexCacheStatistics analyzeVertexCache(const uint32_t *indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = 16)
+	{
+		VertexCacheStatistics stats;
+		std::vector<uint32_t> timestamps(vertexCount, 0);
+		// Start "in the future" so that no vertex is in the cache initially
+		uint32_t timestamp = cacheSize + 1;
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			uint32_t index = indices[i];
+			if (timestamp - timestamps[index] > cacheSize)
+			{
+				timestamps[index] = timestamp++;
+				stats.transformedVertices++;
+			}
+		}
+		stats.triangleCount = (uint32_t)(indexCount / 3);
+		stats.vertexCount = vertexCount;
+		stats.acmr = (stats.triangleCount > 0) ? (float)stats.transformedVertices / stats.triangleCount : 0.0f;
+		stats.atvr = (vertexCount > 0) ? (float)stats.transformedVertices / vertexCount : 0.0f;
+		return stats;
+	}
+
+	namespace detail
+	{
+		// Returns 1 if cross(p1 - p0, p2 - p0) points outwards (counter clockwise triangles), -1 if it points inwards
+		// The winding depends on the load flags and on mirrored (e.g. y flipped) positions,
+		// so it's taken from the sign of the mesh's volume instead of being assumed
+		inline float getWindingOrientation(const uint32_t *indices, size_t indexCount, const glm::vec3 *positions, const glm::vec3 &center)
+		{
+			float volume = 0.0f;
+			for (size_t t = 0; t + 2 < indexCount; t += 3)
+			{
+				const glm::vec3 p0 = positions[indices[t]] - center;
+				const glm::vec3 p1 = positions[indices[t + 1]] - center;
+				const glm::vec3 p2 = positions[indices[t + 2]] - center;
+				volume += glm::dot(p0, glm::cross(p1, p2));
+			}
+			return (volume < 0.0f) ? -1.0f : 1.0f;
+		}
+	}
+
+	// Rasterize the mesh in draw order with a depth test from the six axis directions
+	// and count the pixels that pass the depth test (early z) against those covered
+	// Back faces are culled, which side is the front is taken from the mesh's winding
+	static OverdrawStatistics analyzeOverdraw(const uint32_t *indices, size_t indexCount, const glm::vec3 *positions, uint32_t vertexCount, uint32_t resolution = 256)
+	{
+		OverdrawStatistics stats;
+		glm::vec3 min(FLT_MAX);
+		glm::vec3 max(-FLT_MAX);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			min = glm::min(min, positions[v]);
+			max = glm::max(max, positions[v]);
+		}
+		const glm::vec3 size = max - min;
+		const float extent = std::max(size.x, std::max(size.y, size.z));
+		if ((indexCount < 3) || (extent <= 0.0f))
+		{
+			return stats;
+		}
+
+		const float orientation = detail::getWindingOrientation(indices, indexCount, positions, (min + max) * 0.5f);
+
+		std::vector<float> depth(resolution * resolution);
+		for (uint32_t view = 0; view < 6; view++)
+		{
+			const int axis = view % 3;
+			const bool flip = view >= 3;
+			std::fill(depth.begin(), depth.end(), FLT_MAX);
+			for (size_t t = 0; t + 2 < indexCount; t += 3)
+			{
+				// The view looks along +axis (-axis if flipped), front faces point against it
+				const glm::vec3 &v0 = positions[indices[t]];
+				const glm::vec3 normal = glm::cross(positions[indices[t + 1]] - v0, positions[indices[t + 2]] - v0) * orientation;
+				if ((flip ? normal[axis] : -normal[axis]) <= 0.0f)
+				{
+					continue;
+				}
+
+				// Orthographic projection into the unit cube
+				glm::vec3 p[3];
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					glm::vec3 n = (positions[indices[t + k]] - min) / extent;
+					p[k] = glm::vec3(n[(axis + 1) % 3] * resolution, n[(axis + 2) % 3] * resolution, flip ? 1.0f - n[axis] : n[axis]);
+				}
+				auto edge = [](const glm::vec3 &a, const glm::vec3 &b, float x, float y) { return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x); };
+				float area = edge(p[0], p[1], p[2].x, p[2].y);
+				if (area == 0.0f)
+				{
+					continue;
+				}
+				const float sign = (area > 0.0f) ? 1.0f : -1.0f;
+				const int x0 = std::max((int)floorf(std::min(p[0].x, std::min(p[1].x, p[2].x))), 0);
+				const int y0 = std::max((int)floorf(std::min(p[0].y, std::min(p[1].y, p[2].y))), 0);
+				const int x1 = std::min((int)ceilf(std::max(p[0].x, std::max(p[1].x, p[2].x))), (int)resolution - 1);
+				const int y1 = std::min((int)ceilf(std::max(p[0].y, std::max(p[1].y, p[2].y))), (int)resolution - 1);
+				for (int y = y0; y <= y1; y++)
+				{
+					for (int x = x0; x <= x1; x++)
+					{
+						const float px = x + 0.5f;
+						const float py = y + 0.5f;
+						const float w0 = edge(p[1], p[2], px, py) * sign;
+						const float w1 = edge(p[2], p[0], px, py) * sign;
+						const float w2 = edge(p[0], p[1], px, py) * sign;
+						if ((w0 < 0.0f) || (w1 < 0.0f) || (w2 < 0.0f))
+						{
+							continue;
+						}
+						const float z = (w0 * p[0].z + w1 * p[1].z + w2 * p[2].z) / (area * sign);
+						float &pixel = depth[y * resolution + x];
+						if (z < pixel)
+						{
+							stats.pixelsCovered += (pixel == FLT_MAX) ? 1 : 0;
+							stats.pixelsShaded++;
+							pixel = z;
+						}
+					}
+				}
+			}
+		}
+		stats.overdraw = (stats.pixelsCovered > 0) ? (float)stats.pixelsShaded / stats.pixelsCovered : 0.0f;
+		return stats;
+	}
+
+	namespace detail
+	{
+		// Cache size the scores are tuned for, not the hardware's cache size
+		const int forsythCacheSize = 32;
+
+		inline float forsythVertexScore(int cachePosition, uint32_t remainingTriangles)
+		{
+			if (remainingTriangles == 0)
+			{
+				return -1.0f;
+			}
+			float score = 0.0f;
+			if (cachePosition >= 0)
+			{
+				// The last triangle's vertices get a fixed score so the next triangle doesn't
+				// just reuse them in the same order
+				score = (cachePosition < 3) ? 0.75f : powf(1.0f - (float)(cachePosition - 3) / (forsythCacheSize - 3), 1.5f);
+			}
+			// Prefer vertices with few triangles left, so they can be retired
+			return score + 2.0f * powf((float)remainingTriangles, -0.5f);
+		}
+
+		// Split the triangles of a cache optimized list into clusters that can be reordered
+		// without hurting the cache efficiency much (at most threshold times the cluster's ACMR)
+		inline std::vector<uint32_t> getOverdrawClusters(const uint32_t *indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize, float threshold)
+		{
+			const size_t triangleCount = indexCount / 3;
+			std::vector<uint32_t> timestamps(vertexCount, 0);
+			uint32_t timestamp = cacheSize + 1;
+			auto misses = [&](size_t triangle)
+			{
+				uint32_t count = 0;
+				for (size_t v = 0; v < 3; v++)
+				{
+					uint32_t index = indices[triangle * 3 + v];
+					if (timestamp - timestamps[index] > cacheSize)
+					{
+						timestamps[index] = timestamp++;
+						count++;
+					}
+				}
+				return count;
+			};
+
+			// Hard boundaries : triangles where the cache optimizer started over
+			std::vector<uint32_t> hardClusters;
+			for (size_t t = 0; t < triangleCount; t++)
+			{
+				if ((misses(t) == 3) || (t == 0))
+				{
+					hardClusters.push_back((uint32_t)t);
+				}
+			}
+			hardClusters.push_back((uint32_t)triangleCount);
+
+			// Soft boundaries : split hard clusters while the running ACMR is low enough
+			std::vector<uint32_t> clusters;
+			for (size_t c = 0; c + 1 < hardClusters.size(); c++)
+			{
+				const uint32_t start = hardClusters[c];
+				const uint32_t end = hardClusters[c + 1];
+
+				// Flush the cache before measuring each cluster on it's own
+				timestamp += cacheSize + 1;
+				uint32_t clusterMisses = 0;
+				for (uint32_t t = start; t < end; t++)
+				{
+					clusterMisses += misses(t);
+				}
+				const float clusterThreshold = threshold * (float)clusterMisses / (end - start);
+
+				timestamp += cacheSize + 1;
+				uint32_t runStart = start;
+				uint32_t runMisses = 0;
+				clusters.push_back(start);
+				for (uint32_t t = start; t < end; t++)
+				{
+					runMisses += misses(t);
+					if ((t + 1 < end) && ((float)runMisses / (t - runStart + 1) <= clusterThreshold))
+					{
+						clusters.push_back(t + 1);
+						runStart = t + 1;
+						runMisses = 0;
+						timestamp += cacheSize + 1;
+					}
+				}
+			}
+			clusters.push_back((uint32_t)triangleCount);
+			return clusters;
+		}
+	}
+
+	// Reorder triangles for post-transform vertex cache locality
+	static void optimizeVertexCache(uint32_t *indices, size_t indexCount, uint32_t vertexCount)
+	{
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		// Triangles using each vertex
+		std::vector<uint32_t> remaining(vertexCount, 0);
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			remaining[indices[i]]++;
+		}
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+		}
+		std::vector<uint32_t> adjacency(indexCount);
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < indexCount; i++)
+			{
+				adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+			}
+		}
+
+		std::vector<int> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			vertexScores[v] = detail::forsythVertexScore(-1, remaining[v]);
+		}
+		std::vector<float> triangleScores(triangleCount);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		}
+		std::vector<bool> emitted(triangleCount, false);
+
+		std::vector<uint32_t> output;
+		output.reserve(indexCount);
+		std::vector<uint32_t> cache, newCache;
+		cache.reserve(detail::forsythCacheSize + 3);
+		newCache.reserve(detail::forsythCacheSize + 3);
+		size_t scanCursor = 0;
+		int64_t best = -1;
+
+		while (output.size() < indexCount)
+		{
+			// Nothing in the cache is connected to a remaining triangle,
+			// continue with the next one in input order (keeps this linear)
+			if (best < 0)
+			{
+				while (emitted[scanCursor])
+				{
+					scanCursor++;
+				}
+				best = (int64_t)scanCursor;
+			}
+
+			const uint32_t triangle = (uint32_t)best;
+			emitted[triangle] = true;
+			const uint32_t *tri = &indices[triangle * 3];
+			for (size_t v = 0; v < 3; v++)
+			{
+				output.push_back(tri[v]);
+				// Remove the triangle from it's vertices' lists
+				uint32_t *list = &adjacency[adjacencyOffsets[tri[v]]];
+				uint32_t &count = remaining[tri[v]];
+				for (uint32_t i = 0; i < count; i++)
+				{
+					if (list[i] == triangle)
+					{
+						list[i] = list[count - 1];
+						count--;
+						break;
+					}
+				}
+			}
+
+			// Move the triangle's vertices to the front of the LRU cache
+			newCache.clear();
+			newCache.insert(newCache.end(), tri, tri + 3);
+			for (auto v : cache)
+			{
+				if ((v != tri[0]) && (v != tri[1]) && (v != tri[2]))
+				{
+					newCache.push_back(v);
+				}
+			}
+			std::swap(cache, newCache);
+
+			// Update the scores of all vertices that are or were in the cache,
+			// and find the best triangle connected to the cache
+			for (size_t i = 0; i < cache.size(); i++)
+			{
+				const uint32_t v = cache[i];
+				cachePositions[v] = (i < (size_t)detail::forsythCacheSize) ? (int)i : -1;
+			}
+			float bestScore = -1.0f;
+			best = -1;
+			for (auto v : cache)
+			{
+				const float score = detail::forsythVertexScore(cachePositions[v], remaining[v]);
+				const float delta = score - vertexScores[v];
+				vertexScores[v] = score;
+				const uint32_t *list = &adjacency[adjacencyOffsets[v]];
+				for (uint32_t i = 0; i < remaining[v]; i++)
+				{
+					triangleScores[list[i]] += delta;
+					if (triangleScores[list[i]] > bestScore)
+					{
+						bestScore = triangleScores[list[i]];
+						best = list[i];
+					}
+				}
+			}
+			if (cache.size() > (size_t)detail::forsythCacheSize)
+			{
+				cache.resize(detail::forsythCacheSize);
+			}
+		}
+
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	// Reorder clusters of a cache optimized triangle list so that triangles facing
+	// away from the mesh's center are drawn first and occlude the ones behind them
+	// A threshold of 1.05 allows the ACMR to get up to 5% worse
+	static void optimizeOverdraw(uint32_t *indices, size_t indexCount, const glm::vec3 *positions, uint32_t vertexCount, float threshold = 1.05f, uint32_t cacheSize = 16)
+	{
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		std::vector<uint32_t> clusters = detail::getOverdrawClusters(indices, indexCount, vertexCount, cacheSize, threshold);
+		const size_t clusterCount = clusters.size() - 1;
+
+		glm::vec3 meshCenter(0.0f);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			meshCenter += positions[v];
+		}
+		meshCenter /= (float)std::max(vertexCount, 1u);
+
+		// Makes the cluster normals point outwards for both winding orders
+		const float orientation = detail::getWindingOrientation(indices, indexCount, positions, meshCenter);
+
+		// Area weighted center and (outward) normal of each cluster
+		std::vector<float> sortKeys(clusterCount);
+		for (size_t c = 0; c < clusterCount; c++)
+		{
+			glm::vec3 center(0.0f);
+			glm::vec3 normal(0.0f);
+			float area = 0.0f;
+			for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+			{
+				const glm::vec3 &p0 = positions[indices[t * 3]];
+				const glm::vec3 &p1 = positions[indices[t * 3 + 1]];
+				const glm::vec3 &p2 = positions[indices[t * 3 + 2]];
+				glm::vec3 triangleNormal = glm::cross(p1 - p0, p2 - p0);
+				float triangleArea = glm::length(triangleNormal);
+				center += (p0 + p1 + p2) * (triangleArea / 3.0f);
+				normal += triangleNormal;
+				area += triangleArea;
+			}
+			center = (area > 0.0f) ? center / area : positions[indices[clusters[c] * 3]];
+			float normalLength = glm::length(normal);
+			sortKeys[c] = (normalLength > 0.0f) ? orientation * glm::dot(center - meshCenter, normal / normalLength) : 0.0f;
+		}
+
+		std::vector<uint32_t> order(clusterCount);
+		for (size_t c = 0; c < clusterCount; c++)
+		{
+			order[c] = (uint32_t)c;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> output;
+		output.reserve(indexCount);
+		for (auto c : order)
+		{
+			output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+		}
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	// Returns a remap table (old to new vertex index) that orders vertices by their first use
+	// Unused vertices are moved to the end
+	static std::vector<uint32_t> optimizeVertexFetchRemap(const uint32_t *indices, size_t indexCount, uint32_t vertexCount)
+	{
+		const uint32_t unused = ~0u;
+		std::vector<uint32_t> remap(vertexCount, unused);
+		uint32_t next = 0;
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			if (remap[indices[i]] == unused)
+			{
+				remap[indices[i]] = next++;
+			}
+		}
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			if (remap[v] == unused)
+			{
+				remap[v] = next++;
+			}
+		}
+		return remap;
+	}
+
+}
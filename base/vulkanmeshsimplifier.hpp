@@ -0,0 +1,333 @@
+/*
+* Mesh simplification
+*
+* Reduces the triangle count of an indexed mesh by collapsing edges in the order of
+* their quadric error (Garland and Heckbert, "Surface Simplification Using Quadric
+* Error Metrics"). Edges are collapsed onto one of their vertices, so the result
+* is a new index list into the same vertex data
+* Vertices sharing a position are treated as one, the simplified mesh uses the
+* attributes of one of them. Borders of the mesh are kept in place
+*/
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+namespace vkMeshLoader
+{
+
+	namespace detail
+	{
+		// Symmetric 4x4 matrix of the summed squared distances to a set of planes
+		struct Quadric
+		{
+			double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+			double b2 = 0.0, bc = 0.0, bd = 0.0;
+			double c2 = 0.0, cd = 0.0;
+			double d2 = 0.0;
+			// Sum of the weights (areas) of the planes
+			double weight = 0.0;
+
+			Quadric() {}
+
+			Quadric(const glm::vec3 &n, float d, float w)
+			{
+				a2 = w * n.x * n.x; ab = w * n.x * n.y; ac = w * n.x * n.z; ad = w * n.x * d;
+				b2 = w * n.y * n.y; bc = w * n.y * n.z; bd = w * n.y * d;
+				c2 = w * n.z * n.z; cd = w * n.z * d;
+				d2 = w * d * d;
+				weight = w;
+			}
+
+			Quadric &operator+=(const Quadric &q)
+			{
+				a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+				b2 += q.b2; bc += q.bc; bd += q.bd;
+				c2 += q.c2; cd += q.cd;
+				d2 += q.d2;
+				weight += q.weight;
+				return *this;
+			}
+
+			// Average squared distance of p to the planes
+			double error(const glm::vec3 &p) const
+			{
+				double x = p.x, y = p.y, z = p.z;
+				double e =
+					a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x +
+					b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y +
+					c2 * z * z + 2.0 * cd * z +
+					d2;
+				return (weight > 0.0) ? fabs(e) / weight : 0.0;
+			}
+		};
+
+		struct Collapse
+		{
+			uint32_t from;
+			uint32_t to;
+			double error;
+		};
+
+		inline uint64_t edgeKey(uint32_t a, uint32_t b)
+		{
+			return ((uint64_t)a << 32) | b;
+		}
+
+		// Returns true if moving vertex from to the position of to flips any of it's triangles
+		inline bool collapseFlips(
+			uint32_t from,
+			uint32_t to,
+			const std::vector<uint32_t> &indices,
+			const std::vector<uint32_t> &triangles,
+			const glm::vec3 *positions)
+		{
+			for (auto t : triangles)
+			{
+				const uint32_t *tri = &indices[t * 3];
+				if ((tri[0] == to) || (tri[1] == to) || (tri[2] == to))
+				{
+					// Removed by the collapse
+					continue;
+				}
+				glm::vec3 p[3] = { positions[tri[0]], positions[tri[1]], positions[tri[2]] };
+				glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				for (size_t v = 0; v < 3; v++)
+				{
+					if (tri[v] == from)
+					{
+						p[v] = positions[to];
+					}
+				}
+				glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+				if (glm::dot(before, after) <= 0.0f)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+	}
+
+	// Simplify a triangle list down to targetIndexCount indices, or until the next
+	// collapse would move the surface by more than maxError (in model units)
+	// Returns the new index list, the largest error is stored in resultError
+	static std::vector<uint32_t> simplifyMesh(
+		const uint32_t *indices,
+		size_t indexCount,
+		const glm::vec3 *positions,
+		uint32_t vertexCount,
+		size_t targetIndexCount,
+		float maxError,
+		float *resultError = nullptr)
+	{
+		// Map all vertices to the first vertex with the same position
+		std::vector<uint32_t> weld(vertexCount);
+		{
+			struct PositionHash
+			{
+				size_t operator()(const glm::vec3 &p) const
+				{
+					uint32_t h[3];
+					memcpy(h, &p, sizeof(h));
+					return (size_t)(h[0] * 73856093u ^ h[1] * 19349663u ^ h[2] * 83492791u);
+				}
+			};
+			std::unordered_map<glm::vec3, uint32_t, PositionHash> firstVertex;
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				weld[v] = firstVertex.insert(std::make_pair(positions[v], v)).first->second;
+			}
+		}
+
+		std::vector<uint32_t> result;
+		result.reserve(indexCount);
+		for (size_t t = 0; t + 2 < indexCount; t += 3)
+		{
+			uint32_t a = weld[indices[t]], b = weld[indices[t + 1]], c = weld[indices[t + 2]];
+			if ((a != b) && (b != c) && (c != a))
+			{
+				result.push_back(a);
+				result.push_back(b);
+				result.push_back(c);
+			}
+		}
+
+		// Lock vertices on the border of the mesh (edges without an opposite edge)
+		std::vector<bool> locked(vertexCount, false);
+		{
+			std::unordered_set<uint64_t> edges;
+			for (size_t t = 0; t < result.size(); t += 3)
+			{
+				for (size_t e = 0; e < 3; e++)
+				{
+					edges.insert(detail::edgeKey(result[t + e], result[t + (e + 1) % 3]));
+				}
+			}
+			for (size_t t = 0; t < result.size(); t += 3)
+			{
+				for (size_t e = 0; e < 3; e++)
+				{
+					uint32_t a = result[t + e], b = result[t + (e + 1) % 3];
+					if (edges.find(detail::edgeKey(b, a)) == edges.end())
+					{
+						locked[a] = locked[b] = true;
+					}
+				}
+			}
+		}
+
+		// Area weighted plane quadrics of the adjacent triangles
+		std::vector<detail::Quadric> quadrics(vertexCount);
+		for (size_t t = 0; t < result.size(); t += 3)
+		{
+			const glm::vec3 &p0 = positions[result[t]];
+			glm::vec3 normal = glm::cross(positions[result[t + 1]] - p0, positions[result[t + 2]] - p0);
+			float area = glm::length(normal);
+			if (area > 0.0f)
+			{
+				normal /= area;
+				detail::Quadric quadric(normal, -glm::dot(normal, p0), area * 0.5f);
+				for (size_t v = 0; v < 3; v++)
+				{
+					quadrics[result[t + v]] += quadric;
+				}
+			}
+		}
+
+		const double maxErrorSquared = (double)maxError * maxError;
+		double largestError = 0.0;
+		std::vector<uint32_t> remap(vertexCount);
+		std::vector<bool> touched(vertexCount);
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+		std::vector<uint32_t> adjacency;
+		std::vector<uint32_t> vertexTriangles;
+		std::vector<detail::Collapse> collapses;
+
+		// Each pass collapses the cheapest edges that don't share any triangles,
+		// so the costs and adjacency of a pass stay valid while collapsing
+		while (result.size() > targetIndexCount)
+		{
+			const size_t triangleCount = result.size() / 3;
+
+			// Triangles using each vertex
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+			for (auto index : result)
+			{
+				adjacencyOffsets[index + 1]++;
+			}
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+			}
+			adjacency.resize(result.size());
+			{
+				std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (size_t i = 0; i < result.size(); i++)
+				{
+					adjacency[fill[result[i]]++] = (uint32_t)(i / 3);
+				}
+			}
+
+			// Cheapest direction of each edge
+			collapses.clear();
+			for (size_t t = 0; t < result.size(); t += 3)
+			{
+				for (size_t e = 0; e < 3; e++)
+				{
+					uint32_t a = result[t + e], b = result[t + (e + 1) % 3];
+					// Interior edges are visited from both triangles, only use one
+					if ((a > b) && !locked[a] && !locked[b])
+					{
+						continue;
+					}
+					detail::Quadric quadric = quadrics[a];
+					quadric += quadrics[b];
+					double errorAB = locked[a] ? DBL_MAX : quadric.error(positions[b]);
+					double errorBA = locked[b] ? DBL_MAX : quadric.error(positions[a]);
+					if ((errorAB == DBL_MAX) && (errorBA == DBL_MAX))
+					{
+						continue;
+					}
+					collapses.push_back((errorAB <= errorBA) ? detail::Collapse{ a, b, errorAB } : detail::Collapse{ b, a, errorBA });
+				}
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const detail::Collapse &l, const detail::Collapse &r) { return l.error < r.error; });
+
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				remap[v] = v;
+			}
+			std::fill(touched.begin(), touched.end(), false);
+
+			size_t remainingTriangles = triangleCount;
+			const size_t targetTriangles = targetIndexCount / 3;
+			size_t collapseCount = 0;
+			for (auto& collapse : collapses)
+			{
+				if ((remainingTriangles <= targetTriangles) || (collapse.error > maxErrorSquared))
+				{
+					break;
+				}
+				if (touched[collapse.from] || touched[collapse.to])
+				{
+					continue;
+				}
+
+				vertexTriangles.assign(adjacency.begin() + adjacencyOffsets[collapse.from], adjacency.begin() + adjacencyOffsets[collapse.from + 1]);
+				if (detail::collapseFlips(collapse.from, collapse.to, result, vertexTriangles, positions))
+				{
+					continue;
+				}
+
+				// Lock the one-ring of the collapsed vertex for the rest of this pass
+				for (auto t : vertexTriangles)
+				{
+					const uint32_t *tri = &result[t * 3];
+					bool removed = (tri[0] == collapse.to) || (tri[1] == collapse.to) || (tri[2] == collapse.to);
+					remainingTriangles -= removed ? 1 : 0;
+					touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+				}
+				remap[collapse.from] = collapse.to;
+				quadrics[collapse.to] += quadrics[collapse.from];
+				largestError = std::max(largestError, collapse.error);
+				collapseCount++;
+			}
+
+			if (collapseCount == 0)
+			{
+				break;
+			}
+
+			// Apply the collapses and remove the triangles that became degenerate
+			size_t written = 0;
+			for (size_t t = 0; t < result.size(); t += 3)
+			{
+				uint32_t a = remap[result[t]], b = remap[result[t + 1]], c = remap[result[t + 2]];
+				if ((a != b) && (b != c) && (c != a))
+				{
+					result[written++] = a;
+					result[written++] = b;
+					result[written++] = c;
+				}
+			}
+			result.resize(written);
+		}
+
+		if (resultError)
+		{
+			*resultError = (float)sqrt(largestError);
+		}
+		return result;
+	}
+
+}
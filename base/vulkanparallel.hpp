@@ -0,0 +1,54 @@
+/*
+* Parallel loops used by the mesh pipeline
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+
+namespace vkMeshLoader
+{
+
+	// Call func(0 ... count - 1) distributed over worker threads
+	// Runs on the calling thread if there's only a single work item or thread
+	template <typename Func>
+	inline void runParallel(uint32_t count, uint32_t threadCount, Func func)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		threadCount = std::min(threadCount, count);
+		if (threadCount <= 1)
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				func(i);
+			}
+			return;
+		}
+
+		std::atomic<uint32_t> next(0);
+		auto worker = [&]()
+		{
+			for (uint32_t i = next++; i < count; i = next++)
+			{
+				func(i);
+			}
+		};
+		std::vector<std::thread> threads;
+		for (uint32_t t = 1; t < threadCount; t++)
+		{
+			threads.push_back(std::thread(worker));
+		}
+		worker();
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+}
@@ -0,0 +1,155 @@
+/*
+* Pipeline cache file
+*
+* Stores the contents of a VkPipelineCache on disk so pipelines
+* don't need to be compiled by the driver again on the next start
+* Cache data is only used if it was written by the same device and driver
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string.h>
+
+#include <vulkan/vulkan.h>
+
+namespace vkTools
+{
+
+	class VulkanPipelineCacheFile
+	{
+	private:
+		// Written in front of the cache data
+		// The driver version isn't part of Vulkan's own cache header,
+		// so it's stored here to reject data from older drivers
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t vendorID;
+			uint32_t deviceID;
+			uint32_t driverVersion;
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+			uint64_t dataSize;
+		};
+
+		static const uint32_t fileMagic = 0x43504b56; // "VKPC"
+		static const uint32_t fileVersion = 1;
+
+		// Checks the header the driver puts in front of the cache data
+		static bool validCacheData(const std::vector<char> &data, const VkPhysicalDeviceProperties &deviceProperties)
+		{
+			// Header length, header version, vendor id, device id, cache UUID
+			const size_t headerSize = 16 + VK_UUID_SIZE;
+			if (data.size() < headerSize)
+			{
+				return false;
+			}
+			uint32_t header[4];
+			memcpy(header, data.data(), sizeof(header));
+			return (header[0] >= headerSize) &&
+				(header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE) &&
+				(header[2] == deviceProperties.vendorID) &&
+				(header[3] == deviceProperties.deviceID) &&
+				(memcmp(data.data() + 16, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0);
+		}
+
+	public:
+		// Returns a file name unique to the device, e.g. "vulkanExample_pipelinecache_10de_1b80.bin"
+		static std::string getFileName(std::string name, const VkPhysicalDeviceProperties &deviceProperties)
+		{
+			std::stringstream fileName;
+			fileName << name << "_pipelinecache_" << std::hex << std::setfill('0')
+				<< std::setw(4) << deviceProperties.vendorID << "_"
+				<< std::setw(4) << deviceProperties.deviceID << ".bin";
+			return fileName.str();
+		}
+
+		// Load cache data written by save
+		// Returns false (and no data) if the file doesn't exist or was written
+		// by a different device, driver or pipeline cache version
+		static bool load(std::string fileName, const VkPhysicalDeviceProperties &deviceProperties, std::vector<char> &data)
+		{
+			data.clear();
+			std::ifstream file(fileName, std::ios::in | std::ios::binary);
+			if (!file.is_open())
+			{
+				return false;
+			}
+
+			FileHeader header;
+			if (!file.read((char*)&header, sizeof(header)))
+			{
+				return false;
+			}
+			if ((header.magic != fileMagic) ||
+				(header.version != fileVersion) ||
+				(header.vendorID != deviceProperties.vendorID) ||
+				(header.deviceID != deviceProperties.deviceID) ||
+				(header.driverVersion != deviceProperties.driverVersion) ||
+				(memcmp(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0))
+			{
+				return false;
+			}
+
+			// Don't trust the stored size before checking it against the file's length
+			std::streamoff dataOffset = file.tellg();
+			file.seekg(0, std::ios::end);
+			std::streamoff fileSize = file.tellg();
+			if ((dataOffset < 0) || (fileSize < dataOffset) || (header.dataSize > (uint64_t)(fileSize - dataOffset)))
+			{
+				return false;
+			}
+			file.seekg(dataOffset, std::ios::beg);
+
+			data.resize((size_t)header.dataSize);
+			if (!file.read(data.data(), data.size()) || !validCacheData(data, deviceProperties))
+			{
+				data.clear();
+				return false;
+			}
+			return true;
+		}
+
+		// Write the current contents of a pipeline cache to a file
+		// Returns the number of bytes of cache data written
+		static size_t save(std::string fileName, const VkPhysicalDeviceProperties &deviceProperties, VkDevice device, VkPipelineCache pipelineCache)
+		{
+			size_t dataSize = 0;
+			VkResult err = vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr);
+			if ((err != VK_SUCCESS) || (dataSize == 0))
+			{
+				return 0;
+			}
+			std::vector<char> data(dataSize);
+			err = vkGetPipelineCacheData(device, pipelineCache, &dataSize, data.data());
+			if (err != VK_SUCCESS)
+			{
+				return 0;
+			}
+
+			FileHeader header = {};
+			header.magic = fileMagic;
+			header.version = fileVersion;
+			header.vendorID = deviceProperties.vendorID;
+			header.deviceID = deviceProperties.deviceID;
+			header.driverVersion = deviceProperties.driverVersion;
+			memcpy(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+			header.dataSize = dataSize;
+
+			std::ofstream file(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				return 0;
+			}
+			file.write((char*)&header, sizeof(header));
+			file.write(data.data(), dataSize);
+			return file.good() ? dataSize : 0;
+		}
+	};
+
+}
@@ -0,0 +1,311 @@
+/*
+* GPU timestamp profiler
+*
+* Measures GPU execution times of named scopes using timestamp queries
+* Each frame in flight uses it's own query pool, results are read back
+* once the frame slot is reused (so reading them never stalls)
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <assert.h>
+
+#include <vulkan/vulkan.h>
+#include "vulkantools.h"
+
+namespace vkTools
+{
+
+	class VulkanProfiler
+	{
+	public:
+		// Accumulated timings of a named scope (in milliseconds)
+		struct ScopeTiming
+		{
+			double last = 0.0;
+			double min = 0.0;
+			double max = 0.0;
+			double total = 0.0;
+			uint32_t count = 0;
+		};
+
+	private:
+		VkDevice device;
+		VkCommandPool cmdPool;
+		// Nanoseconds per timestamp tick
+		float timestampPeriod;
+		// Mask for the valid bits of a timestamp
+		uint64_t timestampMask;
+		uint32_t maxScopes;
+
+		struct FrameQueries
+		{
+			VkQueryPool queryPool;
+			// Command buffers that only contain a timestamp write
+			// Used to profile static command buffers (see addCommandBuffer)
+			std::vector<VkCommandBuffer> markerCmdBuffers;
+			uint32_t markerCount = 0;
+			// Name of each scope, the scope at index i uses queries 2*i and 2*i+1
+			std::vector<std::string> scopeNames;
+		};
+		std::vector<FrameQueries> frames;
+		uint32_t currentFrame = 0;
+		// Scopes that have been started but not yet ended in the current frame
+		std::map<std::string, uint32_t> openScopes;
+
+		// Scope timings and the order in which scopes were first seen
+		std::map<std::string, ScopeTiming> timings;
+		std::vector<std::string> scopeOrder;
+
+		// Read back the results of the last submission of the given frame slot
+		// Only call once that submission has finished (e.g. after waiting on it's fence)
+		void collectResults(FrameQueries &frame)
+		{
+			if (frame.scopeNames.empty())
+			{
+				return;
+			}
+
+			uint32_t queryCount = (uint32_t)frame.scopeNames.size() * 2;
+			std::vector<uint64_t> timestamps(queryCount);
+			// Don't wait for the results, drop them if they're not available
+			VkResult err = vkGetQueryPoolResults(
+				device,
+				frame.queryPool,
+				0,
+				queryCount,
+				timestamps.size() * sizeof(uint64_t),
+				timestamps.data(),
+				sizeof(uint64_t),
+				VK_QUERY_RESULT_64_BIT);
+
+			if (err == VK_SUCCESS)
+			{
+				for (size_t i = 0; i < frame.scopeNames.size(); i++)
+				{
+					uint64_t begin = timestamps[i * 2] & timestampMask;
+					uint64_t end = timestamps[i * 2 + 1] & timestampMask;
+					double time = (end >= begin) ? (double)(end - begin) * timestampPeriod / 1000000.0 : 0.0;
+					addTiming(frame.scopeNames[i], time);
+				}
+			}
+			frame.scopeNames.clear();
+		}
+
+		void addTiming(const std::string &name, double time)
+		{
+			if (timings.find(name) == timings.end())
+			{
+				scopeOrder.push_back(name);
+			}
+			ScopeTiming &timing = timings[name];
+			timing.last = time;
+			timing.min = (timing.count == 0) ? time : std::min(timing.min, time);
+			timing.max = (timing.count == 0) ? time : std::max(timing.max, time);
+			timing.total += time;
+			timing.count++;
+		}
+
+		// Returns a command buffer containing a single timestamp write
+		VkCommandBuffer getMarkerCmdBuffer(VkPipelineStageFlagBits stage, uint32_t query)
+		{
+			FrameQueries &frame = frames[currentFrame];
+			assert(frame.markerCount < frame.markerCmdBuffers.size());
+			VkCommandBuffer cmdBuffer = frame.markerCmdBuffers[frame.markerCount++];
+
+			VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
+			VkResult err = vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo);
+			assert(!err);
+			vkCmdWriteTimestamp(cmdBuffer, stage, frame.queryPool, query);
+			err = vkEndCommandBuffer(cmdBuffer);
+			assert(!err);
+
+			return cmdBuffer;
+		}
+
+	public:
+		// Set by the "-profile" command line argument
+		bool enabled = false;
+
+		// Create query pools and marker command buffers for all frames in flight
+		// Disables the profiler if the queue family doesn't support timestamps
+		void prepare(
+			VkPhysicalDevice physicalDevice,
+			VkDevice device,
+			VkCommandPool cmdPool,
+			uint32_t queueFamilyIndex,
+			uint32_t framesInFlight,
+			uint32_t maxScopes = 32)
+		{
+			this->device = device;
+			this->cmdPool = cmdPool;
+			this->maxScopes = maxScopes;
+
+			uint32_t queueCount;
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueCount, NULL);
+			std::vector<VkQueueFamilyProperties> queueProps(queueCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueCount, queueProps.data());
+
+			uint32_t validBits = queueProps[queueFamilyIndex].timestampValidBits;
+			if (validBits == 0)
+			{
+				std::cout << "Timestamps not supported by the graphics queue, profiler disabled\n";
+				enabled = false;
+				return;
+			}
+			timestampMask = (validBits >= 64) ? ~0ULL : ((1ULL << validBits) - 1);
+
+			VkPhysicalDeviceProperties deviceProperties;
+			vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+			timestampPeriod = deviceProperties.limits.timestampPeriod;
+
+			frames.resize(framesInFlight);
+			for (auto& frame : frames)
+			{
+				VkQueryPoolCreateInfo queryPoolInfo = {};
+				queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+				queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+				queryPoolInfo.queryCount = maxScopes * 2;
+				VkResult err = vkCreateQueryPool(device, &queryPoolInfo, nullptr, &frame.queryPool);
+				assert(!err);
+
+				frame.markerCmdBuffers.resize(maxScopes * 2);
+				VkCommandBufferAllocateInfo cmdBufAllocateInfo =
+					vkTools::initializers::commandBufferAllocateInfo(
+						cmdPool,
+						VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+						(uint32_t)frame.markerCmdBuffers.size());
+				err = vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, frame.markerCmdBuffers.data());
+				assert(!err);
+			}
+		}
+
+		void destroy()
+		{
+			for (auto& frame : frames)
+			{
+				vkDestroyQueryPool(device, frame.queryPool, nullptr);
+				vkFreeCommandBuffers(device, cmdPool, (uint32_t)frame.markerCmdBuffers.size(), frame.markerCmdBuffers.data());
+			}
+			frames.clear();
+		}
+
+		// Start profiling a new frame using the given frame slot
+		// Reads back the results of the slot's last submission and
+		// resets it's queries in the given command buffer (must be executed
+		// before any other command buffer of the frame)
+		void beginFrame(uint32_t frameIndex, VkCommandBuffer cmdBuffer)
+		{
+			if (!enabled)
+			{
+				return;
+			}
+			currentFrame = frameIndex;
+			FrameQueries &frame = frames[currentFrame];
+			collectResults(frame);
+			frame.markerCount = 0;
+			openScopes.clear();
+			vkCmdResetQueryPool(cmdBuffer, frame.queryPool, 0, maxScopes * 2);
+		}
+
+		// Read back the results of all frame slots
+		// Call after the device has become idle (e.g. at the end of the render loop)
+		void collectAllResults()
+		{
+			for (auto& frame : frames)
+			{
+				collectResults(frame);
+			}
+		}
+
+		// Write a begin timestamp for the named scope into a command buffer
+		// The command buffer needs to be recorded every frame as the
+		// queries used change with each frame slot
+		void beginScope(VkCommandBuffer cmdBuffer, const std::string &name)
+		{
+			if (!enabled)
+			{
+				return;
+			}
+			FrameQueries &frame = frames[currentFrame];
+			if (frame.scopeNames.size() >= maxScopes)
+			{
+				return;
+			}
+			uint32_t index = (uint32_t)frame.scopeNames.size();
+			frame.scopeNames.push_back(name);
+			openScopes[name] = index;
+			vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool, index * 2);
+		}
+
+		// Write the end timestamp for the named scope into a command buffer
+		void endScope(VkCommandBuffer cmdBuffer, const std::string &name)
+		{
+			if (!enabled)
+			{
+				return;
+			}
+			auto scope = openScopes.find(name);
+			if (scope == openScopes.end())
+			{
+				return;
+			}
+			vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frames[currentFrame].queryPool, scope->second * 2 + 1);
+			openScopes.erase(scope);
+		}
+
+		// Add a command buffer to a list of command buffers to be submitted
+		// and measure it as a named scope
+		// Timestamps are written by separate command buffers submitted before
+		// and after it, so this also works for command buffers that are only recorded once
+		// If the profiler is disabled, only the command buffer itself is added
+		void addCommandBuffer(std::vector<VkCommandBuffer> &cmdBuffers, VkCommandBuffer cmdBuffer, const std::string &name)
+		{
+			if ((!enabled) || (frames[currentFrame].scopeNames.size() >= maxScopes))
+			{
+				cmdBuffers.push_back(cmdBuffer);
+				return;
+			}
+			FrameQueries &frame = frames[currentFrame];
+			uint32_t index = (uint32_t)frame.scopeNames.size();
+			frame.scopeNames.push_back(name);
+			cmdBuffers.push_back(getMarkerCmdBuffer(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, index * 2));
+			cmdBuffers.push_back(cmdBuffer);
+			cmdBuffers.push_back(getMarkerCmdBuffer(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, index * 2 + 1));
+		}
+
+		// Returns the accumulated timings of a scope (zero if the scope hasn't been measured yet)
+		ScopeTiming getTiming(const std::string &name)
+		{
+			auto timing = timings.find(name);
+			return (timing != timings.end()) ? timing->second : ScopeTiming();
+		}
+
+		// Print average, min and max times of all scopes
+		void print()
+		{
+			if (scopeOrder.empty())
+			{
+				return;
+			}
+			std::cout << "GPU profiler results (ms) :\n";
+			std::cout << std::fixed << std::setprecision(3);
+			for (auto& name : scopeOrder)
+			{
+				ScopeTiming &timing = timings[name];
+				std::cout << "  " << std::left << std::setw(32) << name << std::right
+					<< " avg " << timing.total / timing.count
+					<< "  min " << timing.min
+					<< "  max " << timing.max
+					<< "  (" << timing.count << " frames)\n";
+			}
+		}
+	};
+
+}
@@ -22,6 +22,7 @@
 
 #include <vulkan/vulkan.h>
 #include "vulkantools.h"
+#include "vulkanmemory.hpp"
 
 #ifdef __ANDROID__
 #include "vulkanandroid.h"
@@ -69,6 +70,8 @@ private:
 	PFN_vkGetSwapchainImagesKHR fpGetSwapchainImagesKHR;
 	PFN_vkAcquireNextImageKHR fpAcquireNextImageKHR;
 	PFN_vkQueuePresentKHR fpQueuePresentKHR;
+	// Allocator used for the offscreen images in headless mode
+	vkTools::VulkanMemoryAllocator *memoryAllocator = nullptr;
 public:
 	VkFormat colorFormat;
 	VkColorSpaceKHR colorSpace;
@@ -82,6 +85,18 @@ public:
 	// Index of the deteced graphics and presenting device queue
 	uint32_t queueNodeIndex = UINT32_MAX;
 
+	// Headless mode
+	// No surface is created and the swap chain images are replaced
+	// by a ring of offscreen images that are handed out in order
+	// Must be set before connecting the swap chain
+	bool headless = false;
+	// Number of offscreen images used in headless mode
+	uint32_t headlessImageCount = 3;
+	// Device memory backing the offscreen images
+	std::vector<vkTools::Allocation> headlessAllocations;
+	// Index of the next offscreen image to be acquired
+	uint32_t headlessNextImage = 0;
+
 	// Creates an os specific surface
 	// Tries to find a graphics and a present queue
 	void initSurface(
@@ -213,12 +228,48 @@ public:
 		colorSpace = surfaceFormats[0].colorSpace;
 	}
 
+	// Headless mode : Select a graphics queue and the color format
+	// to be used for the offscreen images (no surface is created)
+	void initHeadless(VkFormat format)
+	{
+		uint32_t queueCount;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueCount, NULL);
+		assert(queueCount >= 1);
+
+		std::vector<VkQueueFamilyProperties> queueProps(queueCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueCount, queueProps.data());
+
+		for (uint32_t i = 0; i < queueCount; i++)
+		{
+			if ((queueProps[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0)
+			{
+				queueNodeIndex = i;
+				break;
+			}
+		}
+
+		if (queueNodeIndex == UINT32_MAX)
+		{
+			vkTools::exitFatal("Could not find a graphics queue!", "Fatal error");
+		}
+
+		colorFormat = format;
+		colorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
+	}
+
 	// Connect to the instance und device and get all required function pointers
-	void connect(VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device)
+	// The memory allocator backs the offscreen images in headless mode
+	void connect(VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device, vkTools::VulkanMemoryAllocator *memoryAllocator)
 	{
 		this->instance = instance;
 		this->physicalDevice = physicalDevice;
 		this->device = device;
+		this->memoryAllocator = memoryAllocator;
+		if (headless)
+		{
+			// No window system integration required
+			return;
+		}
 		GET_INSTANCE_PROC_ADDR(instance, GetPhysicalDeviceSurfaceSupportKHR);
 		GET_INSTANCE_PROC_ADDR(instance, GetPhysicalDeviceSurfaceCapabilitiesKHR);
 		GET_INSTANCE_PROC_ADDR(instance, GetPhysicalDeviceSurfaceFormatsKHR);
@@ -231,8 +282,15 @@ public:
 	}
 
 	// Create the swap chain and get images with given width and height
-	void create(VkCommandBuffer cmdBuffer, uint32_t *width, uint32_t *height)
+	// The images are transitioned from their initial layout by the render pass
+	void create(uint32_t *width, uint32_t *height)
 	{
+		if (headless)
+		{
+			createHeadless(*width, *height);
+			return;
+		}
+
 		VkResult err;
 		VkSwapchainKHR oldSwapchain = swapChain;
 
@@ -362,14 +420,50 @@ public:
 
 			buffers[i].image = images[i];
 
-			// Transform images from initial (undefined) to present layout
-			vkTools::setImageLayout(
-				cmdBuffer, 
-				buffers[i].image, 
-				VK_IMAGE_ASPECT_COLOR_BIT, 
-				VK_IMAGE_LAYOUT_UNDEFINED, 
-				VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+			colorAttachmentView.image = buffers[i].image;
+
+			err = vkCreateImageView(device, &colorAttachmentView, nullptr, &buffers[i].view);
+			assert(!err);
+		}
+	}
+
+	// Headless mode : Create a ring of offscreen images with given width and height
+	// The images can be used as color attachments and copied from (e.g. to save them to disk)
+	void createHeadless(uint32_t width, uint32_t height)
+	{
+		VkResult err;
+
+		imageCount = headlessImageCount;
+		images.resize(imageCount);
+		buffers.resize(imageCount);
+		headlessAllocations.resize(imageCount);
+		headlessNextImage = 0;
 
+		for (uint32_t i = 0; i < imageCount; i++)
+		{
+			VkImageCreateInfo image = vkTools::initializers::imageCreateInfo();
+			image.imageType = VK_IMAGE_TYPE_2D;
+			image.format = colorFormat;
+			image.extent = { width, height, 1 };
+			image.mipLevels = 1;
+			image.arrayLayers = 1;
+			image.samples = VK_SAMPLE_COUNT_1_BIT;
+			image.tiling = VK_IMAGE_TILING_OPTIMAL;
+			image.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			image.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			err = vkCreateImage(device, &image, nullptr, &images[i]);
+			assert(!err);
+
+			// Allocated like all other images, so headless runs have the same allocation pattern as windowed ones
+			headlessAllocations[i] = memoryAllocator->allocateImage(images[i], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			buffers[i].image = images[i];
+
+			VkImageViewCreateInfo colorAttachmentView = vkTools::initializers::imageViewCreateInfo();
+			colorAttachmentView.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			colorAttachmentView.format = colorFormat;
+			colorAttachmentView.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
 			colorAttachmentView.image = buffers[i].image;
 
 			err = vkCreateImageView(device, &colorAttachmentView, nullptr, &buffers[i].view);
@@ -378,20 +472,54 @@ public:
 	}
 
 	// Acquires the next image in the swap chain
+	// Headless mode : Returns the next image of the offscreen ring,
+	// the semaphore is not signaled
 	VkResult acquireNextImage(VkSemaphore presentCompleteSemaphore, uint32_t *currentBuffer)
 	{
+		if (headless)
+		{
+			*currentBuffer = headlessNextImage;
+			headlessNextImage = (headlessNextImage + 1) % imageCount;
+			return VK_SUCCESS;
+		}
 		return fpAcquireNextImageKHR(device, swapChain, UINT64_MAX, presentCompleteSemaphore, (VkFence)nullptr, currentBuffer);
 	}
 
 	// Present the current image to the queue
 	VkResult queuePresent(VkQueue queue, uint32_t currentBuffer)
 	{
+		if (headless)
+		{
+			return VK_SUCCESS;
+		}
+		VkPresentInfoKHR presentInfo = {};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		presentInfo.pNext = NULL;
+		presentInfo.swapchainCount = 1;
+		presentInfo.pSwapchains = &swapChain;
+		presentInfo.pImageIndices = &currentBuffer;
+		return fpQueuePresentKHR(queue, &presentInfo);
+	}
+
+	// Present the current image to the queue once the given semaphore
+	// has been signaled (e.g. by the command buffer submission rendering to it)
+	VkResult queuePresent(VkQueue queue, uint32_t currentBuffer, VkSemaphore waitSemaphore)
+	{
+		if (headless)
+		{
+			return VK_SUCCESS;
+		}
 		VkPresentInfoKHR presentInfo = {};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 		presentInfo.pNext = NULL;
 		presentInfo.swapchainCount = 1;
 		presentInfo.pSwapchains = &swapChain;
 		presentInfo.pImageIndices = &currentBuffer;
+		if (waitSemaphore != VK_NULL_HANDLE)
+		{
+			presentInfo.waitSemaphoreCount = 1;
+			presentInfo.pWaitSemaphores = &waitSemaphore;
+		}
 		return fpQueuePresentKHR(queue, &presentInfo);
 	}
 
@@ -402,6 +530,15 @@ public:
 		{
 			vkDestroyImageView(device, buffers[i].view, nullptr);
 		}
+		if (headless)
+		{
+			for (uint32_t i = 0; i < imageCount; i++)
+			{
+				vkDestroyImage(device, images[i], nullptr);
+				memoryAllocator->free(headlessAllocations[i]);
+			}
+			return;
+		}
 		fpDestroySwapchainKHR(device, swapChain, nullptr);
 		vkDestroySurfaceKHR(instance, surface, nullptr);
 	}
@@ -0,0 +1,208 @@
+/*
+* Texture cache
+*
+* Sits in front of the texture loader and loads every texture only once. Textures are
+* keyed by file name, format and sampler settings, repeated requests return the already
+* loaded texture and add a reference to it. The texture's image and memory are freed
+* once the last reference has been released
+*/
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <assert.h>
+
+#include <vulkan/vulkan.h>
+#include "vulkantools.h"
+#include "vulkanTextureLoader.hpp"
+
+namespace vkTools
+{
+
+	// Sampler of a cached texture, the defaults match the texture loader's sampler
+	struct TextureSamplerSettings
+	{
+		VkFilter filter = VK_FILTER_LINEAR;
+		VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		// Anisotropic filtering is enabled for values > 1
+		float maxAnisotropy = 0.0f;
+
+		bool operator<(const TextureSamplerSettings &other) const
+		{
+			return std::tie(filter, addressMode, maxAnisotropy) < std::tie(other.filter, other.addressMode, other.maxAnisotropy);
+		}
+	};
+
+	// Texture owned by the cache, valid until the last reference has been released
+	struct CachedTexture
+	{
+		VulkanTexture texture;
+
+	private:
+		friend class VulkanTextureCache;
+		uint32_t references = 0;
+	};
+
+	class VulkanTextureCache
+	{
+	public:
+		struct Statistics
+		{
+			// Number of acquire calls
+			uint32_t requestCount = 0;
+			// Requests that returned an already loaded texture
+			uint32_t hitCount = 0;
+			// Textures currently in the cache
+			uint32_t textureCount = 0;
+			// Device memory of the textures currently in the cache
+			VkDeviceSize residentBytes = 0;
+			// Device memory that would have been allocated for the hits without the cache
+			VkDeviceSize savedBytes = 0;
+		};
+
+	private:
+		struct Key
+		{
+			std::string filename;
+			VkFormat format;
+			bool cubemap;
+			TextureSamplerSettings sampler;
+
+			bool operator<(const Key &other) const
+			{
+				if (filename != other.filename)
+				{
+					return filename < other.filename;
+				}
+				return std::tie(format, cubemap, sampler) < std::tie(other.format, other.cubemap, other.sampler);
+			}
+		};
+
+		VkDevice device = VK_NULL_HANDLE;
+		VulkanTextureLoader *textureLoader;
+		// Entries have fixed addresses, so pointers returned by acquire stay valid
+		std::map<Key, CachedTexture> entries;
+		Statistics stats;
+
+		CachedTexture *acquire(const Key &key)
+		{
+			assert(device != VK_NULL_HANDLE);
+			stats.requestCount++;
+
+			auto entry = entries.find(key);
+			if (entry != entries.end())
+			{
+				entry->second.references++;
+				stats.hitCount++;
+				stats.savedBytes += entry->second.texture.allocation.size;
+				return &entry->second;
+			}
+
+			CachedTexture &cached = entries[key];
+			if (key.cubemap)
+			{
+				textureLoader->loadCubemap(key.filename.c_str(), key.format, &cached.texture);
+			}
+			else
+			{
+				textureLoader->loadTexture(key.filename.c_str(), key.format, &cached.texture);
+			}
+			cached.references = 1;
+
+			// Replace the loader's sampler with one for the requested settings
+			vkDestroySampler(device, cached.texture.sampler, nullptr);
+			VkSamplerCreateInfo sampler = vkTools::initializers::samplerCreateInfo();
+			sampler.magFilter = key.sampler.filter;
+			sampler.minFilter = key.sampler.filter;
+			sampler.mipmapMode = (key.sampler.filter == VK_FILTER_NEAREST) ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR;
+			sampler.addressModeU = key.sampler.addressMode;
+			sampler.addressModeV = key.sampler.addressMode;
+			sampler.addressModeW = key.sampler.addressMode;
+			sampler.mipLodBias = 0.0f;
+			sampler.anisotropyEnable = (key.sampler.maxAnisotropy > 1.0f) ? VK_TRUE : VK_FALSE;
+			sampler.maxAnisotropy = key.sampler.maxAnisotropy;
+			sampler.compareOp = VK_COMPARE_OP_NEVER;
+			sampler.minLod = 0.0f;
+			sampler.maxLod = (float)cached.texture.mipLevels;
+			sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+			VkResult err = vkCreateSampler(device, &sampler, nullptr, &cached.texture.sampler);
+			assert(!err);
+
+			stats.textureCount++;
+			stats.residentBytes += cached.texture.allocation.size;
+			return &cached;
+		}
+
+	public:
+		void prepare(VkDevice device, VulkanTextureLoader *textureLoader)
+		{
+			this->device = device;
+			this->textureLoader = textureLoader;
+		}
+
+		// Free all textures, including those that still have references
+		void destroy()
+		{
+			if (device == VK_NULL_HANDLE)
+			{
+				return;
+			}
+			for (auto& entry : entries)
+			{
+				textureLoader->destroyTexture(entry.second.texture);
+			}
+			entries.clear();
+			stats.textureCount = 0;
+			stats.residentBytes = 0;
+			device = VK_NULL_HANDLE;
+		}
+
+		// Get a 2D texture, loading it if it's not in the cache yet
+		// Every call adds a reference that has to be released
+		CachedTexture *acquire(const std::string &filename, VkFormat format, TextureSamplerSettings sampler = TextureSamplerSettings())
+		{
+			return acquire({ filename, format, false, sampler });
+		}
+
+		// Same as above for a cube map (single file)
+		CachedTexture *acquireCubemap(const std::string &filename, VkFormat format, TextureSamplerSettings sampler = TextureSamplerSettings())
+		{
+			return acquire({ filename, format, true, sampler });
+		}
+
+		// Release a reference, the texture is destroyed with the last one
+		// The texture must no longer be used by any pending command buffers by then
+		void release(CachedTexture *cached)
+		{
+			if (!cached)
+			{
+				return;
+			}
+			for (auto entry = entries.begin(); entry != entries.end(); ++entry)
+			{
+				if (&entry->second != cached)
+				{
+					continue;
+				}
+				assert(cached->references > 0);
+				if (--cached->references == 0)
+				{
+					stats.textureCount--;
+					stats.residentBytes -= cached->texture.allocation.size;
+					textureLoader->destroyTexture(cached->texture);
+					entries.erase(entry);
+				}
+				return;
+			}
+			assert(false && "Texture not owned by this cache");
+		}
+
+		const Statistics &getStatistics()
+		{
+			return stats;
+		}
+	};
+
+}
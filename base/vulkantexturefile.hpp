@@ -0,0 +1,357 @@
+/*
+* Memory mapped texture file
+*
+* Minimal reader for KTX (version 1) and DDS files. The file is mapped and only it's
+* header is parsed, the data of each subresource (mip level, array layer and cube face)
+* is accessed in place, so it can be copied straight into (staging) buffer memory without
+* reading the file into an intermediate heap allocation first
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <string.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+#include "mappedfile.hpp"
+
+namespace vkTools
+{
+
+	class TextureFile
+	{
+	private:
+		struct FormatInfo
+		{
+			VkFormat format;
+			uint32_t blockWidth;
+			uint32_t blockHeight;
+			// Bytes per block (per texel for uncompressed formats)
+			uint32_t blockSize;
+		};
+
+		// KTX header (after the 12 byte identifier)
+		struct KtxHeader
+		{
+			uint32_t endianness;
+			uint32_t glType;
+			uint32_t glTypeSize;
+			uint32_t glFormat;
+			uint32_t glInternalFormat;
+			uint32_t glBaseInternalFormat;
+			uint32_t pixelWidth;
+			uint32_t pixelHeight;
+			uint32_t pixelDepth;
+			uint32_t numberOfArrayElements;
+			uint32_t numberOfFaces;
+			uint32_t numberOfMipmapLevels;
+			uint32_t bytesOfKeyValueData;
+		};
+
+		// DDS header (after the "DDS " magic)
+		struct DdsHeader
+		{
+			uint32_t size;
+			uint32_t flags;
+			uint32_t height;
+			uint32_t width;
+			uint32_t pitchOrLinearSize;
+			uint32_t depth;
+			uint32_t mipMapCount;
+			uint32_t reserved1[11];
+			struct
+			{
+				uint32_t size;
+				uint32_t flags;
+				uint32_t fourCC;
+				uint32_t rgbBitCount;
+				uint32_t rBitMask;
+				uint32_t gBitMask;
+				uint32_t bBitMask;
+				uint32_t aBitMask;
+			} pixelFormat;
+			uint32_t caps;
+			uint32_t caps2;
+			uint32_t caps3;
+			uint32_t caps4;
+			uint32_t reserved2;
+		};
+
+		struct DdsHeaderDX10
+		{
+			uint32_t dxgiFormat;
+			uint32_t resourceDimension;
+			uint32_t miscFlag;
+			uint32_t arraySize;
+			uint32_t miscFlags2;
+		};
+
+		MappedFile file;
+		FormatInfo formatInfo;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t levels = 0;
+		uint32_t layers = 0;
+		uint32_t faces = 0;
+		// Offset of each subresource into the file, indexed by getIndex
+		std::vector<size_t> offsets;
+
+		static uint32_t fourCC(char a, char b, char c, char d)
+		{
+			return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+		}
+
+		static bool getKtxFormat(uint32_t glInternalFormat, FormatInfo *info)
+		{
+			switch (glInternalFormat)
+			{
+			case 0x8058: *info = { VK_FORMAT_R8G8B8A8_UNORM, 1, 1, 4 }; return true;	// GL_RGBA8
+			case 0x8C43: *info = { VK_FORMAT_R8G8B8A8_SRGB, 1, 1, 4 }; return true;	// GL_SRGB8_ALPHA8
+			case 0x8051: *info = { VK_FORMAT_R8G8B8_UNORM, 1, 1, 3 }; return true;	// GL_RGB8
+			case 0x8229: *info = { VK_FORMAT_R8_UNORM, 1, 1, 1 }; return true;	// GL_R8
+			case 0x83F0: *info = { VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 4, 8 }; return true;	// GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+			case 0x83F1: *info = { VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 4, 8 }; return true;	// GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+			case 0x83F2: *info = { VK_FORMAT_BC2_UNORM_BLOCK, 4, 4, 16 }; return true;	// GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+			case 0x83F3: *info = { VK_FORMAT_BC3_UNORM_BLOCK, 4, 4, 16 }; return true;	// GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+			case 0x8DBB: *info = { VK_FORMAT_BC4_UNORM_BLOCK, 4, 4, 8 }; return true;	// GL_COMPRESSED_RED_RGTC1
+			case 0x8DBD: *info = { VK_FORMAT_BC5_UNORM_BLOCK, 4, 4, 16 }; return true;	// GL_COMPRESSED_RG_RGTC2
+			}
+			return false;
+		}
+
+		static bool getDdsFormat(const DdsHeader &header, const DdsHeaderDX10 *headerDX10, FormatInfo *info)
+		{
+			if (headerDX10)
+			{
+				switch (headerDX10->dxgiFormat)
+				{
+				case 28: *info = { VK_FORMAT_R8G8B8A8_UNORM, 1, 1, 4 }; return true;	// DXGI_FORMAT_R8G8B8A8_UNORM
+				case 29: *info = { VK_FORMAT_R8G8B8A8_SRGB, 1, 1, 4 }; return true;	// DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+				case 61: *info = { VK_FORMAT_R8_UNORM, 1, 1, 1 }; return true;	// DXGI_FORMAT_R8_UNORM
+				case 71: *info = { VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 4, 8 }; return true;	// DXGI_FORMAT_BC1_UNORM
+				case 74: *info = { VK_FORMAT_BC2_UNORM_BLOCK, 4, 4, 16 }; return true;	// DXGI_FORMAT_BC2_UNORM
+				case 77: *info = { VK_FORMAT_BC3_UNORM_BLOCK, 4, 4, 16 }; return true;	// DXGI_FORMAT_BC3_UNORM
+				case 80: *info = { VK_FORMAT_BC4_UNORM_BLOCK, 4, 4, 8 }; return true;	// DXGI_FORMAT_BC4_UNORM
+				case 83: *info = { VK_FORMAT_BC5_UNORM_BLOCK, 4, 4, 16 }; return true;	// DXGI_FORMAT_BC5_UNORM
+				case 87: *info = { VK_FORMAT_B8G8R8A8_UNORM, 1, 1, 4 }; return true;	// DXGI_FORMAT_B8G8R8A8_UNORM
+				}
+				return false;
+			}
+			// DDPF_FOURCC
+			if (header.pixelFormat.flags & 0x4)
+			{
+				const uint32_t code = header.pixelFormat.fourCC;
+				if (code == fourCC('D', 'X', 'T', '1')) { *info = { VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 4, 8 }; return true; }
+				if (code == fourCC('D', 'X', 'T', '3')) { *info = { VK_FORMAT_BC2_UNORM_BLOCK, 4, 4, 16 }; return true; }
+				if (code == fourCC('D', 'X', 'T', '5')) { *info = { VK_FORMAT_BC3_UNORM_BLOCK, 4, 4, 16 }; return true; }
+				if (code == fourCC('A', 'T', 'I', '1')) { *info = { VK_FORMAT_BC4_UNORM_BLOCK, 4, 4, 8 }; return true; }
+				if (code == fourCC('A', 'T', 'I', '2')) { *info = { VK_FORMAT_BC5_UNORM_BLOCK, 4, 4, 16 }; return true; }
+				return false;
+			}
+			// DDPF_RGB with 32 bits per texel
+			if ((header.pixelFormat.flags & 0x40) && (header.pixelFormat.rgbBitCount == 32))
+			{
+				if (header.pixelFormat.rBitMask == 0x000000FF)
+				{
+					*info = { VK_FORMAT_R8G8B8A8_UNORM, 1, 1, 4 };
+					return true;
+				}
+				if (header.pixelFormat.rBitMask == 0x00FF0000)
+				{
+					*info = { VK_FORMAT_B8G8R8A8_UNORM, 1, 1, 4 };
+					return true;
+				}
+			}
+			return false;
+		}
+
+		uint32_t getIndex(uint32_t level, uint32_t layer, uint32_t face) const
+		{
+			return (layer * faces + face) * levels + level;
+		}
+
+		bool parseKtx()
+		{
+			static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+			if ((file.size() < sizeof(identifier) + sizeof(KtxHeader)) || (memcmp(file.data(), identifier, sizeof(identifier)) != 0))
+			{
+				return false;
+			}
+			KtxHeader header;
+			memcpy(&header, file.data() + sizeof(identifier), sizeof(header));
+			// Only files with the same (little) endianness as the host are supported
+			if ((header.endianness != 0x04030201) || (header.pixelDepth > 1) || !getKtxFormat(header.glInternalFormat, &formatInfo))
+			{
+				return false;
+			}
+
+			width = header.pixelWidth;
+			height = std::max(header.pixelHeight, 1u);
+			levels = std::max(header.numberOfMipmapLevels, 1u);
+			layers = std::max(header.numberOfArrayElements, 1u);
+			faces = std::max(header.numberOfFaces, 1u);
+			offsets.resize(levels * layers * faces);
+
+			// Levels follow each other, each one holds all layers and faces
+			size_t offset = sizeof(identifier) + sizeof(KtxHeader) + header.bytesOfKeyValueData;
+			for (uint32_t level = 0; level < levels; level++)
+			{
+				if (offset + sizeof(uint32_t) > file.size())
+				{
+					return false;
+				}
+				offset += sizeof(uint32_t);
+				const size_t size = getSize(level);
+				for (uint32_t layer = 0; layer < layers; layer++)
+				{
+					for (uint32_t face = 0; face < faces; face++)
+					{
+						offsets[getIndex(level, layer, face)] = offset;
+						// Faces are padded to 4 bytes
+						offset += (size + 3) & ~(size_t)3;
+					}
+				}
+			}
+			return offset <= file.size();
+		}
+
+		bool parseDds()
+		{
+			const size_t headerOffset = sizeof(uint32_t);
+			if ((file.size() < headerOffset + sizeof(DdsHeader)) || (memcmp(file.data(), "DDS ", 4) != 0))
+			{
+				return false;
+			}
+			DdsHeader header;
+			memcpy(&header, file.data() + headerOffset, sizeof(header));
+			size_t offset = headerOffset + sizeof(DdsHeader);
+
+			DdsHeaderDX10 headerDX10;
+			const bool dx10 = (header.pixelFormat.flags & 0x4) && (header.pixelFormat.fourCC == fourCC('D', 'X', '1', '0'));
+			if (dx10)
+			{
+				if (file.size() < offset + sizeof(DdsHeaderDX10))
+				{
+					return false;
+				}
+				memcpy(&headerDX10, file.data() + offset, sizeof(headerDX10));
+				offset += sizeof(DdsHeaderDX10);
+			}
+			// DDSD_DEPTH for volume textures
+			if (((header.flags & 0x800000) && (header.depth > 1)) || !getDdsFormat(header, dx10 ? &headerDX10 : nullptr, &formatInfo))
+			{
+				return false;
+			}
+
+			width = header.width;
+			height = std::max(header.height, 1u);
+			// DDSD_MIPMAPCOUNT
+			levels = (header.flags & 0x20000) ? std::max(header.mipMapCount, 1u) : 1;
+			layers = dx10 ? std::max(headerDX10.arraySize, 1u) : 1;
+			// DDSCAPS2_CUBEMAP or D3D11_RESOURCE_MISC_TEXTURECUBE
+			faces = ((header.caps2 & 0x200) || (dx10 && (headerDX10.miscFlag & 0x4))) ? 6 : 1;
+			offsets.resize(levels * layers * faces);
+
+			// Each layer (and face) holds it's complete mip chain
+			for (uint32_t layer = 0; layer < layers; layer++)
+			{
+				for (uint32_t face = 0; face < faces; face++)
+				{
+					for (uint32_t level = 0; level < levels; level++)
+					{
+						offsets[getIndex(level, layer, face)] = offset;
+						offset += getSize(level);
+					}
+				}
+			}
+			return offset <= file.size();
+		}
+
+	public:
+		TextureFile() {}
+
+		TextureFile(const std::string &filename)
+		{
+			open(filename);
+		}
+
+		// Map a KTX or DDS file and parse it's header
+		// Returns false if the file can't be read or uses a layout or format that's not supported
+		bool open(const std::string &filename)
+		{
+			close();
+			if (!file.open(filename))
+			{
+				return false;
+			}
+			if (!parseKtx() && !parseDds())
+			{
+				close();
+				return false;
+			}
+			return true;
+		}
+
+		void close()
+		{
+			file.close();
+			offsets.clear();
+			width = height = levels = layers = faces = 0;
+		}
+
+		bool isOpen() const
+		{
+			return file.isOpen();
+		}
+
+		// Format of the file's data
+		VkFormat getFormat() const
+		{
+			return formatInfo.format;
+		}
+
+		uint32_t getWidth(uint32_t level = 0) const
+		{
+			return std::max(width >> level, 1u);
+		}
+
+		uint32_t getHeight(uint32_t level = 0) const
+		{
+			return std::max(height >> level, 1u);
+		}
+
+		uint32_t getLevels() const
+		{
+			return levels;
+		}
+
+		uint32_t getLayers() const
+		{
+			return layers;
+		}
+
+		// 6 for cube maps, 1 otherwise
+		uint32_t getFaces() const
+		{
+			return faces;
+		}
+
+		// Size in bytes of a single layer (or face) of a mip level
+		size_t getSize(uint32_t level) const
+		{
+			const size_t blocksX = (getWidth(level) + formatInfo.blockWidth - 1) / formatInfo.blockWidth;
+			const size_t blocksY = (getHeight(level) + formatInfo.blockHeight - 1) / formatInfo.blockHeight;
+			return blocksX * blocksY * formatInfo.blockSize;
+		}
+
+		// Data of a subresource, points into the mapped file
+		const uint8_t *getData(uint32_t level, uint32_t layer = 0, uint32_t face = 0) const
+		{
+			return file.data() + offsets[getIndex(level, layer, face)];
+		}
+	};
+
+}
@@ -0,0 +1,599 @@
+/*
+* Texture streamer
+*
+* Streams the mip chains of 2D textures in over several frames. Files are read on a
+* worker thread, the smallest mip levels (the mip tail) are uploaded first so a texture
+* can be sampled as soon as it's file has been read, larger levels follow as the per frame
+* upload budget allows. The image view of a texture only covers it's resident levels and
+* is replaced whenever another level has been uploaded
+*/
+
+#pragma once
+
+#include <vector>
+#include <list>
+#include <string>
+#include <future>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+#include <vulkan/vulkan.h>
+#include <gli/gli.hpp>
+#include "vulkantools.h"
+#include "vulkanmemory.hpp"
+
+namespace vkTools
+{
+
+	// Texture that is usable right after it has been requested from the streamer
+	struct StreamingTexture
+	{
+		// Sampler, view and layout to write into descriptors
+		// Points to a placeholder image until the mip tail is resident
+		VkDescriptorImageInfo descriptor;
+		// Incremented whenever descriptor changes, descriptor sets written
+		// with an older version have to be updated before they are used again
+		uint32_t version = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		// Zero until the file has been read
+		uint32_t mipLevels = 0;
+		// First mip level that has been uploaded, equal to mipLevels while nothing is resident
+		uint32_t residentLevel = 0;
+
+		bool isComplete() const
+		{
+			return (mipLevels > 0) && (residentLevel == 0);
+		}
+
+	private:
+		friend class VulkanTextureStreamer;
+		VkFormat format;
+		// Pending read of the file on a worker thread
+		std::future<gli::texture2D> file;
+		// Contents of the file, released once all levels are resident
+		std::unique_ptr<gli::texture2D> data;
+		VkImage image = VK_NULL_HANDLE;
+		Allocation allocation;
+		VkImageView view = VK_NULL_HANDLE;
+		// Levels from tailLevel on are uploaded at once, equal to mipLevels if there is no mip tail
+		uint32_t tailLevel = 0;
+		// Next block row of the level that is being uploaded (residentLevel - 1)
+		uint32_t uploadRow = 0;
+	};
+
+	class VulkanTextureStreamer
+	{
+	private:
+		// Max. size of the mip tail that is uploaded in one go
+		static const VkDeviceSize mipTailSize = 64 * 1024;
+
+		VkDevice device = VK_NULL_HANDLE;
+		VkQueue queue;
+		VkCommandPool cmdPool;
+		VulkanMemoryAllocator *allocator;
+		VkDeviceSize budget;
+		uint32_t framesInFlight;
+
+		// Staging buffer, command buffer and fence for each frame in flight
+		struct Slot
+		{
+			VkBuffer stagingBuffer;
+			Allocation stagingMemory;
+			VkCommandBuffer cmdBuffer;
+			VkFence fence;
+			bool submitted;
+		};
+		std::vector<Slot> slots;
+		VkDeviceSize stagingSize;
+		uint32_t currentSlot = 0;
+		uint64_t frameNumber = 0;
+
+		// Mid grey 1x1 image sampled until a texture's mip tail is resident
+		VkImage placeholderImage;
+		Allocation placeholderMemory;
+		VkImageView placeholderView;
+		// Shared by all textures, the image views limit the levels that are sampled
+		VkSampler sampler;
+
+		// List, so pointers handed out stay valid
+		std::list<StreamingTexture> textures;
+		// Reads of released textures that were still pending
+		std::vector<std::future<gli::texture2D>> abandonedReads;
+
+		// Objects that may still be used by frames in flight
+		struct Retired
+		{
+			uint64_t frameNumber;
+			VkImageView view;
+			VkImage image;
+			Allocation allocation;
+		};
+		std::vector<Retired> retired;
+
+		void retire(VkImageView view, VkImage image, Allocation allocation)
+		{
+			retired.push_back({ frameNumber, view, image, allocation });
+		}
+
+		// Destroy retired objects once all frames that could use them have finished
+		void releaseRetired(bool all)
+		{
+			for (auto it = retired.begin(); it != retired.end();)
+			{
+				if (!all && (it->frameNumber + framesInFlight > frameNumber))
+				{
+					++it;
+					continue;
+				}
+				if (it->view != VK_NULL_HANDLE)
+				{
+					vkDestroyImageView(device, it->view, nullptr);
+				}
+				if (it->image != VK_NULL_HANDLE)
+				{
+					vkDestroyImage(device, it->image, nullptr);
+					allocator->free(it->allocation);
+				}
+				it = retired.erase(it);
+			}
+		}
+
+		// Layout transition of a range of mip levels
+		void levelBarrier(
+			VkCommandBuffer cmdBuffer,
+			VkImage image,
+			uint32_t baseLevel,
+			uint32_t levelCount,
+			VkImageLayout oldLayout,
+			VkImageLayout newLayout,
+			VkAccessFlags srcAccessMask,
+			VkAccessFlags dstAccessMask,
+			VkPipelineStageFlags srcStageMask,
+			VkPipelineStageFlags dstStageMask)
+		{
+			VkImageMemoryBarrier imageMemoryBarrier = vkTools::initializers::imageMemoryBarrier();
+			imageMemoryBarrier.oldLayout = oldLayout;
+			imageMemoryBarrier.newLayout = newLayout;
+			imageMemoryBarrier.srcAccessMask = srcAccessMask;
+			imageMemoryBarrier.dstAccessMask = dstAccessMask;
+			imageMemoryBarrier.image = image;
+			imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, levelCount, 0, 1 };
+			vkCmdPipelineBarrier(
+				cmdBuffer,
+				srcStageMask,
+				dstStageMask,
+				VK_FLAGS_NONE,
+				0, nullptr,
+				0, nullptr,
+				1, &imageMemoryBarrier);
+		}
+
+		void createPlaceholder()
+		{
+			VkImageCreateInfo imageCreateInfo = vkTools::initializers::imageCreateInfo();
+			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageCreateInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+			imageCreateInfo.extent = { 1, 1, 1 };
+			imageCreateInfo.mipLevels = 1;
+			imageCreateInfo.arrayLayers = 1;
+			imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			VkResult err = vkCreateImage(device, &imageCreateInfo, nullptr, &placeholderImage);
+			assert(!err);
+			placeholderMemory = allocator->allocateImage(placeholderImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			VkCommandBuffer cmdBuffer = slots[0].cmdBuffer;
+			VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
+			cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			err = vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo);
+			assert(!err);
+			levelBarrier(cmdBuffer, placeholderImage, 0, 1,
+				VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				0, VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+			VkClearColorValue color = { { 0.5f, 0.5f, 0.5f, 1.0f } };
+			VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			vkCmdClearColorImage(cmdBuffer, placeholderImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1, &range);
+			levelBarrier(cmdBuffer, placeholderImage, 0, 1,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+			err = vkEndCommandBuffer(cmdBuffer);
+			assert(!err);
+
+			VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &cmdBuffer;
+			err = vkQueueSubmit(queue, 1, &submitInfo, slots[0].fence);
+			assert(!err);
+			slots[0].submitted = true;
+
+			VkImageViewCreateInfo view = vkTools::initializers::imageViewCreateInfo();
+			view.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			view.format = VK_FORMAT_R8G8B8A8_UNORM;
+			view.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
+			view.subresourceRange = range;
+			view.image = placeholderImage;
+			err = vkCreateImageView(device, &view, nullptr, &placeholderView);
+			assert(!err);
+		}
+
+		// Create the image for a texture who's file has been read
+		// All levels are transitioned to transfer destination in cmdBuffer
+		void createImage(StreamingTexture &texture, VkCommandBuffer cmdBuffer)
+		{
+			texture.width = (uint32_t)(*texture.data)[0].dimensions().x;
+			texture.height = (uint32_t)(*texture.data)[0].dimensions().y;
+			texture.mipLevels = (uint32_t)texture.data->levels();
+			texture.residentLevel = texture.mipLevels;
+			texture.uploadRow = 0;
+
+			// Smallest levels that together (with their aligned staging offsets) fit into the mip tail size
+			// Levels that don't fit (e.g. the only level of a large texture) are streamed by rows
+			texture.tailLevel = texture.mipLevels;
+			VkDeviceSize tailSize = 0;
+			while (texture.tailLevel > 0)
+			{
+				VkDeviceSize levelSize = ((*texture.data)[texture.tailLevel - 1].size() + 15) & ~(VkDeviceSize)15;
+				if (tailSize + levelSize > mipTailSize)
+				{
+					break;
+				}
+				texture.tailLevel--;
+				tailSize += levelSize;
+			}
+
+			VkImageCreateInfo imageCreateInfo = vkTools::initializers::imageCreateInfo();
+			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageCreateInfo.format = texture.format;
+			imageCreateInfo.extent = { texture.width, texture.height, 1 };
+			imageCreateInfo.mipLevels = texture.mipLevels;
+			imageCreateInfo.arrayLayers = 1;
+			imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			VkResult err = vkCreateImage(device, &imageCreateInfo, nullptr, &texture.image);
+			assert(!err);
+			texture.allocation = allocator->allocateImage(texture.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			levelBarrier(cmdBuffer, texture.image, 0, texture.mipLevels,
+				VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				0, VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+		}
+
+		// Replace the texture's view with one that starts at the first resident level
+		void updateView(StreamingTexture &texture)
+		{
+			if (texture.view != VK_NULL_HANDLE)
+			{
+				retire(texture.view, VK_NULL_HANDLE, Allocation());
+			}
+
+			VkImageViewCreateInfo view = vkTools::initializers::imageViewCreateInfo();
+			view.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			view.format = texture.format;
+			view.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
+			view.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, texture.residentLevel, texture.mipLevels - texture.residentLevel, 0, 1 };
+			view.image = texture.image;
+			VkResult err = vkCreateImageView(device, &view, nullptr, &texture.view);
+			assert(!err);
+
+			texture.descriptor = vkTools::initializers::descriptorImageInfo(sampler, texture.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			texture.version++;
+		}
+
+		// Copy as many block rows of the texture's missing levels into the staging buffer as fit
+		// Returns true if at least one level has become resident
+		bool stream(StreamingTexture &texture, Slot &slot, VkDeviceSize *stagingOffset)
+		{
+			const gli::dim3_t blockDimensions = gli::block_dimensions(texture.data->format());
+			bool levelsCompleted = false;
+			while (texture.residentLevel > 0)
+			{
+				const uint32_t level = texture.residentLevel - 1;
+				gli::image image = (*texture.data)[level];
+				const uint32_t width = std::max(texture.width >> level, 1u);
+				const uint32_t height = std::max(texture.height >> level, 1u);
+				const uint32_t blockRows = (height + blockDimensions.y - 1) / blockDimensions.y;
+				const VkDeviceSize rowSize = image.size() / blockRows;
+
+				uint32_t rows = blockRows - texture.uploadRow;
+				if (level >= texture.tailLevel)
+				{
+					// The mip tail is only uploaded in one piece
+					if (*stagingOffset + rowSize * rows > stagingSize)
+					{
+						break;
+					}
+				}
+				else
+				{
+					// Budget is spent, but always make some progress
+					VkDeviceSize available = (budget > *stagingOffset) ? budget - *stagingOffset : 0;
+					rows = std::min(rows, (uint32_t)(available / rowSize));
+					if ((rows == 0) && (*stagingOffset == 0))
+					{
+						rows = 1;
+					}
+					if (rows == 0)
+					{
+						break;
+					}
+					assert(*stagingOffset + rowSize * rows <= stagingSize);
+				}
+
+				VkDeviceSize size = rowSize * rows;
+				memcpy((uint8_t*)slot.stagingMemory.mapped + *stagingOffset, (const uint8_t*)image.data() + rowSize * texture.uploadRow, (size_t)size);
+
+				VkBufferImageCopy copyRegion = {};
+				copyRegion.bufferOffset = *stagingOffset;
+				copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				copyRegion.imageSubresource.mipLevel = level;
+				copyRegion.imageSubresource.baseArrayLayer = 0;
+				copyRegion.imageSubresource.layerCount = 1;
+				copyRegion.imageOffset = { 0, (int32_t)(texture.uploadRow * blockDimensions.y), 0 };
+				const uint32_t copyHeight = (uint32_t)std::min<size_t>(rows * blockDimensions.y, height - texture.uploadRow * blockDimensions.y);
+				copyRegion.imageExtent = { width, copyHeight, 1 };
+				vkCmdCopyBufferToImage(slot.cmdBuffer, slot.stagingBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+
+				// Keep source offsets aligned to the texel block size
+				*stagingOffset = std::min((*stagingOffset + size + 15) & ~(VkDeviceSize)15, stagingSize);
+				streamedBytes += size;
+
+				texture.uploadRow += rows;
+				if (texture.uploadRow < blockRows)
+				{
+					break;
+				}
+				levelBarrier(slot.cmdBuffer, texture.image, level, 1,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+					VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+				texture.residentLevel = level;
+				texture.uploadRow = 0;
+				levelsCompleted = true;
+			}
+			return levelsCompleted;
+		}
+
+	public:
+		// Number of bytes uploaded since creation
+		VkDeviceSize streamedBytes = 0;
+
+		// budget is the max. number of bytes uploaded per frame (except for mip tails)
+		// framesInFlight is the number of frames the CPU may be ahead of the GPU
+		void prepare(VkDevice device, VulkanMemoryAllocator *allocator, VkQueue queue, VkCommandPool cmdPool, uint32_t framesInFlight, VkDeviceSize budget = 1024 * 1024)
+		{
+			this->device = device;
+			this->allocator = allocator;
+			this->queue = queue;
+			this->cmdPool = cmdPool;
+			this->framesInFlight = framesInFlight;
+			this->budget = budget;
+			// Has to fit a mip tail and a single row of any level
+			stagingSize = std::max(budget, mipTailSize) + 16;
+
+			slots.resize(framesInFlight);
+			VkCommandBufferAllocateInfo cmdBufAllocateInfo = vkTools::initializers::commandBufferAllocateInfo(cmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+			VkFenceCreateInfo fenceCreateInfo = vkTools::initializers::fenceCreateInfo(VK_FLAGS_NONE);
+			for (auto& slot : slots)
+			{
+				VkBufferCreateInfo bufferInfo = vkTools::initializers::bufferCreateInfo(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingSize);
+				VkResult err = vkCreateBuffer(device, &bufferInfo, nullptr, &slot.stagingBuffer);
+				assert(!err);
+				slot.stagingMemory = allocator->allocateBuffer(slot.stagingBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+				err = vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &slot.cmdBuffer);
+				assert(!err);
+				err = vkCreateFence(device, &fenceCreateInfo, nullptr, &slot.fence);
+				assert(!err);
+				slot.submitted = false;
+			}
+
+			VkSamplerCreateInfo samplerInfo = vkTools::initializers::samplerCreateInfo();
+			samplerInfo.magFilter = VK_FILTER_LINEAR;
+			samplerInfo.minFilter = VK_FILTER_LINEAR;
+			samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+			samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			samplerInfo.mipLodBias = 0.0f;
+			samplerInfo.maxAnisotropy = 0;
+			samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+			samplerInfo.minLod = 0.0f;
+			// Enough for any mip chain
+			samplerInfo.maxLod = 16.0f;
+			samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+			VkResult err = vkCreateSampler(device, &samplerInfo, nullptr, &sampler);
+			assert(!err);
+
+			createPlaceholder();
+		}
+
+		void destroy()
+		{
+			if (device == VK_NULL_HANDLE)
+			{
+				return;
+			}
+			while (!textures.empty())
+			{
+				release(&textures.front());
+			}
+			for (auto& slot : slots)
+			{
+				if (slot.submitted)
+				{
+					VkResult err = vkWaitForFences(device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+					assert(!err);
+				}
+				vkDestroyFence(device, slot.fence, nullptr);
+				vkFreeCommandBuffers(device, cmdPool, 1, &slot.cmdBuffer);
+				vkDestroyBuffer(device, slot.stagingBuffer, nullptr);
+				allocator->free(slot.stagingMemory);
+			}
+			slots.clear();
+			releaseRetired(true);
+			for (auto& read : abandonedReads)
+			{
+				read.wait();
+			}
+			abandonedReads.clear();
+			vkDestroyImageView(device, placeholderView, nullptr);
+			vkDestroyImage(device, placeholderImage, nullptr);
+			allocator->free(placeholderMemory);
+			vkDestroySampler(device, sampler, nullptr);
+			device = VK_NULL_HANDLE;
+		}
+
+		// Request a 2D texture, doesn't block
+		// The file is read on a worker thread, it's levels are uploaded by update
+		// The returned texture is owned by the streamer and valid until it's released
+		StreamingTexture *load(const char *filename, VkFormat format)
+		{
+			assert(device != VK_NULL_HANDLE);
+			textures.emplace_back();
+			StreamingTexture &texture = textures.back();
+			texture.format = format;
+			texture.descriptor = vkTools::initializers::descriptorImageInfo(sampler, placeholderView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			std::string file(filename);
+			texture.file = std::async(std::launch::async, [file]()
+			{
+				return gli::texture2D(gli::load(file.c_str()));
+			});
+			return &texture;
+		}
+
+		// Release a texture's resources once no frame in flight can use them anymore
+		// Descriptor sets that still use the texture must not be used after this
+		void release(StreamingTexture *texture)
+		{
+			auto it = std::find_if(textures.begin(), textures.end(), [texture](const StreamingTexture &t) { return &t == texture; });
+			assert(it != textures.end());
+			if (it->file.valid())
+			{
+				// Don't block on the read, the result is dropped once it's available
+				abandonedReads.push_back(std::move(it->file));
+			}
+			if (it->image != VK_NULL_HANDLE)
+			{
+				retire(it->view, it->image, it->allocation);
+			}
+			textures.erase(it);
+		}
+
+		// Upload the next levels of all textures, up to the budget
+		// Called by the example base class once per frame after waiting for the frame's fence,
+		// so the copies are submitted before (and are visible to) the frame's command buffers
+		// Never blocks, if the GPU hasn't finished with the next staging buffer yet nothing is uploaded
+		void update()
+		{
+			if (device == VK_NULL_HANDLE)
+			{
+				return;
+			}
+			frameNumber++;
+			releaseRetired(false);
+			abandonedReads.erase(std::remove_if(abandonedReads.begin(), abandonedReads.end(), [](std::future<gli::texture2D> &read)
+			{
+				return read.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+			}), abandonedReads.end());
+
+			Slot &slot = slots[currentSlot];
+			if (slot.submitted)
+			{
+				if (vkGetFenceStatus(device, slot.fence) != VK_SUCCESS)
+				{
+					return;
+				}
+				VkResult err = vkResetFences(device, 1, &slot.fence);
+				assert(!err);
+				slot.submitted = false;
+			}
+
+			bool recording = false;
+			VkDeviceSize stagingOffset = 0;
+			std::vector<StreamingTexture*> updatedTextures;
+			for (auto& texture : textures)
+			{
+				if (texture.image == VK_NULL_HANDLE)
+				{
+					if (!texture.file.valid() || (texture.file.wait_for(std::chrono::seconds(0)) != std::future_status::ready))
+					{
+						continue;
+					}
+				}
+				else if (texture.residentLevel == 0)
+				{
+					continue;
+				}
+
+				if (!recording)
+				{
+					VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
+					cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+					VkResult err = vkBeginCommandBuffer(slot.cmdBuffer, &cmdBufInfo);
+					assert(!err);
+					recording = true;
+				}
+				if (texture.image == VK_NULL_HANDLE)
+				{
+					texture.data.reset(new gli::texture2D(texture.file.get()));
+					assert(!texture.data->empty());
+					createImage(texture, slot.cmdBuffer);
+				}
+				if (stream(texture, slot, &stagingOffset))
+				{
+					updatedTextures.push_back(&texture);
+				}
+				if (stagingOffset >= budget)
+				{
+					break;
+				}
+			}
+
+			if (!recording)
+			{
+				return;
+			}
+			VkResult err = vkEndCommandBuffer(slot.cmdBuffer);
+			assert(!err);
+			VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &slot.cmdBuffer;
+			err = vkQueueSubmit(queue, 1, &submitInfo, slot.fence);
+			assert(!err);
+			slot.submitted = true;
+			currentSlot = (currentSlot + 1) % (uint32_t)slots.size();
+
+			for (auto texture : updatedTextures)
+			{
+				updateView(*texture);
+				if (texture->isComplete())
+				{
+					// Source data is no longer needed
+					texture->data.reset();
+				}
+			}
+		}
+
+		// Number of textures that still have levels to upload
+		uint32_t pendingTextures()
+		{
+			uint32_t count = 0;
+			for (auto& texture : textures)
+			{
+				count += texture.isComplete() ? 0 : 1;
+			}
+			return count;
+		}
+	};
+
+}
@@ -100,16 +100,23 @@ namespace vkTools
 	// See chapter 11.4 "Image Layout" for details
 	//todo : rename
 	void setImageLayout(VkCommandBuffer cmdbuffer, VkImage image, VkImageAspectFlags aspectMask, VkImageLayout oldImageLayout, VkImageLayout newImageLayout)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = aspectMask;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = 1;
+		subresourceRange.layerCount = 1;
+		setImageLayout(cmdbuffer, image, oldImageLayout, newImageLayout, subresourceRange);
+	}
+
+	void setImageLayout(VkCommandBuffer cmdbuffer, VkImage image, VkImageLayout oldImageLayout, VkImageLayout newImageLayout, VkImageSubresourceRange subresourceRange)
 	{
 		// Create an image barrier object
 		VkImageMemoryBarrier imageMemoryBarrier = vkTools::initializers::imageMemoryBarrier();
 		imageMemoryBarrier.oldLayout = oldImageLayout;
 		imageMemoryBarrier.newLayout = newImageLayout;
 		imageMemoryBarrier.image = image;
-		imageMemoryBarrier.subresourceRange.aspectMask = aspectMask;
-		imageMemoryBarrier.subresourceRange.baseMipLevel = 0;
-		imageMemoryBarrier.subresourceRange.levelCount = 1;
-		imageMemoryBarrier.subresourceRange.layerCount = 1;
+		imageMemoryBarrier.subresourceRange = subresourceRange;
 
 		// Source layouts (old)
 
@@ -334,7 +341,7 @@ namespace vkTools
 	void destroyUniformData(VkDevice device, vkTools::UniformData *uniformData)
 	{
 		vkDestroyBuffer(device, uniformData->buffer, nullptr);
-		vkFreeMemory(device, uniformData->memory, nullptr);
+		uniformData->allocation.free();
 	}
 }
 
@@ -457,6 +464,16 @@ VkSemaphoreCreateInfo vkTools::initializers::semaphoreCreateInfo(
 	return semaphoreCreateInfo;
 }
 
+VkFenceCreateInfo vkTools::initializers::fenceCreateInfo(
+	VkFenceCreateFlags flags)
+{
+	VkFenceCreateInfo fenceCreateInfo = {};
+	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceCreateInfo.pNext = NULL;
+	fenceCreateInfo.flags = flags;
+	return fenceCreateInfo;
+}
+
 VkSubmitInfo vkTools::initializers::submitInfo()
 {
 	VkSubmitInfo submitInfo = {};
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "vulkan/vulkan.h"
+#include "vulkanmemory.hpp"
 
 #include <math.h>
 #include <stdlib.h>
@@ -43,6 +44,13 @@ namespace vkTools
 		VkImageAspectFlags aspectMask, 
 		VkImageLayout oldImageLayout, 
 		VkImageLayout newImageLayout);
+	// Same as above, but for a range of mip levels and array layers (e.g. all faces of a cube map)
+	void setImageLayout(
+		VkCommandBuffer cmdbuffer,
+		VkImage image,
+		VkImageLayout oldImageLayout,
+		VkImageLayout newImageLayout,
+		VkImageSubresourceRange subresourceRange);
 
 	// Display error message and exit on fatal error
 	void exitFatal(std::string message, std::string caption);
@@ -70,7 +78,7 @@ namespace vkTools
 	struct UniformData 
 	{
 		VkBuffer buffer;
-		VkDeviceMemory memory;
+		vkTools::Allocation allocation;
 		VkDescriptorBufferInfo descriptor;
 		uint32_t allocSize;
 	};
@@ -109,6 +117,9 @@ namespace vkTools
 		VkSemaphoreCreateInfo semaphoreCreateInfo(
 			VkSemaphoreCreateFlags flags);
 
+		VkFenceCreateInfo fenceCreateInfo(
+			VkFenceCreateFlags flags);
+
 		VkSubmitInfo submitInfo();
 
 		VkViewport viewport(
@@ -0,0 +1,209 @@
+/*
+* Uniform buffer ring
+*
+* One persistently mapped buffer for all uniform data of an example, split
+* into one region per command buffer that may be in flight (i.e. per swap chain image)
+* Uniform blocks are sub-allocated once and bound as dynamic uniform buffers,
+* the region to read from is selected by the dynamic offset
+*
+* Updates made while a frame is being recorded go straight into the region of
+* the acquired image, other regions are brought up to date once their image
+* is acquired again
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+#include <vulkan/vulkan.h>
+#include "vulkantools.h"
+#include "vulkanmemory.hpp"
+
+namespace vkTools
+{
+
+	class VulkanUniformRing
+	{
+	private:
+		VkDevice device = VK_NULL_HANDLE;
+		VkBuffer buffer = VK_NULL_HANDLE;
+		Allocation memory;
+
+		VkDeviceSize alignment = 256;
+		VkDeviceSize regionSize = 0;
+		VkDeviceSize regionUsed = 0;
+
+		uint32_t regionCount = 0;
+		// Region of the image that is currently being recorded, the only one
+		// that's safe to write to as all others may still be read by the GPU
+		uint32_t currentRegion = UINT32_MAX;
+
+		// Updates outside of a frame (e.g. on input or during preparation) can't
+		// go into any of the regions, so they are kept here until the next begin
+		// This is treated as one more region with index regionCount
+		std::vector<uint8_t> hostData;
+
+		// A sub-allocation, the number of times it has been updated and the
+		// region that holds the latest version
+		struct Range
+		{
+			VkDeviceSize offset;
+			VkDeviceSize size;
+			uint64_t version;
+			uint32_t latestRegion;
+		};
+		std::vector<Range> ranges;
+		// Version of each range stored in a region
+		std::vector<std::vector<uint64_t>> regionVersions;
+
+		uint8_t *getRegionData(uint32_t region)
+		{
+			return (region == regionCount) ? hostData.data() : (uint8_t*)memory.mapped + region * regionSize;
+		}
+
+		// Copy the latest version of a range into the given region if it's outdated
+		// Reads from the mapped buffer, but only for ranges that weren't updated
+		// for the region's last frame (i.e. not for blocks updated every frame)
+		void refresh(size_t index, uint32_t region)
+		{
+			Range &range = ranges[index];
+			if (regionVersions[region][index] == range.version)
+			{
+				return;
+			}
+			memcpy(getRegionData(region) + range.offset, getRegionData(range.latestRegion) + range.offset, (size_t)range.size);
+			regionVersions[region][index] = range.version;
+		}
+
+		// Returns the index of the range containing the given offset
+		size_t findRange(VkDeviceSize offset)
+		{
+			auto it = std::upper_bound(ranges.begin(), ranges.end(), offset, [](VkDeviceSize offset, const Range &range) { return offset < range.offset; });
+			assert(it != ranges.begin());
+			return (size_t)(it - ranges.begin()) - 1;
+		}
+
+	public:
+		// Create the buffer with one region of regionSize bytes per command buffer
+		void prepare(VkPhysicalDevice physicalDevice, VkDevice device, VulkanMemoryAllocator *allocator, uint32_t regionCount, VkDeviceSize regionSize = 256 * 1024)
+		{
+			this->device = device;
+
+			VkPhysicalDeviceProperties deviceProperties;
+			vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+			alignment = std::max(deviceProperties.limits.minUniformBufferOffsetAlignment, (VkDeviceSize)16);
+			// Dynamic offsets need to be a multiple of the alignment too
+			this->regionSize = (regionSize + alignment - 1) & ~(alignment - 1);
+
+			VkBufferCreateInfo bufferInfo = vkTools::initializers::bufferCreateInfo(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, this->regionSize * regionCount);
+			VkResult err = vkCreateBuffer(device, &bufferInfo, nullptr, &buffer);
+			assert(!err);
+			// Coherent, so no explicit flushes are required after writing
+			memory = allocator->allocateBuffer(buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			assert(memory.mapped);
+
+			this->regionCount = regionCount;
+			hostData.resize(this->regionSize);
+			regionVersions.resize(regionCount + 1);
+		}
+
+		void destroy()
+		{
+			if (device == VK_NULL_HANDLE)
+			{
+				return;
+			}
+			vkDestroyBuffer(device, buffer, nullptr);
+			memory.free();
+			ranges.clear();
+			regionVersions.clear();
+			regionUsed = 0;
+			currentRegion = UINT32_MAX;
+			device = VK_NULL_HANDLE;
+		}
+
+		// Sub-allocate a uniform block, returns it's offset inside of a region
+		// Allocations live as long as the ring
+		VkDeviceSize allocate(VkDeviceSize size)
+		{
+			VkDeviceSize offset = (regionUsed + alignment - 1) & ~(alignment - 1);
+			assert(offset + size <= regionSize);
+			regionUsed = offset + size;
+			// Starts zeroed in the host copy, every region gets it on it's next begin
+			ranges.push_back({ offset, size, 1, regionCount });
+			memset(hostData.data() + offset, 0, (size_t)size);
+			for (uint32_t region = 0; region < regionCount; region++)
+			{
+				regionVersions[region].push_back(0);
+			}
+			regionVersions[regionCount].push_back(1);
+			return offset;
+		}
+
+		// Descriptor for a sub-allocation, to be used with VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+		// The offset of the region is added at bind time (see getDynamicOffset)
+		VkDescriptorBufferInfo getDescriptor(VkDeviceSize offset, VkDeviceSize size)
+		{
+			VkDescriptorBufferInfo descriptor = {};
+			descriptor.buffer = buffer;
+			descriptor.offset = offset;
+			descriptor.range = size;
+			return descriptor;
+		}
+
+		// Dynamic offset that selects the region of the given command buffer
+		uint32_t getDynamicOffset(uint32_t region)
+		{
+			return (uint32_t)(region * regionSize);
+		}
+
+		// Update (a part of) a sub-allocation
+		// Between begin and end the data is written straight into the current region,
+		// otherwise into the host copy
+		void update(VkDeviceSize offset, const void *data, VkDeviceSize size)
+		{
+			size_t index = findRange(offset);
+			Range &range = ranges[index];
+			assert(offset + size <= range.offset + range.size);
+			uint32_t region = (currentRegion != UINT32_MAX) ? currentRegion : regionCount;
+			// Partial updates need the rest of the range to be current
+			if ((offset != range.offset) || (size != range.size))
+			{
+				refresh(index, region);
+			}
+			memcpy(getRegionData(region) + offset, data, (size_t)size);
+			range.version++;
+			range.latestRegion = region;
+			regionVersions[region][index] = range.version;
+		}
+
+		// Start writing to the region of a command buffer, bringing all of it's
+		// sub-allocations up to date
+		// Call after waiting for the previous submission that read from the region
+		void begin(uint32_t region)
+		{
+			assert(region < regionCount);
+			currentRegion = region;
+			for (size_t i = 0; i < ranges.size(); i++)
+			{
+				refresh(i, region);
+			}
+		}
+
+		// Stop writing to the current region, call before submitting the command buffer
+		// Updates until the next begin go to the host copy
+		void end()
+		{
+			currentRegion = UINT32_MAX;
+		}
+
+		VkBuffer getBuffer()
+		{
+			return buffer;
+		}
+	};
+
+}
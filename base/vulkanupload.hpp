@@ -0,0 +1,210 @@
+/*
+* Staging upload manager
+*
+* Copies data into device local buffers through a host visible staging buffer
+* Uploads are collected and submitted in a single command buffer on flush
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+#include <vulkan/vulkan.h>
+#include "vulkantools.h"
+#include "vulkanmemory.hpp"
+
+namespace vkTools
+{
+
+	class VulkanUploadManager
+	{
+	private:
+		VkDevice device = VK_NULL_HANDLE;
+		VkQueue queue;
+		VkCommandPool cmdPool;
+		VkCommandBuffer cmdBuffer;
+		VkFence fence;
+
+		// Staging buffer, reused after each flush
+		VkBuffer stagingBuffer = VK_NULL_HANDLE;
+		Allocation stagingMemory;
+		VkDeviceSize stagingSize = 0;
+		VkDeviceSize stagingOffset = 0;
+
+		// Copies to the same buffer are merged into one vkCmdCopyBuffer
+		struct PendingCopy
+		{
+			VkBuffer dstBuffer;
+			std::vector<VkBufferCopy> regions;
+		};
+		std::vector<PendingCopy> pendingCopies;
+
+		// Add a copy region for the next size bytes of the staging buffer
+		// and return a pointer to them
+		void *addCopy(VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset)
+		{
+			void *data = (uint8_t*)stagingMemory.mapped + stagingOffset;
+
+			VkBufferCopy region = {};
+			region.srcOffset = stagingOffset;
+			region.dstOffset = dstOffset;
+			region.size = size;
+			if (pendingCopies.empty() || (pendingCopies.back().dstBuffer != dstBuffer))
+			{
+				pendingCopies.push_back({ dstBuffer, {} });
+			}
+			pendingCopies.back().regions.push_back(region);
+
+			// Keep source offsets aligned
+			stagingOffset = std::min((stagingOffset + size + 15) & ~(VkDeviceSize)15, stagingSize);
+			uploadedBytes += size;
+			return data;
+		}
+
+	public:
+		// Number of bytes and submissions since creation
+		VkDeviceSize uploadedBytes = 0;
+		uint32_t flushCount = 0;
+
+		// Create the staging buffer, command buffer and fence
+		void prepare(VkDevice device, VulkanMemoryAllocator *allocator, VkQueue queue, VkCommandPool cmdPool, VkDeviceSize stagingSize = 16 * 1024 * 1024)
+		{
+			this->device = device;
+			this->queue = queue;
+			this->cmdPool = cmdPool;
+			this->stagingSize = stagingSize;
+
+			VkBufferCreateInfo bufferInfo = vkTools::initializers::bufferCreateInfo(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingSize);
+			VkResult err = vkCreateBuffer(device, &bufferInfo, nullptr, &stagingBuffer);
+			assert(!err);
+			// Coherent, so no explicit flushes are required after writing
+			stagingMemory = allocator->allocateBuffer(stagingBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+			VkCommandBufferAllocateInfo cmdBufAllocateInfo =
+				vkTools::initializers::commandBufferAllocateInfo(
+					cmdPool,
+					VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+					1);
+			err = vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &cmdBuffer);
+			assert(!err);
+
+			VkFenceCreateInfo fenceCreateInfo = vkTools::initializers::fenceCreateInfo(VK_FLAGS_NONE);
+			err = vkCreateFence(device, &fenceCreateInfo, nullptr, &fence);
+			assert(!err);
+		}
+
+		void destroy()
+		{
+			if (device == VK_NULL_HANDLE)
+			{
+				return;
+			}
+			vkDestroyFence(device, fence, nullptr);
+			vkFreeCommandBuffers(device, cmdPool, 1, &cmdBuffer);
+			vkDestroyBuffer(device, stagingBuffer, nullptr);
+			stagingMemory.free();
+			device = VK_NULL_HANDLE;
+		}
+
+		// Queue a copy of host data into a (device local) buffer
+		// The buffer needs to be created with VK_BUFFER_USAGE_TRANSFER_DST_BIT
+		// Data is copied into the staging buffer immediately, the
+		// copy on the GPU is done on the next flush
+		void upload(VkBuffer dstBuffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset = 0)
+		{
+			const uint8_t *src = (const uint8_t*)data;
+			while (size > 0)
+			{
+				if (stagingOffset >= stagingSize)
+				{
+					// Staging buffer is full, submit and start over
+					flush();
+				}
+				VkDeviceSize chunkSize = std::min(size, stagingSize - stagingOffset);
+				memcpy(addCopy(dstBuffer, chunkSize, dstOffset), src, chunkSize);
+				src += chunkSize;
+				dstOffset += chunkSize;
+				size -= chunkSize;
+			}
+		}
+
+		// Queue a copy into a (device local) buffer and return a pointer into the
+		// staging buffer that the caller writes the data to (before the next flush)
+		// Saves a copy if the data is generated anyway
+		// Returns nullptr if size is larger than the staging buffer
+		void *reserve(VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0)
+		{
+			if (size > stagingSize)
+			{
+				return nullptr;
+			}
+			if (stagingOffset + size > stagingSize)
+			{
+				flush();
+			}
+			return addCopy(dstBuffer, size, dstOffset);
+		}
+
+		// Returns true if there are uploads that haven't been submitted yet
+		bool pending()
+		{
+			return !pendingCopies.empty();
+		}
+
+		// Submit all pending copies and wait for them to finish
+		void flush()
+		{
+			if (pendingCopies.empty())
+			{
+				return;
+			}
+
+			VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
+			cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			VkResult err = vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo);
+			assert(!err);
+
+			for (auto& copy : pendingCopies)
+			{
+				vkCmdCopyBuffer(cmdBuffer, stagingBuffer, copy.dstBuffer, (uint32_t)copy.regions.size(), copy.regions.data());
+			}
+
+			// Make the copied data visible to all later reads of the buffers
+			VkMemoryBarrier memoryBarrier = {};
+			memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			memoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(
+				cmdBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+				VK_FLAGS_NONE,
+				1, &memoryBarrier,
+				0, nullptr,
+				0, nullptr);
+
+			err = vkEndCommandBuffer(cmdBuffer);
+			assert(!err);
+
+			VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &cmdBuffer;
+			err = vkQueueSubmit(queue, 1, &submitInfo, fence);
+			assert(!err);
+
+			// Staging memory can only be reused once the copies are done
+			err = vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+			assert(!err);
+			err = vkResetFences(device, 1, &fence);
+			assert(!err);
+
+			pendingCopies.clear();
+			stagingOffset = 0;
+			flushCount++;
+		}
+	};
+
+}
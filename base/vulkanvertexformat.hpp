@@ -0,0 +1,272 @@
+/*
+* Compile time vertex formats
+*
+* Declares a vertex layout as a type, e.g.
+*   typedef vkMeshLoader::VertexFormat<VERTEX_LAYOUT_POSITION, VERTEX_LAYOUT_NORMAL> Format;
+* Stride, component offsets and vertex input attributes are constant expressions
+* and the packing loop is generated per format, so it's fully unrolled
+* Formats can be converted to the runtime layout (vector of VertexLayout) used
+* by vertexSize, the mesh cache and the non-template mesh loader functions
+*/
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <stdint.h>
+
+#include "vulkan/vulkan.h"
+#include "vulkanMeshLoader.hpp"
+
+namespace vkMeshLoader
+{
+
+	namespace detail
+	{
+		// Sum of the component sizes
+		template <VertexLayout... Components>
+		struct LayoutSize;
+
+		template <>
+		struct LayoutSize<>
+		{
+			static const uint32_t value = 0;
+		};
+
+		template <VertexLayout Component, VertexLayout... Components>
+		struct LayoutSize<Component, Components...>
+		{
+			static const uint32_t value = componentSize(Component) + LayoutSize<Components...>::value;
+		};
+
+		// Component and byte offset of the component at Index
+		template <uint32_t Index, VertexLayout... Components>
+		struct ComponentAt;
+
+		template <VertexLayout Component, VertexLayout... Components>
+		struct ComponentAt<0, Component, Components...>
+		{
+			static const VertexLayout component = Component;
+			static const uint32_t offset = 0;
+		};
+
+		template <uint32_t Index, VertexLayout Component, VertexLayout... Components>
+		struct ComponentAt<Index, Component, Components...>
+		{
+			static const VertexLayout component = ComponentAt<Index - 1, Components...>::component;
+			static const uint32_t offset = componentSize(Component) + ComponentAt<Index - 1, Components...>::offset;
+		};
+
+		template <uint32_t... Indices>
+		struct IndexSequence {};
+
+		template <uint32_t Count, uint32_t... Indices>
+		struct MakeIndexSequence : MakeIndexSequence<Count - 1, Count - 1, Indices...> {};
+
+		template <uint32_t... Indices>
+		struct MakeIndexSequence<0, Indices...>
+		{
+			typedef IndexSequence<Indices...> type;
+		};
+
+		// Writes a single component, conversions must match VulkanMeshLoader::packVertexRange
+		template <VertexLayout Component>
+		struct ComponentPacker;
+
+		template <>
+		struct ComponentPacker<VERTEX_LAYOUT_POSITION>
+		{
+			template <typename Vertex>
+			static inline void pack(const Vertex &vertex, const PackParams &params, float *out)
+			{
+				out[0] = vertex.m_pos.x * params.scale;
+				out[1] = vertex.m_pos.y * params.scale;
+				out[2] = vertex.m_pos.z * params.scale;
+			}
+		};
+
+		template <>
+		struct ComponentPacker<VERTEX_LAYOUT_NORMAL>
+		{
+			template <typename Vertex>
+			static inline void pack(const Vertex &vertex, const PackParams &, float *out)
+			{
+				out[0] = vertex.m_normal.x;
+				out[1] = -vertex.m_normal.y;
+				out[2] = vertex.m_normal.z;
+			}
+		};
+
+		template <>
+		struct ComponentPacker<VERTEX_LAYOUT_UV>
+		{
+			template <typename Vertex>
+			static inline void pack(const Vertex &vertex, const PackParams &, float *out)
+			{
+				out[0] = vertex.m_tex.s;
+				out[1] = vertex.m_tex.t;
+			}
+		};
+
+		template <>
+		struct ComponentPacker<VERTEX_LAYOUT_COLOR>
+		{
+			template <typename Vertex>
+			static inline void pack(const Vertex &vertex, const PackParams &, float *out)
+			{
+				out[0] = vertex.m_color.r;
+				out[1] = vertex.m_color.g;
+				out[2] = vertex.m_color.b;
+			}
+		};
+
+		template <>
+		struct ComponentPacker<VERTEX_LAYOUT_TANGENT>
+		{
+			template <typename Vertex>
+			static inline void pack(const Vertex &vertex, const PackParams &, float *out)
+			{
+				out[0] = vertex.m_tangent.x;
+				out[1] = vertex.m_tangent.y;
+				out[2] = vertex.m_tangent.z;
+			}
+		};
+
+		template <>
+		struct ComponentPacker<VERTEX_LAYOUT_BITANGENT>
+		{
+			template <typename Vertex>
+			static inline void pack(const Vertex &vertex, const PackParams &, float *out)
+			{
+				out[0] = vertex.m_binormal.x;
+				out[1] = vertex.m_binormal.y;
+				out[2] = vertex.m_binormal.z;
+			}
+		};
+
+		template <>
+		struct ComponentPacker<VERTEX_LAYOUT_POSITION_QUANTIZED>
+		{
+			template <typename Vertex>
+			static inline void pack(const Vertex &vertex, const PackParams &params, float *out)
+			{
+				packQuantizedPosition(vertex.m_pos, params, out);
+			}
+		};
+
+		template <>
+		struct ComponentPacker<VERTEX_LAYOUT_NORMAL_PACKED>
+		{
+			template <typename Vertex>
+			static inline void pack(const Vertex &vertex, const PackParams &, float *out)
+			{
+				packSnorm10(glm::vec3(vertex.m_normal.x, -vertex.m_normal.y, vertex.m_normal.z), out);
+			}
+		};
+
+		template <>
+		struct ComponentPacker<VERTEX_LAYOUT_TANGENT_PACKED>
+		{
+			template <typename Vertex>
+			static inline void pack(const Vertex &vertex, const PackParams &, float *out)
+			{
+				packSnorm10(vertex.m_tangent, out);
+			}
+		};
+
+		template <>
+		struct ComponentPacker<VERTEX_LAYOUT_UV_HALF>
+		{
+			template <typename Vertex>
+			static inline void pack(const Vertex &vertex, const PackParams &, float *out)
+			{
+				packHalf2(vertex.m_tex, out);
+			}
+		};
+
+		template <>
+		struct ComponentPacker<VERTEX_LAYOUT_COLOR_UNORM8>
+		{
+			template <typename Vertex>
+			static inline void pack(const Vertex &vertex, const PackParams &, float *out)
+			{
+				packUnorm8(vertex.m_color, out);
+			}
+		};
+
+		// Writes all components of a vertex at their compile time offsets
+		template <VertexLayout... Components>
+		struct VertexPacker;
+
+		template <>
+		struct VertexPacker<>
+		{
+			template <typename Vertex>
+			static inline void pack(const Vertex &, const PackParams &, float *) {}
+		};
+
+		template <VertexLayout Component, VertexLayout... Components>
+		struct VertexPacker<Component, Components...>
+		{
+			template <typename Vertex>
+			static inline void pack(const Vertex &vertex, const PackParams &params, float *out)
+			{
+				ComponentPacker<Component>::pack(vertex, params, out);
+				VertexPacker<Components...>::pack(vertex, params, out + componentSize(Component) / sizeof(float));
+			}
+		};
+	}
+
+	template <VertexLayout... Components>
+	struct VertexFormat
+	{
+		static const uint32_t componentCount = sizeof...(Components);
+		// Size of a single vertex in bytes
+		static const uint32_t stride = detail::LayoutSize<Components...>::value;
+
+		typedef std::array<VkVertexInputAttributeDescription, sizeof...(Components)> AttributeDescriptions;
+
+		// Runtime layout of this format
+		static std::vector<VertexLayout> layout()
+		{
+			return { Components... };
+		}
+
+		static constexpr VkVertexInputBindingDescription bindingDescription(uint32_t binding)
+		{
+			return { binding, stride, VK_VERTEX_INPUT_RATE_VERTEX };
+		}
+
+		// One attribute per component, at consecutive shader locations starting with firstLocation
+		static constexpr AttributeDescriptions attributeDescriptions(uint32_t binding, uint32_t firstLocation = 0)
+		{
+			return attributeDescriptions(binding, firstLocation, typename detail::MakeIndexSequence<sizeof...(Components)>::type());
+		}
+
+		// Pack count vertices to out (count * stride bytes)
+		template <typename Vertex>
+		static void pack(const Vertex *src, uint32_t count, const PackParams &params, float *out)
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				detail::VertexPacker<Components...>::pack(src[i], params, out);
+				out += stride / sizeof(float);
+			}
+		}
+
+	private:
+		template <uint32_t... Indices>
+		static constexpr AttributeDescriptions attributeDescriptions(uint32_t binding, uint32_t firstLocation, detail::IndexSequence<Indices...>)
+		{
+			return {{
+				{
+					firstLocation + Indices,
+					binding,
+					componentFormat(detail::ComponentAt<Indices, Components...>::component),
+					detail::ComponentAt<Indices, Components...>::offset
+				}...
+			}};
+		}
+	};
+
+}
@@ -0,0 +1,202 @@
+/*
+* Mesh optimization benchmark
+*
+* Measures the vertex cache efficiency (ACMR) and overdraw of meshes before and
+* after VulkanMeshLoader::optimize, and the time the optimization takes
+* Also checks that the overdraw sort doesn't increase overdraw on generated meshes
+* with known occlusion (a convex sphere and a sphere enclosing a smaller one),
+* for both winding orders. Returns 1 if it does
+*
+* Usage : meshoptimization [-threads <n>] [model files...]
+* Runs from the bin directory like the examples (models are loaded from ./../data/models)
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+#include "vulkanMeshLoader.hpp"
+#include "vulkanmeshoptimizer.hpp"
+
+// Models used if none are passed on the command line
+static const std::vector<std::string> defaultModels =
+{
+	"./../data/models/voyager/voyager.obj",
+	"./../data/models/retroufo.X",
+	"./../data/models/vulkanscenelogos.dae",
+	"./../data/models/vulkanscenebackground.dae",
+	"./../data/models/suzanne.obj",
+	"./../data/models/torus.obj",
+	"./../data/models/color_teapot_spheres.X",
+	"./../data/models/angryteapot.X",
+};
+
+// Append a uv sphere with counter clockwise (outward facing) triangles
+static void generateSphere(float radius, uint32_t rings, uint32_t segments, std::vector<glm::vec3> &positions, std::vector<uint32_t> &indices)
+{
+	const uint32_t base = (uint32_t)positions.size();
+	for (uint32_t r = 0; r <= rings; r++)
+	{
+		float theta = (float)M_PI * r / rings;
+		for (uint32_t s = 0; s <= segments; s++)
+		{
+			float phi = 2.0f * (float)M_PI * s / segments;
+			positions.push_back(radius * glm::vec3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi)));
+		}
+	}
+	for (uint32_t r = 0; r < rings; r++)
+	{
+		for (uint32_t s = 0; s < segments; s++)
+		{
+			uint32_t i0 = base + r * (segments + 1) + s;
+			uint32_t i1 = i0 + segments + 1;
+			uint32_t quad[6] = { i0, i0 + 1, i1, i1, i0 + 1, i1 + 1 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+}
+
+// Optimize the (shuffled) triangles with both winding orders and compare the overdraw
+// Returns false if the overdraw went up
+static bool checkOverdraw(const std::string &name, std::vector<glm::vec3> positions, std::vector<uint32_t> indices)
+{
+	std::mt19937 rng(1);
+	std::vector<uint32_t> order(indices.size() / 3);
+	for (uint32_t t = 0; t < order.size(); t++)
+	{
+		order[t] = t;
+	}
+	std::shuffle(order.begin(), order.end(), rng);
+	std::vector<uint32_t> shuffled;
+	for (auto t : order)
+	{
+		shuffled.insert(shuffled.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+	}
+
+	bool passed = true;
+	const uint32_t vertexCount = (uint32_t)positions.size();
+	for (uint32_t mirrored = 0; mirrored < 2; mirrored++)
+	{
+		// Mirror the positions like the mesh loader's y flip, which reverses the winding
+		if (mirrored)
+		{
+			for (auto& position : positions)
+			{
+				position.y = -position.y;
+			}
+		}
+		std::vector<uint32_t> optimized = shuffled;
+		vkMeshLoader::OverdrawStatistics before = vkMeshLoader::analyzeOverdraw(optimized.data(), optimized.size(), positions.data(), vertexCount);
+		vkMeshLoader::optimizeVertexCache(optimized.data(), optimized.size(), vertexCount);
+		vkMeshLoader::optimizeOverdraw(optimized.data(), optimized.size(), positions.data(), vertexCount);
+		vkMeshLoader::OverdrawStatistics after = vkMeshLoader::analyzeOverdraw(optimized.data(), optimized.size(), positions.data(), vertexCount);
+
+		bool ok = after.overdraw <= before.overdraw;
+		passed &= ok;
+		std::cout << std::left << std::setw(48) << (name + (mirrored ? " (mirrored)" : "")) << std::right << std::fixed
+			<< std::setprecision(3)
+			<< std::setw(10) << before.overdraw
+			<< std::setw(10) << after.overdraw
+			<< (ok ? "" : "  (overdraw increased!)") << "\n";
+	}
+	return passed;
+}
+
+// Positions and indices of all mesh entries as a single triangle list
+static void gatherMesh(VulkanMeshLoader &mesh, std::vector<glm::vec3> &positions, std::vector<uint32_t> &indices)
+{
+	positions.clear();
+	indices.clear();
+	for (auto& entry : mesh.m_Entries)
+	{
+		const uint32_t base = (uint32_t)positions.size();
+		for (auto& vertex : entry.Vertices)
+		{
+			positions.push_back(vertex.m_pos);
+		}
+		for (auto index : entry.Indices)
+		{
+			indices.push_back(base + index);
+		}
+	}
+}
+
+int main(const int argc, const char *argv[])
+{
+	uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<std::string> models;
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "-threads") == 0) && (i + 1 < argc))
+		{
+			threadCount = std::max(atoi(argv[++i]), 1);
+		}
+		else
+		{
+			models.push_back(argv[i]);
+		}
+	}
+	if (models.empty())
+	{
+		models = defaultModels;
+	}
+
+	std::cout << "Overdraw of generated meshes before and after optimizing\n";
+	std::cout << std::left << std::setw(48) << "mesh" << std::right
+		<< std::setw(10) << "before"
+		<< std::setw(10) << "after" << "\n";
+
+	bool passed = true;
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> indices;
+	generateSphere(1.0f, 32, 64, positions, indices);
+	passed &= checkOverdraw("sphere", positions, indices);
+	// The inner sphere is hidden, drawing the outer one first avoids shading it
+	generateSphere(0.5f, 32, 64, positions, indices);
+	passed &= checkOverdraw("nested spheres", positions, indices);
+
+	std::cout << "\n" << threadCount << " threads, ACMR with a 16 entry FIFO cache\n";
+	std::cout << std::left << std::setw(48) << "model" << std::right
+		<< std::setw(10) << "triangles"
+		<< std::setw(10) << "ms"
+		<< std::setw(10) << "ACMR"
+		<< std::setw(10) << "->"
+		<< std::setw(10) << "overdraw"
+		<< std::setw(10) << "->" << "\n";
+
+	for (auto& model : models)
+	{
+		VulkanMeshLoader mesh;
+		if (!mesh.LoadMesh(model))
+		{
+			continue;
+		}
+		gatherMesh(mesh, positions, indices);
+		vkMeshLoader::OverdrawStatistics overdrawBefore = vkMeshLoader::analyzeOverdraw(indices.data(), indices.size(), positions.data(), (uint32_t)positions.size());
+
+		auto tStart = std::chrono::high_resolution_clock::now();
+		vkMeshLoader::MeshOptimizationStatistics stats = mesh.optimize(1.05f, threadCount);
+		auto tEnd = std::chrono::high_resolution_clock::now();
+
+		gatherMesh(mesh, positions, indices);
+		vkMeshLoader::OverdrawStatistics overdrawAfter = vkMeshLoader::analyzeOverdraw(indices.data(), indices.size(), positions.data(), (uint32_t)positions.size());
+
+		std::string name = (model.size() > 46) ? "..." + model.substr(model.size() - 43) : model;
+		std::cout << std::left << std::setw(48) << name << std::right << std::fixed
+			<< std::setw(10) << stats.before.triangleCount
+			<< std::setprecision(2)
+			<< std::setw(10) << std::chrono::duration<double, std::milli>(tEnd - tStart).count()
+			<< std::setprecision(3)
+			<< std::setw(10) << stats.before.acmr
+			<< std::setw(10) << stats.after.acmr
+			<< std::setw(10) << overdrawBefore.overdraw
+			<< std::setw(10) << overdrawAfter.overdraw << "\n";
+	}
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+/*
+* Mesh packing benchmark
+*
+* Measures the throughput (vertices per second) of building the interleaved vertex
+* and index data that VulkanMeshLoader uploads to the GPU
+* Compares the original per-component push_back path against the
+* allocation-free packer (runtime layout, single threaded and using all
+* hardware threads) and the packer generated for a compile time vertex format
+*
+* Usage : meshpacking [-iterations <n>] [-threads <n>] [model files...]
+* Runs from the bin directory like the examples (models are loaded from ./../data/models)
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+#include "vulkanMeshLoader.hpp"
+#include "vulkanvertexformat.hpp"
+
+// Models used if none are passed on the command line
+static const std::vector<std::string> defaultModels =
+{
+	"./../data/models/voyager/voyager.obj",
+	"./../data/models/retroufo.X",
+	"./../data/models/vulkanscenelogos.dae",
+	"./../data/models/vulkanscenebackground.dae",
+	"./../data/models/suzanne.obj",
+	"./../data/models/torus.obj",
+	"./../data/models/color_teapot_spheres.X",
+	"./../data/models/angryteapot.X",
+};
+
+// Layout used by most of the examples
+static const std::vector<vkMeshLoader::VertexLayout> layout =
+{
+	vkMeshLoader::VERTEX_LAYOUT_POSITION,
+	vkMeshLoader::VERTEX_LAYOUT_NORMAL,
+	vkMeshLoader::VERTEX_LAYOUT_UV,
+	vkMeshLoader::VERTEX_LAYOUT_COLOR
+};
+
+// Same layout as a compile time format
+typedef vkMeshLoader::VertexFormat<
+	vkMeshLoader::VERTEX_LAYOUT_POSITION,
+	vkMeshLoader::VERTEX_LAYOUT_NORMAL,
+	vkMeshLoader::VERTEX_LAYOUT_UV,
+	vkMeshLoader::VERTEX_LAYOUT_COLOR> VertexFormat;
+
+// Original implementation of VulkanMeshLoader::createVulkanBuffers (without the buffer creation)
+// Kept as the baseline for comparison
+static void packLegacy(VulkanMeshLoader *mesh, float scale, std::vector<float> &vertexBuffer, std::vector<uint32_t> &indexBuffer)
+{
+	for (uint32_t m = 0; m < mesh->m_Entries.size(); m++)
+	{
+		for (uint32_t i = 0; i < mesh->m_Entries[m].Vertices.size(); i++)
+		{
+			for (auto& layoutDetail : layout)
+			{
+				if (layoutDetail == vkMeshLoader::VERTEX_LAYOUT_POSITION)
+				{
+					vertexBuffer.push_back(mesh->m_Entries[m].Vertices[i].m_pos.x * scale);
+					vertexBuffer.push_back(mesh->m_Entries[m].Vertices[i].m_pos.y * scale);
+					vertexBuffer.push_back(mesh->m_Entries[m].Vertices[i].m_pos.z * scale);
+				}
+				if (layoutDetail == vkMeshLoader::VERTEX_LAYOUT_NORMAL)
+				{
+					vertexBuffer.push_back(mesh->m_Entries[m].Vertices[i].m_normal.x);
+					vertexBuffer.push_back(-mesh->m_Entries[m].Vertices[i].m_normal.y);
+					vertexBuffer.push_back(mesh->m_Entries[m].Vertices[i].m_normal.z);
+				}
+				if (layoutDetail == vkMeshLoader::VERTEX_LAYOUT_UV)
+				{
+					vertexBuffer.push_back(mesh->m_Entries[m].Vertices[i].m_tex.s);
+					vertexBuffer.push_back(mesh->m_Entries[m].Vertices[i].m_tex.t);
+				}
+				if (layoutDetail == vkMeshLoader::VERTEX_LAYOUT_COLOR)
+				{
+					vertexBuffer.push_back(mesh->m_Entries[m].Vertices[i].m_color.r);
+					vertexBuffer.push_back(mesh->m_Entries[m].Vertices[i].m_color.g);
+					vertexBuffer.push_back(mesh->m_Entries[m].Vertices[i].m_color.b);
+				}
+			}
+		}
+	}
+
+	for (uint32_t m = 0; m < mesh->m_Entries.size(); m++)
+	{
+		uint32_t vertexBase = mesh->m_Entries[m].vertexBase;
+		for (uint32_t i = 0; i < mesh->m_Entries[m].Indices.size(); i++)
+		{
+			indexBuffer.push_back(mesh->m_Entries[m].Indices[i] + vertexBase);
+		}
+	}
+}
+
+// Runs func the given number of times and returns the average time in milliseconds
+template <typename Func>
+static double measure(uint32_t iterations, Func func)
+{
+	auto tStart = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		func();
+	}
+	auto tEnd = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(tEnd - tStart).count() / iterations;
+}
+
+int main(const int argc, const char *argv[])
+{
+	uint32_t iterations = 20;
+	uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<std::string> models;
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "-iterations") == 0) && (i + 1 < argc))
+		{
+			iterations = std::max(atoi(argv[++i]), 1);
+		}
+		else if ((strcmp(argv[i], "-threads") == 0) && (i + 1 < argc))
+		{
+			threadCount = std::max(atoi(argv[++i]), 1);
+		}
+		else
+		{
+			models.push_back(argv[i]);
+		}
+	}
+	if (models.empty())
+	{
+		models = defaultModels;
+	}
+
+	const uint32_t stride = vkMeshLoader::vertexSize(layout);
+	std::cout << "Vertex stride " << stride << " bytes, " << iterations << " iterations, " << threadCount << " threads\n";
+	std::cout << "Throughput in million vertices per second\n";
+	std::cout << std::left << std::setw(48) << "model" << std::right
+		<< std::setw(10) << "vertices"
+		<< std::setw(10) << "legacy"
+		<< std::setw(10) << "1 thread"
+		<< std::setw(10) << "threaded"
+		<< std::setw(10) << "format"
+		<< std::setw(10) << "speedup" << "\n";
+
+	for (auto& model : models)
+	{
+		VulkanMeshLoader mesh;
+		if (!mesh.LoadMesh(model))
+		{
+			continue;
+		}
+		const float scale = 1.0f;
+		const size_t vertexDataSize = (size_t)mesh.numVertices * stride;
+		const uint32_t indexCount = mesh.getIndexCount();
+
+		// Baseline allocates and grows it's vectors on every run
+		std::vector<float> legacyVertices;
+		std::vector<uint32_t> legacyIndices;
+		double legacyTime = measure(iterations, [&]()
+		{
+			legacyVertices = std::vector<float>();
+			legacyIndices = std::vector<uint32_t>();
+			packLegacy(&mesh, scale, legacyVertices, legacyIndices);
+		});
+
+		// The packer writes to preallocated (mapped or staging) memory
+		std::vector<uint8_t> vertexData(vertexDataSize);
+		std::vector<uint32_t> indexData(indexCount);
+		double singleTime = measure(iterations, [&]()
+		{
+			mesh.packVertices(layout, scale, vertexData.data(), 1);
+			mesh.packIndices(indexData.data(), 1);
+		});
+		double threadedTime = measure(iterations, [&]()
+		{
+			mesh.packVertices(layout, scale, vertexData.data(), threadCount);
+			mesh.packIndices(indexData.data(), threadCount);
+		});
+		std::vector<uint8_t> formatVertexData(vertexDataSize);
+		double formatTime = measure(iterations, [&]()
+		{
+			mesh.packVertices<VertexFormat>(scale, formatVertexData.data(), threadCount);
+			mesh.packIndices(indexData.data(), threadCount);
+		});
+
+		// Both paths need to produce identical data
+		bool match = (legacyVertices.size() * sizeof(float) == vertexDataSize) &&
+			(memcmp(legacyVertices.data(), vertexData.data(), vertexDataSize) == 0) &&
+			(legacyIndices == indexData) &&
+			(vertexData == formatVertexData);
+
+		auto throughput = [&](double time) { return (time > 0.0) ? mesh.numVertices / (time * 1000.0) : 0.0; };
+		std::string name = (model.size() > 46) ? "..." + model.substr(model.size() - 43) : model;
+		std::cout << std::left << std::setw(48) << name << std::right << std::fixed
+			<< std::setw(10) << mesh.numVertices
+			<< std::setprecision(2)
+			<< std::setw(10) << throughput(legacyTime)
+			<< std::setw(10) << throughput(singleTime)
+			<< std::setw(10) << throughput(threadedTime)
+			<< std::setw(10) << throughput(formatTime)
+			<< std::setw(9) << legacyTime / threadedTime << "x"
+			<< (match ? "" : "  (output mismatch!)") << "\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,232 @@
+/*
+* Texture loading benchmark
+*
+* Measures the time it takes to get the data of all subresources of a texture file
+* into (staging) memory, and the process' peak resident set size while doing so
+* Compares reading the file with gli (heap allocated copy of the whole file that's
+* then copied again) against the memory mapped vkTools::TextureFile that copies
+* straight from the mapped file
+*
+* Usage : textureloading [-iterations <n>] [-reader gli|mapped] [texture files...]
+* Runs from the bin directory like the examples (textures are loaded from ./../data/textures)
+* Peak RSS can only grow, so the mapped reader runs first. Use -reader to measure one reader on it's own
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <gli/gli.hpp>
+#include "vulkantexturefile.hpp"
+
+// Largest textures in data/textures, used if none are passed on the command line
+static const std::vector<std::string> defaultTextures =
+{
+	"./../data/textures/font_sdf_rgba.ktx",
+	"./../data/textures/igor_and_pal_rgba.ktx",
+	"./../data/textures/vulkan_space_rgba8.ktx",
+	"./../data/textures/rocks_color_bc3.dds",
+	"./../data/textures/stonewall_heightmap_rgba.dds",
+	"./../data/textures/darkmetal_bc3.ktx",
+	"./../data/textures/font_bitmap_rgba.ktx",
+};
+
+// Peak resident set size of the process in KB
+static size_t getPeakRSS()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize / 1024;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (size_t)usage.ru_maxrss;
+#endif
+}
+
+// Copy all subresources of a file to dst like the texture loader fills it's staging buffer
+// Returns the number of bytes copied, 0 if the file couldn't be read
+static size_t loadGli(const std::string &filename, uint8_t *dst)
+{
+	gli::texture texture(gli::load(filename.c_str()));
+	if (texture.empty())
+	{
+		return 0;
+	}
+	size_t offset = 0;
+	for (size_t layer = 0; layer < texture.layers(); layer++)
+	{
+		for (size_t face = 0; face < texture.faces(); face++)
+		{
+			for (size_t level = 0; level < texture.levels(); level++)
+			{
+				memcpy(dst + offset, texture.data(layer, face, level), texture.size(level));
+				offset += texture.size(level);
+			}
+		}
+	}
+	return offset;
+}
+
+static size_t loadMapped(const std::string &filename, uint8_t *dst)
+{
+	vkTools::TextureFile file(filename);
+	if (!file.isOpen())
+	{
+		return 0;
+	}
+	size_t offset = 0;
+	for (uint32_t layer = 0; layer < file.getLayers(); layer++)
+	{
+		for (uint32_t face = 0; face < file.getFaces(); face++)
+		{
+			for (uint32_t level = 0; level < file.getLevels(); level++)
+			{
+				memcpy(dst + offset, file.getData(level, layer, face), file.getSize(level));
+				offset += file.getSize(level);
+			}
+		}
+	}
+	return offset;
+}
+
+// Runs func the given number of times and returns the average time in milliseconds
+template <typename Func>
+static double measure(uint32_t iterations, Func func)
+{
+	auto tStart = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		func();
+	}
+	auto tEnd = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(tEnd - tStart).count() / iterations;
+}
+
+int main(const int argc, const char *argv[])
+{
+	uint32_t iterations = 50;
+	bool runGli = true;
+	bool runMapped = true;
+	std::vector<std::string> textures;
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "-iterations") == 0) && (i + 1 < argc))
+		{
+			iterations = std::max(atoi(argv[++i]), 1);
+		}
+		else if ((strcmp(argv[i], "-reader") == 0) && (i + 1 < argc))
+		{
+			i++;
+			runGli = (strcmp(argv[i], "gli") == 0);
+			runMapped = (strcmp(argv[i], "mapped") == 0);
+		}
+		else
+		{
+			textures.push_back(argv[i]);
+		}
+	}
+	if (textures.empty())
+	{
+		textures = defaultTextures;
+	}
+
+	// Sizes of the data, read once up front
+	std::vector<size_t> dataSizes(textures.size(), 0);
+	size_t maxDataSize = 0;
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		vkTools::TextureFile file(textures[i]);
+		for (uint32_t level = 0; file.isOpen() && (level < file.getLevels()); level++)
+		{
+			dataSizes[i] += file.getSize(level) * file.getLayers() * file.getFaces();
+		}
+		maxDataSize = std::max(maxDataSize, dataSizes[i]);
+	}
+
+	// Stands in for the mapped staging buffer, touched so it counts as resident for both readers
+	std::vector<uint8_t> staging(maxDataSize, 1);
+	std::vector<uint8_t> reference(maxDataSize);
+	const size_t baseRSS = getPeakRSS();
+
+	std::vector<double> mappedTimes(textures.size(), 0.0);
+	std::vector<double> gliTimes(textures.size(), 0.0);
+	std::vector<bool> match(textures.size(), true);
+	size_t mappedRSS = 0;
+	size_t gliRSS = 0;
+
+	if (runMapped)
+	{
+		for (size_t i = 0; i < textures.size(); i++)
+		{
+			mappedTimes[i] = measure(iterations, [&]() { loadMapped(textures[i], staging.data()); });
+		}
+		mappedRSS = getPeakRSS();
+	}
+	if (runGli)
+	{
+		for (size_t i = 0; i < textures.size(); i++)
+		{
+			gliTimes[i] = measure(iterations, [&]() { loadGli(textures[i], staging.data()); });
+		}
+		gliRSS = getPeakRSS();
+	}
+	// Both readers need to produce the same data
+	if (runGli && runMapped)
+	{
+		for (size_t i = 0; i < textures.size(); i++)
+		{
+			size_t mappedSize = loadMapped(textures[i], reference.data());
+			size_t gliSize = loadGli(textures[i], staging.data());
+			match[i] = (mappedSize == gliSize) && (memcmp(reference.data(), staging.data(), gliSize) == 0);
+		}
+	}
+
+	std::cout << iterations << " iterations, average time in ms to copy all subresources into staging memory\n";
+	std::cout << std::left << std::setw(48) << "texture" << std::right
+		<< std::setw(10) << "KB"
+		<< std::setw(10) << "gli"
+		<< std::setw(10) << "mapped"
+		<< std::setw(10) << "speedup" << "\n";
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		if (dataSizes[i] == 0)
+		{
+			std::cout << textures[i] << " : could not be read\n";
+			continue;
+		}
+		std::string name = (textures[i].size() > 46) ? "..." + textures[i].substr(textures[i].size() - 43) : textures[i];
+		std::cout << std::left << std::setw(48) << name << std::right << std::fixed
+			<< std::setw(10) << dataSizes[i] / 1024
+			<< std::setprecision(3)
+			<< std::setw(10) << gliTimes[i]
+			<< std::setw(10) << mappedTimes[i]
+			<< std::setprecision(2)
+			<< std::setw(9) << ((runGli && runMapped) ? gliTimes[i] / mappedTimes[i] : 0.0) << "x"
+			<< (match[i] ? "" : "  (output mismatch!)") << "\n";
+	}
+	std::cout << "Peak RSS : " << baseRSS << " KB before loading";
+	if (runMapped)
+	{
+		std::cout << ", " << mappedRSS << " KB after mapped";
+	}
+	if (runGli)
+	{
+		std::cout << ", " << gliRSS << " KB after gli";
+	}
+	std::cout << "\n";
+
+	return 0;
+}
@@ -57,13 +57,14 @@ public:
 		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
 	} vertices;
 
+	// Offsets of the uniform blocks inside the base class uniform ring
 	struct {
-		vkTools::UniformData vsScene;
-		vkTools::UniformData vsFullScreen;
-		vkTools::UniformData vsSkyBox;
-		vkTools::UniformData fsVertBlur;
-		vkTools::UniformData fsHorzBlur;
-	} uniformData;
+		VkDeviceSize vsScene;
+		VkDeviceSize vsFullScreen;
+		VkDeviceSize vsSkyBox;
+		VkDeviceSize fsVertBlur;
+		VkDeviceSize fsHorzBlur;
+	} uniformOffsets;
 
 	struct UBO {
 		glm::mat4 projection;
@@ -109,7 +110,7 @@ public:
 	// Framebuffer for offscreen rendering
 	struct FrameBufferAttachment {
 		VkImage image;
-		VkDeviceMemory mem;
+		vkTools::Allocation allocation;
 		VkImageView view;
 	};
 	struct FrameBuffer {
@@ -121,8 +122,14 @@ public:
 	} offScreenFrameBuf, offScreenFrameBufB;
 
 	// Used to store commands for rendering and blitting
-	// the offscreen scene
-	VkCommandBuffer offScreenCmdBuffer = VK_NULL_HANDLE;
+	// the offscreen scene, one per swap chain image so each
+	// can read the uniform ring region of it's image
+	std::vector<VkCommandBuffer> offScreenCmdBuffers;
+
+	// Render pass used for the offscreen framebuffers
+	// Unlike the default render pass it keeps the color attachment
+	// in color attachment layout instead of transitioning it to present
+	VkRenderPass offScreenRenderPass;
 
 	VulkanExample() : VulkanExampleBase(ENABLE_VALIDATION)
 	{
@@ -144,22 +151,23 @@ public:
 		// Frame buffer
 		vkDestroyImageView(device, offScreenFrameBuf.color.view, nullptr);
 		vkDestroyImage(device, offScreenFrameBuf.color.image, nullptr);
-		vkFreeMemory(device, offScreenFrameBuf.color.mem, nullptr);
+		memoryAllocator.free(offScreenFrameBuf.color.allocation);
 
 		vkDestroyImageView(device, offScreenFrameBuf.depth.view, nullptr);
 		vkDestroyImage(device, offScreenFrameBuf.depth.image, nullptr);
-		vkFreeMemory(device, offScreenFrameBuf.depth.mem, nullptr);
+		memoryAllocator.free(offScreenFrameBuf.depth.allocation);
 
 		vkDestroyImageView(device, offScreenFrameBufB.color.view, nullptr);
 		vkDestroyImage(device, offScreenFrameBufB.color.image, nullptr);
-		vkFreeMemory(device, offScreenFrameBufB.color.mem, nullptr);
+		memoryAllocator.free(offScreenFrameBufB.color.allocation);
 
 		vkDestroyImageView(device, offScreenFrameBufB.depth.view, nullptr);
 		vkDestroyImage(device, offScreenFrameBufB.depth.image, nullptr);
-		vkFreeMemory(device, offScreenFrameBufB.depth.mem, nullptr);
+		memoryAllocator.free(offScreenFrameBufB.depth.allocation);
 
 		vkDestroyFramebuffer(device, offScreenFrameBuf.frameBuffer, nullptr);
 		vkDestroyFramebuffer(device, offScreenFrameBufB.frameBuffer, nullptr);
+		vkDestroyRenderPass(device, offScreenRenderPass, nullptr);
 
 		vkDestroyPipeline(device, pipelines.blurVert, nullptr);
 		vkDestroyPipeline(device, pipelines.phongPass, nullptr);
@@ -177,14 +185,7 @@ public:
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.skyBox);
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.quad);
 
-		// Uniform buffers
-		vkTools::destroyUniformData(device, &uniformData.vsScene);
-		vkTools::destroyUniformData(device, &uniformData.vsFullScreen);
-		vkTools::destroyUniformData(device, &uniformData.vsSkyBox);
-		vkTools::destroyUniformData(device, &uniformData.fsVertBlur);
-		vkTools::destroyUniformData(device, &uniformData.fsHorzBlur);
-
-		vkFreeCommandBuffers(device, cmdPool, 1, &offScreenCmdBuffer);
+		vkFreeCommandBuffers(device, cmdPool, offScreenCmdBuffers.size(), offScreenCmdBuffers.data());
 
 		textureLoader->destroyTexture(textures.cubemap);
 	}
@@ -217,18 +218,9 @@ public:
 		// Texture will be sampled in a shader and is also the blit destination
 		imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
-		VkMemoryAllocateInfo memAllocInfo = vkTools::initializers::memoryAllocateInfo();
-		VkMemoryRequirements memReqs;
-
 		err = vkCreateImage(device, &imageCreateInfo, nullptr, &tex->image);
 		assert(!err);
-		vkGetImageMemoryRequirements(device, tex->image, &memReqs);
-		memAllocInfo.allocationSize = memReqs.size;
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAllocInfo.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAllocInfo, nullptr, &(tex->deviceMemory));
-		assert(!err);
-		err = vkBindImageMemory(device, tex->image, tex->deviceMemory, 0);
-		assert(!err);
+		tex->allocation = memoryAllocator.allocateImage(tex->image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Transform image layout to transer destination
 		tex->imageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
@@ -301,9 +293,6 @@ public:
 		image.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 		image.flags = 0;
 
-		VkMemoryAllocateInfo memAlloc = vkTools::initializers::memoryAllocateInfo();
-		VkMemoryRequirements memReqs;
-
 		VkImageViewCreateInfo colorImageView = vkTools::initializers::imageViewCreateInfo();
 		colorImageView.viewType = VK_IMAGE_VIEW_TYPE_2D;
 		colorImageView.format = fbColorFormat;
@@ -317,14 +306,7 @@ public:
 
 		err = vkCreateImage(device, &image, nullptr, &frameBuf->color.image);
 		assert(!err);
-		vkGetImageMemoryRequirements(device, frameBuf->color.image, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAlloc.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAlloc, nullptr, &frameBuf->color.mem);
-		assert(!err);
-
-		err = vkBindImageMemory(device, frameBuf->color.image, frameBuf->color.mem, 0);
-		assert(!err);
+		frameBuf->color.allocation = memoryAllocator.allocateImage(frameBuf->color.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		vkTools::setImageLayout(
 			setupCmdBuffer, 
@@ -354,14 +336,7 @@ public:
 
 		err = vkCreateImage(device, &image, nullptr, &frameBuf->depth.image);
 		assert(!err);
-		vkGetImageMemoryRequirements(device, frameBuf->depth.image, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT, &memAlloc.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAlloc, nullptr, &frameBuf->depth.mem);
-		assert(!err);
-
-		err = vkBindImageMemory(device, frameBuf->depth.image, frameBuf->depth.mem, 0);
-		assert(!err);
+		frameBuf->depth.allocation = memoryAllocator.allocateImage(frameBuf->depth.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		vkTools::setImageLayout(
 			setupCmdBuffer,
@@ -381,7 +356,7 @@ public:
 		attachments[1] = frameBuf->depth.view;
 
 		VkFramebufferCreateInfo fbufCreateInfo = vkTools::initializers::framebufferCreateInfo();
-		fbufCreateInfo.renderPass = renderPass;
+		fbufCreateInfo.renderPass = offScreenRenderPass;
 		fbufCreateInfo.attachmentCount = 2;
 		fbufCreateInfo.pAttachments = attachments;
 		fbufCreateInfo.width = frameBuf->width;
@@ -392,35 +367,39 @@ public:
 		assert(!err);
 	}
 
-	void createOffscreenCommandBuffer()
+	void createOffscreenCommandBuffers()
 	{
+		offScreenCmdBuffers.resize(drawCmdBuffers.size());
 		VkCommandBufferAllocateInfo cmd = vkTools::initializers::commandBufferAllocateInfo(
 			cmdPool,
 			VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-			1);
-		VkResult vkRes = vkAllocateCommandBuffers(device, &cmd, &offScreenCmdBuffer);
+			offScreenCmdBuffers.size());
+		VkResult vkRes = vkAllocateCommandBuffers(device, &cmd, offScreenCmdBuffers.data());
 		assert(!vkRes);
 	}
 
 	// Render the 3D scene into a texture target
-	void buildOffscreenCommandBuffer()
+	void buildOffscreenCommandBuffer(VkCommandBuffer cmdBuffer, uint32_t dynamicOffset)
 	{
 		VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
 
+		// One dynamic offset per uniform buffer binding of the set
+		uint32_t dynamicOffsets[2] = { dynamicOffset, dynamicOffset };
+
 		// Horizontal blur
 		VkClearValue clearValues[2];
 		clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
 		clearValues[1].depthStencil = { 1.0f, 0 };
 
 		VkRenderPassBeginInfo renderPassBeginInfo = vkTools::initializers::renderPassBeginInfo();
-		renderPassBeginInfo.renderPass = renderPass;
+		renderPassBeginInfo.renderPass = offScreenRenderPass;
 		renderPassBeginInfo.framebuffer = offScreenFrameBuf.frameBuffer;
 		renderPassBeginInfo.renderArea.extent.width = offScreenFrameBuf.width;
 		renderPassBeginInfo.renderArea.extent.height = offScreenFrameBuf.height;
 		renderPassBeginInfo.clearValueCount = 2;
 		renderPassBeginInfo.pClearValues = clearValues;
 
-		VkResult err = vkBeginCommandBuffer(offScreenCmdBuffer, &cmdBufInfo);
+		VkResult err = vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo);
 		assert(!err);
 
 		VkViewport viewport = vkTools::initializers::viewport(
@@ -428,30 +407,30 @@ public:
 			(float)offScreenFrameBuf.height,
 			0.0f,
 			1.0f);
-		vkCmdSetViewport(offScreenCmdBuffer, 0, 1, &viewport);
+		vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
 
 		VkRect2D scissor = vkTools::initializers::rect2D(
 			offScreenFrameBuf.width,
 			offScreenFrameBuf.height,
 			0,
 			0);
-		vkCmdSetScissor(offScreenCmdBuffer, 0, 1, &scissor);
+		vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
 
-		vkCmdBeginRenderPass(offScreenCmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-		vkCmdBindDescriptorSets(offScreenCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets.scene, 0, NULL);
-		vkCmdBindPipeline(offScreenCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.phongPass);
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets.scene, 2, dynamicOffsets);
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.phongPass);
 
 		VkDeviceSize offsets[1] = { 0 };
-		vkCmdBindVertexBuffers(offScreenCmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &meshes.ufoGlow.vertices.buf, offsets);
-		vkCmdBindIndexBuffer(offScreenCmdBuffer, meshes.ufoGlow.indices.buf, 0, VK_INDEX_TYPE_UINT32);
-		vkCmdDrawIndexed(offScreenCmdBuffer, meshes.ufoGlow.indexCount, 1, 0, 0, 0);
+		vkCmdBindVertexBuffers(cmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &meshes.ufoGlow.vertices.buf, offsets);
+		vkCmdBindIndexBuffer(cmdBuffer, meshes.ufoGlow.indices.buf, 0, meshes.ufoGlow.indexType);
+		vkMeshLoader::drawMesh(cmdBuffer, meshes.ufoGlow);
 
-		vkCmdEndRenderPass(offScreenCmdBuffer);
+		vkCmdEndRenderPass(cmdBuffer);
 
 		// Make sure color writes to the framebuffer are finished before using it as transfer source
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBuf.color.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
@@ -459,7 +438,7 @@ public:
 
 		// Transform texture target to transfer destination
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBuf.textureTarget.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
@@ -491,7 +470,7 @@ public:
 		// Blit from framebuffer image to texture image
 		// vkCmdBlitImage does scaling and (if necessary and possible) also does format conversions
 		vkCmdBlitImage(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBuf.color.image,
 			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 			offScreenFrameBuf.textureTarget.image,
@@ -503,7 +482,7 @@ public:
 
 		// Transform framebuffer color attachment back 
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBuf.color.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
@@ -513,7 +492,7 @@ public:
 		// Makes sure that writes to the texture are finished before
 		// it's accessed in the shader
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBuf.textureTarget.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
@@ -528,24 +507,24 @@ public:
 
 		viewport.width = offScreenFrameBuf.width;
 		viewport.height = offScreenFrameBuf.height;
-		vkCmdSetViewport(offScreenCmdBuffer, 0, 1, &viewport);
+		vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
 
-		vkCmdSetScissor(offScreenCmdBuffer, 0, 1, &scissor);
+		vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
 
-		vkCmdBeginRenderPass(offScreenCmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 		// Draw horizontally blurred texture 
-		vkCmdBindDescriptorSets(offScreenCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.radialBlur, 0, 1, &descriptorSets.verticalBlur, 0, NULL);
-		vkCmdBindPipeline(offScreenCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.blurVert);
-		vkCmdBindVertexBuffers(offScreenCmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &meshes.quad.vertices.buf, offsets);
-		vkCmdBindIndexBuffer(offScreenCmdBuffer, meshes.quad.indices.buf, 0, VK_INDEX_TYPE_UINT32);
-		vkCmdDrawIndexed(offScreenCmdBuffer, meshes.quad.indexCount, 1, 0, 0, 0);
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.radialBlur, 0, 1, &descriptorSets.verticalBlur, 2, dynamicOffsets);
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.blurVert);
+		vkCmdBindVertexBuffers(cmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &meshes.quad.vertices.buf, offsets);
+		vkCmdBindIndexBuffer(cmdBuffer, meshes.quad.indices.buf, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdDrawIndexed(cmdBuffer, meshes.quad.indexCount, 1, 0, 0, 0);
 
-		vkCmdEndRenderPass(offScreenCmdBuffer);
+		vkCmdEndRenderPass(cmdBuffer);
 
 		// Make sure color writes to the framebuffer are finished before using it as transfer source
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBufB.color.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
@@ -553,7 +532,7 @@ public:
 
 		// Transform texture target to transfer destination
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBufB.textureTarget.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
@@ -563,7 +542,7 @@ public:
 		// Blit from framebuffer image to texture image
 		// vkCmdBlitImage does scaling and (if necessary and possible) also does format conversions
 		vkCmdBlitImage(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBufB.color.image,
 			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 			offScreenFrameBufB.textureTarget.image,
@@ -575,7 +554,7 @@ public:
 
 		// Transform framebuffer color attachment back 
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBufB.color.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
@@ -585,16 +564,24 @@ public:
 		// Makes sure that writes to the texture are finished before
 		// it's accessed in the shader
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBufB.textureTarget.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-		err = vkEndCommandBuffer(offScreenCmdBuffer);
+		err = vkEndCommandBuffer(cmdBuffer);
 		assert(!err);
 	}
 
+	void buildOffscreenCommandBuffers()
+	{
+		for (uint32_t i = 0; i < offScreenCmdBuffers.size(); ++i)
+		{
+			buildOffscreenCommandBuffer(offScreenCmdBuffers[i], uniformRing.getDynamicOffset(i));
+		}
+	}
+
 	void loadTextures()
 	{
 		textureLoader->loadCubemap(
@@ -605,6 +592,8 @@ public:
 
 	void reBuildCommandBuffers()
 	{
+		// Frames may still be in flight
+		vkDeviceWaitIdle(device);
 		if (!checkCommandBuffers())
 		{
 			destroyCommandBuffers();
@@ -658,26 +647,30 @@ public:
 
 			VkDeviceSize offsets[1] = { 0 };
 
+			// Each command buffer reads the uniform ring region of it's swap chain image
+			// One dynamic offset per uniform buffer binding of the set
+			uint32_t dynamicOffsets[2] = { uniformRing.getDynamicOffset(i), uniformRing.getDynamicOffset(i) };
+
 			// Skybox 
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets.skyBox, 0, NULL);
+			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets.skyBox, 2, dynamicOffsets);
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.skyBox);
 
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.skyBox.vertices.buf, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.skyBox.indices.buf, 0, VK_INDEX_TYPE_UINT32);
-			vkCmdDrawIndexed(drawCmdBuffers[i], meshes.skyBox.indexCount, 1, 0, 0, 0);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.skyBox.indices.buf, 0, meshes.skyBox.indexType);
+			vkMeshLoader::drawMesh(drawCmdBuffers[i], meshes.skyBox);
 		
 			// 3D scene
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets.scene, 0, NULL);
+			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets.scene, 2, dynamicOffsets);
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.phongPass);
 
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.ufo.vertices.buf, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.ufo.indices.buf, 0, VK_INDEX_TYPE_UINT32);
-			vkCmdDrawIndexed(drawCmdBuffers[i], meshes.ufo.indexCount, 1, 0, 0, 0);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.ufo.indices.buf, 0, meshes.ufo.indexType);
+			vkMeshLoader::drawMesh(drawCmdBuffers[i], meshes.ufo);
 
 			// Render vertical blurred scene applying a horizontal blur
 			if (bloom)
 			{
-				vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.radialBlur, 0, 1, &descriptorSets.horizontalBlur, 0, NULL);
+				vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.radialBlur, 0, 1, &descriptorSets.horizontalBlur, 2, dynamicOffsets);
 				vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.blurVert);
 				vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.quad.vertices.buf, offsets);
 				vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.quad.indices.buf, 0, VK_INDEX_TYPE_UINT32);
@@ -686,70 +679,40 @@ public:
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE,
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
-
 			err = vkEndCommandBuffer(drawCmdBuffers[i]);
 			assert(!err);
 		}
 
 		if (bloom) 
 		{
-			buildOffscreenCommandBuffer();
+			buildOffscreenCommandBuffers();
 		}
 	}
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo =
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
 
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
+		// The UFO moves every frame, write it to the uniform ring region of the acquired image
+		if (!paused)
+		{
+			updateUniformBuffersScene();
+		}
 
 		// Gather command buffers to be sumitted to the queue
 		std::vector<VkCommandBuffer> submitCmdBuffers;
 
 		// Submit offscreen rendering command buffer 
+		// Each command buffer is measured by the GPU profiler (if enabled)
 		if (bloom)
 		{
-			submitCmdBuffers.push_back(offScreenCmdBuffer);
+			profiler.addCommandBuffer(submitCmdBuffers, offScreenCmdBuffers[currentBuffer], "Glow + horizontal blur");
 		}
 
-		submitCmdBuffers.push_back(drawCmdBuffers[currentBuffer]);
-
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = submitCmdBuffers.size();
-		submitInfo.pCommandBuffers = submitCmdBuffers.data();
-
-		// Submit draw command buffer
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
+		profiler.addCommandBuffer(submitCmdBuffers, drawCmdBuffers[currentBuffer], "Scene + vertical blur");
 
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
-
-		err = vkQueueWaitIdle(queue);
-		assert(err == VK_SUCCESS);
+		submitFrame(submitCmdBuffers);
 	}
 
 	void loadMeshes()
@@ -784,7 +747,7 @@ public:
 			vertexBuffer.size() * sizeof(Vertex),
 			vertexBuffer.data(),
 			&meshes.quad.vertices.buf,
-			&meshes.quad.vertices.mem);
+			&meshes.quad.vertices.allocation);
 
 		// Setup indices
 		std::vector<uint32_t> indexBuffer = { 0,1,2, 2,3,0 };
@@ -795,7 +758,7 @@ public:
 			indexBuffer.size() * sizeof(uint32_t),
 			indexBuffer.data(),
 			&meshes.quad.indices.buf,
-			&meshes.quad.indices.mem);
+			&meshes.quad.indices.allocation);
 	}
 
 	void setupVertexDescriptions()
@@ -851,7 +814,7 @@ public:
 	{
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 8),
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 8),
 			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 6)
 		};
 
@@ -873,7 +836,7 @@ public:
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_VERTEX_BIT,
 				0),
 			// Binding 1 : Fragment shader image sampler
@@ -883,7 +846,7 @@ public:
 				1),
 			// Binding 2 : Framgnet shader image sampler
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_FRAGMENT_BIT,
 				2),
 		};
@@ -917,6 +880,13 @@ public:
 				&descriptorSetLayout,
 				1);
 
+		// Uniform blocks inside the uniform ring
+		VkDescriptorBufferInfo vsSceneDescriptor = uniformRing.getDescriptor(uniformOffsets.vsScene, sizeof(ubos.scene));
+		VkDescriptorBufferInfo vsFullScreenDescriptor = uniformRing.getDescriptor(uniformOffsets.vsFullScreen, sizeof(ubos.fullscreen));
+		VkDescriptorBufferInfo vsSkyBoxDescriptor = uniformRing.getDescriptor(uniformOffsets.vsSkyBox, sizeof(ubos.skyBox));
+		VkDescriptorBufferInfo fsVertBlurDescriptor = uniformRing.getDescriptor(uniformOffsets.fsVertBlur, sizeof(ubos.vertBlur));
+		VkDescriptorBufferInfo fsHorzBlurDescriptor = uniformRing.getDescriptor(uniformOffsets.fsHorzBlur, sizeof(ubos.horzBlur));
+
 		// Full screen blur descriptor sets
 		// Vertical blur
 		VkResult err = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSets.verticalBlur);
@@ -933,9 +903,9 @@ public:
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.verticalBlur,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.vsScene.descriptor),
+				&vsSceneDescriptor),
 			// Binding 1 : Fragment shader texture sampler
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.verticalBlur,
@@ -945,9 +915,9 @@ public:
 			// Binding 2 : Fragment shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.verticalBlur,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				2,
-				&uniformData.fsVertBlur.descriptor)
+				&fsVertBlurDescriptor)
 		};
 
 		vkUpdateDescriptorSets(device, writeDescriptorSets.size(), writeDescriptorSets.data(), 0, NULL);
@@ -967,9 +937,9 @@ public:
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.horizontalBlur,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.vsScene.descriptor),
+				&vsSceneDescriptor),
 			// Binding 1 : Fragment shader texture sampler
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.horizontalBlur,
@@ -979,9 +949,9 @@ public:
 			// Binding 2 : Fragment shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.horizontalBlur,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				2,
-				&uniformData.fsHorzBlur.descriptor)
+				&fsHorzBlurDescriptor)
 		};
 
 		vkUpdateDescriptorSets(device, writeDescriptorSets.size(), writeDescriptorSets.data(), 0, NULL);
@@ -995,9 +965,9 @@ public:
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.scene,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.vsFullScreen.descriptor)
+				&vsFullScreenDescriptor)
 		};
 
 		vkUpdateDescriptorSets(device, writeDescriptorSets.size(), writeDescriptorSets.data(), 0, NULL);
@@ -1018,9 +988,9 @@ public:
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.skyBox,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.vsSkyBox.descriptor),
+				&vsSkyBoxDescriptor),
 			// Binding 1 : Fragment shader texture sampler
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.skyBox,
@@ -1169,49 +1139,19 @@ public:
 	void prepareUniformBuffers()
 	{
 		// Phong and color pass vertex shader uniform buffer
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(ubos.scene),
-			&ubos.scene,
-			&uniformData.vsScene.buffer,
-			&uniformData.vsScene.memory,
-			&uniformData.vsScene.descriptor);
+		uniformOffsets.vsScene = uniformRing.allocate(sizeof(ubos.scene));
 
 		// Fullscreen quad display vertex shader uniform buffer
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(ubos.fullscreen),
-			&ubos.fullscreen,
-			&uniformData.vsFullScreen.buffer,
-			&uniformData.vsFullScreen.memory,
-			&uniformData.vsFullScreen.descriptor);
+		uniformOffsets.vsFullScreen = uniformRing.allocate(sizeof(ubos.fullscreen));
 
 		// Fullscreen quad fragment shader uniform buffers
 		// Vertical blur
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(ubos.vertBlur),
-			&ubos.vertBlur,
-			&uniformData.fsVertBlur.buffer,
-			&uniformData.fsVertBlur.memory,
-			&uniformData.fsVertBlur.descriptor);
+		uniformOffsets.fsVertBlur = uniformRing.allocate(sizeof(ubos.vertBlur));
 		// Horizontal blur
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(ubos.horzBlur),
-			&ubos.horzBlur,
-			&uniformData.fsHorzBlur.buffer,
-			&uniformData.fsHorzBlur.memory,
-			&uniformData.fsHorzBlur.descriptor);
+		uniformOffsets.fsHorzBlur = uniformRing.allocate(sizeof(ubos.horzBlur));
 
 		// Skybox
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(ubos.skyBox),
-			&ubos.skyBox,
-			&uniformData.vsSkyBox.buffer,
-			&uniformData.vsSkyBox.memory,
-			&uniformData.vsSkyBox.descriptor);
+		uniformOffsets.vsSkyBox = uniformRing.allocate(sizeof(ubos.skyBox));
 
 		// Intialize uniform buffers
 		updateUniformBuffersScene();
@@ -1234,11 +1174,7 @@ public:
 		ubos.fullscreen.model = glm::rotate(ubos.fullscreen.model, deg_to_rad(timer * 360.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 		ubos.fullscreen.model = glm::rotate(ubos.fullscreen.model, deg_to_rad(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.vsFullScreen.memory, 0, sizeof(ubos.fullscreen), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &ubos.fullscreen, sizeof(ubos.fullscreen));
-		vkUnmapMemory(device, uniformData.vsFullScreen.memory);
+		uniformRing.update(uniformOffsets.vsFullScreen, &ubos.fullscreen, sizeof(ubos.fullscreen));
 
 		// Skybox
 		ubos.skyBox.projection = glm::perspective(deg_to_rad(45.0f), (float)width / (float)height, 0.1f, 256.0f);
@@ -1248,10 +1184,7 @@ public:
 		ubos.skyBox.model = glm::rotate(ubos.skyBox.model, deg_to_rad(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
 		ubos.skyBox.model = glm::rotate(ubos.skyBox.model, deg_to_rad(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
-		err = vkMapMemory(device, uniformData.vsSkyBox.memory, 0, sizeof(ubos.skyBox), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &ubos.skyBox, sizeof(ubos.skyBox));
-		vkUnmapMemory(device, uniformData.vsSkyBox.memory);
+		uniformRing.update(uniformOffsets.vsSkyBox, &ubos.skyBox, sizeof(ubos.skyBox));
 	}
 
 	// Update uniform buffers for the fullscreen quad
@@ -1261,25 +1194,15 @@ public:
 		ubos.scene.projection = glm::ortho(0.0f, 1.0f, 0.0f, 1.0f, -1.0f, 1.0f);
 		ubos.scene.model = glm::mat4();
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.vsScene.memory, 0, sizeof(ubos.scene), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &ubos.scene, sizeof(ubos.scene));
-		vkUnmapMemory(device, uniformData.vsScene.memory);
+		uniformRing.update(uniformOffsets.vsScene, &ubos.scene, sizeof(ubos.scene));
 
 		// Fragment shader
 		// Vertical
 		ubos.vertBlur.horizontal = 0;
-		err = vkMapMemory(device, uniformData.fsVertBlur.memory, 0, sizeof(ubos.vertBlur), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &ubos.vertBlur, sizeof(ubos.vertBlur));
-		vkUnmapMemory(device, uniformData.fsVertBlur.memory);
+		uniformRing.update(uniformOffsets.fsVertBlur, &ubos.vertBlur, sizeof(ubos.vertBlur));
 		// Horizontal
 		ubos.horzBlur.horizontal = 1;
-		err = vkMapMemory(device, uniformData.fsHorzBlur.memory, 0, sizeof(ubos.horzBlur), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &ubos.horzBlur, sizeof(ubos.horzBlur));
-		vkUnmapMemory(device, uniformData.fsHorzBlur.memory);
+		uniformRing.update(uniformOffsets.fsHorzBlur, &ubos.horzBlur, sizeof(ubos.horzBlur));
 	}
 
 	void prepare()
@@ -1296,7 +1219,8 @@ public:
 		preparePipelines();
 		setupDescriptorPool();
 		setupDescriptorSet();
-		createOffscreenCommandBuffer(); 
+		createOffscreenCommandBuffers();
+		offScreenRenderPass = createRenderPass(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
 		prepareOffscreenFramebuffer(&offScreenFrameBuf);
 		prepareOffscreenFramebuffer(&offScreenFrameBufB);
 		buildCommandBuffers();
@@ -1307,13 +1231,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
-		if (!paused)
-		{
-			updateUniformBuffersScene();
-		}
 	}
 
 	virtual void viewChanged()
@@ -1381,6 +1299,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
@@ -43,7 +43,9 @@ public:
 	int vertexBufferSize;
 
 	VkQueue computeQueue;
-	VkCommandBuffer computeCmdBuffer;
+	// One compute command buffer per swap chain image, each reads the
+	// uniform ring region of its image
+	std::vector<VkCommandBuffer> computeCmdBuffers;
 	VkPipelineLayout computePipelineLayout;
 	VkDescriptorSet computeDescriptorSet;
 	VkDescriptorSetLayout computeDescriptorSetLayout;
@@ -57,11 +59,8 @@ public:
 		int32_t particleCount = PARTICLE_COUNT;
 	} computeUbo;
 
-	struct {
-		struct {
-			vkTools::UniformData ubo;
-		} computeShader;
-	} uniformData;
+	// Offset of the compute shader uniform block inside the base class uniform ring
+	VkDeviceSize uniformOffsetCompute;
 
 	struct Particle {
 		glm::vec4 pos;
@@ -90,12 +89,9 @@ public:
 
 		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
-		vkDestroyBuffer(device, computeStorageBuffer.buffer, nullptr);
-		vkFreeMemory(device, computeStorageBuffer.memory, nullptr);
-
-		vkTools::destroyUniformData(device, &uniformData.computeShader.ubo);
+		vkTools::destroyUniformData(device, &computeStorageBuffer);
 
-		vkFreeCommandBuffers(device, cmdPool, 1, &computeCmdBuffer);
+		vkFreeCommandBuffers(device, cmdPool, computeCmdBuffers.size(), computeCmdBuffers.data());
 		vkDestroyPipelineLayout(device, computePipelineLayout, nullptr);
 		vkDestroyDescriptorSetLayout(device, computeDescriptorSetLayout, nullptr);
 		vkDestroyPipeline(device, pipelines.compute, nullptr);
@@ -196,74 +192,60 @@ public:
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE,
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
-
 			err = vkEndCommandBuffer(drawCmdBuffers[i]);
 			assert(!err);
 		}
 
 	}
 
-	void buildComputeCommandBuffer()
+	void buildComputeCommandBuffers()
 	{
 		VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();;
 
-		vkBeginCommandBuffer(computeCmdBuffer, &cmdBufInfo);
+		for (uint32_t i = 0; i < computeCmdBuffers.size(); ++i)
+		{
+			vkBeginCommandBuffer(computeCmdBuffers[i], &cmdBufInfo);
 
-		vkCmdBindPipeline(computeCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines.compute);
-		vkCmdBindDescriptorSets(computeCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 0, 1, &computeDescriptorSet, 0, 0);
+			vkCmdBindPipeline(computeCmdBuffers[i], VK_PIPELINE_BIND_POINT_COMPUTE, pipelines.compute);
+			uint32_t dynamicOffset = uniformRing.getDynamicOffset(i);
+			vkCmdBindDescriptorSets(computeCmdBuffers[i], VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 0, 1, &computeDescriptorSet, 1, &dynamicOffset);
 
-		vkCmdDispatch(computeCmdBuffer, PARTICLE_COUNT / 16, 1, 1);
+			vkCmdDispatch(computeCmdBuffers[i], PARTICLE_COUNT / 16, 1, 1);
 
-		vkEndCommandBuffer(computeCmdBuffer);
+			vkEndCommandBuffer(computeCmdBuffers[i]);
+		}
 	}
 
 	void draw()
 	{
 		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo =
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
-
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
 
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
 
-		// Submit draw command buffer
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
-
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
+		// Animation parameters for this frame's dispatch go straight into the
+		// uniform ring region of the acquired image
+		if (animStart > 0.0f)
+		{
+			animStart -= frameTimer * 5.0f;
+		}
+		if ((animate) & (animStart <= 0.0f))
+		{
+			timer += frameTimer * 0.1f;
+			if (timer > 1.0)
+			{
+				timer -= 1.0f;
+			}
+		}
+		updateUniformBuffers();
 
-		err = vkQueueWaitIdle(queue);
-		assert(!err);
+		// Submit the image's draw command buffer and present it
+		submitFrame();
 
 		// Compute
 		VkSubmitInfo computeSubmitInfo = vkTools::initializers::submitInfo();
 		computeSubmitInfo.commandBufferCount = 1;
-		computeSubmitInfo.pCommandBuffers = &computeCmdBuffer;
+		computeSubmitInfo.pCommandBuffers = &computeCmdBuffers[currentBuffer];
 
 		err = vkQueueSubmit(computeQueue, 1, &computeSubmitInfo, VK_NULL_HANDLE);
 		assert(!err);
@@ -305,11 +287,7 @@ public:
 		// Buffer size is the same for all storage buffers
 		uint32_t storageBufferSize = particleBuffer.size() * sizeof(Particle);
 
-		VkMemoryAllocateInfo memAlloc = vkTools::initializers::memoryAllocateInfo();
-		VkMemoryRequirements memReqs;
-
 		VkResult err;
-		void *data;
 
 		// Allocate and fill storage buffer object
 		VkBufferCreateInfo vBufferInfo = 
@@ -318,17 +296,8 @@ public:
 				storageBufferSize);
 		err = vkCreateBuffer(device, &vBufferInfo, nullptr, &computeStorageBuffer.buffer);
 		assert(!err);
-		vkGetBufferMemoryRequirements(device, computeStorageBuffer.buffer, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &memAlloc.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAlloc, nullptr, &computeStorageBuffer.memory);
-		assert(!err);
-		err = vkMapMemory(device, computeStorageBuffer.memory, 0, storageBufferSize, 0, &data);
-		assert(!err);
-		memcpy(data, particleBuffer.data(), storageBufferSize);
-		vkUnmapMemory(device, computeStorageBuffer.memory);
-		err = vkBindBufferMemory(device, computeStorageBuffer.buffer, computeStorageBuffer.memory, 0);
-		assert(!err);
+		computeStorageBuffer.allocation = memoryAllocator.allocateBuffer(computeStorageBuffer.buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+		memcpy(computeStorageBuffer.allocation.mapped, particleBuffer.data(), storageBufferSize);
 
 		computeStorageBuffer.descriptor.buffer = computeStorageBuffer.buffer;
 		computeStorageBuffer.descriptor.offset = 0;
@@ -372,7 +341,7 @@ public:
 	{
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1),
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1),
 			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1),
 			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
 		};
@@ -446,16 +415,18 @@ public:
 		vkUpdateDescriptorSets(device, writeDescriptorSets.size(), writeDescriptorSets.data(), 0, NULL);
 	}
 
-	// Create a separate command buffer for compute commands
-	void createComputeCommandBuffer()
+	// Create separate command buffers for compute commands
+	void createComputeCommandBuffers()
 	{
+		computeCmdBuffers.resize(drawCmdBuffers.size());
+
 		VkCommandBufferAllocateInfo cmdBufAllocateInfo =
 			vkTools::initializers::commandBufferAllocateInfo(
 				cmdPool,
 				VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-				1);
+				computeCmdBuffers.size());
 
-		VkResult vkRes = vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &computeCmdBuffer);
+		VkResult vkRes = vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, computeCmdBuffers.data());
 		assert(!vkRes);
 	}
 
@@ -568,7 +539,7 @@ public:
 				0),
 			// Binding 1 : Uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_COMPUTE_BIT,
 				1),
 		};
@@ -607,6 +578,8 @@ public:
 		err = vkAllocateDescriptorSets(device, &allocInfo, &computeDescriptorSet);
 		assert(!err);
 
+		VkDescriptorBufferInfo uboDescriptor = uniformRing.getDescriptor(uniformOffsetCompute, sizeof(computeUbo));
+
 		std::vector<VkWriteDescriptorSet> computeWriteDescriptorSets =
 		{
 			// Binding 0 : Particle position storage buffer
@@ -618,9 +591,9 @@ public:
 			// Binding 1 : Uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				computeDescriptorSet,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				1,
-				&uniformData.computeShader.ubo.descriptor)
+				&uboDescriptor)
 		};
 
 		vkUpdateDescriptorSets(device, computeWriteDescriptorSets.size(), computeWriteDescriptorSets.data(), 0, NULL);
@@ -643,13 +616,7 @@ public:
 	void prepareUniformBuffers()
 	{
 		// Compute shader uniform buffer block
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(computeUbo),
-			&computeUbo,
-			&uniformData.computeShader.ubo.buffer,
-			&uniformData.computeShader.ubo.memory,
-			&uniformData.computeShader.ubo.descriptor);
+		uniformOffsetCompute = uniformRing.allocate(sizeof(computeUbo));
 
 		updateUniformBuffers();
 	}
@@ -659,11 +626,7 @@ public:
 		computeUbo.deltaT = frameTimer * 5.0f;
 		computeUbo.destX = sin(deg_to_rad(timer*360.0)) * 0.75f;
 		computeUbo.destY = 0;
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.computeShader.ubo.memory, 0, sizeof(computeUbo), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &computeUbo, sizeof(computeUbo));
-		vkUnmapMemory(device, uniformData.computeShader.ubo.memory);
+		uniformRing.update(uniformOffsetCompute, &computeUbo, sizeof(computeUbo));
 	}
 
 	// Find and create a compute capable device queue
@@ -696,7 +659,7 @@ public:
 		VulkanExampleBase::prepare();
 		loadTextures();
 		getComputeQueue();
-		createComputeCommandBuffer();
+		createComputeCommandBuffers();
 		prepareStorageBuffers();
 		prepareUniformBuffers();
 		setupDescriptorSetLayout();
@@ -705,7 +668,7 @@ public:
 		setupDescriptorSet();
 		prepareCompute();
 		buildCommandBuffers(); 
-		buildComputeCommandBuffer();
+		buildComputeCommandBuffers();
 		prepared = true;
 	}
 
@@ -713,22 +676,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
-		if (animStart > 0.0f)
-		{
-			animStart -= frameTimer * 5.0f;
-		}
-		if ((animate) & (animStart <= 0.0f))
-		{
-			timer += frameTimer * 0.1f;
-			if (timer > 1.0)
-			{
-				timer -= 1.0f;
-			}
-		}
-		updateUniformBuffers();
 	}
 
 	void toggleAnimation()
@@ -776,6 +724,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
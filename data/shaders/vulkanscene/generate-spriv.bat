@@ -5,4 +5,6 @@ glslangvalidator -V mesh.vert -o mesh.vert.spv
 glslangvalidator -V mesh.frag -o mesh.frag.spv
 
 glslangvalidator -V skybox.vert -o skybox.vert.spv
-glslangvalidator -V skybox.frag -o skybox.frag.spv
\ No newline at end of file
+glslangvalidator -V skybox.frag -o skybox.frag.spv
+
+glslangvalidator -V clustercull.comp -o clustercull.comp.spv
\ No newline at end of file
@@ -73,11 +73,12 @@ public:
 		glm::vec4 viewPos;
 	} uboFragmentLights;
 
+	// Offsets of the uniform blocks inside the base class uniform ring
 	struct {
-		vkTools::UniformData vsFullScreen;
-		vkTools::UniformData vsOffscreen;
-		vkTools::UniformData fsLights;
-	} uniformData;
+		VkDeviceSize vsFullScreen;
+		VkDeviceSize vsOffscreen;
+		VkDeviceSize fsLights;
+	} uniformOffsets;
 
 	struct {
 		VkPipeline deferred;
@@ -100,7 +101,7 @@ public:
 	// Framebuffer for offscreen rendering
 	struct FrameBufferAttachment {
 		VkImage image;
-		VkDeviceMemory mem;
+		vkTools::Allocation allocation;
 		VkImageView view;
 		VkFormat format;
 	};
@@ -119,7 +120,9 @@ public:
 		vkTools::VulkanTexture albedo;
 	} textureTargets;
 
-	VkCommandBuffer offScreenCmdBuffer = VK_NULL_HANDLE;
+	// One offscreen command buffer per swap chain image, so each can read
+	// the uniform ring region of it's image (like the draw command buffers)
+	std::vector<VkCommandBuffer> offScreenCmdBuffers;
 
 	VulkanExample() : VulkanExampleBase(ENABLE_VALIDATION)
 	{
@@ -145,20 +148,20 @@ public:
 		// Color attachments
 		vkDestroyImageView(device, offScreenFrameBuf.position.view, nullptr);
 		vkDestroyImage(device, offScreenFrameBuf.position.image, nullptr);
-		vkFreeMemory(device, offScreenFrameBuf.position.mem, nullptr);
+		memoryAllocator.free(offScreenFrameBuf.position.allocation);
 
 		vkDestroyImageView(device, offScreenFrameBuf.normal.view, nullptr);
 		vkDestroyImage(device, offScreenFrameBuf.normal.image, nullptr);
-		vkFreeMemory(device, offScreenFrameBuf.normal.mem, nullptr);
+		memoryAllocator.free(offScreenFrameBuf.normal.allocation);
 
 		vkDestroyImageView(device, offScreenFrameBuf.albedo.view, nullptr);
 		vkDestroyImage(device, offScreenFrameBuf.albedo.image, nullptr);
-		vkFreeMemory(device, offScreenFrameBuf.albedo.mem, nullptr);
+		memoryAllocator.free(offScreenFrameBuf.albedo.allocation);
 
 		// Depth attachment
 		vkDestroyImageView(device, offScreenFrameBuf.depth.view, nullptr);
 		vkDestroyImage(device, offScreenFrameBuf.depth.image, nullptr);
-		vkFreeMemory(device, offScreenFrameBuf.depth.mem, nullptr);
+		memoryAllocator.free(offScreenFrameBuf.depth.allocation);
 
 		vkDestroyFramebuffer(device, offScreenFrameBuf.frameBuffer, nullptr);
 
@@ -175,12 +178,7 @@ public:
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.example);
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.quad);
 
-		// Uniform buffers
-		vkTools::destroyUniformData(device, &uniformData.vsOffscreen);
-		vkTools::destroyUniformData(device, &uniformData.vsFullScreen);
-		vkTools::destroyUniformData(device, &uniformData.fsLights);
-
-		vkFreeCommandBuffers(device, cmdPool, 1, &offScreenCmdBuffer);
+		vkFreeCommandBuffers(device, cmdPool, offScreenCmdBuffers.size(), offScreenCmdBuffers.data());
 
 		vkDestroyRenderPass(device, offScreenFrameBuf.renderPass, nullptr);
 
@@ -213,18 +211,9 @@ public:
 		imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 		imageCreateInfo.flags = 0;
 
-		VkMemoryAllocateInfo memAllocInfo = vkTools::initializers::memoryAllocateInfo();
-		VkMemoryRequirements memReqs;
-
 		err = vkCreateImage(device, &imageCreateInfo, nullptr, &target->image);
 		assert(!err);
-		vkGetImageMemoryRequirements(device, target->image, &memReqs);
-		memAllocInfo.allocationSize = memReqs.size;
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAllocInfo.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAllocInfo, nullptr, &target->deviceMemory);
-		assert(!err);
-		err = vkBindImageMemory(device, target->image, target->deviceMemory, 0);
-		assert(!err);
+		target->allocation = memoryAllocator.allocateImage(target->image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Image memory barrier
 		// Set initial layout for the offscreen texture to shader read
@@ -314,8 +303,6 @@ public:
 		image.tiling = VK_IMAGE_TILING_OPTIMAL;
 		image.usage = usage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 
-		VkMemoryAllocateInfo memAlloc = vkTools::initializers::memoryAllocateInfo();
-
 		VkImageViewCreateInfo imageView = vkTools::initializers::imageViewCreateInfo();
 		imageView.viewType = VK_IMAGE_VIEW_TYPE_2D;
 		imageView.format = format;
@@ -326,18 +313,9 @@ public:
 		imageView.subresourceRange.baseArrayLayer = 0;
 		imageView.subresourceRange.layerCount = 1;
 
-		VkMemoryRequirements memReqs;
-
 		VkResult err = vkCreateImage(device, &image, nullptr, &attachment->image);
 		assert(!err);
-		vkGetImageMemoryRequirements(device, attachment->image, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAlloc.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAlloc, nullptr, &attachment->mem);
-		assert(!err);
-
-		err = vkBindImageMemory(device, attachment->image, attachment->mem, 0);
-		assert(!err);
+		attachment->allocation = memoryAllocator.allocateImage(attachment->image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 		
 		vkTools::setImageLayout(
 			setupCmdBuffer,
@@ -474,14 +452,14 @@ public:
 	}
 
 	// Blit frame buffer attachment to texture target
-	void blit(VkImage source, VkImage dest)
+	void blit(VkCommandBuffer cmdBuffer, VkImage source, VkImage dest)
 	{
 		// Image memory barrier
 		// Transform frame buffer color attachment to transfer source layout
 		// Makes sure that writes to the color attachment are finished before
 		// using it as source for the blit
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			source,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
@@ -492,7 +470,7 @@ public:
 		// Makes sure that reads from texture are finished before
 		// using it as a transfer destination for the blit
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			dest,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
@@ -524,7 +502,7 @@ public:
 		// Blit from framebuffer image to texture image
 		// vkCmdBlitImage does scaling and (if necessary and possible) also does format conversions
 		vkCmdBlitImage(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			source,
 			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 			dest,
@@ -539,7 +517,7 @@ public:
 		// Makes sure that writes to the texture are finished before
 		// using it as the source for a sampler in the shader
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			dest,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
@@ -548,7 +526,7 @@ public:
 		// Image memory barrier
 		// Transform the framebuffer color attachment back
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			source,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
@@ -557,22 +535,10 @@ public:
 
 	// Build command buffer for rendering the scene to the offscreen frame buffer 
 	// and blitting it to the different texture targets
-	void buildDeferredCommandBuffer()
+	void buildDeferredCommandBuffer(VkCommandBuffer cmdBuffer, uint32_t dynamicOffset)
 	{
 		VkResult err;
 
-		// Create separate command buffer for offscreen 
-		// rendering
-		if (offScreenCmdBuffer == VK_NULL_HANDLE)
-		{
-			VkCommandBufferAllocateInfo cmd = vkTools::initializers::commandBufferAllocateInfo(
-				cmdPool,
-				VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-				1);
-			VkResult vkRes = vkAllocateCommandBuffers(device, &cmd, &offScreenCmdBuffer);
-			assert(!vkRes);
-		}
-
 		VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
 
 		// Clear values for all attachments written in the fragment sahder
@@ -590,43 +556,66 @@ public:
 		renderPassBeginInfo.clearValueCount = clearValues.size();
 		renderPassBeginInfo.pClearValues = clearValues.data();
 
-		err = vkBeginCommandBuffer(offScreenCmdBuffer, &cmdBufInfo);
+		err = vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo);
 		assert(!err);
 
-		vkCmdBeginRenderPass(offScreenCmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 		VkViewport viewport = vkTools::initializers::viewport(
 			(float)offScreenFrameBuf.width,
 			(float)offScreenFrameBuf.height,
 			0.0f,
 			1.0f);
-		vkCmdSetViewport(offScreenCmdBuffer, 0, 1, &viewport);
+		vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
 
 		VkRect2D scissor = vkTools::initializers::rect2D(
 			offScreenFrameBuf.width,
 			offScreenFrameBuf.height,
 			0,
 			0);
-		vkCmdSetScissor(offScreenCmdBuffer, 0, 1, &scissor);
+		vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
 
-		vkCmdBindDescriptorSets(offScreenCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.offscreen, 0, 1, &descriptorSets.offscreen, 0, NULL);
-		vkCmdBindPipeline(offScreenCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.offscreen);
+		// One dynamic offset per uniform buffer binding of the set
+		uint32_t dynamicOffsets[2] = { dynamicOffset, dynamicOffset };
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.offscreen, 0, 1, &descriptorSets.offscreen, 2, dynamicOffsets);
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.offscreen);
 
 		VkDeviceSize offsets[1] = { 0 };
-		vkCmdBindVertexBuffers(offScreenCmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &meshes.example.vertices.buf, offsets);
-		vkCmdBindIndexBuffer(offScreenCmdBuffer, meshes.example.indices.buf, 0, VK_INDEX_TYPE_UINT32);
-		vkCmdDrawIndexed(offScreenCmdBuffer, meshes.example.indexCount, 1, 0, 0, 0);
+		vkCmdBindVertexBuffers(cmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &meshes.example.vertices.buf, offsets);
+		vkCmdBindIndexBuffer(cmdBuffer, meshes.example.indices.buf, 0, meshes.example.indexType);
+		vkMeshLoader::drawMesh(cmdBuffer, meshes.example);
 
-		vkCmdEndRenderPass(offScreenCmdBuffer);
+		vkCmdEndRenderPass(cmdBuffer);
 
-		blit(offScreenFrameBuf.position.image, textureTargets.position.image);
-		blit(offScreenFrameBuf.normal.image, textureTargets.normal.image);
-		blit(offScreenFrameBuf.albedo.image, textureTargets.albedo.image);
+		blit(cmdBuffer, offScreenFrameBuf.position.image, textureTargets.position.image);
+		blit(cmdBuffer, offScreenFrameBuf.normal.image, textureTargets.normal.image);
+		blit(cmdBuffer, offScreenFrameBuf.albedo.image, textureTargets.albedo.image);
 
-		err = vkEndCommandBuffer(offScreenCmdBuffer);
+		err = vkEndCommandBuffer(cmdBuffer);
 		assert(!err);
 	}
 
+	void buildDeferredCommandBuffers()
+	{
+		// Create separate command buffers for offscreen 
+		// rendering, one per swap chain image
+		if (offScreenCmdBuffers.empty())
+		{
+			offScreenCmdBuffers.resize(drawCmdBuffers.size());
+			VkCommandBufferAllocateInfo cmd = vkTools::initializers::commandBufferAllocateInfo(
+				cmdPool,
+				VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+				offScreenCmdBuffers.size());
+			VkResult vkRes = vkAllocateCommandBuffers(device, &cmd, offScreenCmdBuffers.data());
+			assert(!vkRes);
+		}
+
+		for (uint32_t i = 0; i < offScreenCmdBuffers.size(); ++i)
+		{
+			buildDeferredCommandBuffer(offScreenCmdBuffers[i], uniformRing.getDynamicOffset(i));
+		}
+	}
+
 	void loadTextures()
 	{
 		textureLoader->loadTexture(
@@ -637,6 +626,8 @@ public:
 
 	void reBuildCommandBuffers()
 	{
+		// Frames may still be in flight
+		vkDeviceWaitIdle(device);
 		if (!checkCommandBuffers())
 		{
 			destroyCommandBuffers();
@@ -689,7 +680,11 @@ public:
 			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
 
 			VkDeviceSize offsets[1] = { 0 };
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.deferred, 0, 1, &descriptorSet, 0, NULL);
+
+			// Each command buffer reads the uniform ring region of it's swap chain image
+			// One dynamic offset per uniform buffer binding of the set
+			uint32_t dynamicOffsets[2] = { uniformRing.getDynamicOffset(i), uniformRing.getDynamicOffset(i) };
+			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.deferred, 0, 1, &descriptorSet, 2, dynamicOffsets);
 
 			if (debugDisplay)
 			{
@@ -711,16 +706,6 @@ public:
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE, 
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
-
 			err = vkEndCommandBuffer(drawCmdBuffers[i]);
 			assert(!err);
 		}
@@ -728,43 +713,15 @@ public:
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo =
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
-
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
-
-		// Gather command buffers to be sumitted to the queue
-		std::vector<VkCommandBuffer> submitCmdBuffers = {
-			offScreenCmdBuffer,
-			drawCmdBuffers[currentBuffer],
-		};
-
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = submitCmdBuffers.size();
-		submitInfo.pCommandBuffers = submitCmdBuffers.data();
-
-		// Submit draw command buffer
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
-
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
-
-		err = vkQueueWaitIdle(queue);
-		assert(err == VK_SUCCESS);
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
+
+		// Submit offscreen rendering before the scene composition and present
+		// Each command buffer is measured by the GPU profiler (if enabled)
+		std::vector<VkCommandBuffer> submitCmdBuffers;
+		profiler.addCommandBuffer(submitCmdBuffers, offScreenCmdBuffers[currentBuffer], "G-Buffer");
+		profiler.addCommandBuffer(submitCmdBuffers, drawCmdBuffers[currentBuffer], "Composition");
+		submitFrame(submitCmdBuffers);
 	}
 
 	void loadMeshes()
@@ -807,7 +764,7 @@ public:
 			vertexBuffer.size() * sizeof(Vertex),
 			vertexBuffer.data(),
 			&meshes.quad.vertices.buf,
-			&meshes.quad.vertices.mem);
+			&meshes.quad.vertices.allocation);
 
 		// Setup indices
 		std::vector<uint32_t> indexBuffer = { 0,1,2, 2,3,0 };
@@ -826,7 +783,7 @@ public:
 			indexBuffer.size() * sizeof(uint32_t),
 			indexBuffer.data(),
 			&meshes.quad.indices.buf,
-			&meshes.quad.indices.mem);
+			&meshes.quad.indices.allocation);
 	}
 
 	void setupVertexDescriptions()
@@ -881,7 +838,7 @@ public:
 	{
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 8),
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 8),
 			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 8)
 		};
 
@@ -902,7 +859,7 @@ public:
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_VERTEX_BIT,
 				0),
 			// Binding 1 : Position texture target / Scene colormap
@@ -922,7 +879,7 @@ public:
 				3),
 			// Binding 4 : Fragment shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_FRAGMENT_BIT,
 				4),
 		};
@@ -979,14 +936,19 @@ public:
 				textureTargets.albedo.view,
 				VK_IMAGE_LAYOUT_GENERAL);
 
+		// Uniform blocks inside the uniform ring
+		VkDescriptorBufferInfo vsFullScreenDescriptor = uniformRing.getDescriptor(uniformOffsets.vsFullScreen, sizeof(uboVS));
+		VkDescriptorBufferInfo fsLightsDescriptor = uniformRing.getDescriptor(uniformOffsets.fsLights, sizeof(uboFragmentLights));
+		VkDescriptorBufferInfo vsOffscreenDescriptor = uniformRing.getDescriptor(uniformOffsets.vsOffscreen, sizeof(uboOffscreenVS));
+
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets =
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 			descriptorSet,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.vsFullScreen.descriptor),
+				&vsFullScreenDescriptor),
 			// Binding 1 : Position texture target
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
@@ -1008,9 +970,9 @@ public:
 			// Binding 4 : Fragment shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				4,
-				&uniformData.fsLights.descriptor),
+				&fsLightsDescriptor),
 		};
 
 		vkUpdateDescriptorSets(device, writeDescriptorSets.size(), writeDescriptorSets.data(), 0, NULL);
@@ -1030,9 +992,9 @@ public:
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.offscreen,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.vsOffscreen.descriptor),
+				&vsOffscreenDescriptor),
 			// Binding 1 : Scene color map
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.offscreen,
@@ -1170,31 +1132,13 @@ public:
 	void prepareUniformBuffers()
 	{
 		// Fullscreen vertex shader
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboVS),
-			&uboVS,
-			&uniformData.vsFullScreen.buffer,
-			&uniformData.vsFullScreen.memory,
-			&uniformData.vsFullScreen.descriptor);
+		uniformOffsets.vsFullScreen = uniformRing.allocate(sizeof(uboVS));
 
 		// Deferred vertex shader
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboOffscreenVS),
-			&uboOffscreenVS,
-			&uniformData.vsOffscreen.buffer,
-			&uniformData.vsOffscreen.memory,
-			&uniformData.vsOffscreen.descriptor);
+		uniformOffsets.vsOffscreen = uniformRing.allocate(sizeof(uboOffscreenVS));
 
 		// Deferred fragment shader
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboFragmentLights),
-			&uboFragmentLights,
-			&uniformData.fsLights.buffer,
-			&uniformData.fsLights.memory,
-			&uniformData.fsLights.descriptor);
+		uniformOffsets.fsLights = uniformRing.allocate(sizeof(uboFragmentLights));
 
 		// Update
 		updateUniformBuffersScreen();
@@ -1214,11 +1158,7 @@ public:
 		}
 		uboVS.model = glm::mat4();
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.vsFullScreen.memory, 0, sizeof(uboVS), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboVS, sizeof(uboVS));
-		vkUnmapMemory(device, uniformData.vsFullScreen.memory);
+		uniformRing.update(uniformOffsets.vsFullScreen, &uboVS, sizeof(uboVS));
 	}
 
 	void updateUniformBufferDeferredMatrices()
@@ -1232,11 +1172,7 @@ public:
 		uboOffscreenVS.model = glm::mat4();
 		uboOffscreenVS.model = glm::translate(glm::mat4(), glm::vec3(0.0f, 0.25f, 0.0f));
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.vsOffscreen.memory, 0, sizeof(uboOffscreenVS), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboOffscreenVS, sizeof(uboOffscreenVS));
-		vkUnmapMemory(device, uniformData.vsOffscreen.memory);
+		uniformRing.update(uniformOffsets.vsOffscreen, &uboOffscreenVS, sizeof(uboOffscreenVS));
 	}
 
 	// Update fragment shader light position uniform block
@@ -1276,11 +1212,7 @@ public:
 		// Current view position
 		uboFragmentLights.viewPos = glm::vec4(0.0f, 0.0f, -zoom, 0.0f);
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.fsLights.memory, 0, sizeof(uboFragmentLights), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboFragmentLights, sizeof(uboFragmentLights));
-		vkUnmapMemory(device, uniformData.fsLights.memory);
+		uniformRing.update(uniformOffsets.fsLights, &uboFragmentLights, sizeof(uboFragmentLights));
 	}
 
 
@@ -1299,7 +1231,7 @@ public:
 		setupDescriptorPool();
 		setupDescriptorSet();
 		buildCommandBuffers();
-		buildDeferredCommandBuffer(); 
+		buildDeferredCommandBuffers();
 		prepared = true;
 	}
 
@@ -1307,9 +1239,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
 	}
 
 	virtual void viewChanged()
@@ -1365,6 +1295,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
@@ -18,14 +18,18 @@
 //#define USE_GLSL
 #define ENABLE_VALIDATION false
 #define INSTANCING_RANGE 3
+// Number of generated levels of detail below the full detail mesh
+#define LOD_COUNT 4
 
 // Vertex layout for this example
+// Packed to 20 bytes per vertex (44 with floats) to reduce vertex fetch bandwidth
+// Positions are quantized to the mesh bounds, the dequantization is part of the instance matrices
 std::vector<vkMeshLoader::VertexLayout> vertexLayout =
 {
-	vkMeshLoader::VERTEX_LAYOUT_POSITION,
-	vkMeshLoader::VERTEX_LAYOUT_NORMAL,
-	vkMeshLoader::VERTEX_LAYOUT_UV,
-	vkMeshLoader::VERTEX_LAYOUT_COLOR
+	vkMeshLoader::VERTEX_LAYOUT_POSITION_QUANTIZED,
+	vkMeshLoader::VERTEX_LAYOUT_NORMAL_PACKED,
+	vkMeshLoader::VERTEX_LAYOUT_UV_HALF,
+	vkMeshLoader::VERTEX_LAYOUT_COLOR_UNORM8
 };
 
 class VulkanExample : public VulkanExampleBase
@@ -63,9 +67,30 @@ public:
 		UboInstanceData *instance;		
 	} uboVS;
 
+	// Distance based level of detail selection
+	// Instances are sorted by their level and each level is drawn with a single instanced draw
 	struct {
-		vkTools::UniformData vsScene;
-	} uniformData;
+		// Level of each instance
+		std::vector<uint32_t> levels;
+		// Instances sorted by level as stored in the uniform buffer
+		std::vector<UboInstanceData> instances;
+		// First instance and number of instances of each level
+		std::vector<uint32_t> firstInstance;
+		std::vector<uint32_t> instanceCount;
+		// Incremented on selection changes, command buffers recorded with an older version are rebuilt
+		uint32_t version = 0;
+		std::vector<uint32_t> commandBufferVersions;
+		// Triangles submitted with and without levels of detail over all frames
+		uint64_t triangles = 0;
+		uint64_t trianglesFullDetail = 0;
+		uint64_t frames = 0;
+	} lod;
+
+	// Offsets of the uniform blocks inside the base class uniform ring
+	struct {
+		VkDeviceSize vsScene;
+	} uniformOffsets;
+	uint32_t uboSize;
 
 	struct {
 		VkPipeline solid;
@@ -96,13 +121,24 @@ public:
 		// Meshes
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.example);
 
-		// Uniform buffers
-		vkTools::destroyUniformData(device, &uniformData.vsScene);
-
 		delete[] uboVS.instance;
+
+		if (lod.frames > 0)
+		{
+			std::cout << "Average triangles per frame : " << lod.triangles / lod.frames << " with levels of detail, "
+				<< lod.trianglesFullDetail / lod.frames << " without\n";
+		}
 	}
 
 	void buildCommandBuffers()
+	{
+		for (uint32_t i = 0; i < drawCmdBuffers.size(); ++i)
+		{
+			buildCommandBuffer(i);
+		}
+	}
+
+	void buildCommandBuffer(uint32_t i)
 	{
 		VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
 
@@ -121,95 +157,85 @@ public:
 
 		VkResult err;
 
-		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i)
-		{
-			// Set target frame buffer
-			renderPassBeginInfo.framebuffer = frameBuffers[i];
+		// Set target frame buffer
+		renderPassBeginInfo.framebuffer = frameBuffers[i];
 
-			err = vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo);
-			assert(!err);
-
-			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-			VkViewport viewport = vkTools::initializers::viewport(
-				(float)width,
-				(float)height,
-				0.0f,
-				1.0f);
-			vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
-
-			VkRect2D scissor = vkTools::initializers::rect2D(
-				width,
-				height,
-				0,
-				0);
-			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
-
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
-			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.solid);
-
-			VkDeviceSize offsets[1] = { 0 };
-			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.example.vertices.buf, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.example.indices.buf, 0, VK_INDEX_TYPE_UINT32);
+		err = vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo);
+		assert(!err);
 
-			// Render instances
-			vkCmdDrawIndexed(drawCmdBuffers[i], meshes.example.indexCount, instanceCount, 0, 0, 0);
+		vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+		VkViewport viewport = vkTools::initializers::viewport(
+			(float)width,
+			(float)height,
+			0.0f,
+			1.0f);
+		vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
+
+		VkRect2D scissor = vkTools::initializers::rect2D(
+			width,
+			height,
+			0,
+			0);
+		vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
+
+		// Each command buffer reads the uniform ring region of it's swap chain image
+		uint32_t dynamicOffset = uniformRing.getDynamicOffset(i);
+		vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 1, &dynamicOffset);
+		vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.solid);
+
+		VkDeviceSize offsets[1] = { 0 };
+		vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.example.vertices.buf, offsets);
+		vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.example.indices.buf, 0, meshes.example.indexType);
+
+		// Render instances, one draw per level of detail
+		// The instance index passed to the shader starts at firstInstance
+		for (uint32_t level = 0; level < meshes.example.lods.size(); level++)
+		{
+			if (lod.instanceCount[level] > 0)
+			{
+				vkMeshLoader::drawMesh(drawCmdBuffers[i], meshes.example, lod.instanceCount[level], lod.firstInstance[level], level);
+			}
+		}
 
-			vkCmdEndRenderPass(drawCmdBuffers[i]);
+		vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE, 
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
+		err = vkEndCommandBuffer(drawCmdBuffers[i]);
+		assert(!err);
 
-			err = vkEndCommandBuffer(drawCmdBuffers[i]);
-			assert(!err);
-		}
+		lod.commandBufferVersions[i] = lod.version;
 	}
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo =
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
-
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
-
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
 
-		// Submit draw command buffer
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
+		// The image's command buffer is no longer in use, update it if the level selection changed
+		if (lod.commandBufferVersions[currentBuffer] != lod.version)
+		{
+			buildCommandBuffer(currentBuffer);
+		}
 
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
+		for (uint32_t level = 0; level < meshes.example.lods.size(); level++)
+		{
+			lod.triangles += (uint64_t)lod.instanceCount[level] * meshes.example.lods[level].indexCount / 3;
+		}
+		lod.trianglesFullDetail += (uint64_t)instanceCount * meshes.example.indexCount / 3;
+		lod.frames++;
 
-		err = vkQueueWaitIdle(queue);
-		assert(!err);
+		// Submit the image's draw command buffer and present it
+		submitFrame();
 	}
 
 	void loadMeshes()
 	{
-		loadMesh("./../data/models/angryteapot.X", &meshes.example, vertexLayout, 0.05f);
+		// Packed normals are optional as vertex input
+		if (!vkMeshLoader::isLayoutSupported(physicalDevice, vertexLayout))
+		{
+			vertexLayout[1] = vkMeshLoader::VERTEX_LAYOUT_NORMAL;
+		}
+		loadMesh("./../data/models/angryteapot.X", &meshes.example, vertexLayout, 0.05f, LOD_COUNT);
 	}
 
 	void setupVertexDescriptions()
@@ -223,36 +249,8 @@ public:
 				VK_VERTEX_INPUT_RATE_VERTEX);
 
 		// Attribute descriptions
-		// Describes memory layout and shader positions
-		vertices.attributeDescriptions.resize(4);
-		// Location 0 : Position
-		vertices.attributeDescriptions[0] =
-			vkTools::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				0,
-				VK_FORMAT_R32G32B32_SFLOAT,
-				0);
-		// Location 1 : Normal
-		vertices.attributeDescriptions[1] =
-			vkTools::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				1,
-				VK_FORMAT_R32G32B32_SFLOAT,
-				sizeof(float) * 3);
-		// Location 2 : Texture coordinates
-		vertices.attributeDescriptions[2] =
-			vkTools::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				2,
-				VK_FORMAT_R32G32_SFLOAT,
-				sizeof(float) * 6);
-		// Location 3 : Color
-		vertices.attributeDescriptions[3] =
-			vkTools::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				3,
-				VK_FORMAT_R32G32B32_SFLOAT,
-				sizeof(float) * 8);
+		// Location 0 : Position, 1 : Normal, 2 : Texture coordinates, 3 : Color
+		vertices.attributeDescriptions = vkMeshLoader::getAttributeDescriptions(vertexLayout, VERTEX_BUFFER_BIND_ID);
 
 		vertices.inputState = vkTools::initializers::pipelineVertexInputStateCreateInfo();
 		vertices.inputState.vertexBindingDescriptionCount = vertices.bindingDescriptions.size();
@@ -266,7 +264,7 @@ public:
 		// Example uses one ubo 
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1),
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1),
 		};
 
 		VkDescriptorPoolCreateInfo descriptorPoolInfo =
@@ -285,7 +283,7 @@ public:
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_VERTEX_BIT,
 				0),
 		};
@@ -318,13 +316,15 @@ public:
 		VkResult vkRes = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet);
 		assert(!vkRes);
 
+		VkDescriptorBufferInfo uboDescriptor = uniformRing.getDescriptor(uniformOffsets.vsScene, uboSize);
+
 		// Binding 0 : Vertex shader uniform buffer
 		VkWriteDescriptorSet writeDescriptorSet =
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.vsScene.descriptor);
+				&uboDescriptor);
 
 		vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, NULL);
 	}
@@ -416,22 +416,9 @@ public:
 		instanceCount = pow((INSTANCING_RANGE * 2) + 1, 3);
 		uboVS.instance = new UboInstanceData[instanceCount];
 
-		VkResult err;
-
 		// Vertex shader uniform buffer block
-		uint32_t uboSize = sizeof(uboVS.matrices) + (instanceCount * sizeof(UboInstanceData));
-
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			uboSize,
-			nullptr,
-			&uniformData.vsScene.buffer,
-			&uniformData.vsScene.memory,
-			&uniformData.vsScene.descriptor);
-
-		VkBufferCreateInfo bufferInfo = vkTools::initializers::bufferCreateInfo(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			uboSize);
+		uboSize = sizeof(uboVS.matrices) + (instanceCount * sizeof(UboInstanceData));
+		uniformOffsets.vsScene = uniformRing.allocate(uboSize);
 
 		// Colors and model matrices are fixed
 		float offset = 5.0f;
@@ -445,6 +432,7 @@ public:
 					// Instance model matrix
 					uboVS.instance[index].model = glm::translate(glm::mat4(), glm::vec3(x * offset, y * offset, z * offset));
 					uboVS.instance[index].model = glm::rotate(uboVS.instance[index].model, deg_to_rad(-45.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+					uboVS.instance[index].model = uboVS.instance[index].model * meshes.example.dequantization;
 					// Instance color (randomized)
 					uboVS.instance[index].color = glm::vec4((float)(rand() % 255) / 255.0f, (float)(rand() % 255) / 255.0f, (float)(rand() % 255) / 255.0f, 1.0);
 					index++;
@@ -452,16 +440,59 @@ public:
 			}
 		}
 		
+		lod.levels.assign(instanceCount, UINT32_MAX);
+		lod.instances.resize(instanceCount);
+		lod.firstInstance.resize(meshes.example.lods.size());
+		lod.instanceCount.resize(meshes.example.lods.size());
+		lod.commandBufferVersions.assign(drawCmdBuffers.size(), UINT32_MAX);
+
+		updateUniformBufferMatrices();
+	}
+
+	// Select the level of detail of each instance from it's distance to the camera
+	// and update the instanced part of the uniform buffer if the selection changed
+	void updateLodSelection()
+	{
+		const glm::vec3 cameraPos = glm::vec3(glm::inverse(uboVS.matrices.view)[3]);
+		const float projectionScale = vkMeshLoader::getLodProjectionScale(60.0f, (float)height);
+
+		bool changed = false;
+		for (uint32_t i = 0; i < instanceCount; i++)
+		{
+			// Quantized positions are in [0..1], so this is the center of the mesh bounds
+			glm::vec3 center = glm::vec3(uboVS.instance[i].model * glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
+			uint32_t level = vkMeshLoader::selectLod(meshes.example, glm::distance(cameraPos, center), projectionScale);
+			changed |= (level != lod.levels[i]);
+			lod.levels[i] = level;
+		}
+		if (!changed)
+		{
+			return;
+		}
+
+		// Sort instances by level (counting sort)
+		std::fill(lod.instanceCount.begin(), lod.instanceCount.end(), 0);
+		for (auto level : lod.levels)
+		{
+			lod.instanceCount[level]++;
+		}
+		uint32_t firstInstance = 0;
+		for (uint32_t level = 0; level < lod.instanceCount.size(); level++)
+		{
+			lod.firstInstance[level] = firstInstance;
+			firstInstance += lod.instanceCount[level];
+		}
+		std::vector<uint32_t> next = lod.firstInstance;
+		for (uint32_t i = 0; i < instanceCount; i++)
+		{
+			lod.instances[next[lod.levels[i]]++] = uboVS.instance[i];
+		}
+
 		// Update instanced part of the uniform buffer
-		uint8_t *pData;
 		uint32_t dataOffset = sizeof(uboVS.matrices);
 		uint32_t dataSize = instanceCount * sizeof(UboInstanceData);
-		err = vkMapMemory(device, uniformData.vsScene.memory, dataOffset, dataSize, 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, uboVS.instance, dataSize);
-		vkUnmapMemory(device, uniformData.vsScene.memory);
-
-		updateUniformBufferMatrices();
+		uniformRing.update(uniformOffsets.vsScene + dataOffset, lod.instances.data(), dataSize);
+		lod.version++;
 	}
 
 	void updateUniformBufferMatrices()
@@ -478,11 +509,9 @@ public:
 		uboVS.matrices.view = glm::rotate(uboVS.matrices.view, deg_to_rad(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
 		// Only update the matrices part of the uniform buffer
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.vsScene.memory, 0, sizeof(uboVS.matrices), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboVS.matrices, sizeof(uboVS.matrices));
-		vkUnmapMemory(device, uniformData.vsScene.memory);
+		uniformRing.update(uniformOffsets.vsScene, &uboVS.matrices, sizeof(uboVS.matrices));
+
+		updateLodSelection();
 	}
 
 	void prepare()
@@ -503,9 +532,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
 	}
 
 	virtual void viewChanged()
@@ -544,6 +571,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
@@ -19,6 +19,8 @@
 #define VERTEX_BUFFER_BIND_ID 0
 //#define USE_GLSL
 #define ENABLE_VALIDATION false
+// Number of generated levels of detail below the full detail mesh
+#define LOD_COUNT 4
 
 // Vertex layout used in this example
 // Vertex layout for this example
@@ -42,9 +44,8 @@ public:
 		vkMeshLoader::MeshBuffer ufo;
 	} meshes;
 
-	struct {
-		vkTools::UniformData vsScene;
-	} uniformData;
+	// Offset of the vertex shader uniform block inside the base class uniform ring
+	VkDeviceSize uniformOffsetVS;
 
 	struct {
 		glm::mat4 projection;
@@ -76,9 +77,22 @@ public:
 		VkCommandPool cmdPool;
 		std::vector<VkCommandBuffer> cmdBuffers;
 		ThreadPushConstantBlock pushConstantBlock;
+		// Level of detail of the thread's mesh
+		uint32_t lod = 0;
 	};
 	std::vector<RenderThread> renderThreads;
 
+	// Distance based level of detail selection
+	struct {
+		// Incremented on selection changes, command buffers recorded with an older version are rebuilt
+		uint32_t version = 0;
+		std::vector<uint32_t> commandBufferVersions;
+		// Triangles submitted with and without levels of detail over all frames
+		uint64_t triangles = 0;
+		uint64_t trianglesFullDetail = 0;
+		uint64_t frames = 0;
+	} lod;
+
 	VulkanExample() : VulkanExampleBase(ENABLE_VALIDATION)
 	{
 		width = 1280;
@@ -106,8 +120,6 @@ public:
 		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 
-		vkTools::destroyUniformData(device, &uniformData.vsScene);
-
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.ufo);
 
 		for (auto& thread : renderThreads)
@@ -115,6 +127,12 @@ public:
 			vkFreeCommandBuffers(device, thread.cmdPool, thread.cmdBuffers.size(), thread.cmdBuffers.data());
 			vkDestroyCommandPool(device, thread.cmdPool, nullptr);
 		}
+
+		if (lod.frames > 0)
+		{
+			std::cout << "Average triangles per frame : " << lod.triangles / lod.frames << " with levels of detail, "
+				<< lod.trianglesFullDetail / lod.frames << " without\n";
+		}
 	}
 
 	// Update command buffer and push constants
@@ -166,51 +184,15 @@ public:
 			modelMat = glm::rotate(modelMat, glm::radians(rot), glm::vec3(0.0f, 1.0f, 0.0f));
 			modelMat = glm::rotate(modelMat, glm::radians(deltaT * 360.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 			thread.pushConstantBlock.model = modelMat;
+			thread.lod = selectLod(thread);
 
 			thread.thread = std::thread([=] { threadUpdate(index); });
 			index++;
 
-			// Viewport and scissor rect are shared
-			VkViewport viewport = vkTools::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
-			VkRect2D scissor = vkTools::initializers::rect2D(width, height, 0, 0);
-
 			// Fill command buffers
 			for (uint32_t i = 0; i < thread.cmdBuffers.size(); ++i)
 			{
-				// Inheritance infor for secondary command buffers
-				VkCommandBufferInheritanceInfo inheritanceInfo = vkTools::initializers::commandBufferInheritanceInfo();
-				inheritanceInfo.renderPass = renderPass;
-				inheritanceInfo.framebuffer = frameBuffers[i];
-
-				VkCommandBufferBeginInfo beginInfo = vkTools::initializers::commandBufferBeginInfo();
-				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
-				beginInfo.pInheritanceInfo = &inheritanceInfo;
-
-				vkBeginCommandBuffer(thread.cmdBuffers[i], &beginInfo);
-
-				vkCmdSetViewport(thread.cmdBuffers[i], 0, 1, &viewport);
-				vkCmdSetScissor(thread.cmdBuffers[i], 0, 1, &scissor);
-
-				vkCmdBindPipeline(thread.cmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.phong);
-
-				// Update shader push constant block
-				// Contains model view matrix
-				vkCmdPushConstants(
-					thread.cmdBuffers[i],
-					pipelineLayout,
-					VK_SHADER_STAGE_VERTEX_BIT,
-					0,
-					sizeof(ThreadPushConstantBlock),
-					&thread.pushConstantBlock);
-
-				// Render mesh
-				VkDeviceSize offsets[1] = { 0 };
-				vkCmdBindDescriptorSets(thread.cmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
-				vkCmdBindVertexBuffers(thread.cmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.ufo.vertices.buf, offsets);
-				vkCmdBindIndexBuffer(thread.cmdBuffers[i], meshes.ufo.indices.buf, 0, VK_INDEX_TYPE_UINT32);
-				vkCmdDrawIndexed(thread.cmdBuffers[i], meshes.ufo.indexCount, 1, 0, 0, 0);
-
-				vkEndCommandBuffer(thread.cmdBuffers[i]);
+				buildThreadCommandBuffer(thread, i);
 			}
 		}
 
@@ -219,9 +201,84 @@ public:
 			thread.thread.join();
 		}
 
+		lod.commandBufferVersions.assign(drawCmdBuffers.size(), lod.version);
+	}
+
+	// Record the secondary command buffer of a thread for the given swap chain image
+	void buildThreadCommandBuffer(RenderThread &thread, uint32_t i)
+	{
+		// Viewport and scissor rect are shared
+		VkViewport viewport = vkTools::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
+		VkRect2D scissor = vkTools::initializers::rect2D(width, height, 0, 0);
+
+		// Inheritance infor for secondary command buffers
+		VkCommandBufferInheritanceInfo inheritanceInfo = vkTools::initializers::commandBufferInheritanceInfo();
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.framebuffer = frameBuffers[i];
+
+		VkCommandBufferBeginInfo beginInfo = vkTools::initializers::commandBufferBeginInfo();
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		vkBeginCommandBuffer(thread.cmdBuffers[i], &beginInfo);
+
+		vkCmdSetViewport(thread.cmdBuffers[i], 0, 1, &viewport);
+		vkCmdSetScissor(thread.cmdBuffers[i], 0, 1, &scissor);
+
+		vkCmdBindPipeline(thread.cmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.phong);
+
+		// Update shader push constant block
+		// Contains model view matrix
+		vkCmdPushConstants(
+			thread.cmdBuffers[i],
+			pipelineLayout,
+			VK_SHADER_STAGE_VERTEX_BIT,
+			0,
+			sizeof(ThreadPushConstantBlock),
+			&thread.pushConstantBlock);
+
+		// Render mesh at the thread's level of detail
+		VkDeviceSize offsets[1] = { 0 };
+		// Secondary command buffer i belongs to swap chain image i and reads that image's uniform ring region
+		uint32_t dynamicOffset = uniformRing.getDynamicOffset(i);
+		vkCmdBindDescriptorSets(thread.cmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 1, &dynamicOffset);
+		vkCmdBindVertexBuffers(thread.cmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.ufo.vertices.buf, offsets);
+		vkCmdBindIndexBuffer(thread.cmdBuffers[i], meshes.ufo.indices.buf, 0, meshes.ufo.indexType);
+		vkMeshLoader::drawMesh(thread.cmdBuffers[i], meshes.ufo, 1, 0, thread.lod);
+
+		vkEndCommandBuffer(thread.cmdBuffers[i]);
+	}
+
+	// Level of detail for the thread's mesh from it's distance to the camera
+	uint32_t selectLod(const RenderThread &thread)
+	{
+		const glm::vec3 cameraPos = glm::vec3(glm::inverse(uboVS.view)[3]);
+		const glm::vec3 meshPos = glm::vec3(thread.pushConstantBlock.model[3]);
+		return vkMeshLoader::selectLod(meshes.ufo, glm::distance(cameraPos, meshPos), vkMeshLoader::getLodProjectionScale(60.0f, (float)height));
+	}
+
+	void updateLodSelection()
+	{
+		for (auto& thread : renderThreads)
+		{
+			uint32_t level = selectLod(thread);
+			if (level != thread.lod)
+			{
+				thread.lod = level;
+				lod.version++;
+			}
+		}
 	}
 
 	void buildCommandBuffers()
+	{
+		for (uint32_t i = 0; i < drawCmdBuffers.size(); ++i)
+		{
+			buildCommandBuffer(i);
+		}
+	}
+
+	void buildCommandBuffer(uint32_t i)
 	{
 		VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
 
@@ -240,81 +297,61 @@ public:
 
 		VkResult err;
 
-		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i)
-		{
-			// Set target frame buffer
-			renderPassBeginInfo.framebuffer = frameBuffers[i];
+		// Set target frame buffer
+		renderPassBeginInfo.framebuffer = frameBuffers[i];
 
-			err = vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo);
-			assert(!err);
-
-			// The primary command buffer does not contain any rendering commands
-			// These are stored (and retrieved) from the secondary command buffers
+		err = vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo);
+		assert(!err);
 
-			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		// The primary command buffer does not contain any rendering commands
+		// These are stored (and retrieved) from the secondary command buffers
 
-			// Execute secondary command buffers
-			for (auto& renderThread : renderThreads)
-			{
-				// todo : Make sure threads are finished before accessing their command buffers
-				vkCmdExecuteCommands(drawCmdBuffers[i], 1, &renderThread.cmdBuffers[i]);
-			}
+		vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-			vkCmdEndRenderPass(drawCmdBuffers[i]);
+		// Execute secondary command buffers
+		for (auto& renderThread : renderThreads)
+		{
+			// todo : Make sure threads are finished before accessing their command buffers
+			vkCmdExecuteCommands(drawCmdBuffers[i], 1, &renderThread.cmdBuffers[i]);
+		}
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE,
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
+		vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			err = vkEndCommandBuffer(drawCmdBuffers[i]);
-			assert(!err);
-		}
+		err = vkEndCommandBuffer(drawCmdBuffers[i]);
+		assert(!err);
 	}
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo =
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
 
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
-
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
-
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
-
-		// Submit draw command buffer
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
+		// The image's command buffers are no longer in use, update them if the level selection changed
+		// Re-recording a secondary command buffer invalidates the primary command buffer executing it
+		if (lod.commandBufferVersions[currentBuffer] != lod.version)
+		{
+			for (auto& thread : renderThreads)
+			{
+				buildThreadCommandBuffer(thread, currentBuffer);
+			}
+			buildCommandBuffer(currentBuffer);
+			lod.commandBufferVersions[currentBuffer] = lod.version;
+		}
 
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
+		for (auto& thread : renderThreads)
+		{
+			lod.triangles += meshes.ufo.lods[thread.lod].indexCount / 3;
+		}
+		lod.trianglesFullDetail += (uint64_t)renderThreads.size() * meshes.ufo.indexCount / 3;
+		lod.frames++;
 
-		err = vkQueueWaitIdle(queue);
-		assert(!err);
+		// Submit the image's draw command buffer and present it
+		submitFrame();
 	}
 
 	void loadMeshes()
 	{
-		loadMesh("./../data/models/retroufo_red.X", &meshes.ufo, vertexLayout, 0.25f);
+		loadMesh("./../data/models/retroufo_red.X", &meshes.ufo, vertexLayout, 0.25f, LOD_COUNT);
 	}
 
 	void setupVertexDescriptions()
@@ -363,7 +400,7 @@ public:
 	{
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3)
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 3)
 		};
 
 		VkDescriptorPoolCreateInfo descriptorPoolInfo =
@@ -382,7 +419,7 @@ public:
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_VERTEX_BIT,
 				0)
 		};
@@ -426,14 +463,16 @@ public:
 		VkResult vkRes = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet);
 		assert(!vkRes);
 
+		VkDescriptorBufferInfo uboDescriptor = uniformRing.getDescriptor(uniformOffsetVS, sizeof(uboVS));
+
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets =
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.vsScene.descriptor)
+				&uboDescriptor)
 		};
 
 		vkUpdateDescriptorSets(device, writeDescriptorSets.size(), writeDescriptorSets.data(), 0, NULL);
@@ -525,13 +564,7 @@ public:
 	void prepareUniformBuffers()
 	{
 		// Vertex shader uniform buffer block
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboVS),
-			&uboVS,
-			&uniformData.vsScene.buffer,
-			&uniformData.vsScene.memory,
-			&uniformData.vsScene.descriptor);
+		uniformOffsetVS = uniformRing.allocate(sizeof(uboVS));
 
 		updateUniformBuffers();
 	}
@@ -545,11 +578,9 @@ public:
 		uboVS.view = glm::rotate(uboVS.view, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
 		uboVS.view = glm::rotate(uboVS.view, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.vsScene.memory, 0, sizeof(uboVS), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboVS, sizeof(uboVS));
-		vkUnmapMemory(device, uniformData.vsScene.memory);
+		uniformRing.update(uniformOffsetVS, &uboVS, sizeof(uboVS));
+
+		updateLodSelection();
 	}
 
 	void prepare()
@@ -571,9 +602,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
 	}
 
 	virtual void viewChanged()
@@ -612,6 +641,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
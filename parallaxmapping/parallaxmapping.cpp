@@ -49,10 +49,11 @@ public:
 		vkMeshLoader::MeshBuffer quad;
 	} meshes;
 
+	// Offsets of the uniform blocks inside the base class uniform ring
 	struct {
-		vkTools::UniformData vertexShader;
-		vkTools::UniformData fragmentShader;
-	} uniformData;
+		VkDeviceSize vertexShader;
+		VkDeviceSize fragmentShader;
+	} uniformOffsets;
 
 	struct {
 
@@ -107,20 +108,19 @@ public:
 
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.quad);
 
-		vkTools::destroyUniformData(device, &uniformData.vertexShader);
-		vkTools::destroyUniformData(device, &uniformData.fragmentShader);
-
 		textureLoader->destroyTexture(textures.colorMap);
 		textureLoader->destroyTexture(textures.normalHeightMap);
 	}
 
 	void loadTextures()
 	{
-		textureLoader->loadTexture(
+		// Uploads run on the transfer queue while the rest of the example is set up
+		// The first frame waits for them on the GPU, there is no CPU side wait
+		textureLoader->loadTextureAsync(
 			"./../data/textures/rocks_color_bc3.dds",
 			VK_FORMAT_BC3_UNORM_BLOCK, 
 			&textures.colorMap);
-		textureLoader->loadTexture(
+		textureLoader->loadTextureAsync(
 			"./../data/textures/rocks_normal_height_rgba.dds", 
 			VK_FORMAT_R8G8B8A8_UNORM, 
 			&textures.normalHeightMap);
@@ -128,6 +128,8 @@ public:
 
 	void reBuildCommandBuffers()
 	{
+		// Frames may still be in flight
+		vkDeviceWaitIdle(device);
 		if (!checkCommandBuffers())
 		{
 			destroyCommandBuffers();
@@ -179,16 +181,19 @@ public:
 				0);
 			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
 
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
+			// Each command buffer reads the uniform ring region of it's swap chain image
+			// One dynamic offset per uniform buffer binding of the set
+			uint32_t dynamicOffsets[2] = { uniformRing.getDynamicOffset(i), uniformRing.getDynamicOffset(i) };
+			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 2, dynamicOffsets);
 
 			VkDeviceSize offsets[1] = { 0 };
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.quad.vertices.buf, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.quad.indices.buf, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.quad.indices.buf, 0, meshes.quad.indexType);
 
 			// Parallax enabled
 			vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.parallaxMapping);
-			vkCmdDrawIndexed(drawCmdBuffers[i], meshes.quad.indexCount, 1, 0, 0, 1);
+			vkMeshLoader::drawMesh(drawCmdBuffers[i], meshes.quad, 1, 1);
 
 			// Normal mapping
 			if (splitScreen)
@@ -196,21 +201,11 @@ public:
 				viewport.x = (float)width / 2.0f;
 				vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
 				vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.normalMapping);
-				vkCmdDrawIndexed(drawCmdBuffers[i], meshes.quad.indexCount, 1, 0, 0, 1);
+				vkMeshLoader::drawMesh(drawCmdBuffers[i], meshes.quad, 1, 1);
 			}
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE,
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
-
 			err = vkEndCommandBuffer(drawCmdBuffers[i]);
 			assert(!err);
 		}
@@ -218,37 +213,18 @@ public:
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo =
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
-
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
 
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
-
-		// Submit draw command buffer
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
-
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
+		// The animated light position goes straight into the uniform ring
+		// region of the acquired image that the GPU no longer reads
+		if (!paused)
+		{
+			updateUniformBuffers();
+		}
 
-		err = vkQueueWaitIdle(queue);
-		assert(!err);
+		// Submit the image's draw command buffer and present it
+		submitFrame();
 	}
 
 	void loadMeshes()
@@ -317,7 +293,7 @@ public:
 		// Example uses two ubos and two image sampler
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2),
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2),
 			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2)
 		};
 
@@ -337,7 +313,7 @@ public:
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_VERTEX_BIT,
 				0),
 			// Binding 1 : Fragment shader color map image sampler
@@ -352,7 +328,7 @@ public:
 				2),
 			// Binding 3 : Fragment shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_FRAGMENT_BIT,
 				3)
 		};
@@ -398,14 +374,17 @@ public:
 				textures.normalHeightMap.view,
 				VK_IMAGE_LAYOUT_GENERAL);
 
+		VkDescriptorBufferInfo vertexShaderDescriptor = uniformRing.getDescriptor(uniformOffsets.vertexShader, sizeof(ubos.vertexShader));
+		VkDescriptorBufferInfo fragmentShaderDescriptor = uniformRing.getDescriptor(uniformOffsets.fragmentShader, sizeof(ubos.fragmentShader));
+
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets =
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.vertexShader.descriptor),
+				&vertexShaderDescriptor),
 			// Binding 1 : Fragment shader image sampler
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
@@ -421,9 +400,9 @@ public:
 			// Binding 3 : Fragment shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				3,
-				&uniformData.fragmentShader.descriptor)
+				&fragmentShaderDescriptor)
 		};
 
 		vkUpdateDescriptorSets(device, writeDescriptorSets.size(), writeDescriptorSets.data(), 0, NULL);
@@ -526,22 +505,10 @@ public:
 	void prepareUniformBuffers()
 	{
 		// Vertex shader ubo
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(ubos.vertexShader),
-			&ubos.vertexShader,
-			&uniformData.vertexShader.buffer,
-			&uniformData.vertexShader.memory,
-			&uniformData.vertexShader.descriptor);
+		uniformOffsets.vertexShader = uniformRing.allocate(sizeof(ubos.vertexShader));
 
 		// Fragment shader ubo
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(ubos.fragmentShader),
-			&ubos.fragmentShader,
-			&uniformData.fragmentShader.buffer,
-			&uniformData.fragmentShader.memory,
-			&uniformData.fragmentShader.descriptor);
+		uniformOffsets.fragmentShader = uniformRing.allocate(sizeof(ubos.fragmentShader));
 
 		updateUniformBuffers();
 	}
@@ -569,17 +536,10 @@ public:
 
 		ubos.vertexShader.cameraPos = glm::vec4(0.0, 0.0, zoom, 0.0);
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.vertexShader.memory, 0, sizeof(ubos.vertexShader), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &ubos.vertexShader, sizeof(ubos.vertexShader));
-		vkUnmapMemory(device, uniformData.vertexShader.memory);
+		uniformRing.update(uniformOffsets.vertexShader, &ubos.vertexShader, sizeof(ubos.vertexShader));
 
 		// Fragment shader
-		err = vkMapMemory(device, uniformData.fragmentShader.memory, 0, sizeof(ubos.fragmentShader), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &ubos.fragmentShader, sizeof(ubos.fragmentShader));
-		vkUnmapMemory(device, uniformData.fragmentShader.memory);
+		uniformRing.update(uniformOffsets.fragmentShader, &ubos.fragmentShader, sizeof(ubos.fragmentShader));
 	}
 
 	void prepare()
@@ -601,13 +561,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
-		if (!paused)
-		{
-			updateUniformBuffers();
-		}
 	}
 
 	virtual void viewChanged()
@@ -682,6 +636,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
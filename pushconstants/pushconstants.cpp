@@ -18,13 +18,11 @@
 #define ENABLE_VALIDATION false
 
 // Vertex layout for this example
-std::vector<vkMeshLoader::VertexLayout> vertexLayout =
-{
+typedef vkMeshLoader::VertexFormat<
 	vkMeshLoader::VERTEX_LAYOUT_POSITION,
 	vkMeshLoader::VERTEX_LAYOUT_NORMAL,
 	vkMeshLoader::VERTEX_LAYOUT_UV,
-	vkMeshLoader::VERTEX_LAYOUT_COLOR
-};
+	vkMeshLoader::VERTEX_LAYOUT_COLOR> VertexFormat;
 
 class VulkanExample : public VulkanExampleBase
 {
@@ -41,9 +39,8 @@ public:
 		vkMeshLoader::MeshBuffer scene;
 	} meshes;
 
-	struct {
-		vkTools::UniformData vertexShader;
-	} uniformData;
+	// Offset of the vertex shader uniform block inside the base class uniform ring
+	VkDeviceSize uniformOffsetVS;
 	
 	struct {
 		glm::mat4 projection;
@@ -92,21 +89,10 @@ public:
 		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.scene);
-
-		vkTools::destroyUniformData(device, &uniformData.vertexShader);
-	}
-
-	void reBuildCommandBuffers()
-	{
-		if (!checkCommandBuffers())
-		{
-			destroyCommandBuffers();
-			createCommandBuffers();
-		}
-		buildCommandBuffers();
 	}
 
-	void buildCommandBuffers()
+	// Record the command buffer for a single swap chain image
+	void buildCommandBuffer(int32_t i)
 	{
 		VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
 
@@ -125,171 +111,108 @@ public:
 
 		VkResult err;
 
-		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i)
-		{
-			// Set target frame buffer
-			renderPassBeginInfo.framebuffer = frameBuffers[i];
+		// Set target frame buffer
+		renderPassBeginInfo.framebuffer = frameBuffers[i];
 
-			err = vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo);
-			assert(!err);
+		err = vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo);
+		assert(!err);
 
-			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-			VkViewport viewport = vkTools::initializers::viewport(
-				(float)width,
-				(float)height,
-				0.0f,
-				1.0f);
-			vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
+		VkViewport viewport = vkTools::initializers::viewport(
+			(float)width,
+			(float)height,
+			0.0f,
+			1.0f);
+		vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
 
-			VkRect2D scissor = vkTools::initializers::rect2D(
-				width,
-				height,
-				0,
-				0);
-			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
+		VkRect2D scissor = vkTools::initializers::rect2D(
+			width,
+			height,
+			0,
+			0);
+		vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
 
-			// Update light positions
-			// w component = light radius scale
+		// Update light positions
+		// w component = light radius scale
 #define r 7.5f
 #define sin_t sin(deg_to_rad(timer * 360))
 #define cos_t cos(deg_to_rad(timer * 360))
 #define y -4.0f
-			pushConstants[0] = glm::vec4(r * 1.1 * sin_t, y, r * 1.1 * cos_t, 1.0f);
-			pushConstants[1] = glm::vec4(-r * sin_t, y, -r * cos_t, 1.0f);
-			pushConstants[2] = glm::vec4(r * 0.85f * sin_t, y, -sin_t * 2.5f, 1.5f);
-			pushConstants[3] = glm::vec4(0.0f, y, r * 1.25f * cos_t, 1.5f);
-			pushConstants[4] = glm::vec4(r * 2.25f * cos_t, y, 0.0f, 1.25f);
-			pushConstants[5] = glm::vec4(r * 2.5f * cos(deg_to_rad(timer * 360)), y, r * 2.5f * sin_t, 1.25f);
+		pushConstants[0] = glm::vec4(r * 1.1 * sin_t, y, r * 1.1 * cos_t, 1.0f);
+		pushConstants[1] = glm::vec4(-r * sin_t, y, -r * cos_t, 1.0f);
+		pushConstants[2] = glm::vec4(r * 0.85f * sin_t, y, -sin_t * 2.5f, 1.5f);
+		pushConstants[3] = glm::vec4(0.0f, y, r * 1.25f * cos_t, 1.5f);
+		pushConstants[4] = glm::vec4(r * 2.25f * cos_t, y, 0.0f, 1.25f);
+		pushConstants[5] = glm::vec4(r * 2.5f * cos(deg_to_rad(timer * 360)), y, r * 2.5f * sin_t, 1.25f);
 #undef r
 #undef y
 #undef sin_t
 #undef cos_t
 
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
-			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.solid);
+		// Each command buffer reads the uniform ring region of it's swap chain image
+		uint32_t dynamicOffset = uniformRing.getDynamicOffset(i);
+		vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 1, &dynamicOffset);
+		vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.solid);
 
-			// Submit via push constant (rather than a UBO)
-			vkCmdPushConstants(
-				drawCmdBuffers[i],
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT,
-				VK_FLAGS_NONE,
-				sizeof(pushConstants),
-				pushConstants.data());
+		// Submit via push constant (rather than a UBO)
+		vkCmdPushConstants(
+			drawCmdBuffers[i],
+			pipelineLayout,
+			VK_SHADER_STAGE_VERTEX_BIT,
+			VK_FLAGS_NONE,
+			sizeof(pushConstants),
+			pushConstants.data());
 
-			VkDeviceSize offsets[1] = { 0 };
-			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.scene.vertices.buf, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.scene.indices.buf, 0, VK_INDEX_TYPE_UINT32);
+		VkDeviceSize offsets[1] = { 0 };
+		vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.scene.vertices.buf, offsets);
+		vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.scene.indices.buf, 0, meshes.scene.indexType);
 
-			vkCmdDrawIndexed(drawCmdBuffers[i], meshes.scene.indexCount, 1, 0, 0, 0);
+		vkMeshLoader::drawMesh(drawCmdBuffers[i], meshes.scene);
 
-			vkCmdEndRenderPass(drawCmdBuffers[i]);
+		vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE, 
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
+		err = vkEndCommandBuffer(drawCmdBuffers[i]);
+		assert(!err);
+	}
 
-			err = vkEndCommandBuffer(drawCmdBuffers[i]);
-			assert(!err);
+	void buildCommandBuffers()
+	{
+		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i)
+		{
+			buildCommandBuffer(i);
 		}
 	}
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo =
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
 
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
-
-		err = vkQueueWaitIdle(queue);
-		assert(!err);
-
-		// Gather command buffers to be sumitted to the queue
-		std::vector<VkCommandBuffer> submitCmdBuffers = {
-			drawCmdBuffers[currentBuffer]
-		};
-
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = submitCmdBuffers.size();
-		submitInfo.pCommandBuffers = submitCmdBuffers.data();
-
-		// Submit draw command buffer
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
-
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
+		// Push constants are stored in the command buffer, so the 
+		// current image's command buffer is re-recorded every frame
+		// This is safe as beginFrame ensures that it's no longer pending
+		if (!paused)
+		{
+			buildCommandBuffer(currentBuffer);
+		}
 
-		err = vkQueueWaitIdle(queue);
-		assert(!err);
+		// Submit the image's draw command buffer and present it
+		submitFrame();
 	}
 
 	void loadMeshes()
 	{
-		loadMesh("./../data/models/samplescene.X", &meshes.scene, vertexLayout, 0.35f);
+		loadMesh<VertexFormat>("./../data/models/samplescene.X", &meshes.scene, 0.35f);
 	}
 
 	void setupVertexDescriptions()
 	{
-		// Binding description
-		vertices.bindingDescriptions.resize(1);
-		vertices.bindingDescriptions[0] =
-			vkTools::initializers::vertexInputBindingDescription(
-				VERTEX_BUFFER_BIND_ID,
-				vkMeshLoader::vertexSize(vertexLayout),
-				VK_VERTEX_INPUT_RATE_VERTEX);
-
-		// Attribute descriptions
-		// Describes memory layout and shader positions
-		vertices.attributeDescriptions.resize(4);
-		// Location 0 : Position
-		vertices.attributeDescriptions[0] =
-			vkTools::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				0,
-				VK_FORMAT_R32G32B32_SFLOAT,
-				0);
-		// Location 1 : Normal
-		vertices.attributeDescriptions[1] =
-			vkTools::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				1,
-				VK_FORMAT_R32G32B32_SFLOAT,
-				sizeof(float) * 3);
-		// Location 2 : Texture coordinates
-		vertices.attributeDescriptions[2] =
-			vkTools::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				2,
-				VK_FORMAT_R32G32_SFLOAT,
-				sizeof(float) * 6);
-		// Location 3 : Color
-		vertices.attributeDescriptions[3] =
-			vkTools::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				3,
-				VK_FORMAT_R32G32B32_SFLOAT,
-				sizeof(float) * 8);
+		// Binding and attribute descriptions are generated from the vertex format
+		// Location 0 : Position, 1 : Normal, 2 : Texture coordinates, 3 : Color
+		vertices.bindingDescriptions = { VertexFormat::bindingDescription(VERTEX_BUFFER_BIND_ID) };
+		VertexFormat::AttributeDescriptions attributeDescriptions = VertexFormat::attributeDescriptions(VERTEX_BUFFER_BIND_ID);
+		vertices.attributeDescriptions.assign(attributeDescriptions.begin(), attributeDescriptions.end());
 
 		vertices.inputState = vkTools::initializers::pipelineVertexInputStateCreateInfo();
 		vertices.inputState.vertexBindingDescriptionCount = vertices.bindingDescriptions.size();
@@ -303,7 +226,7 @@ public:
 		// Example uses one ubo 
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1),
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1),
 		};
 
 		VkDescriptorPoolCreateInfo descriptorPoolInfo =
@@ -322,7 +245,7 @@ public:
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_VERTEX_BIT,
 				0),
 		};
@@ -372,13 +295,15 @@ public:
 		VkResult vkRes = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet);
 		assert(!vkRes);
 
+		VkDescriptorBufferInfo uboDescriptor = uniformRing.getDescriptor(uniformOffsetVS, sizeof(uboVS));
+
 		// Binding 0 : Vertex shader uniform buffer
 		VkWriteDescriptorSet writeDescriptorSet =
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.vertexShader.descriptor);
+				&uboDescriptor);
 
 		vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, NULL);
 	}
@@ -468,13 +393,7 @@ public:
 	void prepareUniformBuffers()
 	{
 		// Vertex shader uniform buffer block
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboVS),
-			&uboVS,
-			&uniformData.vertexShader.buffer,
-			&uniformData.vertexShader.memory,
-			&uniformData.vertexShader.descriptor);
+		uniformOffsetVS = uniformRing.allocate(sizeof(uboVS));
 
 		updateUniformBuffers();
 	}
@@ -493,11 +412,7 @@ public:
 		uboVS.model = glm::rotate(uboVS.model, deg_to_rad(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
 		uboVS.model = glm::rotate(uboVS.model, deg_to_rad(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.vertexShader.memory, 0, sizeof(uboVS), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboVS, sizeof(uboVS));
-		vkUnmapMemory(device, uniformData.vertexShader.memory);
+		uniformRing.update(uniformOffsetVS, &uboVS, sizeof(uboVS));
 	}
 
 	void prepare()
@@ -518,13 +433,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
-		if (!paused)
-		{
-			reBuildCommandBuffers();
-		}
 	}
 
 	virtual void viewChanged()
@@ -577,6 +486,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
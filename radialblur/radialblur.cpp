@@ -52,11 +52,12 @@ public:
 		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
 	} vertices;
 
+	// Offsets of the uniform blocks inside the base class uniform ring
 	struct {
-		vkTools::UniformData vsScene;
-		vkTools::UniformData vsQuad;
-		vkTools::UniformData fsQuad;
-	} uniformData;
+		VkDeviceSize vsScene;
+		VkDeviceSize vsQuad;
+		VkDeviceSize fsQuad;
+	} uniformOffsets;
 
 	struct {
 		glm::mat4 projection;
@@ -100,7 +101,7 @@ public:
 	// Framebuffer for offscreen rendering
 	struct FrameBufferAttachment {
 		VkImage image;
-		VkDeviceMemory mem;
+		vkTools::Allocation allocation;
 		VkImageView view;
 	};
 	struct FrameBuffer {
@@ -111,7 +112,14 @@ public:
 		vkTools::VulkanTexture textureTarget;
 	} offScreenFrameBuf;
 
-	VkCommandBuffer offScreenCmdBuffer = VK_NULL_HANDLE;
+	// One offscreen command buffer per swap chain image, so each can read
+	// the uniform ring region of it's image (like the draw command buffers)
+	std::vector<VkCommandBuffer> offScreenCmdBuffers;
+
+	// Render pass used for the offscreen framebuffers
+	// Unlike the default render pass it keeps the color attachment
+	// in color attachment layout instead of transitioning it to present
+	VkRenderPass offScreenRenderPass;
 
 	VulkanExample() : VulkanExampleBase(ENABLE_VALIDATION)
 	{
@@ -134,14 +142,15 @@ public:
 		// Color attachment
 		vkDestroyImageView(device, offScreenFrameBuf.color.view, nullptr);
 		vkDestroyImage(device, offScreenFrameBuf.color.image, nullptr);
-		vkFreeMemory(device, offScreenFrameBuf.color.mem, nullptr);
+		memoryAllocator.free(offScreenFrameBuf.color.allocation);
 
 		// Depth attachment
 		vkDestroyImageView(device, offScreenFrameBuf.depth.view, nullptr);
 		vkDestroyImage(device, offScreenFrameBuf.depth.image, nullptr);
-		vkFreeMemory(device, offScreenFrameBuf.depth.mem, nullptr);
+		memoryAllocator.free(offScreenFrameBuf.depth.allocation);
 
 		vkDestroyFramebuffer(device, offScreenFrameBuf.frameBuffer, nullptr);
+		vkDestroyRenderPass(device, offScreenRenderPass, nullptr);
 
 		vkDestroyPipeline(device, pipelines.radialBlur, nullptr);
 		vkDestroyPipeline(device, pipelines.phongPass, nullptr);
@@ -157,12 +166,7 @@ public:
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.example);
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.quad);
 
-		// Uniform buffers
-		vkTools::destroyUniformData(device, &uniformData.vsScene);
-		vkTools::destroyUniformData(device, &uniformData.vsQuad);
-		vkTools::destroyUniformData(device, &uniformData.fsQuad);
-
-		vkFreeCommandBuffers(device, cmdPool, 1, &offScreenCmdBuffer);
+		vkFreeCommandBuffers(device, cmdPool, offScreenCmdBuffers.size(), offScreenCmdBuffers.data());
 	}
 
 	// Preapre an empty texture as the blit target from 
@@ -193,18 +197,9 @@ public:
 		// Texture will be sampled in a shader and is also the blit destination
 		imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
-		VkMemoryAllocateInfo memAllocInfo = vkTools::initializers::memoryAllocateInfo();
-		VkMemoryRequirements memReqs;
-
 		err = vkCreateImage(device, &imageCreateInfo, nullptr, &tex->image);
 		assert(!err);
-		vkGetImageMemoryRequirements(device, tex->image, &memReqs);
-		memAllocInfo.allocationSize = memReqs.size;
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAllocInfo.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAllocInfo, nullptr, &(tex->deviceMemory));
-		assert(!err);
-		err = vkBindImageMemory(device, tex->image, tex->deviceMemory, 0);
-		assert(!err);
+		tex->allocation = memoryAllocator.allocateImage(tex->image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Transform image layout to transer destination
 		tex->imageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
@@ -277,9 +272,6 @@ public:
 		image.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 		image.flags = 0;
 
-		VkMemoryAllocateInfo memAlloc = vkTools::initializers::memoryAllocateInfo();
-		VkMemoryRequirements memReqs;
-
 		VkImageViewCreateInfo colorImageView = vkTools::initializers::imageViewCreateInfo();
 		colorImageView.viewType = VK_IMAGE_VIEW_TYPE_2D;
 		colorImageView.format = fbColorFormat;
@@ -293,14 +285,7 @@ public:
 
 		err = vkCreateImage(device, &image, nullptr, &offScreenFrameBuf.color.image);
 		assert(!err);
-		vkGetImageMemoryRequirements(device, offScreenFrameBuf.color.image, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAlloc.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAlloc, nullptr, &offScreenFrameBuf.color.mem);
-		assert(!err);
-
-		err = vkBindImageMemory(device, offScreenFrameBuf.color.image, offScreenFrameBuf.color.mem, 0);
-		assert(!err);
+		offScreenFrameBuf.color.allocation = memoryAllocator.allocateImage(offScreenFrameBuf.color.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		vkTools::setImageLayout(
 			setupCmdBuffer, 
@@ -330,14 +315,7 @@ public:
 
 		err = vkCreateImage(device, &image, nullptr, &offScreenFrameBuf.depth.image);
 		assert(!err);
-		vkGetImageMemoryRequirements(device, offScreenFrameBuf.depth.image, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAlloc.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAlloc, nullptr, &offScreenFrameBuf.depth.mem);
-		assert(!err);
-
-		err = vkBindImageMemory(device, offScreenFrameBuf.depth.image, offScreenFrameBuf.depth.mem, 0);
-		assert(!err);
+		offScreenFrameBuf.depth.allocation = memoryAllocator.allocateImage(offScreenFrameBuf.depth.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		vkTools::setImageLayout(
 			setupCmdBuffer, 
@@ -357,7 +335,7 @@ public:
 		attachments[1] = offScreenFrameBuf.depth.view;
 
 		VkFramebufferCreateInfo fbufCreateInfo = vkTools::initializers::framebufferCreateInfo();
-		fbufCreateInfo.renderPass = renderPass;
+		fbufCreateInfo.renderPass = offScreenRenderPass;
 		fbufCreateInfo.attachmentCount = 2;
 		fbufCreateInfo.pAttachments = attachments;
 		fbufCreateInfo.width = offScreenFrameBuf.width;
@@ -368,39 +346,43 @@ public:
 		assert(!err);
 	}
 
-	void createOffscreenCommandBuffer()
+	void createOffscreenCommandBuffers()
 	{
+		offScreenCmdBuffers.resize(drawCmdBuffers.size());
 		VkCommandBufferAllocateInfo cmd = vkTools::initializers::commandBufferAllocateInfo(
 			cmdPool,
 			VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-			1);
-		VkResult vkRes = vkAllocateCommandBuffers(device, &cmd, &offScreenCmdBuffer);
+			offScreenCmdBuffers.size());
+		VkResult vkRes = vkAllocateCommandBuffers(device, &cmd, offScreenCmdBuffers.data());
 		assert(!vkRes);
 	}
 
-	// The command buffer to copy for rendering 
+	// The command buffers to copy for rendering 
 	// the offscreen scene and blitting it into
-	// the texture target is only build once
-	// and gets resubmitted 
-	void buildOffscreenCommandBuffer()
+	// the texture target are only build once
+	// and get resubmitted 
+	void buildOffscreenCommandBuffer(VkCommandBuffer cmdBuffer, uint32_t dynamicOffset)
 	{
 		VkResult err;
 
 		VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
 
+		// One dynamic offset per uniform buffer binding of the set
+		uint32_t dynamicOffsets[2] = { dynamicOffset, dynamicOffset };
+
 		VkClearValue clearValues[2];
 		clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
 		clearValues[1].depthStencil = { 1.0f, 0 };
 
 		VkRenderPassBeginInfo renderPassBeginInfo = vkTools::initializers::renderPassBeginInfo();
-		renderPassBeginInfo.renderPass = renderPass;
+		renderPassBeginInfo.renderPass = offScreenRenderPass;
 		renderPassBeginInfo.framebuffer = offScreenFrameBuf.frameBuffer;
 		renderPassBeginInfo.renderArea.extent.width = offScreenFrameBuf.width;
 		renderPassBeginInfo.renderArea.extent.height = offScreenFrameBuf.height;
 		renderPassBeginInfo.clearValueCount = 2;
 		renderPassBeginInfo.pClearValues = clearValues;
 
-		err = vkBeginCommandBuffer(offScreenCmdBuffer, &cmdBufInfo);
+		err = vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo);
 		assert(!err);
 
 		VkViewport viewport = vkTools::initializers::viewport(
@@ -408,29 +390,29 @@ public:
 			(float)offScreenFrameBuf.height,
 			0.0f,
 			1.0f);
-		vkCmdSetViewport(offScreenCmdBuffer, 0, 1, &viewport);
+		vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
 
 		VkRect2D scissor = vkTools::initializers::rect2D(
 			offScreenFrameBuf.width,
 			offScreenFrameBuf.height,
 			0,
 			0);
-		vkCmdSetScissor(offScreenCmdBuffer, 0, 1, &scissor);
+		vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
 
-		vkCmdBeginRenderPass(offScreenCmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-		vkCmdBindDescriptorSets(offScreenCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets.scene, 0, NULL);
-		vkCmdBindPipeline(offScreenCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.colorPass);
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets.scene, 2, dynamicOffsets);
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.colorPass);
 
 		VkDeviceSize offsets[1] = { 0 };
-		vkCmdBindVertexBuffers(offScreenCmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &meshes.example.vertices.buf, offsets);
-		vkCmdBindIndexBuffer(offScreenCmdBuffer, meshes.example.indices.buf, 0, VK_INDEX_TYPE_UINT32);
-		vkCmdDrawIndexed(offScreenCmdBuffer, meshes.example.indexCount, 1, 0, 0, 0);
-		vkCmdEndRenderPass(offScreenCmdBuffer);
+		vkCmdBindVertexBuffers(cmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &meshes.example.vertices.buf, offsets);
+		vkCmdBindIndexBuffer(cmdBuffer, meshes.example.indices.buf, 0, meshes.example.indexType);
+		vkMeshLoader::drawMesh(cmdBuffer, meshes.example);
+		vkCmdEndRenderPass(cmdBuffer);
 
 		// Make sure color writes to the framebuffer are finished before using it as transfer source
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBuf.color.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
@@ -438,7 +420,7 @@ public:
 
 		// Transform texture target to transfer destination
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBuf.textureTarget.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
@@ -470,7 +452,7 @@ public:
 		// Blit from framebuffer image to texture image
 		// vkCmdBlitImage does scaling and (if necessary and possible) also does format conversions
 		vkCmdBlitImage(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBuf.color.image,
 			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 			offScreenFrameBuf.textureTarget.image,
@@ -482,7 +464,7 @@ public:
 
 		// Transform framebuffer color attachment back 
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBuf.color.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
@@ -492,18 +474,28 @@ public:
 		// Makes sure that writes to the texture are finished before
 		// it's accessed in the shader
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBuf.textureTarget.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-		err = vkEndCommandBuffer(offScreenCmdBuffer);
+		err = vkEndCommandBuffer(cmdBuffer);
 		assert(!err);
 	}
 
+	void buildOffscreenCommandBuffers()
+	{
+		for (uint32_t i = 0; i < offScreenCmdBuffers.size(); ++i)
+		{
+			buildOffscreenCommandBuffer(offScreenCmdBuffers[i], uniformRing.getDynamicOffset(i));
+		}
+	}
+
 	void reBuildCommandBuffers()
 	{
+		// Frames may still be in flight
+		vkDeviceWaitIdle(device);
 		if (!checkCommandBuffers())
 		{
 			destroyCommandBuffers();
@@ -557,18 +549,22 @@ public:
 
 			VkDeviceSize offsets[1] = { 0 };
 
+			// Each command buffer reads the uniform ring region of it's swap chain image
+			// One dynamic offset per uniform buffer binding of the set
+			uint32_t dynamicOffsets[2] = { uniformRing.getDynamicOffset(i), uniformRing.getDynamicOffset(i) };
+
 			// 3D scene
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets.scene, 0, NULL);
+			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets.scene, 2, dynamicOffsets);
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.phongPass);
 
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.example.vertices.buf, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.example.indices.buf, 0, VK_INDEX_TYPE_UINT32);
-			vkCmdDrawIndexed(drawCmdBuffers[i], meshes.example.indexCount, 1, 0, 0, 0);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.example.indices.buf, 0, meshes.example.indexType);
+			vkMeshLoader::drawMesh(drawCmdBuffers[i], meshes.example);
 
 			// Fullscreen quad with radial blur
 			if (blur)
 			{
-				vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.radialBlur, 0, 1, &descriptorSets.quad, 0, NULL);
+				vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.radialBlur, 0, 1, &descriptorSets.quad, 2, dynamicOffsets);
 				vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, (displayTexture) ? pipelines.fullScreenOnly : pipelines.radialBlur);
 				vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.quad.vertices.buf, offsets);
 				vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.quad.indices.buf, 0, VK_INDEX_TYPE_UINT32);
@@ -577,17 +573,6 @@ public:
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			VkImageMemoryBarrier *pMemoryBarrier = &prePresentBarrier;
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE,
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
-
 			err = vkEndCommandBuffer(drawCmdBuffers[i]);
 			assert(!err);
 		}
@@ -595,43 +580,21 @@ public:
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo =
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
-
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
-
-		// Gather command buffers to be sumitted to the queue
-		std::vector<VkCommandBuffer> submitCmdBuffers = {
-			offScreenCmdBuffer,
-			drawCmdBuffers[currentBuffer]
-		};
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
 
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = submitCmdBuffers.size();
-		submitInfo.pCommandBuffers = submitCmdBuffers.data();
-
-		// Submit draw command buffer
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
-
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
+		// The scene rotates every frame, write it to the uniform ring region of the acquired image
+		if (!paused)
+		{
+			updateUniformBuffersScene();
+		}
 
-		err = vkQueueWaitIdle(queue);
-		assert(err == VK_SUCCESS);
+		// Submit offscreen rendering before the scene composition and present
+		// Each command buffer is measured by the GPU profiler (if enabled)
+		std::vector<VkCommandBuffer> submitCmdBuffers;
+		profiler.addCommandBuffer(submitCmdBuffers, offScreenCmdBuffers[currentBuffer], "Offscreen (glow)");
+		profiler.addCommandBuffer(submitCmdBuffers, drawCmdBuffers[currentBuffer], "Radial blur composition");
+		submitFrame(submitCmdBuffers);
 	}
 
 	void loadMeshes()
@@ -664,7 +627,7 @@ public:
 			vertexBuffer.size() * sizeof(Vertex),
 			vertexBuffer.data(),
 			&meshes.quad.vertices.buf,
-			&meshes.quad.vertices.mem);
+			&meshes.quad.vertices.allocation);
 
 		// Setup indices
 		std::vector<uint32_t> indexBuffer = { 0,1,2, 2,3,0 };
@@ -675,7 +638,7 @@ public:
 			indexBuffer.size() * sizeof(uint32_t),
 			indexBuffer.data(),
 			&meshes.quad.indices.buf,
-			&meshes.quad.indices.mem);
+			&meshes.quad.indices.allocation);
 	}
 
 	void setupVertexDescriptions()
@@ -731,7 +694,7 @@ public:
 		// Example uses three ubos and one image sampler
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4),
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 4),
 			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2)
 		};
 
@@ -752,7 +715,7 @@ public:
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_VERTEX_BIT,
 				0),
 			// Binding 1 : Fragment shader image sampler
@@ -762,7 +725,7 @@ public:
 				1),
 			// Binding 2 : Fragment shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_FRAGMENT_BIT,
 				2)
 		};
@@ -807,14 +770,19 @@ public:
 				offScreenFrameBuf.textureTarget.view,
 				VK_IMAGE_LAYOUT_GENERAL);
 
+		// Uniform blocks inside the uniform ring
+		VkDescriptorBufferInfo vsSceneDescriptor = uniformRing.getDescriptor(uniformOffsets.vsScene, sizeof(uboVS));
+		VkDescriptorBufferInfo vsQuadDescriptor = uniformRing.getDescriptor(uniformOffsets.vsQuad, sizeof(uboQuadVS));
+		VkDescriptorBufferInfo fsQuadDescriptor = uniformRing.getDescriptor(uniformOffsets.fsQuad, sizeof(uboQuadFS));
+
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets =
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.quad,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.vsScene.descriptor),
+				&vsSceneDescriptor),
 			// Binding 1 : Fragment shader texture sampler
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.quad,
@@ -824,9 +792,9 @@ public:
 			// Binding 2 : Fragment shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.quad,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				2,
-				&uniformData.fsQuad.descriptor)
+				&fsQuadDescriptor)
 		};
 
 		vkUpdateDescriptorSets(device, writeDescriptorSets.size(), writeDescriptorSets.data(), 0, NULL);
@@ -840,9 +808,9 @@ public:
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.scene,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.vsQuad.descriptor)
+				&vsQuadDescriptor)
 		};
 		vkUpdateDescriptorSets(device, offScreenWriteDescriptorSets.size(), offScreenWriteDescriptorSets.data(), 0, NULL);
 	}
@@ -976,34 +944,14 @@ public:
 	// Prepare and initialize uniform buffer containing shader uniforms
 	void prepareUniformBuffers()
 	{
-		VkResult err;
-
 		// Phong and color pass vertex shader uniform buffer
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboVS),
-			&uboVS,
-			&uniformData.vsScene.buffer,
-			&uniformData.vsScene.memory,
-			&uniformData.vsScene.descriptor);
+		uniformOffsets.vsScene = uniformRing.allocate(sizeof(uboVS));
 
 		// Fullscreen quad vertex shader uniform buffer
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboVS),
-			&uboVS,
-			&uniformData.vsQuad.buffer,
-			&uniformData.vsQuad.memory,
-			&uniformData.vsQuad.descriptor);
+		uniformOffsets.vsQuad = uniformRing.allocate(sizeof(uboQuadVS));
 
 		// Fullscreen quad fragment shader uniform buffer
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboQuadFS),
-			&uboQuadFS,
-			&uniformData.fsQuad.buffer,
-			&uniformData.fsQuad.memory,
-			&uniformData.fsQuad.descriptor);
+		uniformOffsets.fsQuad = uniformRing.allocate(sizeof(uboQuadFS));
 
 		updateUniformBuffersScene();
 		updateUniformBuffersScreen();
@@ -1022,11 +970,7 @@ public:
 		uboQuadVS.model = glm::rotate(uboQuadVS.model, deg_to_rad(timer * 360.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 		uboQuadVS.model = glm::rotate(uboQuadVS.model, deg_to_rad(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.vsQuad.memory, 0, sizeof(uboQuadVS), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboQuadVS, sizeof(uboQuadVS));
-		vkUnmapMemory(device, uniformData.vsQuad.memory);
+		uniformRing.update(uniformOffsets.vsQuad, &uboQuadVS, sizeof(uboQuadVS));
 	}
 
 	// Update uniform buffers for the fullscreen quad
@@ -1036,17 +980,10 @@ public:
 		uboVS.projection = glm::ortho(0.0f, 1.0f, 0.0f, 1.0f, -1.0f, 1.0f);
 		uboVS.model = glm::mat4();
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.vsScene.memory, 0, sizeof(uboVS), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboVS, sizeof(uboVS));
-		vkUnmapMemory(device, uniformData.vsScene.memory);
+		uniformRing.update(uniformOffsets.vsScene, &uboVS, sizeof(uboVS));
 
 		// Fragment shader
-		err = vkMapMemory(device, uniformData.fsQuad.memory, 0, sizeof(uboQuadFS), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboQuadFS, sizeof(uboQuadFS));
-		vkUnmapMemory(device, uniformData.fsQuad.memory);
+		uniformRing.update(uniformOffsets.fsQuad, &uboQuadFS, sizeof(uboQuadFS));
 	}
 
 	void prepare()
@@ -1061,10 +998,11 @@ public:
 		preparePipelines();
 		setupDescriptorPool();
 		setupDescriptorSet();
-		createOffscreenCommandBuffer();
+		createOffscreenCommandBuffers();
+		offScreenRenderPass = createRenderPass(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
 		prepareOffscreenFramebuffer();
 		buildCommandBuffers();
-		buildOffscreenCommandBuffer();
+		buildOffscreenCommandBuffers();
 		prepared = true;
 	}
 
@@ -1072,13 +1010,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
-		if (!paused)
-		{
-			updateUniformBuffersScene();
-		}
 	}
 
 	virtual void viewChanged()
@@ -1144,6 +1076,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
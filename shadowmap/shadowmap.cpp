@@ -25,12 +25,14 @@
 #define FB_COLOR_FORMAT VK_FORMAT_R32_SFLOAT 
 
 // Vertex layout for this example
+// Packed to 24 bytes per vertex (44 with floats) to reduce vertex fetch bandwidth in both passes
+// Positions stay floats as the shaders use them as world space positions
 std::vector<vkMeshLoader::VertexLayout> vertexLayout = 
 {
 	vkMeshLoader::VERTEX_LAYOUT_POSITION,
-	vkMeshLoader::VERTEX_LAYOUT_UV,
-	vkMeshLoader::VERTEX_LAYOUT_COLOR,
-	vkMeshLoader::VERTEX_LAYOUT_NORMAL
+	vkMeshLoader::VERTEX_LAYOUT_UV_HALF,
+	vkMeshLoader::VERTEX_LAYOUT_COLOR_UNORM8,
+	vkMeshLoader::VERTEX_LAYOUT_NORMAL_PACKED
 };
 
 class VulkanExample : public VulkanExampleBase
@@ -52,10 +54,11 @@ public:
 		vkMeshLoader::MeshBuffer scene;
 	} meshes;
 
+	// Offsets of the uniform blocks inside the base class uniform ring
 	struct {
-		vkTools::UniformData scene;
-		vkTools::UniformData offscreen;
-	} uniformData;
+		VkDeviceSize scene;
+		VkDeviceSize offscreen;
+	} uniformOffsets;
 
 	struct {
 		glm::mat4 projection;
@@ -101,7 +104,7 @@ public:
 	// Framebuffer for offscreen rendering
 	struct FrameBufferAttachment {
 		VkImage image;
-		VkDeviceMemory mem;
+		vkTools::Allocation allocation;
 		VkImageView view;
 	};
 	struct FrameBuffer {
@@ -110,7 +113,14 @@ public:
 		FrameBufferAttachment color, depth;
 	} offScreenFrameBuf;
 
-	VkCommandBuffer offScreenCmdBuffer = VK_NULL_HANDLE;
+	// One offscreen command buffer per swap chain image, so each can read
+	// the uniform ring region of its image (like the draw command buffers)
+	std::vector<VkCommandBuffer> offScreenCmdBuffers;
+
+	// Render pass used for the offscreen framebuffers
+	// Unlike the default render pass it keeps the color attachment
+	// in color attachment layout instead of transitioning it to present
+	VkRenderPass offScreenRenderPass;
 
 	VulkanExample() : VulkanExampleBase(ENABLE_VALIDATION)
 	{
@@ -130,21 +140,22 @@ public:
 		vkDestroyImageView(device, shadowCubeMap.view, nullptr);
 		vkDestroyImage(device, shadowCubeMap.image, nullptr);
 		vkDestroySampler(device, shadowCubeMap.sampler, nullptr);
-		vkFreeMemory(device, shadowCubeMap.deviceMemory, nullptr);
+		memoryAllocator.free(shadowCubeMap.allocation);
 
 		// Frame buffer
 
 		// Color attachment
 		vkDestroyImageView(device, offScreenFrameBuf.color.view, nullptr);
 		vkDestroyImage(device, offScreenFrameBuf.color.image, nullptr);
-		vkFreeMemory(device, offScreenFrameBuf.color.mem, nullptr);
+		memoryAllocator.free(offScreenFrameBuf.color.allocation);
 
 		// Depth attachment
 		vkDestroyImageView(device, offScreenFrameBuf.depth.view, nullptr);
 		vkDestroyImage(device, offScreenFrameBuf.depth.image, nullptr);
-		vkFreeMemory(device, offScreenFrameBuf.depth.mem, nullptr);
+		memoryAllocator.free(offScreenFrameBuf.depth.allocation);
 
 		vkDestroyFramebuffer(device, offScreenFrameBuf.frameBuffer, nullptr);
+		vkDestroyRenderPass(device, offScreenRenderPass, nullptr);
 
 		// Pipelibes
 		vkDestroyPipeline(device, pipelines.scene, nullptr);
@@ -160,11 +171,7 @@ public:
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.scene);
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.skybox);
 
-		// Uniform buffers
-		vkTools::destroyUniformData(device, &uniformData.offscreen);
-		vkTools::destroyUniformData(device, &uniformData.scene);
-
-		vkFreeCommandBuffers(device, cmdPool, 1, &offScreenCmdBuffer);
+		vkFreeCommandBuffers(device, cmdPool, offScreenCmdBuffers.size(), offScreenCmdBuffers.data());
 	}
 
 	void prepareCubeMap()
@@ -190,9 +197,6 @@ public:
 		imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 		imageCreateInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
 
-		VkMemoryAllocateInfo memAllocInfo = vkTools::initializers::memoryAllocateInfo();
-		VkMemoryRequirements memReqs;
-
 		// Allocate command buffer for image copies and layouts
 		VkCommandBuffer cmdBuffer;
 		VkCommandBufferAllocateInfo cmdBufAlllocatInfo =
@@ -213,15 +217,7 @@ public:
 		err = vkCreateImage(device, &imageCreateInfo, nullptr, &shadowCubeMap.image);
 		assert(!err);
 
-		vkGetImageMemoryRequirements(device, shadowCubeMap.image, &memReqs);
-
-		memAllocInfo.allocationSize = memReqs.size;
-
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAllocInfo.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAllocInfo, nullptr, &shadowCubeMap.deviceMemory);
-		assert(!err);
-		err = vkBindImageMemory(device, shadowCubeMap.image, shadowCubeMap.deviceMemory, 0);
-		assert(!err);
+		shadowCubeMap.allocation = memoryAllocator.allocateImage(shadowCubeMap.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		// Image barrier for optimal image (target)
 		vkTools::setImageLayout(
@@ -311,8 +307,6 @@ public:
 		image.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 		image.flags = 0;
 
-		VkMemoryAllocateInfo memAlloc = vkTools::initializers::memoryAllocateInfo();
-
 		VkImageViewCreateInfo colorImageView = vkTools::initializers::imageViewCreateInfo();
 		colorImageView.viewType = VK_IMAGE_VIEW_TYPE_2D;
 		colorImageView.format = fbColorFormat;
@@ -324,18 +318,10 @@ public:
 		colorImageView.subresourceRange.baseArrayLayer = 0;
 		colorImageView.subresourceRange.layerCount = 1;
 
-		VkMemoryRequirements memReqs;
-
 		err = vkCreateImage(device, &image, nullptr, &offScreenFrameBuf.color.image);
 		assert(!err);
-		vkGetImageMemoryRequirements(device, offScreenFrameBuf.color.image, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAlloc.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAlloc, nullptr, &offScreenFrameBuf.color.mem);
-		assert(!err);
+		offScreenFrameBuf.color.allocation = memoryAllocator.allocateImage(offScreenFrameBuf.color.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-		err = vkBindImageMemory(device, offScreenFrameBuf.color.image, offScreenFrameBuf.color.mem, 0);
-		assert(!err);
 		vkTools::setImageLayout(
 			setupCmdBuffer, 
 			offScreenFrameBuf.color.image, 
@@ -365,14 +351,7 @@ public:
 
 		err = vkCreateImage(device, &image, nullptr, &offScreenFrameBuf.depth.image);
 		assert(!err);
-		vkGetImageMemoryRequirements(device, offScreenFrameBuf.depth.image, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAlloc.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAlloc, nullptr, &offScreenFrameBuf.depth.mem);
-		assert(!err);
-
-		err = vkBindImageMemory(device, offScreenFrameBuf.depth.image, offScreenFrameBuf.depth.mem, 0);
-		assert(!err);
+		offScreenFrameBuf.depth.allocation = memoryAllocator.allocateImage(offScreenFrameBuf.depth.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
 		vkTools::setImageLayout(
 			setupCmdBuffer, 
@@ -394,7 +373,7 @@ public:
 		VkFramebufferCreateInfo fbufCreateInfo = {};
 		fbufCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
 		fbufCreateInfo.pNext = NULL;
-		fbufCreateInfo.renderPass = renderPass;
+		fbufCreateInfo.renderPass = offScreenRenderPass;
 		fbufCreateInfo.attachmentCount = 2;
 		fbufCreateInfo.pAttachments = attachments;
 		fbufCreateInfo.width = offScreenFrameBuf.width;
@@ -410,7 +389,7 @@ public:
 	// a copy from framebuffer to cube face
 	// Uses push constants for quick update of
 	// view matrix for the current cube map face
-	void updateCubeFace(uint32_t faceIndex)
+	void updateCubeFace(uint32_t faceIndex, VkCommandBuffer cmdBuffer, uint32_t dynamicOffset)
 	{
 		VkClearValue clearValues[2];
 		clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
@@ -418,7 +397,7 @@ public:
 
 		VkRenderPassBeginInfo renderPassBeginInfo = vkTools::initializers::renderPassBeginInfo();
 		// Reuse render pass from example pass
-		renderPassBeginInfo.renderPass = renderPass;
+		renderPassBeginInfo.renderPass = offScreenRenderPass;
 		renderPassBeginInfo.framebuffer = offScreenFrameBuf.frameBuffer;
 		renderPassBeginInfo.renderArea.extent.width = offScreenFrameBuf.width;
 		renderPassBeginInfo.renderArea.extent.height = offScreenFrameBuf.height;
@@ -455,7 +434,7 @@ public:
 		// Update shader push constant block
 		// Contains current face view matrix
 		vkCmdPushConstants(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			pipelineLayouts.offscreen,
 			VK_SHADER_STAGE_VERTEX_BIT,
 			0,
@@ -463,21 +442,21 @@ public:
 			&viewMatrix);
 
 		// Render scene from cube face's point of view
-		vkCmdBeginRenderPass(offScreenCmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-		vkCmdBindDescriptorSets(offScreenCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.offscreen, 0, 1, &descriptorSets.offscreen, 0, NULL);
-		vkCmdBindPipeline(offScreenCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.offscreen);
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.offscreen, 0, 1, &descriptorSets.offscreen, 1, &dynamicOffset);
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.offscreen);
 
 		VkDeviceSize offsets[1] = { 0 };
-		vkCmdBindVertexBuffers(offScreenCmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &meshes.scene.vertices.buf, offsets);
-		vkCmdBindIndexBuffer(offScreenCmdBuffer, meshes.scene.indices.buf, 0, VK_INDEX_TYPE_UINT32);
-		vkCmdDrawIndexed(offScreenCmdBuffer, meshes.scene.indexCount, 1, 0, 0, 0);
+		vkCmdBindVertexBuffers(cmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &meshes.scene.vertices.buf, offsets);
+		vkCmdBindIndexBuffer(cmdBuffer, meshes.scene.indices.buf, 0, meshes.scene.indexType);
+		vkMeshLoader::drawMesh(cmdBuffer, meshes.scene);
 
-		vkCmdEndRenderPass(offScreenCmdBuffer);
+		vkCmdEndRenderPass(cmdBuffer);
 
 		// Make sure color writes to the framebuffer are finished before using it as transfer source
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBuf.color.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
@@ -504,7 +483,7 @@ public:
 
 		// Put image copy into command buffer
 		vkCmdCopyImage(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBuf.color.image,
 			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 			shadowCubeMap.image,
@@ -514,7 +493,7 @@ public:
 
 		// Make sure transfer to cube map face is finished before sampling it in a shader
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			shadowCubeMap.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
@@ -522,60 +501,66 @@ public:
 
 		// Transform framebuffer color attachment back 
 		vkTools::setImageLayout(
-			offScreenCmdBuffer,
+			cmdBuffer,
 			offScreenFrameBuf.color.image,
 			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
 	}
 
-	// Command buffer for rendering and copying all cube map faces
-	void buildOffscreenCommandBuffer()
+	// Command buffers for rendering and copying all cube map faces
+	void buildOffscreenCommandBuffers()
 	{
 		VkResult err;
 
-		// Create separate command buffer for offscreen 
-		// rendering
-		if (offScreenCmdBuffer == VK_NULL_HANDLE)
+		// Create separate command buffers for offscreen 
+		// rendering, one per swap chain image
+		if (offScreenCmdBuffers.empty())
 		{
+			offScreenCmdBuffers.resize(drawCmdBuffers.size());
 			VkCommandBufferAllocateInfo cmd = vkTools::initializers::commandBufferAllocateInfo(
 				cmdPool,
 				VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-				1);
-			VkResult vkRes = vkAllocateCommandBuffers(device, &cmd, &offScreenCmdBuffer);
+				offScreenCmdBuffers.size());
+			VkResult vkRes = vkAllocateCommandBuffers(device, &cmd, offScreenCmdBuffers.data());
 			assert(!vkRes);
 		}
 
 		VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
 
-		err = vkBeginCommandBuffer(offScreenCmdBuffer, &cmdBufInfo);
-		assert(!err);
+		for (uint32_t i = 0; i < offScreenCmdBuffers.size(); ++i)
+		{
+			err = vkBeginCommandBuffer(offScreenCmdBuffers[i], &cmdBufInfo);
+			assert(!err);
 
-		VkViewport viewport = vkTools::initializers::viewport(
-			(float)offScreenFrameBuf.width,
-			(float)offScreenFrameBuf.height,
-			0.0f,
-			1.0f);
-		vkCmdSetViewport(offScreenCmdBuffer, 0, 1, &viewport);
+			VkViewport viewport = vkTools::initializers::viewport(
+				(float)offScreenFrameBuf.width,
+				(float)offScreenFrameBuf.height,
+				0.0f,
+				1.0f);
+			vkCmdSetViewport(offScreenCmdBuffers[i], 0, 1, &viewport);
 
-		VkRect2D scissor = vkTools::initializers::rect2D(
-			offScreenFrameBuf.width,
-			offScreenFrameBuf.height,
-			0,
-			0);
-		vkCmdSetScissor(offScreenCmdBuffer, 0, 1, &scissor);
+			VkRect2D scissor = vkTools::initializers::rect2D(
+				offScreenFrameBuf.width,
+				offScreenFrameBuf.height,
+				0,
+				0);
+			vkCmdSetScissor(offScreenCmdBuffers[i], 0, 1, &scissor);
 
-		for (uint32_t face = 0; face < 6; ++face)
-		{
-			updateCubeFace(face);
-		}
+			for (uint32_t face = 0; face < 6; ++face)
+			{
+				updateCubeFace(face, offScreenCmdBuffers[i], uniformRing.getDynamicOffset(i));
+			}
 
-		err = vkEndCommandBuffer(offScreenCmdBuffer);
-		assert(!err);
+			err = vkEndCommandBuffer(offScreenCmdBuffers[i]);
+			assert(!err);
+		}
 	}
 
 	void reBuildCommandBuffers()
 	{
+		// Frames may still be in flight
+		vkDeviceWaitIdle(device);
 		if (!checkCommandBuffers())
 		{
 			destroyCommandBuffers();
@@ -628,35 +613,27 @@ public:
 
 			VkDeviceSize offsets[1] = { 0 };
 
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets.scene, 0, NULL);
+			// Each command buffer reads the uniform ring region of it's swap chain image
+			uint32_t dynamicOffset = uniformRing.getDynamicOffset(i);
+			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.scene, 0, 1, &descriptorSets.scene, 1, &dynamicOffset);
 
 			if (displayCubeMap)
 			{
 				vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.cubeMap);
 				vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.skybox.vertices.buf, offsets);
-				vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.skybox.indices.buf, 0, VK_INDEX_TYPE_UINT32);
-				vkCmdDrawIndexed(drawCmdBuffers[i], meshes.skybox.indexCount, 1, 0, 0, 0);
+				vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.skybox.indices.buf, 0, meshes.skybox.indexType);
+				vkMeshLoader::drawMesh(drawCmdBuffers[i], meshes.skybox);
 			}
 			else
 			{
 				vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.scene);
 				vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.scene.vertices.buf, offsets);
-				vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.scene.indices.buf, 0, VK_INDEX_TYPE_UINT32);
-				vkCmdDrawIndexed(drawCmdBuffers[i], meshes.scene.indexCount, 1, 0, 0, 0);
+				vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.scene.indices.buf, 0, meshes.scene.indexType);
+				vkMeshLoader::drawMesh(drawCmdBuffers[i], meshes.scene);
 			}
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE,
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
-
 			err = vkEndCommandBuffer(drawCmdBuffers[i]);
 			assert(!err);
 		}
@@ -664,46 +641,32 @@ public:
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo =
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
 
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
-
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
-
-		// Gather command buffers to be sumitted to the queue
-		std::vector<VkCommandBuffer> submitCmdBuffers = {
-			offScreenCmdBuffer,
-			drawCmdBuffers[currentBuffer],
-		};
-		
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = submitCmdBuffers.size();
-		submitInfo.pCommandBuffers = submitCmdBuffers.data();
-
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
-
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
+		// The light moves every frame, both passes read it from the uniform
+		// ring region of the acquired image
+		if (!paused)
+		{
+			updateUniformBufferOffscreen();
+			updateUniformBuffers();
+		}
 
-		err = vkQueueWaitIdle(queue);
-		assert(err == VK_SUCCESS);
+		// Submit offscreen rendering before the scene composition and present
+		// Each command buffer is measured by the GPU profiler (if enabled)
+		std::vector<VkCommandBuffer> submitCmdBuffers;
+		profiler.addCommandBuffer(submitCmdBuffers, offScreenCmdBuffers[currentBuffer], "Shadow map");
+		profiler.addCommandBuffer(submitCmdBuffers, drawCmdBuffers[currentBuffer], "Scene");
+		submitFrame(submitCmdBuffers);
 	}
 
 	void loadMeshes()
 	{
+		// Packed normals are optional as vertex input
+		if (!vkMeshLoader::isLayoutSupported(physicalDevice, vertexLayout))
+		{
+			vertexLayout[3] = vkMeshLoader::VERTEX_LAYOUT_NORMAL;
+		}
 		loadMesh("./../data/models/cube.obj", &meshes.skybox, vertexLayout, 2.0f);
 		loadMesh("./../data/models/shadowscene_fire.X", &meshes.scene, vertexLayout, 2.0f);
 	}
@@ -719,35 +682,8 @@ public:
 				VK_VERTEX_INPUT_RATE_VERTEX);
 
 		// Attribute descriptions
-		vertices.attributeDescriptions.resize(4);
-		// Location 0 : Position
-		vertices.attributeDescriptions[0] =
-			vkTools::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				0,
-				VK_FORMAT_R32G32B32_SFLOAT,
-				0);
-		// Location 1 : Texture coordinates
-		vertices.attributeDescriptions[1] =
-			vkTools::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				1,
-				VK_FORMAT_R32G32_SFLOAT,
-				sizeof(float) * 3);
-		// Location 2 : Color
-		vertices.attributeDescriptions[2] =
-			vkTools::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				2,
-				VK_FORMAT_R32G32B32_SFLOAT,
-				sizeof(float) * 5);
-		// Location 3 : Normal
-		vertices.attributeDescriptions[3] =
-			vkTools::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				3,
-				VK_FORMAT_R32G32B32_SFLOAT,
-				sizeof(float) * 8);
+		// Location 0 : Position, 1 : Texture coordinates, 2 : Color, 3 : Normal
+		vertices.attributeDescriptions = vkMeshLoader::getAttributeDescriptions(vertexLayout, VERTEX_BUFFER_BIND_ID);
 
 		vertices.inputState = vkTools::initializers::pipelineVertexInputStateCreateInfo();
 		vertices.inputState.vertexBindingDescriptionCount = vertices.bindingDescriptions.size();
@@ -761,7 +697,7 @@ public:
 		// Example uses three ubos and two image samplers
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3),
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 3),
 			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2)
 		};
 
@@ -782,7 +718,7 @@ public:
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_VERTEX_BIT,
 				0),
 			// Binding 1 : Fragment shader image sampler (cube map)
@@ -846,14 +782,16 @@ public:
 				shadowCubeMap.view,
 				VK_IMAGE_LAYOUT_GENERAL);
 
+		VkDescriptorBufferInfo sceneDescriptor = uniformRing.getDescriptor(uniformOffsets.scene, sizeof(uboVSscene));
+
 		std::vector<VkWriteDescriptorSet> sceneDescriptorSets =
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 			descriptorSets.scene,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.scene.descriptor),
+				&sceneDescriptor),
 			// Binding 1 : Fragment shader shadow sampler
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.scene,
@@ -867,14 +805,16 @@ public:
 		vkRes = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSets.offscreen);
 		assert(!vkRes);
 
+		VkDescriptorBufferInfo offscreenDescriptor = uniformRing.getDescriptor(uniformOffsets.offscreen, sizeof(uboOffscreenVS));
+
 		std::vector<VkWriteDescriptorSet> offScreenWriteDescriptorSets =
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.offscreen,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.offscreen.descriptor),
+				&offscreenDescriptor),
 		};
 		vkUpdateDescriptorSets(device, offScreenWriteDescriptorSets.size(), offScreenWriteDescriptorSets.data(), 0, NULL);
 	}
@@ -992,22 +932,10 @@ public:
 	void prepareUniformBuffers()
 	{
 		// Offscreen vertex shader uniform buffer block 
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboOffscreenVS),
-			&uboOffscreenVS,
-			&uniformData.offscreen.buffer,
-			&uniformData.offscreen.memory,
-			&uniformData.offscreen.descriptor);
+		uniformOffsets.offscreen = uniformRing.allocate(sizeof(uboOffscreenVS));
 
 		// 3D scene
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboVSscene),
-			&uboVSscene,
-			&uniformData.scene.buffer,
-			&uniformData.scene.memory,
-			&uniformData.scene.descriptor);
+		uniformOffsets.scene = uniformRing.allocate(sizeof(uboVSscene));
 
 		updateUniformBufferOffscreen();
 		updateUniformBuffers();
@@ -1026,11 +954,7 @@ public:
 
 		uboVSscene.lightPos = lightPos;
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.scene.memory, 0, sizeof(uboVSscene), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboVSscene, sizeof(uboVSscene));
-		vkUnmapMemory(device, uniformData.scene.memory);
+		uniformRing.update(uniformOffsets.scene, &uboVSscene, sizeof(uboVSscene));
 	}
 
 	void updateUniformBufferOffscreen()
@@ -1045,11 +969,7 @@ public:
 
 		uboOffscreenVS.lightPos = lightPos;
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.offscreen.memory, 0, sizeof(uboOffscreenVS), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboOffscreenVS, sizeof(uboOffscreenVS));
-		vkUnmapMemory(device, uniformData.offscreen.memory);
+		uniformRing.update(uniformOffsets.offscreen, &uboOffscreenVS, sizeof(uboOffscreenVS));
 	}
 
 	void prepare()
@@ -1063,9 +983,10 @@ public:
 		preparePipelines();
 		setupDescriptorPool();
 		setupDescriptorSets();
+		offScreenRenderPass = createRenderPass(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
 		prepareOffscreenFramebuffer();
 		buildCommandBuffers();
-		buildOffscreenCommandBuffer();
+		buildOffscreenCommandBuffers();
 		prepared = true;
 	}
 
@@ -1073,14 +994,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
-		if (!paused)
-		{
-			updateUniformBufferOffscreen();
-			updateUniformBuffers();
-		}
 	}
 
 	virtual void viewChanged()
@@ -1135,6 +1049,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
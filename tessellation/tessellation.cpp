@@ -44,7 +44,11 @@ public:
 		vkMeshLoader::MeshBuffer object;
 	} meshes;
 	
-	vkTools::UniformData uniformDataTC, uniformDataTE;
+	// Offsets of the uniform blocks inside the base class uniform ring
+	struct {
+		VkDeviceSize tessControl;
+		VkDeviceSize tessEval;
+	} uniformOffsets;
 
 	struct {
 		float tessLevel = 4.0f;
@@ -90,17 +94,13 @@ public:
 
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.object);
 
-		vkDestroyBuffer(device, uniformDataTC.buffer, nullptr);
-		vkFreeMemory(device, uniformDataTC.memory, nullptr);
-
-		vkDestroyBuffer(device, uniformDataTE.buffer, nullptr);
-		vkFreeMemory(device, uniformDataTE.memory, nullptr);
-
 		textureLoader->destroyTexture(textures.colorMap);
 	}
 
 	void reBuildCommandBuffers()
 	{
+		// Frames may still be in flight
+		vkDeviceWaitIdle(device);
 		if (!checkCommandBuffers())
 		{
 			destroyCommandBuffers();
@@ -156,36 +156,29 @@ public:
 
 			vkCmdSetLineWidth(drawCmdBuffers[i], 1.0f);
 
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
+			// Each command buffer reads the uniform ring region of it's swap chain image
+			// One dynamic offset per uniform buffer binding of the set
+			uint32_t dynamicOffsets[2] = { uniformRing.getDynamicOffset(i), uniformRing.getDynamicOffset(i) };
+			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 2, dynamicOffsets);
 
 			VkDeviceSize offsets[1] = { 0 };
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.object.vertices.buf, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.object.indices.buf, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.object.indices.buf, 0, meshes.object.indexType);
 
 			if (splitScreen)
 			{
 				vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
 				vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, *pipelineLeft);
-				vkCmdDrawIndexed(drawCmdBuffers[i], meshes.object.indexCount, 1, 0, 0, 0);
+				vkMeshLoader::drawMesh(drawCmdBuffers[i], meshes.object);
 				viewport.x = float(width) / 2;
 			}
 
 			vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, *pipelineRight);
-			vkCmdDrawIndexed(drawCmdBuffers[i], meshes.object.indexCount, 1, 0, 0, 0);
+			vkMeshLoader::drawMesh(drawCmdBuffers[i], meshes.object);
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE,
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
-
 			err = vkEndCommandBuffer(drawCmdBuffers[i]);
 			assert(!err);
 		}
@@ -193,35 +186,11 @@ public:
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo =
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
-
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
-
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
-
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
 
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
-
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
-
-		err = vkQueueWaitIdle(queue);
-		assert(!err);
+		// Submit the image's draw command buffer and present it
+		submitFrame();
 	}
 
 	void loadMeshes()
@@ -287,7 +256,7 @@ public:
 		// Example uses two ubos and one combined image sampler
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2),
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2),
 			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1),
 		};
 
@@ -307,12 +276,12 @@ public:
 		{
 			// Binding 0 : Tessellation control shader ubo
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
 				0),
 			// Binding 1 : Tessellation evaluation shader ubo
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
 				1),
 			// Binding 2 : Fragment shader combined sampler
@@ -356,20 +325,23 @@ public:
 				textures.colorMap.view,
 				VK_IMAGE_LAYOUT_GENERAL);
 
+		VkDescriptorBufferInfo tessControlDescriptor = uniformRing.getDescriptor(uniformOffsets.tessControl, sizeof(uboTC));
+		VkDescriptorBufferInfo tessEvalDescriptor = uniformRing.getDescriptor(uniformOffsets.tessEval, sizeof(uboTE));
+
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets =
 		{
 			// Binding 0 : Tessellation control shader ubo
 			vkTools::initializers::writeDescriptorSet(
 			descriptorSet,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformDataTC.descriptor),
+				&tessControlDescriptor),
 			// Binding 1 : Tessellation evaluation shader ubo
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				1,
-				&uniformDataTE.descriptor),
+				&tessEvalDescriptor),
 			// Binding 2 : Color map 
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
@@ -503,22 +475,10 @@ public:
 	void prepareUniformBuffers()
 	{
 		// Tessellation evaluation shader uniform buffer
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboTE),
-			&uboTE,
-			&uniformDataTE.buffer,
-			&uniformDataTE.memory,
-			&uniformDataTE.descriptor);
+		uniformOffsets.tessEval = uniformRing.allocate(sizeof(uboTE));
 
 		// Tessellation control shader uniform buffer
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboTC),
-			&uboTC,
-			&uniformDataTC.buffer,
-			&uniformDataTC.memory,
-			&uniformDataTC.descriptor);
+		uniformOffsets.tessControl = uniformRing.allocate(sizeof(uboTC));
 
 		updateUniformBuffers();
 	}
@@ -538,17 +498,10 @@ public:
 		uboTE.model = glm::rotate(uboTE.model, deg_to_rad(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
 		uboTE.model = glm::rotate(uboTE.model, deg_to_rad(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformDataTE.memory, 0, sizeof(uboTE), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboTE, sizeof(uboTE));
-		vkUnmapMemory(device, uniformDataTE.memory);
+		uniformRing.update(uniformOffsets.tessEval, &uboTE, sizeof(uboTE));
 
 		// Tessellation control
-		err = vkMapMemory(device, uniformDataTC.memory, 0, sizeof(uboTC), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboTC, sizeof(uboTC));
-		vkUnmapMemory(device, uniformDataTC.memory);
+		uniformRing.update(uniformOffsets.tessControl, &uboTC, sizeof(uboTC));
 	}
 
 	void prepare()
@@ -570,9 +523,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
 	}
 
 	virtual void viewChanged()
@@ -661,6 +612,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
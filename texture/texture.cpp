@@ -40,9 +40,14 @@ public:
 		uint32_t mipLevels;
 	} texture;
 
+	// Stream the texture's mip levels in over several frames instead ("-streaming")
+	// The texture is drawn with it's smallest levels first, larger ones follow as they are uploaded
+	bool streaming = false;
+	vkTools::StreamingTexture *streamedTexture = nullptr;
+
 	struct {
 		VkBuffer buf;
-		VkDeviceMemory mem;
+		vkTools::Allocation allocation;
 		VkPipelineVertexInputStateCreateInfo inputState;
 		std::vector<VkVertexInputBindingDescription> bindingDescriptions;
 		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
@@ -51,10 +56,11 @@ public:
 	struct {
 		int count;
 		VkBuffer buf;
-		VkDeviceMemory mem;
+		vkTools::Allocation allocation;
 	} indices;
 
-	vkTools::UniformData uniformDataVS;
+	// Offset of the vertex shader uniform block inside the base class uniform ring
+	VkDeviceSize uniformOffsetVS;
 
 	struct {
 		glm::mat4 projection;
@@ -67,14 +73,25 @@ public:
 	} pipelines;
 
 	VkPipelineLayout pipelineLayout;
-	VkDescriptorSet descriptorSet;
 	VkDescriptorSetLayout descriptorSetLayout;
+	// One descriptor set per draw command buffer, so the texture descriptor of an image's
+	// set can be updated while the command buffers of the other images are still pending
+	std::vector<VkDescriptorSet> descriptorSets;
+	// Version of the streamed texture each set was last written with
+	std::vector<uint32_t> descriptorVersions;
 
 	VulkanExample() : VulkanExampleBase(ENABLE_VALIDATION)
 	{
 		zoom = -2.5f;
 		rotation = { 45.0f, 0.0f, 0.0f };
 		title = "Vulkan Example - Texturing";
+		for (size_t i = 0; i < args.size(); i++)
+		{
+			if (args[i] == std::string("-streaming"))
+			{
+				streaming = true;
+			}
+		}
 	}
 
 	~VulkanExample()
@@ -83,10 +100,17 @@ public:
 		// Note : Inherited destructor cleans up resources stored in base class
 
 		// Clean up texture resources
-		vkDestroyImageView(device, texture.view, nullptr);
-		vkDestroyImage(device, texture.image, nullptr);
-		vkDestroySampler(device, texture.sampler, nullptr);
-		vkFreeMemory(device, texture.deviceMemory, nullptr);
+		if (streaming)
+		{
+			textureStreamer.release(streamedTexture);
+		}
+		else
+		{
+			vkDestroyImageView(device, texture.view, nullptr);
+			vkDestroyImage(device, texture.image, nullptr);
+			vkDestroySampler(device, texture.sampler, nullptr);
+			vkFreeMemory(device, texture.deviceMemory, nullptr);
+		}
 
 		vkDestroyPipeline(device, pipelines.solid, nullptr);
 
@@ -94,28 +118,33 @@ public:
 		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 
 		vkDestroyBuffer(device, vertices.buf, nullptr);
-		vkFreeMemory(device, vertices.mem, nullptr);
+		memoryAllocator.free(vertices.allocation);
 
 		vkDestroyBuffer(device, indices.buf, nullptr);
-		vkFreeMemory(device, indices.mem, nullptr);
-
-		vkDestroyBuffer(device, uniformDataVS.buffer, nullptr);
-		vkFreeMemory(device, uniformDataVS.memory, nullptr);
+		memoryAllocator.free(indices.allocation);
 	}
 
 	// Create an image memory barrier for changing the layout of
 	// an image and put it into an active command buffer
 	void setImageLayout(VkImage image, VkImageAspectFlags aspectMask, VkImageLayout oldImageLayout, VkImageLayout newImageLayout)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = aspectMask;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = 1;
+		subresourceRange.layerCount = 1;
+		setImageLayout(image, oldImageLayout, newImageLayout, subresourceRange);
+	}
+
+	// Same as above, but for a range of mip levels and array layers
+	void setImageLayout(VkImage image, VkImageLayout oldImageLayout, VkImageLayout newImageLayout, VkImageSubresourceRange subresourceRange)
 	{
 		// Create an image barrier object
 		VkImageMemoryBarrier imageMemoryBarrier = vkTools::initializers::imageMemoryBarrier();;
 		imageMemoryBarrier.oldLayout = oldImageLayout;
 		imageMemoryBarrier.newLayout = newImageLayout;
 		imageMemoryBarrier.image = image;
-		imageMemoryBarrier.subresourceRange.aspectMask = aspectMask;
-		imageMemoryBarrier.subresourceRange.baseMipLevel = 0;
-		imageMemoryBarrier.subresourceRange.levelCount = 1;
-		imageMemoryBarrier.subresourceRange.layerCount = 1;
+		imageMemoryBarrier.subresourceRange = subresourceRange;
 
 		// Only sets masks for layouts used in this example
 		// For a more complete version that can be used with
@@ -206,56 +235,53 @@ public:
 
 		if (useStaging)
 		{
-			// Load all available mip levels into linear textures
-			// and copy to optimal tiling target
-			struct MipLevel {
-				VkImage image;
-				VkDeviceMemory memory;
-			};
-			std::vector<MipLevel> mipLevels;
-			mipLevels.resize(texture.mipLevels);
-
-			// Copy mip levels
+			// Copy all available mip levels into a single host visible staging buffer
+			// and copy them to the optimal tiled image in one command
+			std::vector<VkBufferImageCopy> bufferCopyRegions(texture.mipLevels);
+			VkDeviceSize stagingSize = 0;
 			for (uint32_t level = 0; level < texture.mipLevels; ++level)
 			{
-				imageCreateInfo.extent.width = tex2D[level].dimensions().x;
-				imageCreateInfo.extent.height = tex2D[level].dimensions().y;
-				imageCreateInfo.extent.depth = 1;
-
-				err = vkCreateImage(device, &imageCreateInfo, nullptr, &mipLevels[level].image);
-				assert(!err);
-
-				vkGetImageMemoryRequirements(device, mipLevels[level].image, &memReqs);
-				memAllocInfo.allocationSize = memReqs.size;
-				getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &memAllocInfo.memoryTypeIndex);
-				err = vkAllocateMemory(device, &memAllocInfo, nullptr, &mipLevels[level].memory);
-				assert(!err);
-				err = vkBindImageMemory(device, mipLevels[level].image, mipLevels[level].memory, 0);
-				assert(!err);
-
-				VkImageSubresource subRes = {};
-				subRes.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-
-				VkSubresourceLayout subResLayout;
-				void *data;
-
-				vkGetImageSubresourceLayout(device, mipLevels[level].image, &subRes, &subResLayout);
-				assert(!err);
-				err = vkMapMemory(device, mipLevels[level].memory, 0, memReqs.size, 0, &data);
-				assert(!err);
-				memcpy(data, tex2D[level].data(), tex2D[level].size());
-				vkUnmapMemory(device, mipLevels[level].memory);
-
-				// Image barrier for linear image (base)
-				// Linear image will be used as a source for the copy
-				setImageLayout(
-					mipLevels[level].image,
-					VK_IMAGE_ASPECT_COLOR_BIT,
-					VK_IMAGE_LAYOUT_UNDEFINED,
-					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+				VkBufferImageCopy &copyRegion = bufferCopyRegions[level];
+				copyRegion = {};
+				// Offset of the level in the staging buffer
+				copyRegion.bufferOffset = stagingSize;
+				copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				// Set mip level to copy the buffer data to
+				copyRegion.imageSubresource.mipLevel = level;
+				copyRegion.imageSubresource.baseArrayLayer = 0;
+				copyRegion.imageSubresource.layerCount = 1;
+				copyRegion.imageExtent.width = tex2D[level].dimensions().x;
+				copyRegion.imageExtent.height = tex2D[level].dimensions().y;
+				copyRegion.imageExtent.depth = 1;
+				// Buffer offsets must be a multiple of the texel (block) size
+				stagingSize += (tex2D[level].size() + 15) & ~(VkDeviceSize)15;
 			}
 
-			// Setup texture as blit target with optimal tiling
+			VkBuffer stagingBuffer;
+			VkDeviceMemory stagingMemory;
+
+			VkBufferCreateInfo bufferCreateInfo = vkTools::initializers::bufferCreateInfo(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingSize);
+			err = vkCreateBuffer(device, &bufferCreateInfo, nullptr, &stagingBuffer);
+			assert(!err);
+
+			vkGetBufferMemoryRequirements(device, stagingBuffer, &memReqs);
+			memAllocInfo.allocationSize = memReqs.size;
+			getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &memAllocInfo.memoryTypeIndex);
+			err = vkAllocateMemory(device, &memAllocInfo, nullptr, &stagingMemory);
+			assert(!err);
+			err = vkBindBufferMemory(device, stagingBuffer, stagingMemory, 0);
+			assert(!err);
+
+			uint8_t *data;
+			err = vkMapMemory(device, stagingMemory, 0, memReqs.size, 0, (void **)&data);
+			assert(!err);
+			for (uint32_t level = 0; level < texture.mipLevels; ++level)
+			{
+				memcpy(data + bufferCopyRegions[level].bufferOffset, tex2D[level].data(), tex2D[level].size());
+			}
+			vkUnmapMemory(device, stagingMemory);
+
+			// Setup texture as copy target with optimal tiling
 			imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 			imageCreateInfo.mipLevels = texture.mipLevels;
@@ -274,64 +300,44 @@ public:
 			err = vkBindImageMemory(device, texture.image, texture.deviceMemory, 0);
 			assert(!err);
 
+			// All mip levels are transitioned and copied at once
+			VkImageSubresourceRange subresourceRange = {};
+			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			subresourceRange.baseMipLevel = 0;
+			subresourceRange.levelCount = texture.mipLevels;
+			subresourceRange.layerCount = 1;
+
 			// Image barrier for optimal image (target)
 			// Optimal image will be used as destination for the copy
 			setImageLayout(
 				texture.image,
-				VK_IMAGE_ASPECT_COLOR_BIT,
 				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				subresourceRange);
 
-			// Copy mip levels one by one
-			for (uint32_t level = 0; level < texture.mipLevels; ++level)
-			{
-				// Copy region for image blit
-				VkImageCopy copyRegion = {};
-
-				copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				copyRegion.srcSubresource.baseArrayLayer = 0;
-				copyRegion.srcSubresource.mipLevel = 0;
-				copyRegion.srcSubresource.layerCount = 1;
-				copyRegion.srcOffset = { 0, 0, 0 };
-
-				copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				copyRegion.dstSubresource.baseArrayLayer = 0;
-				// Set mip level to copy the linear image to
-				copyRegion.dstSubresource.mipLevel = level;
-				copyRegion.dstSubresource.layerCount = 1;
-				copyRegion.dstOffset = { 0, 0, 0 };
-
-				copyRegion.extent.width = tex2D[level].dimensions().x;
-				copyRegion.extent.height = tex2D[level].dimensions().y;
-				copyRegion.extent.depth = 1;
-
-				// Put image copy into command buffer
-				vkCmdCopyImage(
-					setupCmdBuffer,
-					mipLevels[level].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-					texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					1, &copyRegion);
-
-				// Change texture image layout to shader read after the copy
-				texture.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				setImageLayout(
-					texture.image,
-					VK_IMAGE_ASPECT_COLOR_BIT,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					texture.imageLayout);
-			}
+			// Copy mip levels from staging buffer
+			vkCmdCopyBufferToImage(
+				setupCmdBuffer,
+				stagingBuffer,
+				texture.image,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				(uint32_t)bufferCopyRegions.size(),
+				bufferCopyRegions.data());
+
+			// Change texture image layout to shader read after all mip levels have been copied
+			texture.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			setImageLayout(
+				texture.image,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				texture.imageLayout,
+				subresourceRange);
 
 			flushSetupCommandBuffer();
 			createSetupCommandBuffer();
 
-			// Clean up linear images 
-			// No longer required after mip levels
-			// have been transformed over to optimal tiling
-			for (auto& level : mipLevels)
-			{
-				vkDestroyImage(device, level.image, nullptr);
-				vkFreeMemory(device, level.memory, nullptr);
-			}
+			// Clean up staging resources
+			vkFreeMemory(device, stagingMemory, nullptr);
+			vkDestroyBuffer(device, stagingBuffer, nullptr);
 		}
 		else
 		{
@@ -450,6 +456,14 @@ public:
 	}
 
 	void buildCommandBuffers()
+	{
+		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i)
+		{
+			buildCommandBuffer(i);
+		}
+	}
+
+	void buildCommandBuffer(int32_t i)
 	{
 		VkCommandBufferBeginInfo cmdBufInfo = vkTools::initializers::commandBufferBeginInfo();
 
@@ -468,89 +482,65 @@ public:
 
 		VkResult err;
 
-		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i)
-		{
-			// Set target frame buffer
-			renderPassBeginInfo.framebuffer = frameBuffers[i];
-
-			err = vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo);
-			assert(!err);
+		// Set target frame buffer
+		renderPassBeginInfo.framebuffer = frameBuffers[i];
 
-			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		err = vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo);
+		assert(!err);
 
-			VkViewport viewport = vkTools::initializers::viewport(
-				(float)width,
-				(float)height,
-				0.0f,
-				1.0f);
-			vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
+		vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-			VkRect2D scissor = vkTools::initializers::rect2D(
-				width,
-				height,
-				0,
-				0);
-			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
+		VkViewport viewport = vkTools::initializers::viewport(
+			(float)width,
+			(float)height,
+			0.0f,
+			1.0f);
+		vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
 
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
-			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.solid);
+		VkRect2D scissor = vkTools::initializers::rect2D(
+			width,
+			height,
+			0,
+			0);
+		vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
 
-			VkDeviceSize offsets[1] = { 0 };
-			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &vertices.buf, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], indices.buf, 0, VK_INDEX_TYPE_UINT32);
+		// Each command buffer reads the uniform ring region of it's swap chain image
+		uint32_t dynamicOffset = uniformRing.getDynamicOffset(i);
+		vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[i], 1, &dynamicOffset);
+		vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.solid);
 
-			vkCmdDrawIndexed(drawCmdBuffers[i], indices.count, 1, 0, 0, 0);
+		VkDeviceSize offsets[1] = { 0 };
+		vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &vertices.buf, offsets);
+		vkCmdBindIndexBuffer(drawCmdBuffers[i], indices.buf, 0, VK_INDEX_TYPE_UINT32);
 
-			vkCmdEndRenderPass(drawCmdBuffers[i]);
+		vkCmdDrawIndexed(drawCmdBuffers[i], indices.count, 1, 0, 0, 0);
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE,
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
+		vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			err = vkEndCommandBuffer(drawCmdBuffers[i]);
-			assert(!err);
-		}
+		err = vkEndCommandBuffer(drawCmdBuffers[i]);
+		assert(!err);
 	}
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo = 
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
-
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
-
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
 
-		// Submit draw command buffer
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
-
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
+		// More mip levels of the streamed texture have been uploaded since the image's set was written
+		// The image's command buffer is no longer pending, so it's set can be updated and the
+		// command buffer rebuilt
+		if (streaming && (descriptorVersions[currentBuffer] != streamedTexture->version))
+		{
+			updateTextureDescriptor(currentBuffer);
+			buildCommandBuffer(currentBuffer);
+			if (streamedTexture->isComplete() && (streamedTexture->version == descriptorVersions[currentBuffer]))
+			{
+				std::cout << "Streamed texture: " << streamedTexture->mipLevels << " mip levels resident after " << frameCounter << " frames" << std::endl;
+			}
+		}
 
-		err = vkQueueWaitIdle(queue);
-		assert(!err);
+		// Submit the image's draw command buffer and present it
+		submitFrame();
 	}
 
 	void generateQuad()
@@ -570,7 +560,7 @@ public:
 			vertexBuffer.size() * sizeof(Vertex),
 			vertexBuffer.data(),
 			&vertices.buf,
-			&vertices.mem);
+			&vertices.allocation);
 
 		// Setup indices
 		std::vector<uint32_t> indexBuffer = { 0,1,2, 2,3,0 };
@@ -581,7 +571,7 @@ public:
 			indexBuffer.size() * sizeof(uint32_t),
 			indexBuffer.data(),
 			&indices.buf,
-			&indices.mem);
+			&indices.allocation);
 	}
 
 	void setupVertexDescriptions()
@@ -624,15 +614,15 @@ public:
 		// Example uses one ubo and one image sampler
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1),
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, drawCmdBuffers.size()),
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, drawCmdBuffers.size())
 		};
 
 		VkDescriptorPoolCreateInfo descriptorPoolInfo = 
 			vkTools::initializers::descriptorPoolCreateInfo(
 				poolSizes.size(),
 				poolSizes.data(),
-				2);
+				drawCmdBuffers.size());
 
 		VkResult vkRes = vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &descriptorPool);
 		assert(!vkRes);
@@ -644,7 +634,7 @@ public:
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 
 				VK_SHADER_STAGE_VERTEX_BIT, 
 				0),
 			// Binding 1 : Fragment shader image sampler
@@ -673,39 +663,58 @@ public:
 
 	void setupDescriptorSet()
 	{
+		std::vector<VkDescriptorSetLayout> setLayouts(drawCmdBuffers.size(), descriptorSetLayout);
 		VkDescriptorSetAllocateInfo allocInfo = 
 			vkTools::initializers::descriptorSetAllocateInfo(
 				descriptorPool,
-				&descriptorSetLayout,
-				1);
+				setLayouts.data(),
+				setLayouts.size());
 
-		VkResult vkRes = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet);
+		descriptorSets.resize(drawCmdBuffers.size());
+		descriptorVersions.resize(drawCmdBuffers.size());
+		VkResult vkRes = vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data());
 		assert(!vkRes);
 
+		VkDescriptorBufferInfo uniformDescriptor = uniformRing.getDescriptor(uniformOffsetVS, sizeof(uboVS));
+
+		for (uint32_t i = 0; i < descriptorSets.size(); i++)
+		{
+			// Binding 0 : Vertex shader uniform buffer
+			VkWriteDescriptorSet writeDescriptorSet =
+				vkTools::initializers::writeDescriptorSet(
+					descriptorSets[i], 
+					VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 
+					0, 
+					&uniformDescriptor);
+			vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, NULL);
+
+			updateTextureDescriptor(i);
+		}
+	}
+
+	// Write the current texture descriptor into the set of draw command buffer i
+	void updateTextureDescriptor(uint32_t i)
+	{
 		// Image descriptor for the color map texture
 		VkDescriptorImageInfo texDescriptor =
 			vkTools::initializers::descriptorImageInfo(
 				texture.sampler,
 				texture.view,
 				VK_IMAGE_LAYOUT_GENERAL);
-
-		std::vector<VkWriteDescriptorSet> writeDescriptorSets =
+		if (streaming)
 		{
-			// Binding 0 : Vertex shader uniform buffer
-			vkTools::initializers::writeDescriptorSet(
-				descriptorSet, 
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 
-				0, 
-				&uniformDataVS.descriptor),
-			// Binding 1 : Fragment shader texture sampler
+			texDescriptor = streamedTexture->descriptor;
+			descriptorVersions[i] = streamedTexture->version;
+		}
+
+		// Binding 1 : Fragment shader texture sampler
+		VkWriteDescriptorSet writeDescriptorSet =
 			vkTools::initializers::writeDescriptorSet(
-				descriptorSet, 
+				descriptorSets[i], 
 				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 
 				1, 
-				&texDescriptor)
-		};
-
-		vkUpdateDescriptorSets(device, writeDescriptorSets.size(), writeDescriptorSets.data(), 0, NULL);
+				&texDescriptor);
+		vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, NULL);
 	}
 
 	void preparePipelines()
@@ -793,13 +802,7 @@ public:
 	void prepareUniformBuffers()
 	{
 		// Vertex shader uniform buffer block
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboVS),
-			&uboVS,
-			&uniformDataVS.buffer,
-			&uniformDataVS.memory,
-			&uniformDataVS.descriptor);
+		uniformOffsetVS = uniformRing.allocate(sizeof(uboVS));
 
 		updateUniformBuffers();
 	}
@@ -817,11 +820,7 @@ public:
 		uboVS.model = glm::rotate(uboVS.model, deg_to_rad(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
 		uboVS.model = glm::rotate(uboVS.model, deg_to_rad(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformDataVS.memory, 0, sizeof(uboVS), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboVS, sizeof(uboVS));
-		vkUnmapMemory(device, uniformDataVS.memory);
+		uniformRing.update(uniformOffsetVS, &uboVS, sizeof(uboVS));
 	}
 
 	void prepare()
@@ -830,10 +829,18 @@ public:
 		generateQuad();
 		setupVertexDescriptions();
 		prepareUniformBuffers();
-		loadTexture(
-			"./../data/textures/igor_and_pal_bc3.ktx", 
-			VK_FORMAT_BC3_UNORM_BLOCK, 
-			false);
+		if (streaming)
+		{
+			// Returns right away, the texture is sampled from a placeholder until it's smallest levels are resident
+			streamedTexture = textureStreamer.load("./../data/textures/igor_and_pal_bc3.ktx", VK_FORMAT_BC3_UNORM_BLOCK);
+		}
+		else
+		{
+			loadTexture(
+				"./../data/textures/igor_and_pal_bc3.ktx", 
+				VK_FORMAT_BC3_UNORM_BLOCK, 
+				false);
+		}
 		setupDescriptorSetLayout();
 		preparePipelines();
 		setupDescriptorPool();
@@ -846,9 +853,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
 	}
 
 	virtual void viewChanged()
@@ -913,6 +918,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
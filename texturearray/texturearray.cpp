@@ -48,9 +48,9 @@ public:
 		vkMeshLoader::MeshBuffer quad;
 	} meshes;
 
-	struct {
-		vkTools::UniformData vertexShader;
-	} uniformData;
+	// Offset and size of the vertex shader uniform block inside the base class uniform ring
+	VkDeviceSize uniformOffsetVS;
+	uint32_t uboSize;
 
 	struct UboInstanceData {
 		// Model matrix
@@ -96,7 +96,7 @@ public:
 		vkDestroyImageView(device, textureArray.view, nullptr);
 		vkDestroyImage(device, textureArray.image, nullptr);
 		vkDestroySampler(device, textureArray.sampler, nullptr);
-		vkFreeMemory(device, textureArray.deviceMemory, nullptr);
+		memoryAllocator.free(textureArray.allocation);
 
 		vkDestroyPipeline(device, pipelines.solid, nullptr);
 
@@ -105,14 +105,11 @@ public:
 
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.quad);
 
-		vkTools::destroyUniformData(device, &uniformData.vertexShader);
-
 		delete[] uboVS.instance;
 	}
 
 	void loadTextureArray(const char* filename, VkFormat format)
 	{
-		VkFormatProperties formatProperties;
 		VkResult err;
 
 		gli::texture2DArray tex2DArray(gli::load(filename));
@@ -120,34 +117,65 @@ public:
 
 		textureArray.width = tex2DArray.dimensions().x;
 		textureArray.height = tex2DArray.dimensions().y;
+		textureArray.mipLevels = tex2DArray.levels();
 		layerCount = tex2DArray.layers();
 
-		// Get device properites for the requested texture format
-		vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+		// Copy all layers (and their mip levels) into a single host visible staging buffer
+		std::vector<VkBufferImageCopy> bufferCopyRegions;
+		VkDeviceSize stagingSize = 0;
+		for (uint32_t layer = 0; layer < layerCount; ++layer)
+		{
+			for (uint32_t level = 0; level < textureArray.mipLevels; ++level)
+			{
+				VkBufferImageCopy copyRegion = {};
+				copyRegion.bufferOffset = stagingSize;
+				copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				copyRegion.imageSubresource.mipLevel = level;
+				copyRegion.imageSubresource.baseArrayLayer = layer;
+				copyRegion.imageSubresource.layerCount = 1;
+				copyRegion.imageExtent.width = tex2DArray[layer][level].dimensions().x;
+				copyRegion.imageExtent.height = tex2DArray[layer][level].dimensions().y;
+				copyRegion.imageExtent.depth = 1;
+				bufferCopyRegions.push_back(copyRegion);
+				// Buffer offsets must be a multiple of the texel (block) size
+				stagingSize += (tex2DArray[layer][level].size() + 15) & ~(VkDeviceSize)15;
+			}
+		}
+
+		VkBuffer stagingBuffer;
+		VkBufferCreateInfo bufferCreateInfo = vkTools::initializers::bufferCreateInfo(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingSize);
+		err = vkCreateBuffer(device, &bufferCreateInfo, nullptr, &stagingBuffer);
+		assert(!err);
+		vkTools::Allocation stagingMemory = memoryAllocator.allocateBuffer(stagingBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
+		// Staging memory is persistently mapped
+		for (uint32_t layer = 0, region = 0; layer < layerCount; ++layer)
+		{
+			for (uint32_t level = 0; level < textureArray.mipLevels; ++level, ++region)
+			{
+				memcpy((uint8_t*)stagingMemory.mapped + bufferCopyRegions[region].bufferOffset, tex2DArray[layer][level].data(), tex2DArray[layer][level].size());
+			}
+		}
+
+		// Setup texture as copy target with optimal tiling
 		VkImageCreateInfo imageCreateInfo = vkTools::initializers::imageCreateInfo();
 		imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
 		imageCreateInfo.format = format;
 		imageCreateInfo.extent = { textureArray.width, textureArray.height, 1 };
-		imageCreateInfo.mipLevels = 1;
-		imageCreateInfo.arrayLayers = 1;
+		imageCreateInfo.mipLevels = textureArray.mipLevels;
+		imageCreateInfo.arrayLayers = layerCount;
 		imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-		imageCreateInfo.tiling = VK_IMAGE_TILING_LINEAR;
-		imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 		imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 		imageCreateInfo.flags = 0;
 
-		VkMemoryAllocateInfo memAllocInfo = vkTools::initializers::memoryAllocateInfo();
-		VkMemoryRequirements memReqs;
+		err = vkCreateImage(device, &imageCreateInfo, nullptr, &textureArray.image);
+		assert(!err);
 
-		struct Layer {
-			VkImage image;
-			VkDeviceMemory memory;
-		};
-		std::vector<Layer> arrayLayer;
-		arrayLayer.resize(layerCount);
+		textureArray.allocation = memoryAllocator.allocateImage(textureArray.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-		// Allocate command buffer for image copies and layouts
+		// Allocate command buffer for the copy and layouts
 		VkCommandBuffer cmdBuffer;
 		VkCommandBufferAllocateInfo cmdBufAlllocatInfo =
 			vkTools::initializers::commandBufferAllocateInfo(
@@ -163,110 +191,40 @@ public:
 		err = vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo);
 		assert(!err);
 
-		// Load separate cube map faces into linear tiled textures
-		for (uint32_t i = 0; i < layerCount; ++i)
-		{
-			err = vkCreateImage(device, &imageCreateInfo, nullptr, &arrayLayer[i].image);
-			assert(!err);
-
-			vkGetImageMemoryRequirements(device, arrayLayer[i].image, &memReqs);
-			memAllocInfo.allocationSize = memReqs.size;
-			getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &memAllocInfo.memoryTypeIndex);
-			err = vkAllocateMemory(device, &memAllocInfo, nullptr, &arrayLayer[i].memory);
-			assert(!err);
-			err = vkBindImageMemory(device, arrayLayer[i].image, arrayLayer[i].memory, 0);
-			assert(!err);
-
-			VkImageSubresource subRes = {};
-			subRes.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-
-			VkSubresourceLayout subResLayout;
-			void *data;
-
-			vkGetImageSubresourceLayout(device, arrayLayer[i].image, &subRes, &subResLayout);
-			assert(!err);
-			err = vkMapMemory(device, arrayLayer[i].memory, 0, memReqs.size, 0, &data);
-			assert(!err);
-			memcpy(data, tex2DArray[i].data(), tex2DArray[i].size());
-			vkUnmapMemory(device, arrayLayer[i].memory);
-
-			// Image barrier for linear image (base)
-			// Linear image will be used as a source for the copy
-			vkTools::setImageLayout(
-				cmdBuffer,
-				arrayLayer[i].image,
-				VK_IMAGE_ASPECT_COLOR_BIT,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-		}
-
-		// Transfer cube map faces to optimal tiling
-
-		// Setup texture as blit target with optimal tiling
-		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-		imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-		imageCreateInfo.arrayLayers = layerCount;
-
-		err = vkCreateImage(device, &imageCreateInfo, nullptr, &textureArray.image);
-		assert(!err);
-
-		vkGetImageMemoryRequirements(device, textureArray.image, &memReqs);
-
-		memAllocInfo.allocationSize = memReqs.size;
-
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAllocInfo.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAllocInfo, nullptr, &textureArray.deviceMemory);
-		assert(!err);
-		err = vkBindImageMemory(device, textureArray.image, textureArray.deviceMemory, 0);
-		assert(!err);
+		// All layers and mip levels are transitioned and copied at once
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = textureArray.mipLevels;
+		subresourceRange.baseArrayLayer = 0;
+		subresourceRange.layerCount = layerCount;
 
 		// Image barrier for optimal image (target)
 		// Optimal image will be used as destination for the copy
 		vkTools::setImageLayout(
 			cmdBuffer,
 			textureArray.image,
-			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_UNDEFINED,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			subresourceRange);
 
-		// Copy cube map faces one by one
-		for (uint32_t i = 0; i < layerCount; ++i)
-		{
-			// Copy region for image blit
-			VkImageCopy copyRegion = {};
-
-			copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			copyRegion.srcSubresource.baseArrayLayer = 0;
-			copyRegion.srcSubresource.mipLevel = 0;
-			copyRegion.srcSubresource.layerCount = 1;
-			copyRegion.srcOffset = { 0, 0, 0 };
-
-			copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			copyRegion.dstSubresource.baseArrayLayer = i;
-			copyRegion.dstSubresource.mipLevel = 0;
-			copyRegion.dstSubresource.layerCount = 1;
-			copyRegion.dstOffset = { 0, 0, 0 };
-
-			copyRegion.extent.width = textureArray.width;
-			copyRegion.extent.height = textureArray.height;
-			copyRegion.extent.depth = 1;
-
-			// Put image copy into command buffer
-			vkCmdCopyImage(
-				cmdBuffer,
-				arrayLayer[i].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				textureArray.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				1, &copyRegion);
-
-			// Change texture image layout to shader read after the copy
-			textureArray.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			vkTools::setImageLayout(
-				cmdBuffer,
-				textureArray.image,
-				VK_IMAGE_ASPECT_COLOR_BIT,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				textureArray.imageLayout);
-		}
+		// Copy all layers from the staging buffer
+		vkCmdCopyBufferToImage(
+			cmdBuffer,
+			stagingBuffer,
+			textureArray.image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			(uint32_t)bufferCopyRegions.size(),
+			bufferCopyRegions.data());
+
+		// Change texture image layout to shader read after the copy
+		textureArray.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		vkTools::setImageLayout(
+			cmdBuffer,
+			textureArray.image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			textureArray.imageLayout,
+			subresourceRange);
 
 		err = vkEndCommandBuffer(cmdBuffer);
 		assert(!err);
@@ -296,7 +254,7 @@ public:
 		sampler.maxAnisotropy = 8;
 		sampler.compareOp = VK_COMPARE_OP_NEVER;
 		sampler.minLod = 0.0f;
-		sampler.maxLod = 0.0f;
+		sampler.maxLod = (float)textureArray.mipLevels;
 		sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
 		err = vkCreateSampler(device, &sampler, nullptr, &textureArray.sampler);
 		assert(!err);
@@ -308,17 +266,16 @@ public:
 		view.format = format;
 		view.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
 		view.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		view.subresourceRange.levelCount = textureArray.mipLevels;
 		view.subresourceRange.layerCount = layerCount;
 		view.image = textureArray.image;
 		err = vkCreateImageView(device, &view, nullptr, &textureArray.view);
 		assert(!err);
 
 		// Cleanup
-		for (auto& layer : arrayLayer)
-		{
-			vkDestroyImage(device, layer.image, nullptr);
-			vkFreeMemory(device, layer.memory, nullptr);
-		}
+		vkFreeCommandBuffers(device, cmdPool, 1, &cmdBuffer);
+		vkDestroyBuffer(device, stagingBuffer, nullptr);
+		memoryAllocator.free(stagingMemory);
 	}
 
 	void loadTextures()
@@ -369,7 +326,9 @@ public:
 				0);
 			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
 
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
+			// Each command buffer reads the uniform ring region of it's swap chain image
+			uint32_t dynamicOffset = uniformRing.getDynamicOffset(i);
+			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 1, &dynamicOffset);
 
 			VkDeviceSize offsets[1] = { 0 };
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.quad.vertices.buf, offsets);
@@ -380,16 +339,6 @@ public:
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE,
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
-
 			err = vkEndCommandBuffer(drawCmdBuffers[i]);
 			assert(!err);
 		}
@@ -397,37 +346,11 @@ public:
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo =
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
 
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
-
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
-
-		// Submit draw command buffer
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
-
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
-
-		err = vkQueueWaitIdle(queue);
-		assert(!err);
+		// Submit the image's draw command buffer and present it
+		submitFrame();
 	}
 
 	// Setup vertices for a single uv-mapped quad
@@ -448,7 +371,7 @@ public:
 			vertexBuffer.size() * sizeof(Vertex),
 			vertexBuffer.data(),
 			&meshes.quad.vertices.buf,
-			&meshes.quad.vertices.mem);
+			&meshes.quad.vertices.allocation);
 
 		// Setup indices
 		std::vector<uint32_t> indexBuffer = { 0,1,2, 2,3,0 };
@@ -459,7 +382,7 @@ public:
 			indexBuffer.size() * sizeof(uint32_t),
 			indexBuffer.data(),
 			&meshes.quad.indices.buf,
-			&meshes.quad.indices.mem);
+			&meshes.quad.indices.allocation);
 	}
 
 	void setupVertexDescriptions()
@@ -501,7 +424,7 @@ public:
 	{
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1),
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1),
 			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
 		};
 
@@ -521,7 +444,7 @@ public:
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_VERTEX_BIT,
 				0),
 			// Binding 1 : Fragment shader image sampler (texture array)
@@ -566,14 +489,16 @@ public:
 				textureArray.view,
 				VK_IMAGE_LAYOUT_GENERAL);
 
+		VkDescriptorBufferInfo uboDescriptor = uniformRing.getDescriptor(uniformOffsetVS, uboSize);
+
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets =
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.vertexShader.descriptor),
+				&uboDescriptor),
 			// Binding 1 : Fragment shader cubemap sampler
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
@@ -671,17 +596,9 @@ public:
 	{
 		uboVS.instance = new UboInstanceData[layerCount];
 
-		VkResult err;
-		uint32_t uboSize = sizeof(uboVS.matrices) + (layerCount * sizeof(UboInstanceData));
-
 		// Vertex shader uniform buffer block
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			uboSize,
-			&uboVS,
-			&uniformData.vertexShader.buffer,
-			&uniformData.vertexShader.memory,
-			&uniformData.vertexShader.descriptor);
+		uboSize = sizeof(uboVS.matrices) + (layerCount * sizeof(UboInstanceData));
+		uniformOffsetVS = uniformRing.allocate(uboSize);
 
 		// Array indices and model matrices are fixed
 		float offset = -1.5f;
@@ -697,13 +614,9 @@ public:
 		}
 
 		// Update instanced part of the uniform buffer
-		uint8_t *pData;
 		uint32_t dataOffset = sizeof(uboVS.matrices);
 		uint32_t dataSize = layerCount * sizeof(UboInstanceData);
-		err = vkMapMemory(device, uniformData.vertexShader.memory, dataOffset, dataSize, 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, uboVS.instance, dataSize);
-		vkUnmapMemory(device, uniformData.vertexShader.memory);
+		uniformRing.update(uniformOffsetVS + dataOffset, uboVS.instance, dataSize);
 
 		updateUniformBufferMatrices();
 	}
@@ -722,11 +635,7 @@ public:
 		uboVS.matrices.view = glm::rotate(uboVS.matrices.view, deg_to_rad(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
 		// Only update the matrices part of the uniform buffer
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.vertexShader.memory, 0, sizeof(uboVS.matrices), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboVS.matrices, sizeof(uboVS.matrices));
-		vkUnmapMemory(device, uniformData.vertexShader.memory);
+		uniformRing.update(uniformOffsetVS, &uboVS.matrices, sizeof(uboVS.matrices));
 	}
 
 	void prepare()
@@ -748,9 +657,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
 	}
 
 	virtual void viewChanged()
@@ -789,6 +696,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
@@ -42,10 +42,11 @@ public:
 		vkMeshLoader::MeshBuffer skybox, object;
 	} meshes;
 
+	// Offsets of the uniform blocks inside the base class uniform ring
 	struct {
-		vkTools::UniformData objectVS;
-		vkTools::UniformData skyboxVS;
-	} uniformData;
+		VkDeviceSize objectVS;
+		VkDeviceSize skyboxVS;
+	} uniformOffsets;
 
 	struct {
 		glm::mat4 projection;
@@ -82,7 +83,7 @@ public:
 		vkDestroyImageView(device, cubeMap.view, nullptr);
 		vkDestroyImage(device, cubeMap.image, nullptr);
 		vkDestroySampler(device, cubeMap.sampler, nullptr);
-		vkFreeMemory(device, cubeMap.deviceMemory, nullptr);
+		memoryAllocator.free(cubeMap.allocation);
 
 		vkDestroyPipeline(device, pipelines.skybox, nullptr);
 		vkDestroyPipeline(device, pipelines.reflect, nullptr);
@@ -92,14 +93,10 @@ public:
 
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.object);
 		vkMeshLoader::freeMeshBufferResources(device, &meshes.skybox);
-
-		vkTools::destroyUniformData(device, &uniformData.objectVS);
-		vkTools::destroyUniformData(device, &uniformData.skyboxVS);
 	}
 
 	void loadTexture(const char* filename, VkFormat format, bool forceLinearTiling)
 	{
-		VkFormatProperties formatProperties;
 		VkResult err;
 
 		gli::textureCube texCube(gli::load(filename));
@@ -107,31 +104,66 @@ public:
 
 		cubeMap.width = texCube[0].dimensions().x;
 		cubeMap.height = texCube[0].dimensions().y;
+		cubeMap.mipLevels = texCube.levels();
+
+		// Copy all faces (and their mip levels) into a single host visible staging buffer
+		std::vector<VkBufferImageCopy> bufferCopyRegions;
+		VkDeviceSize stagingSize = 0;
+		for (uint32_t face = 0; face < 6; ++face)
+		{
+			for (uint32_t level = 0; level < cubeMap.mipLevels; ++level)
+			{
+				VkBufferImageCopy copyRegion = {};
+				copyRegion.bufferOffset = stagingSize;
+				copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				copyRegion.imageSubresource.mipLevel = level;
+				copyRegion.imageSubresource.baseArrayLayer = face;
+				copyRegion.imageSubresource.layerCount = 1;
+				copyRegion.imageExtent.width = texCube[face][level].dimensions().x;
+				copyRegion.imageExtent.height = texCube[face][level].dimensions().y;
+				copyRegion.imageExtent.depth = 1;
+				bufferCopyRegions.push_back(copyRegion);
+				// Buffer offsets must be a multiple of the texel (block) size
+				stagingSize += (texCube[face][level].size() + 15) & ~(VkDeviceSize)15;
+			}
+		}
 
-		// Get device properites for the requested texture format
-		vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+		VkBuffer stagingBuffer;
+		VkBufferCreateInfo bufferCreateInfo = vkTools::initializers::bufferCreateInfo(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingSize);
+		err = vkCreateBuffer(device, &bufferCreateInfo, nullptr, &stagingBuffer);
+		assert(!err);
+		vkTools::Allocation stagingMemory = memoryAllocator.allocateBuffer(stagingBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
+		// Staging memory is persistently mapped
+		for (uint32_t face = 0, region = 0; face < 6; ++face)
+		{
+			for (uint32_t level = 0; level < cubeMap.mipLevels; ++level, ++region)
+			{
+				memcpy((uint8_t*)stagingMemory.mapped + bufferCopyRegions[region].bufferOffset, texCube[face][level].data(), texCube[face][level].size());
+			}
+		}
+
+		// Setup texture as copy target with optimal tiling
 		VkImageCreateInfo imageCreateInfo = vkTools::initializers::imageCreateInfo();
 		imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
 		imageCreateInfo.format = format;
 		imageCreateInfo.extent = { cubeMap.width, cubeMap.height, 1 };
-		imageCreateInfo.mipLevels = 1;
-		imageCreateInfo.arrayLayers = 1;
+		imageCreateInfo.mipLevels = cubeMap.mipLevels;
 		imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-		imageCreateInfo.tiling = VK_IMAGE_TILING_LINEAR;
-		imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 		imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-		imageCreateInfo.flags = 0;
+		// Cube faces count as array layers in Vulkan
+		imageCreateInfo.arrayLayers = 6;
+		// This flag is required for cube map images
+		imageCreateInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
 
-		VkMemoryAllocateInfo memAllocInfo = vkTools::initializers::memoryAllocateInfo();
-		VkMemoryRequirements memReqs;
+		err = vkCreateImage(device, &imageCreateInfo, nullptr, &cubeMap.image);
+		assert(!err);
 
-		struct {
-			VkImage image;
-			VkDeviceMemory memory;
-		} cubeFace[6];
+		cubeMap.allocation = memoryAllocator.allocateImage(cubeMap.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-		// Allocate command buffer for image copies and layouts
+		// Allocate command buffer for the copy and layouts
 		VkCommandBuffer cmdBuffer;
 		VkCommandBufferAllocateInfo cmdBufAlllocatInfo =
 			vkTools::initializers::commandBufferAllocateInfo(
@@ -147,111 +179,40 @@ public:
 		err = vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo);
 		assert(!err);
 
-		// Load separate cube map faces into linear tiled textures
-		for (uint32_t face = 0; face < 6; ++face)
-		{
-			err = vkCreateImage(device, &imageCreateInfo, nullptr, &cubeFace[face].image);
-			assert(!err);
-
-			vkGetImageMemoryRequirements(device, cubeFace[face].image, &memReqs);
-			memAllocInfo.allocationSize = memReqs.size;
-			getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &memAllocInfo.memoryTypeIndex);
-			err = vkAllocateMemory(device, &memAllocInfo, nullptr, &cubeFace[face].memory);
-			assert(!err);
-			err = vkBindImageMemory(device, cubeFace[face].image, cubeFace[face].memory, 0);
-			assert(!err);
-
-			VkImageSubresource subRes = {};
-			subRes.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-
-			VkSubresourceLayout subResLayout;
-			void *data;
-
-			vkGetImageSubresourceLayout(device, cubeFace[face].image, &subRes, &subResLayout);
-			assert(!err);
-			err = vkMapMemory(device, cubeFace[face].memory, 0, memReqs.size, 0, &data);
-			assert(!err);
-			memcpy(data, texCube[face][subRes.mipLevel].data(), texCube[face][subRes.mipLevel].size());
-			vkUnmapMemory(device, cubeFace[face].memory);
-
-			// Image barrier for linear image (base)
-			// Linear image will be used as a source for the copy
-			vkTools::setImageLayout(
-				cmdBuffer,
-				cubeFace[face].image,
-				VK_IMAGE_ASPECT_COLOR_BIT,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-		}
-		
-		// Transfer cube map faces to optimal tiling
-
-		// Setup texture as blit target with optimal tiling
-		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-		imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-		imageCreateInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
-		imageCreateInfo.arrayLayers = 6;
-
-		err = vkCreateImage(device, &imageCreateInfo, nullptr, &cubeMap.image);
-		assert(!err);
-
-		vkGetImageMemoryRequirements(device, cubeMap.image, &memReqs);
-
-		memAllocInfo.allocationSize = memReqs.size;
-
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAllocInfo.memoryTypeIndex);
-		err = vkAllocateMemory(device, &memAllocInfo, nullptr, &cubeMap.deviceMemory);
-		assert(!err);
-		err = vkBindImageMemory(device, cubeMap.image, cubeMap.deviceMemory, 0);
-		assert(!err);
+		// All faces and mip levels are transitioned and copied at once
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = cubeMap.mipLevels;
+		subresourceRange.baseArrayLayer = 0;
+		subresourceRange.layerCount = 6;
 
 		// Image barrier for optimal image (target)
 		// Optimal image will be used as destination for the copy
 		vkTools::setImageLayout(
 			cmdBuffer,
 			cubeMap.image,
-			VK_IMAGE_ASPECT_COLOR_BIT,
 			VK_IMAGE_LAYOUT_UNDEFINED,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			subresourceRange);
 
-		// Copy cube map faces one by one
-		for (uint32_t face = 0; face < 6; ++face)
-		{
-			// Copy region for image blit
-			VkImageCopy copyRegion = {};
-
-			copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			copyRegion.srcSubresource.baseArrayLayer = 0;
-			copyRegion.srcSubresource.mipLevel = 0;
-			copyRegion.srcSubresource.layerCount = 1;
-			copyRegion.srcOffset = { 0, 0, 0 };
-
-			copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			copyRegion.dstSubresource.baseArrayLayer = face;
-			copyRegion.dstSubresource.mipLevel = 0;
-			copyRegion.dstSubresource.layerCount = 1;
-			copyRegion.dstOffset = { 0, 0, 0 };
-
-			copyRegion.extent.width = cubeMap.width;
-			copyRegion.extent.height = cubeMap.height;
-			copyRegion.extent.depth = 1;
-
-			// Put image copy into command buffer
-			vkCmdCopyImage(
-				cmdBuffer,
-				cubeFace[face].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				cubeMap.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				1, &copyRegion);
-
-			// Change texture image layout to shader read after the copy
-			cubeMap.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			vkTools::setImageLayout(
-				cmdBuffer,
-				cubeMap.image,
-				VK_IMAGE_ASPECT_COLOR_BIT,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				cubeMap.imageLayout);
-		}
+		// Copy all faces from the staging buffer
+		vkCmdCopyBufferToImage(
+			cmdBuffer,
+			stagingBuffer,
+			cubeMap.image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			(uint32_t)bufferCopyRegions.size(),
+			bufferCopyRegions.data());
+
+		// Change texture image layout to shader read after the copy
+		cubeMap.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		vkTools::setImageLayout(
+			cmdBuffer,
+			cubeMap.image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			cubeMap.imageLayout,
+			subresourceRange);
 
 		err = vkEndCommandBuffer(cmdBuffer);
 		assert(!err);
@@ -281,7 +242,7 @@ public:
 		sampler.maxAnisotropy = 8;
 		sampler.compareOp = VK_COMPARE_OP_NEVER;
 		sampler.minLod = 0.0f;
-		sampler.maxLod = 0.0f;
+		sampler.maxLod = (float)cubeMap.mipLevels;
 		sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
 		err = vkCreateSampler(device, &sampler, nullptr, &cubeMap.sampler);
 		assert(!err);
@@ -293,17 +254,16 @@ public:
 		view.format = format;
 		view.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
 		view.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		view.subresourceRange.levelCount = cubeMap.mipLevels;
 		view.subresourceRange.layerCount = 6;
 		view.image = cubeMap.image;
 		err = vkCreateImageView(device, &view, nullptr, &cubeMap.view);
 		assert(!err);
 
 		// Cleanup
-		for (auto& face : cubeFace)
-		{
-			vkDestroyImage(device, face.image, nullptr);
-			vkFreeMemory(device, face.memory, nullptr);
-		}
+		vkFreeCommandBuffers(device, cmdPool, 1, &cmdBuffer);
+		vkDestroyBuffer(device, stagingBuffer, nullptr);
+		memoryAllocator.free(stagingMemory);
 	}
 
 	void buildCommandBuffers()
@@ -350,33 +310,25 @@ public:
 			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
 
 			VkDeviceSize offsets[1] = { 0 };
+			// Each command buffer reads the uniform ring region of it's swap chain image
+			uint32_t dynamicOffset = uniformRing.getDynamicOffset(i);
 
 			// Skybox
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets.skybox, 0, NULL);
+			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets.skybox, 1, &dynamicOffset);
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.skybox.vertices.buf, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.skybox.indices.buf, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.skybox.indices.buf, 0, meshes.skybox.indexType);
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.skybox);
-			vkCmdDrawIndexed(drawCmdBuffers[i], meshes.skybox.indexCount, 1, 0, 0, 0);
+			vkMeshLoader::drawMesh(drawCmdBuffers[i], meshes.skybox);
 
 			// 3D object
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets.object, 0, NULL);
+			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets.object, 1, &dynamicOffset);
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &meshes.object.vertices.buf, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.object.indices.buf, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], meshes.object.indices.buf, 0, meshes.object.indexType);
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.reflect);
-			vkCmdDrawIndexed(drawCmdBuffers[i], meshes.object.indexCount, 1, 0, 0, 0);
+			vkMeshLoader::drawMesh(drawCmdBuffers[i], meshes.object);
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE,
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
-
 			err = vkEndCommandBuffer(drawCmdBuffers[i]);
 			assert(!err);
 		}
@@ -384,37 +336,14 @@ public:
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo = 
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
-
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
-
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
-
-		// Submit draw command buffer
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
 
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
+		// Written straight into the uniform ring region of the acquired image
+		updateUniformBuffers();
 
-		err = vkQueueWaitIdle(queue);
-		assert(!err);
+		// Submit the image's draw command buffer and present it
+		submitFrame();
 	}
 
 	void loadMeshes()
@@ -469,7 +398,7 @@ public:
 	{
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2),
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2),
 			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2)
 		};
 
@@ -489,7 +418,7 @@ public:
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 
 				VK_SHADER_STAGE_VERTEX_BIT, 
 				0),
 			// Binding 1 : Fragment shader image sampler
@@ -525,6 +454,9 @@ public:
 				cubeMap.view,
 				VK_IMAGE_LAYOUT_GENERAL);
 
+		VkDescriptorBufferInfo objectDescriptor = uniformRing.getDescriptor(uniformOffsets.objectVS, sizeof(uboVS));
+		VkDescriptorBufferInfo skyboxDescriptor = uniformRing.getDescriptor(uniformOffsets.skyboxVS, sizeof(uboVS));
+
 		VkDescriptorSetAllocateInfo allocInfo =
 			vkTools::initializers::descriptorSetAllocateInfo(
 				descriptorPool,
@@ -540,9 +472,9 @@ public:
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.object, 
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 
 				0, 
-				&uniformData.objectVS.descriptor),
+				&objectDescriptor),
 			// Binding 1 : Fragment shader cubemap sampler
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.object, 
@@ -561,9 +493,9 @@ public:
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.skybox,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.skyboxVS.descriptor),
+				&skyboxDescriptor),
 			// Binding 1 : Fragment shader cubemap sampler
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSets.skybox,
@@ -671,22 +603,12 @@ public:
 	void prepareUniformBuffers()
 	{
 		// 3D objact 
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboVS),
-			&uboVS,
-			&uniformData.objectVS.buffer,
-			&uniformData.objectVS.memory,
-			&uniformData.objectVS.descriptor);
+		uniformOffsets.objectVS = uniformRing.allocate(sizeof(uboVS));
 
 		// Skybox
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboVS),
-			&uboVS,
-			&uniformData.skyboxVS.buffer,
-			&uniformData.skyboxVS.memory,
-			&uniformData.skyboxVS.descriptor);
+		uniformOffsets.skyboxVS = uniformRing.allocate(sizeof(uboVS));
+
+		updateUniformBuffers();
 	}
 
 	void updateUniformBuffers()
@@ -702,11 +624,7 @@ public:
 		uboVS.model = glm::rotate(uboVS.model, deg_to_rad(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
 		uboVS.model = glm::rotate(uboVS.model, deg_to_rad(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.objectVS.memory, 0, sizeof(uboVS), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboVS, sizeof(uboVS));
-		vkUnmapMemory(device, uniformData.objectVS.memory);
+		uniformRing.update(uniformOffsets.objectVS, &uboVS, sizeof(uboVS));
 
 		// Skysphere
 		viewMatrix = glm::mat4();
@@ -718,10 +636,7 @@ public:
 		uboVS.model = glm::rotate(uboVS.model, deg_to_rad(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
 		uboVS.model = glm::rotate(uboVS.model, deg_to_rad(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
-		err = vkMapMemory(device, uniformData.skyboxVS.memory, 0, sizeof(uboVS), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboVS, sizeof(uboVS));
-		vkUnmapMemory(device, uniformData.skyboxVS.memory);
+		uniformRing.update(uniformOffsets.skyboxVS, &uboVS, sizeof(uboVS));
 	}
 
 	void prepare()
@@ -746,10 +661,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
-		updateUniformBuffers();
 	}
 
 	virtual void viewChanged()
@@ -788,6 +700,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
@@ -47,11 +47,10 @@ public:
 		VkDeviceMemory mem;
 	} indices;
 
-	struct {
-		VkBuffer buffer;
-		VkDeviceMemory memory;
-		VkDescriptorBufferInfo descriptor;
-	}  uniformDataVS;
+	// Offset of the vertex shader uniform block inside the base class uniform ring
+	// The ring has one copy of the block per swap chain image, so updating it
+	// never touches data that a frame still in flight is reading
+	VkDeviceSize uniformOffsetVS;
 
 	struct {
 		glm::mat4 projectionMatrix;
@@ -90,9 +89,6 @@ public:
 
 		vkDestroyBuffer(device, indices.buf, nullptr);
 		vkFreeMemory(device, indices.mem, nullptr);
-
-		vkDestroyBuffer(device, uniformDataVS.buffer, nullptr);
-		vkFreeMemory(device, uniformDataVS.memory, nullptr);
 	}
 
 	// Build separate command buffers for every framebuffer image
@@ -148,7 +144,9 @@ public:
 			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
 
 			// Bind descriptor sets describing shader binding points
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
+			// The dynamic offset selects the uniform ring region of this swap chain image
+			uint32_t dynamicOffset = uniformRing.getDynamicOffset(i);
+			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 1, &dynamicOffset);
 
 			// Bind the rendering pipeline (including the shaders)
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.solid);
@@ -163,33 +161,12 @@ public:
 			// Draw indexed triangle
 			vkCmdDrawIndexed(drawCmdBuffers[i], indices.count, 1, 0, 0, 1);
 
+			// Ending the render pass will transform the frame buffer color attachment
+			// to the render pass' final layout (VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) 
+			// for presenting it to the windowing system
+			// So there is no need for a separate present barrier
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			// Add a present memory barrier to the end of the command buffer
-			// This will transform the frame buffer color attachment to a
-			// new layout for presenting it to the windowing system integration 
-			VkImageMemoryBarrier prePresentBarrier = {};
-			prePresentBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			prePresentBarrier.pNext = NULL;
-			prePresentBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			prePresentBarrier.dstAccessMask = 0;
-			prePresentBarrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-			prePresentBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-			prePresentBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			prePresentBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			prePresentBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };			
-			prePresentBarrier.image = swapChain.buffers[i].image;
-
-			VkImageMemoryBarrier *pMemoryBarrier = &prePresentBarrier;
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i], 
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 
-				VK_FLAGS_NONE,
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
-
 			err = vkEndCommandBuffer(drawCmdBuffers[i]);
 			assert(!err);
 		}
@@ -197,90 +174,22 @@ public:
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo = {};
-		presentCompleteSemaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-		presentCompleteSemaphoreCreateInfo.pNext = NULL;
-		presentCompleteSemaphoreCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
-
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
-
-		// The submit infor strcuture contains a list of
-		// command buffers and semaphores to be submitted to a queue
-		// If you want to submit multiple command buffers, pass an array
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
-
-		// Submit to the graphics queue
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		// Present the current buffer to the swap chain
-		// This will display the image
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
-
-		// Add a post present image memory barrier
-		// This will transform the frame buffer color attachment back
-		// to it's initial layout after it has been presented to the
-		// windowing system
-		// See buildCommandBuffers for the pre present barrier that 
-		// does the opposite transformation 
-		VkImageMemoryBarrier postPresentBarrier = {};
-		postPresentBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		postPresentBarrier.pNext = NULL;
-		postPresentBarrier.srcAccessMask = 0;
-		postPresentBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		postPresentBarrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-		postPresentBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-		postPresentBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		postPresentBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		postPresentBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
-		postPresentBarrier.image = swapChain.buffers[currentBuffer].image;
-
-		// Use dedicated command buffer from example base class for submitting the post present barrier
-		VkCommandBufferBeginInfo cmdBufInfo = {};
-		cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-		err = vkBeginCommandBuffer(postPresentCmdBuffer, &cmdBufInfo);
-		assert(!err);
-
-		// Put post present barrier into command buffer
-		vkCmdPipelineBarrier(
-			postPresentCmdBuffer,
-			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-			VK_FLAGS_NONE,
-			0, nullptr,
-			0, nullptr,
-			1, &postPresentBarrier);
-
-		err = vkEndCommandBuffer(postPresentCmdBuffer);
-		assert(!err);
-
-		// Submit to the queue
-		submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &postPresentCmdBuffer;
-
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-		
-		err = vkQueueWaitIdle(queue);
-		assert(!err);
+		// The example base class keeps a ring of frames in flight
+		// Each frame slot has its own fence, a semaphore signaled by the
+		// presentation engine once the swap chain image is ready and a 
+		// semaphore signaled by the queue once rendering is done
+		// Unlike waiting for the queue to become idle after each frame
+		// this lets the CPU record the next frame while the GPU is still 
+		// busy with the previous one
+
+		// Wait for a free frame slot and get next image in the swap chain (back/front buffer)
+		// The transition from present layout back to color attachment
+		// is done by the render pass (see setupRenderPass in the base class)
+		beginFrame();
+
+		// Submit the command buffer for the current swap chain image
+		// to the graphics queue and present it once rendering is done
+		submitFrame();
 	}
 
 	// Setups vertex and index buffers for an indexed triangle,
@@ -400,9 +309,9 @@ public:
 	{
 		// We need to tell the API the number of max. requested descriptors per type
 		VkDescriptorPoolSize typeCounts[1];
-		// This example only uses one descriptor type (uniform buffer) and only
+		// This example only uses one descriptor type (dynamic uniform buffer) and only
 		// requests one descriptor of this type
-		typeCounts[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		typeCounts[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		typeCounts[0].descriptorCount = 1;
 		// For additional types you need to add new entries in the type count list
 		// E.g. for two combined image samplers :
@@ -433,8 +342,9 @@ public:
 		// binding
 
 		// Binding 0 : Uniform buffer (Vertex shader)
+		// Dynamic, so the offset into the buffer can be set when binding the descriptor set
 		VkDescriptorSetLayoutBinding layoutBinding = {};
-		layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		layoutBinding.descriptorCount = 1;
 		layoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 		layoutBinding.pImmutableSamplers = NULL;
@@ -478,12 +388,16 @@ public:
 		VkResult vkRes = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet);
 		assert(!vkRes);
 
+		// The descriptor covers the uniform block inside of one ring region, 
+		// the region's offset is added at bind time
+		VkDescriptorBufferInfo uniformDescriptor = uniformRing.getDescriptor(uniformOffsetVS, sizeof(uboVS));
+
 		// Binding 0 : Uniform buffer
 		writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		writeDescriptorSet.dstSet = descriptorSet;
 		writeDescriptorSet.descriptorCount = 1;
-		writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		writeDescriptorSet.pBufferInfo = &uniformDataVS.descriptor;
+		writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		writeDescriptorSet.pBufferInfo = &uniformDescriptor;
 		// Binds this uniform buffer to binding point 0
 		writeDescriptorSet.dstBinding = 0;
 
@@ -625,42 +539,9 @@ public:
 
 	void prepareUniformBuffers()
 	{
-		// Prepare and initialize uniform buffer containing shader uniforms
-		VkMemoryRequirements memReqs;
-
-		// Vertex shader uniform buffer block
-		VkBufferCreateInfo bufferInfo = {};
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.pNext = NULL;
-		allocInfo.allocationSize = 0;
-		allocInfo.memoryTypeIndex = 0;
-		VkResult err;
-
-		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		bufferInfo.size = sizeof(uboVS);
-		bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-
-		// Create a new buffer
-		err = vkCreateBuffer(device, &bufferInfo, nullptr, &uniformDataVS.buffer);
-		assert(!err);
-		// Get memory requirements including size, alignment and memory type 
-		vkGetBufferMemoryRequirements(device, uniformDataVS.buffer, &memReqs);
-		allocInfo.allocationSize = memReqs.size;
-		// Gets the appropriate memory type for this type of buffer allocation
-		// Only memory types that are visible to the host
-		getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &allocInfo.memoryTypeIndex);
-		// Allocate memory for the uniform buffer
-		err = vkAllocateMemory(device, &allocInfo, nullptr, &(uniformDataVS.memory));
-		assert(!err);
-		// Bind memory to buffer
-		err = vkBindBufferMemory(device, uniformDataVS.buffer, uniformDataVS.memory, 0);
-		assert(!err);
-		
-		// Store information in the uniform's descriptor
-		uniformDataVS.descriptor.buffer = uniformDataVS.buffer;
-		uniformDataVS.descriptor.offset = 0;
-		uniformDataVS.descriptor.range = sizeof(uboVS);
+		// Sub-allocate the vertex shader uniform block from the uniform ring
+		// of the base class (a persistently mapped, host visible buffer)
+		uniformOffsetVS = uniformRing.allocate(sizeof(uboVS));
 
 		updateUniformBuffers();
 	}
@@ -677,13 +558,11 @@ public:
 		uboVS.modelMatrix = glm::rotate(uboVS.modelMatrix, deg_to_rad(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
 		uboVS.modelMatrix = glm::rotate(uboVS.modelMatrix, deg_to_rad(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
 
-		// Map uniform buffer and update it
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformDataVS.memory, 0, sizeof(uboVS), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboVS, sizeof(uboVS));
-		vkUnmapMemory(device, uniformDataVS.memory);
-		assert(!err);
+		// Copy the matrices into the uniform ring
+		// This is called on user input, outside of a frame, so the ring keeps
+		// them until the next frame and copies them into each image's region
+		// once that image is no longer in use by the GPU
+		uniformRing.update(uniformOffsetVS, &uboVS, sizeof(uboVS));
 	}
 
 	void prepare()
@@ -703,9 +582,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
 
 	}
 
@@ -747,6 +624,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);
@@ -15,6 +15,8 @@
 
 #include <vulkan/vulkan.h>
 #include "vulkanexamplebase.h"
+#include "vulkanclusterculling.hpp"
+#include "vulkangeometrypool.hpp"
 
 #define VERTEX_BUFFER_BIND_ID 0
 //#define USE_GLSL
@@ -38,9 +40,20 @@ public:
 	} demoMeshes;
 	std::vector<VulkanMeshLoader*> meshes;
 
-	struct {
-		vkTools::UniformData meshVS;
-	} uniformData;
+	// Vertices and indices of all meshes are sub-allocated from a geometry pool
+	vkTools::VulkanGeometryPool geometryPool;
+	std::vector<vkTools::GeometryRange> geometry;
+
+	// Cull meshlets on the GPU and draw the meshes with the compacted
+	// indices of the visible ones (enabled with -clusterculling)
+	bool clusterCulling = false;
+	vkTools::VulkanClusterCuller clusterCuller;
+	// Draw command of each mesh, the skybox isn't culled
+	std::vector<uint32_t> clusterDrawIndices;
+	const uint32_t noClusterDraw = UINT32_MAX;
+
+	// Offset of the vertex shader uniform block inside the base class uniform ring
+	VkDeviceSize uniformOffsetVS;
 
 	struct {
 		glm::mat4 projection;
@@ -50,9 +63,10 @@ public:
 		glm::vec4 lightPos;
 	} uboVS;
 
+	// Owned by the base class' texture cache
 	struct
 	{
-		vkTools::VulkanTexture skybox;
+		vkTools::CachedTexture *skybox = nullptr;
 	} textures;
 
 	struct {
@@ -75,6 +89,13 @@ public:
 		rotationSpeed = 0.5f;
 		rotation = glm::vec3(15.0f, 0.f, 0.0f);
 		title = "Vulkan Demo Scene -  2016 by Sascha Willems";
+		for (size_t i = 0; i < args.size(); i++)
+		{
+			if (args[i] == std::string("-clusterculling"))
+			{
+				clusterCulling = true;
+			}
+		}
 	}
 
 	~VulkanExample()
@@ -88,26 +109,25 @@ public:
 		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 
-		vkTools::destroyUniformData(device, &uniformData.meshVS);
+		clusterCuller.destroy();
 
-		for (auto& mesh : meshes)
+		for (auto& range : geometry)
 		{
-			vkDestroyBuffer(device, mesh->vertexBuffer.buf, nullptr);
-			vkFreeMemory(device, mesh->vertexBuffer.mem, nullptr);
-
-			vkDestroyBuffer(device, mesh->indexBuffer.buf, nullptr);
-			vkFreeMemory(device, mesh->indexBuffer.mem, nullptr);
+			geometryPool.free(range);
 		}
+		geometryPool.destroy();
 
-		textureLoader->destroyTexture(textures.skybox);
+		textureCache.release(textures.skybox);
 	}
 
 	void loadTextures()
 	{
-		textureLoader->loadCubemap(
+		vkTools::TextureSamplerSettings skyboxSampler;
+		skyboxSampler.addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		textures.skybox = textureCache.acquireCubemap(
 			"./../data/textures/cubemap_vulkan.ktx", 
 			VK_FORMAT_R8G8B8A8_UNORM, 
-			&textures.skybox);
+			skyboxSampler);
 	}
 
 	void buildCommandBuffers()
@@ -136,6 +156,14 @@ public:
 			err = vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo);
 			assert(!err);
 
+			// Each command buffer reads the uniform ring region of it's swap chain image
+			uint32_t dynamicOffset = uniformRing.getDynamicOffset(i);
+
+			if (clusterCulling)
+			{
+				clusterCuller.cull(drawCmdBuffers[i], dynamicOffset);
+			}
+
 			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 			VkViewport viewport = vkTools::initializers::viewport(
@@ -152,28 +180,35 @@ public:
 				0);
 			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
 
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
+			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 1, &dynamicOffset);
 
-			VkDeviceSize offsets[1] = { 0 };
-			for (auto& mesh : meshes)
+			// All meshes share the pool's buffers
+			geometryPool.bind(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID);
+			for (size_t m = 0; m < meshes.size(); m++)
 			{
-				vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, mesh->pipeline);
-				vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &mesh->vertexBuffer.buf, offsets);
-				vkCmdBindIndexBuffer(drawCmdBuffers[i], mesh->indexBuffer.buf, 0, VK_INDEX_TYPE_UINT32);
-				vkCmdDrawIndexed(drawCmdBuffers[i], mesh->indexBuffer.count, 1, 0, 0, 0);
+				if (clusterCulling && (clusterDrawIndices[m] != noClusterDraw))
+				{
+					continue;
+				}
+				vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, meshes[m]->pipeline);
+				geometryPool.draw(drawCmdBuffers[i], geometry[m]);
 			}
 
-			vkCmdEndRenderPass(drawCmdBuffers[i]);
+			// Culled meshes are drawn with the compacted indices (same vertex buffer)
+			if (clusterCulling)
+			{
+				clusterCuller.bindIndexBuffer(drawCmdBuffers[i]);
+				for (size_t m = 0; m < meshes.size(); m++)
+				{
+					if (clusterDrawIndices[m] != noClusterDraw)
+					{
+						vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, meshes[m]->pipeline);
+						clusterCuller.draw(drawCmdBuffers[i], clusterDrawIndices[m]);
+					}
+				}
+			}
 
-			VkImageMemoryBarrier prePresentBarrier = vkTools::prePresentBarrier(swapChain.buffers[i].image);
-			vkCmdPipelineBarrier(
-				drawCmdBuffers[i],
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_FLAGS_NONE,
-				0, nullptr,
-				0, nullptr,
-				1, &prePresentBarrier);
+			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
 			err = vkEndCommandBuffer(drawCmdBuffers[i]);
 			assert(!err);
@@ -182,37 +217,11 @@ public:
 
 	void draw()
 	{
-		VkResult err;
-		VkSemaphore presentCompleteSemaphore;
-		VkSemaphoreCreateInfo presentCompleteSemaphoreCreateInfo =
-			vkTools::initializers::semaphoreCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-
-		err = vkCreateSemaphore(device, &presentCompleteSemaphoreCreateInfo, nullptr, &presentCompleteSemaphore);
-		assert(!err);
-
-		// Get next image in the swap chain (back/front buffer)
-		err = swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer);
-		assert(!err);
-
-		VkSubmitInfo submitInfo = vkTools::initializers::submitInfo();
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
-
-		// Submit draw command buffer
-		err = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		assert(!err);
-
-		err = swapChain.queuePresent(queue, currentBuffer);
-		assert(!err);
+		// Wait for a free frame slot and acquire the next swap chain image
+		beginFrame();
 
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
-
-		submitPostPresentBarrier(swapChain.buffers[currentBuffer].image);
-
-		err = vkQueueWaitIdle(queue);
-		assert(!err);
+		// Submit the image's draw command buffer and present it
+		submitFrame();
 	}
 
 	void prepareVertices()
@@ -240,8 +249,15 @@ public:
 		meshList.push_back(demoMeshes.background);
 		meshList.push_back(demoMeshes.models);
 
-		VkMemoryAllocateInfo memAlloc = vkTools::initializers::memoryAllocateInfo();
-		VkMemoryRequirements memReqs;
+		// One pool with room for all meshes of the scene
+		uint32_t vertexCount = 0;
+		uint32_t indexCount = 0;
+		for (auto& mesh : meshList)
+		{
+			vertexCount += mesh->numVertices;
+			indexCount += mesh->getIndexCount();
+		}
+		geometryPool.prepare(device, &memoryAllocator, &uploadManager, sizeof(Vertex), vertexCount, indexCount);
 
 		// todo : Use mesh function for loading
 		float scale = 1.0f;
@@ -273,30 +289,32 @@ public:
 					vertexBuffer.push_back(vert);
 				}
 			}
-			createBuffer(
-				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-				vertexBuffer.size() * sizeof(Vertex),
-				vertexBuffer.data(),
-				&mesh->vertexBuffer.buf,
-				&mesh->vertexBuffer.mem);
-
-			uint32_t vertexBufferSize = vertexBuffer.size() * sizeof(Vertex);
-
 			std::vector<uint32_t> indexBuffer;
 			for (int m = 0; m < mesh->m_Entries.size(); m++)
 			{
-				int indexBase = indexBuffer.size();
+				// Indices of each entry start at it's first vertex
+				uint32_t vertexBase = mesh->m_Entries[m].vertexBase;
 				for (int i = 0; i < mesh->m_Entries[m].Indices.size(); i++) {
-					indexBuffer.push_back(mesh->m_Entries[m].Indices[i] + indexBase);
+					indexBuffer.push_back(mesh->m_Entries[m].Indices[i] + vertexBase);
 				}
 			}
-			createBuffer(
-				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-				indexBuffer.size() * sizeof(uint32_t),
-				indexBuffer.data(),
-				&mesh->indexBuffer.buf,
-				&mesh->indexBuffer.mem);
-			mesh->indexBuffer.count = indexBuffer.size();
+			vkTools::GeometryRange range = geometryPool.allocate(vertexBuffer.data(), (uint32_t)vertexBuffer.size(), indexBuffer.data(), (uint32_t)indexBuffer.size());
+			assert(range.valid());
+			geometry.push_back(range);
+
+			// The skybox is drawn with front face culling and always covers the screen
+			uint32_t clusterDrawIndex = noClusterDraw;
+			if (clusterCulling && (mesh != demoMeshes.skybox))
+			{
+				std::vector<vkMeshLoader::Meshlet> meshlets = mesh->buildMeshlets();
+				for (auto& meshlet : meshlets)
+				{
+					// Same offset as the vertices
+					meshlet.sphere.y += 1.15f;
+				}
+				clusterDrawIndex = clusterCuller.addMesh(indexBuffer.data(), indexBuffer.size(), meshlets, range.vertexOffset);
+			}
+			clusterDrawIndices.push_back(clusterDrawIndex);
 
 			meshes.push_back(mesh);
 		}
@@ -352,7 +370,7 @@ public:
 		// Example uses one ubo and one image sampler
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2),
+			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2),
 			vkTools::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
 		};
 
@@ -372,7 +390,7 @@ public:
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::descriptorSetLayoutBinding(
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				VK_SHADER_STAGE_VERTEX_BIT,
 				0),
 			// Binding 1 : Fragment shader color map image sampler
@@ -413,18 +431,20 @@ public:
 		// Cube map image descriptor
 		VkDescriptorImageInfo texDescriptorCubeMap =
 			vkTools::initializers::descriptorImageInfo(
-				textures.skybox.sampler,
-				textures.skybox.view,
+				textures.skybox->texture.sampler,
+				textures.skybox->texture.view,
 				VK_IMAGE_LAYOUT_GENERAL);
 
+		VkDescriptorBufferInfo uboDescriptor = uniformRing.getDescriptor(uniformOffsetVS, sizeof(uboVS));
+
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets =
 		{
 			// Binding 0 : Vertex shader uniform buffer
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				0,
-				&uniformData.meshVS.descriptor),
+				&uboDescriptor),
 			// Binding 1 : Fragment shader image sampler
 			vkTools::initializers::writeDescriptorSet(
 				descriptorSet,
@@ -547,17 +567,26 @@ public:
 		demoMeshes.skybox->pipeline = pipelines.skybox;
 	}
 
+	void prepareClusterCulling()
+	{
+		if (!clusterCulling)
+		{
+			return;
+		}
+#ifdef USE_GLSL
+		VkPipelineShaderStageCreateInfo shaderStage = loadShaderGLSL("./../data/shaders/vulkanscene/clustercull.comp", VK_SHADER_STAGE_COMPUTE_BIT);
+#else
+		VkPipelineShaderStageCreateInfo shaderStage = loadShader("./../data/shaders/vulkanscene/clustercull.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+#endif
+		clusterCuller.prepare(device, &memoryAllocator, &uploadManager, &uniformRing, shaderStage, pipelineCache);
+		std::cout << "Cluster culling: " << clusterCuller.getClusterCount() << " clusters, " << clusterCuller.getTriangleCount() << " triangles" << std::endl;
+	}
+
 	// Prepare and initialize uniform buffer containing shader uniforms
 	void prepareUniformBuffers()
 	{
 		// Vertex shader uniform buffer block
-		createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			sizeof(uboVS),
-			&uboVS,
-			&uniformData.meshVS.buffer,
-			&uniformData.meshVS.memory,
-			&uniformData.meshVS.descriptor);
+		uniformOffsetVS = uniformRing.allocate(sizeof(uboVS));
 
 		updateUniformBuffers();
 	}
@@ -581,11 +610,14 @@ public:
 
 		uboVS.lightPos = lightPos;
 
-		uint8_t *pData;
-		VkResult err = vkMapMemory(device, uniformData.meshVS.memory, 0, sizeof(uboVS), 0, (void **)&pData);
-		assert(!err);
-		memcpy(pData, &uboVS, sizeof(uboVS));
-		vkUnmapMemory(device, uniformData.meshVS.memory);
+		uniformRing.update(uniformOffsetVS, &uboVS, sizeof(uboVS));
+
+		if (clusterCulling)
+		{
+			// Meshlets are culled in model space
+			glm::mat4 modelView = uboVS.view * uboVS.model;
+			clusterCuller.update(uboVS.projection * modelView, glm::vec3(glm::inverse(modelView)[3]));
+		}
 	}
 
 	void prepare()
@@ -596,6 +628,7 @@ public:
 		prepareUniformBuffers();
 		setupDescriptorSetLayout();
 		preparePipelines();
+		prepareClusterCulling();
 		setupDescriptorPool();
 		setupDescriptorSet();
 		buildCommandBuffers();
@@ -606,9 +639,7 @@ public:
 	{
 		if (!prepared)
 			return;
-		vkDeviceWaitIdle(device);
 		draw();
-		vkDeviceWaitIdle(device);
 	}
 
 	virtual void viewChanged()
@@ -648,6 +679,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 int main(const int argc, const char *argv[])
 #endif
 {
+#ifndef _WIN32
+	for (int32_t i = 0; i < argc; i++)
+	{
+		VulkanExampleBase::args.push_back(argv[i]);
+	}
+#endif
 	vulkanExample = new VulkanExample();
 #ifdef _WIN32
 	vulkanExample->setupWindow(hInstance, WndProc);